@@ -0,0 +1,743 @@
+/**
+ * @brief	A replay harness that drives the deformer's pipeline without Maya. It
+ * 		loads the logic library through the same loader as the plugin, and
+ * 		evaluates it on every frame of a number of meshes, reporting the frame
+ * 		times, throughput and a checksum of the deformed points of each mesh.
+ *
+ * 		Usage: deformer_replay [--library <file>] [--capture <file>]... [--points <n>[,<n>...]]
+ * 						[--frames <n>] [--stages <n>] [--envelope <value>] [--world-space]
+ * 						[--save <file>] [--output <file>] [--baseline <file>]
+ * 						[--threshold <ratio>] [--trace <file>] [--track-allocations]
+ * 						[--shadow <n>]
+ *
+ * 		Each ``--capture`` replays a recorded mesh, which is a point cache file
+ * 		(see ``writePointCacheFile``). Otherwise, an animated grid is generated
+ * 		for each of the ``--points`` counts (``10000,100000,1000000`` by default)
+ * 		and played for ``--frames`` frames. ``--save`` records the generated mesh
+ * 		to a point cache file, so that the exact same mesh can be replayed later.
+ *
+ * 		The logic library is ``logic.so`` (or ``logic.dll``) next to the executable
+ * 		by default. It is checked for changes on every frame, just like in Maya,
+ * 		so it can be rebuilt while a replay is running. ``--trace`` (or the same
+ * 		environment variable as the plugin) writes a trace of the replay's zones.
+ * 		``--track-allocations`` also reports the heap allocations made by the logic
+ * 		library per point, and how many of them it leaked per frame (Linux only).
+ * 		``--shadow`` compares each version of the logic library that is reloaded
+ * 		during the replay against the previous one for that many frames.
+ *
+ * 		``--output`` writes the results as JSON, with one result per line. A
+ * 		results file can then be passed to ``--baseline`` on a later run, which
+ * 		fails (with an exit code of ``1``) if the checksum of any mesh has changed
+ * 		or its throughput has dropped by more than ``--threshold`` (``1.25`` by
+ * 		default). The checksums depend on the instruction sets that the logic
+ * 		library uses, so baselines are only meaningful on the machine that they
+ * 		were recorded on.
+ */
+#include "deformer_host.h"
+#include "deformer_stats.h"
+#include <ssmath/point_codec.h>
+#include <ssmath/simd_kernels.h>
+
+#include "deformer_platform.cpp"
+#include "deformer_host.cpp"
+#include "deformer_stats.cpp"
+
+#include <ssmath/instrset.cpp>
+#include <ssmath/matrix_math.cpp>
+
+#include <math.h>
+#include <string.h>
+
+
+static const unsigned int kReplayDefaultPointCounts[] = {10000, 100000, 1000000};
+static const unsigned int kReplayDefaultFrames = 60;
+static const float kReplayDefaultEnvelope = 0.5f;
+static const double kReplayDefaultThreshold = 1.25;
+
+/// The error bound that generated meshes are recorded with by ``--save``.
+static const float kReplayCaptureErrorBound = 1e-4f;
+
+static const unsigned int kMaxReplayMeshes = 32;
+static const unsigned int kReplayNameLen = 64;
+
+/// Every mesh is replayed by a new node, which needs its own statistics ID.
+globalVar unsigned int kNextReplayStatsID = 1;
+
+
+/// A mesh to replay, which is either read from a point cache file or generated.
+struct ReplayMesh
+{
+	char name[kReplayNameLen];
+	unsigned int numPoints;
+	unsigned int numFrames;
+
+	const char *capturePath; /// ``NULL`` for generated meshes.
+};
+
+
+/// The state of the mesh being replayed, which the pipeline accesses through a
+/// ``DeformerHost``.
+struct ReplayHostData
+{
+	const Vec3Stream *positions;	/// The undeformed points of the current frame.
+	Vec3 *deformed;				/// Where the deformed points are written to.
+
+	Mat44 worldMatrix;
+	unsigned int numStages;
+	float envelope;
+	bool worldSpace;
+};
+
+
+struct ReplayResult
+{
+	char mesh[kReplayNameLen];
+	unsigned int numPoints;
+	unsigned int numFrames;
+	unsigned int numStages;
+
+	double meanFrameMs;
+	double p50FrameMs;
+	double p99FrameMs;
+	double maxFrameMs;
+	double pointsPerSecond;
+	uint64_t checksum;
+
+	/// The heap allocations made by the logic library over all frames. These are
+	/// only counted if its allocations are being tracked.
+	AllocationCounts logicAllocations;
+};
+
+
+void displayDeformerInfo(const char *message)
+{
+	fprintf(stderr, "%s\n", message);
+}
+
+
+void displayDeformerWarning(const char *message)
+{
+	fprintf(stderr, "WARNING: %s\n", message);
+}
+
+
+void displayDeformerError(const char *message)
+{
+	fprintf(stderr, "ERROR: %s\n", message);
+}
+
+
+static unsigned int getReplayStages(void *data, FusedStage *stages, unsigned int maxStages)
+{
+	ReplayHostData *host = (ReplayHostData *)data;
+	unsigned int numStages = host->numStages < maxStages ? host->numStages : maxStages;
+	for (unsigned int i=0; i < numStages; ++i) {
+		stages[i].envelope = host->envelope;
+		stages[i].worldSpace = host->worldSpace;
+	}
+
+	return numStages;
+}
+
+
+static void getReplayWorldMatrix(void *data, Mat44 &matrix)
+{
+	ReplayHostData *host = (ReplayHostData *)data;
+	matrix = host->worldMatrix;
+}
+
+
+static unsigned int getReplayNumPoints(void *data)
+{
+	ReplayHostData *host = (ReplayHostData *)data;
+	return host->positions->count;
+}
+
+
+static int readReplayPoints(void *data, Vec3 *points, unsigned int numPoints)
+{
+	ReplayHostData *host = (ReplayHostData *)data;
+	const Vec3Stream &positions = *host->positions;
+	if (positions.count < numPoints) {
+		return -1;
+	}
+	for (unsigned int i=0; i < numPoints; ++i) {
+		points[i] = vec3(positions.x[i], positions.y[i], positions.z[i]);
+	}
+
+	return 0;
+}
+
+
+static int writeReplayPoints(void *data, const Vec3 *points, unsigned int numPoints)
+{
+	ReplayHostData *host = (ReplayHostData *)data;
+	memcpy(host->deformed, points, sizeof(Vec3) * numPoints);
+
+	return 0;
+}
+
+
+/**
+ * Generates a frame of an animated grid of points: a square sheet in the XZ
+ * plane with a wave travelling across it. The grid is generated the same way on
+ * every machine, up to the accuracy of ``sinf`` and ``cosf``.
+ *
+ * @param positions	The stream to write the points to. Its count must already be set.
+ * @param frame		The frame to generate.
+ * @param waves		Scratch space for one value per row and column of the grid;
+ * 					``count + 2`` values is always enough.
+ */
+static void generateReplayFrame(Vec3Stream &positions, unsigned int frame, float *waves)
+{
+	unsigned int numPoints = positions.count;
+	unsigned int width = (unsigned int)ceil(sqrt((double)numPoints));
+	unsigned int height = (numPoints + width - 1) / width;
+	float time = (float)frame * 0.1f;
+	float spacing = 10.0f / (float)width;
+
+	// NOTE: (sonictk) The wave is separable, so only one sine per row and one
+	// cosine per column are needed; otherwise generating large meshes takes
+	// longer than deforming them.
+	float *rowWaves = waves;
+	float *colWaves = waves + height;
+	for (unsigned int row=0; row < height; ++row) {
+		rowWaves[row] = sinf((float)row * spacing + time);
+	}
+	for (unsigned int col=0; col < width; ++col) {
+		colWaves[col] = cosf((float)col * spacing * 0.5f + time);
+	}
+	for (unsigned int i=0, col=0, row=0; i < numPoints; ++i) {
+		positions.x[i] = (float)col * spacing - 5.0f;
+		positions.y[i] = 0.5f * rowWaves[row] * colWaves[col];
+		positions.z[i] = (float)row * spacing - 5.0f;
+		if (++col == width) {
+			col = 0;
+			++row;
+		}
+	}
+}
+
+
+/// The world matrix of the mesh at the given frame, which slowly spins and drifts
+/// so that every frame's matrix is different.
+static Mat44 getReplayWorldMatrixAtFrame(unsigned int frame)
+{
+	float angle = (float)frame * 0.01f;
+	float c = cosf(angle);
+	float s = sinf(angle);
+
+	Mat44 matrix = identityMat44();
+	matrix[0][0] = c;
+	matrix[0][2] = s;
+	matrix[2][0] = -s;
+	matrix[2][2] = c;
+	matrix[0][3] = (float)frame * 0.05f;
+	matrix[1][3] = 1.0f;
+
+	return matrix;
+}
+
+
+/// Folds the bits of the deformed points into a 64-bit hash, using the FNV-1a steps
+/// on whole coordinates rather than on single bytes.
+static uint64_t hashReplayPoints(uint64_t hash, const Vec3 *points, unsigned int numPoints)
+{
+	const float *values = (const float *)points;
+	for (size_t i=0; i < (size_t)numPoints * 3; ++i) {
+		uint32_t bits;
+		memcpy(&bits, values + i, sizeof(bits));
+		hash = (hash ^ bits) * 0x100000001b3ULL;
+	}
+
+	return hash;
+}
+
+
+static int compareReplayFrameTimes(const void *a, const void *b)
+{
+	double x = *(const double *)a;
+	double y = *(const double *)b;
+
+	return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+
+/**
+ * Replays every frame of a mesh through the deformer pipeline.
+ *
+ * @param mesh			The mesh to replay.
+ * @param host			The settings of the stages; its points are set for each frame.
+ * @param savePath		If not ``NULL``, the mesh is recorded to this point cache file.
+ * @param result		Set to the results of the replay.
+ *
+ * @return				``0`` on success, ``-1`` if the mesh could not be read,
+ * 					allocated or saved, or any frame failed to evaluate.
+ */
+static int replayMesh(const ReplayMesh &mesh, ReplayHostData &host, const char *savePath, ReplayResult &result)
+{
+	PointCache cache = {};
+	PointCacheDecoder decoder = {};
+	unsigned int numPoints = mesh.numPoints;
+	unsigned int numFrames = mesh.numFrames;
+	if (mesh.capturePath) {
+		if (readPointCacheFile(cache, mesh.capturePath) != 0 || createPointCacheDecoder(decoder, cache) != 0) {
+			fprintf(stderr, "Failed to read the capture: %s\n", mesh.capturePath);
+			freePointCache(cache);
+			return -1;
+		}
+		numPoints = cache.numPoints;
+		numFrames = cache.numFrames;
+	} else if (savePath && createPointCache(cache, numPoints, pointCacheSettings(kReplayCaptureErrorBound)) != 0) {
+		fprintf(stderr, "Failed to create the capture!\n");
+		return -1;
+	}
+
+	Vec3Stream positions = {};
+	Vec3 *deformed = (Vec3 *)malloc(sizeof(Vec3) * (numPoints > 0 ? numPoints : 1));
+	float *waves = (float *)malloc(sizeof(float) * (numPoints + 2));
+	double *frameTimes = (double *)malloc(sizeof(double) * (numFrames > 0 ? numFrames : 1));
+	if (allocateVec3Stream(positions, numPoints) != 0 || !deformed || !waves || !frameTimes) {
+		fprintf(stderr, "Failed to allocate the mesh: %s\n", mesh.name);
+		freeVec3Stream(positions);
+		free(deformed);
+		free(waves);
+		free(frameTimes);
+		freePointCacheDecoder(decoder);
+		freePointCache(cache);
+		return -1;
+	}
+
+	// NOTE: (sonictk) Each mesh gets a fresh node, so that the first frame of every
+	// mesh pays for growing the point buffer just like a new node in Maya would.
+	DeformerPipeline pipeline;
+	initializeDeformerPipeline(pipeline, kNextReplayStatsID++);
+
+	DeformerHost deformerHost;
+	deformerHost.data = &host;
+	deformerHost.getStages = getReplayStages;
+	deformerHost.getWorldMatrix = getReplayWorldMatrix;
+	deformerHost.getNumPoints = getReplayNumPoints;
+	deformerHost.readPoints = readReplayPoints;
+	deformerHost.writePoints = writeReplayPoints;
+
+	host.positions = &positions;
+	host.deformed = deformed;
+
+	int status = 0;
+	uint64_t checksum = 0xcbf29ce484222325ULL;
+	AllocationCounts allocationsStart = getThreadAllocationCounts();
+	double totalSeconds = 0.0;
+	for (unsigned int frame=0; frame < numFrames && status == 0; ++frame) {
+		if (mesh.capturePath) {
+			status = decodePointCacheFrame(cache, frame, decoder, positions);
+		} else {
+			generateReplayFrame(positions, frame, waves);
+			if (savePath) {
+				status = appendPointCacheFrame(cache, positions);
+			}
+		}
+		if (status != 0) {
+			fprintf(stderr, "Failed to %s frame %u of: %s\n", mesh.capturePath ? "decode" : "record", frame, mesh.name);
+			break;
+		}
+		host.worldMatrix = getReplayWorldMatrixAtFrame(frame);
+
+		SS_PROFILE_ZONE("replay: frame");
+
+		uint64_t start = getMonotonicNanoseconds();
+		status = evaluateDeformerPipeline(pipeline, deformerHost);
+		uint64_t end = getMonotonicNanoseconds();
+		if (status != 0) {
+			fprintf(stderr, "Failed to evaluate frame %u of: %s\n", frame, mesh.name);
+			break;
+		}
+
+		frameTimes[frame] = (double)(end - start) * 1e-6;
+		totalSeconds += (double)(end - start) * 1e-9;
+		checksum = hashReplayPoints(checksum, deformed, numPoints);
+	}
+
+	if (status == 0 && savePath && !mesh.capturePath) {
+		if (writePointCacheFile(cache, savePath) != 0) {
+			fprintf(stderr, "Failed to write the capture: %s\n", savePath);
+			status = -1;
+		} else {
+			fprintf(stderr,
+					"Recorded %s to: %s (%.1fx compression)\n",
+					mesh.name,
+					savePath,
+					getPointCacheCompressionRatio(cache));
+		}
+	}
+
+	if (status == 0) {
+		qsort(frameTimes, numFrames, sizeof(double), compareReplayFrameTimes);
+
+		memcpy(result.mesh, mesh.name, kReplayNameLen);
+		result.numPoints = numPoints;
+		result.numFrames = numFrames;
+		result.numStages = host.numStages;
+		result.meanFrameMs = numFrames > 0 ? totalSeconds * 1e3 / (double)numFrames : 0.0;
+		result.p50FrameMs = numFrames > 0 ? frameTimes[(numFrames - 1) / 2] : 0.0;
+		result.p99FrameMs = numFrames > 0 ? frameTimes[(unsigned int)((double)(numFrames - 1) * 0.99)] : 0.0;
+		result.maxFrameMs = numFrames > 0 ? frameTimes[numFrames - 1] : 0.0;
+		result.pointsPerSecond = totalSeconds > 0.0 ? (double)numPoints * (double)numFrames / totalSeconds : 0.0;
+		result.checksum = checksum;
+		result.logicAllocations = subtractAllocationCounts(getThreadAllocationCounts(), allocationsStart);
+	}
+
+	freeDeformerPipeline(pipeline);
+	freeVec3Stream(positions);
+	free(deformed);
+	free(waves);
+	free(frameTimes);
+	freePointCacheDecoder(decoder);
+	freePointCache(cache);
+
+	return status;
+}
+
+
+/**
+ * Reads a results file written by ``writeReplayResults``.
+ *
+ * @return		The number of results read, or ``-1`` if the file could not be read.
+ */
+static int readReplayResults(const char *filename, ReplayResult *results, unsigned int maxResults)
+{
+	FILE *file = fopen(filename, "r");
+	if (!file) {
+		perror("Failed to open the baseline file!\n");
+		return -1;
+	}
+
+	unsigned int numResults = 0;
+	char line[1024];
+	while (numResults < maxResults && fgets(line, sizeof(line), file)) {
+		ReplayResult &result = results[numResults];
+		unsigned long long checksum = 0;
+		int numRead = sscanf(line,
+							 " {\"mesh\":\"%63[^\"]\",\"points\":%u,\"frames\":%u,\"stages\":%u,"
+							 "\"meanFrameMs\":%lf,\"p50FrameMs\":%lf,\"p99FrameMs\":%lf,\"maxFrameMs\":%lf,"
+							 "\"pointsPerSecond\":%lf,\"checksum\":\"%llx\"",
+							 result.mesh,
+							 &result.numPoints,
+							 &result.numFrames,
+							 &result.numStages,
+							 &result.meanFrameMs,
+							 &result.p50FrameMs,
+							 &result.p99FrameMs,
+							 &result.maxFrameMs,
+							 &result.pointsPerSecond,
+							 &checksum);
+		if (numRead == 10) {
+			result.checksum = (uint64_t)checksum;
+			++numResults;
+		}
+	}
+	fclose(file);
+
+	return (int)numResults;
+}
+
+static int writeReplayResults(const char *filename, const ReplayResult *results, unsigned int numResults)
+{
+	FILE *file = fopen(filename, "w");
+	if (!file) {
+		perror("Failed to open the output file!\n");
+		return -1;
+	}
+
+	fprintf(file, "[\n");
+	for (unsigned int i=0; i < numResults; ++i) {
+		const ReplayResult &result = results[i];
+		fprintf(file,
+				"{\"mesh\":\"%s\",\"points\":%u,\"frames\":%u,\"stages\":%u,"
+				"\"meanFrameMs\":%.4f,\"p50FrameMs\":%.4f,\"p99FrameMs\":%.4f,\"maxFrameMs\":%.4f,"
+				"\"pointsPerSecond\":%.1f,\"checksum\":\"%016llx\"}%s\n",
+				result.mesh,
+				result.numPoints,
+				result.numFrames,
+				result.numStages,
+				result.meanFrameMs,
+				result.p50FrameMs,
+				result.p99FrameMs,
+				result.maxFrameMs,
+				result.pointsPerSecond,
+				(unsigned long long)result.checksum,
+				i + 1 < numResults ? "," : "");
+	}
+	fprintf(file, "]\n");
+
+	return fclose(file) == 0 ? 0 : -1;
+}
+
+
+/**
+ * Compares the results against a baseline, printing every mesh whose checksum
+ * has changed or whose throughput has regressed past the threshold.
+ *
+ * @return		The number of failures, or ``-1`` if the baseline could not be read.
+ */
+static int checkReplayBaseline(const char *filename, const ReplayResult *results, unsigned int numResults, double threshold)
+{
+	ReplayResult *baseline = (ReplayResult *)malloc(sizeof(ReplayResult) * kMaxReplayMeshes);
+	int numBaseline = baseline ? readReplayResults(filename, baseline, kMaxReplayMeshes) : -1;
+	if (numBaseline < 0) {
+		free(baseline);
+		return -1;
+	}
+
+	int numFailures = 0;
+	for (unsigned int i=0; i < numResults; ++i) {
+		const ReplayResult &result = results[i];
+		for (int j=0; j < numBaseline; ++j) {
+			const ReplayResult &expected = baseline[j];
+			if (strcmp(result.mesh, expected.mesh) != 0
+				|| result.numFrames != expected.numFrames
+				|| result.numStages != expected.numStages) {
+				continue;
+			}
+			if (result.checksum != expected.checksum) {
+				printf("MISMATCH: %s has a checksum of %016llx instead of %016llx\n",
+					   result.mesh,
+					   (unsigned long long)result.checksum,
+					   (unsigned long long)expected.checksum);
+				++numFailures;
+			}
+			double ratio = result.pointsPerSecond > 0.0 ? expected.pointsPerSecond / result.pointsPerSecond : 0.0;
+			if (ratio > threshold) {
+				printf("REGRESSION: %s is %.2fx slower than the baseline (%.1f vs %.1f points/s)\n",
+					   result.mesh,
+					   ratio,
+					   result.pointsPerSecond,
+					   expected.pointsPerSecond);
+				++numFailures;
+			}
+			break;
+		}
+	}
+	free(baseline);
+
+	return numFailures;
+}
+
+
+int main(int argc, char **argv)
+{
+	const char *libraryPath = NULL;
+	const char *savePath = NULL;
+	const char *outputPath = NULL;
+	const char *baselinePath = NULL;
+	const char *tracePath = getenv(kDeformerTraceFileEnvVar);
+	double threshold = kReplayDefaultThreshold;
+	unsigned int numFrames = kReplayDefaultFrames;
+	bool trackAllocations = false;
+	unsigned int numShadowEvaluations = 0;
+
+	ReplayHostData host;
+	host.positions = NULL;
+	host.deformed = NULL;
+	host.worldMatrix = identityMat44();
+	host.numStages = 1;
+	host.envelope = kReplayDefaultEnvelope;
+	host.worldSpace = false;
+
+	ReplayMesh meshes[kMaxReplayMeshes];
+	unsigned int numMeshes = 0;
+	bool hasPointCounts = false;
+	bool isValid = true;
+
+	for (int i=1; i < argc && isValid; ++i) {
+		bool hasValue = i + 1 < argc;
+		if (strcmp(argv[i], "--library") == 0 && hasValue) {
+			libraryPath = argv[++i];
+		} else if (strcmp(argv[i], "--capture") == 0 && hasValue && numMeshes < kMaxReplayMeshes) {
+			ReplayMesh &mesh = meshes[numMeshes++];
+			const char *path = argv[++i];
+			const char *filename = strrchr(path, kPathDelimiter);
+			snprintf(mesh.name, kReplayNameLen, "%s", filename ? filename + 1 : path);
+			mesh.numPoints = mesh.numFrames = 0;
+			mesh.capturePath = path;
+		} else if (strcmp(argv[i], "--points") == 0 && hasValue) {
+			// NOTE: (sonictk) This takes a comma-separated list of point counts.
+			char *count = argv[++i];
+			while (*count != '\0' && isValid) {
+				char *end;
+				unsigned long numPoints = strtoul(count, &end, 10);
+				isValid = end != count && numPoints > 0 && numPoints <= UINT_MAX && numMeshes < kMaxReplayMeshes;
+				if (isValid) {
+					ReplayMesh &mesh = meshes[numMeshes++];
+					snprintf(mesh.name, kReplayNameLen, "grid-%lu", numPoints);
+					mesh.numPoints = (unsigned int)numPoints;
+					mesh.capturePath = NULL;
+				}
+				count = *end == ',' ? end + 1 : end;
+				isValid = isValid && (*end == ',' || *end == '\0');
+			}
+			hasPointCounts = true;
+		} else if (strcmp(argv[i], "--frames") == 0 && hasValue) {
+			numFrames = (unsigned int)atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--stages") == 0 && hasValue) {
+			host.numStages = (unsigned int)atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--envelope") == 0 && hasValue) {
+			host.envelope = (float)atof(argv[++i]);
+		} else if (strcmp(argv[i], "--world-space") == 0) {
+			host.worldSpace = true;
+		} else if (strcmp(argv[i], "--save") == 0 && hasValue) {
+			savePath = argv[++i];
+		} else if (strcmp(argv[i], "--output") == 0 && hasValue) {
+			outputPath = argv[++i];
+		} else if (strcmp(argv[i], "--baseline") == 0 && hasValue) {
+			baselinePath = argv[++i];
+		} else if (strcmp(argv[i], "--threshold") == 0 && hasValue) {
+			threshold = atof(argv[++i]);
+		} else if (strcmp(argv[i], "--trace") == 0 && hasValue) {
+			tracePath = argv[++i];
+		} else if (strcmp(argv[i], "--track-allocations") == 0) {
+			trackAllocations = true;
+		} else if (strcmp(argv[i], "--shadow") == 0 && hasValue) {
+			numShadowEvaluations = (unsigned int)atoi(argv[++i]);
+		} else {
+			isValid = false;
+		}
+	}
+	if (!isValid) {
+		fprintf(stderr,
+				"Usage: %s [--library <file>] [--capture <file>]... [--points <n>[,<n>...]] [--frames <n>]\n"
+				"       [--stages <n>] [--envelope <value>] [--world-space] [--save <file>] [--output <file>]\n"
+				"       [--baseline <file>] [--threshold <ratio>] [--trace <file>] [--track-allocations]\n"
+				"       [--shadow <n>]\n",
+				argv[0]);
+		return 2;
+	}
+	if (threshold < 1.0) {
+		fprintf(stderr, "The threshold must be at least 1.0!\n");
+		return 2;
+	}
+	if (host.numStages == 0 || host.numStages > kMaxFusedStages) {
+		fprintf(stderr, "The number of stages must be between 1 and %u!\n", kMaxFusedStages);
+		return 2;
+	}
+
+	if (numMeshes == 0) {
+		unsigned int numDefaults = sizeof(kReplayDefaultPointCounts) / sizeof(kReplayDefaultPointCounts[0]);
+		for (unsigned int i=0; i < numDefaults; ++i) {
+			ReplayMesh &mesh = meshes[numMeshes++];
+			snprintf(mesh.name, kReplayNameLen, "grid-%u", kReplayDefaultPointCounts[i]);
+			mesh.numPoints = kReplayDefaultPointCounts[i];
+			mesh.capturePath = NULL;
+		}
+		hasPointCounts = true;
+	}
+	for (unsigned int i=0; i < numMeshes; ++i) {
+		if (!meshes[i].capturePath) {
+			meshes[i].numFrames = numFrames;
+		}
+	}
+	if (savePath && (numMeshes != 1 || !hasPointCounts)) {
+		fprintf(stderr, "--save records a single generated mesh, so it needs exactly one point count!\n");
+		return 2;
+	}
+
+	// NOTE: (sonictk) Just like the plugin, the logic library is expected to be next
+	// to the executable unless told otherwise.
+	if (libraryPath) {
+		snprintf(kPluginLogicLibraryPath, kMaxPathLen, "%s", libraryPath);
+	} else {
+		char appPath[kMaxPathLen] = {};
+		char appDir[kMaxPathLen] = {};
+		if (getAppPath(appPath, kMaxPathLen - 1) < 0
+			|| getDirPath(appPath, appDir) < 0
+			|| getDeformerLogicLibraryPath(appDir, kPluginLogicLibraryPath, kMaxPathLen) != 0) {
+			fprintf(stderr, "Could not find the logic library; pass it with --library.\n");
+			return 2;
+		}
+	}
+
+	// NOTE: (sonictk) Like the plugin, a trace can also be requested through the
+	// environment, so the same setup works for both.
+	snprintf(kPluginTraceFilePath, kMaxPathLen, "%s", tracePath ? tracePath : "");
+
+	initializeSIMDKernels();
+	initializeProfiler();
+	setProfilerEnabled(kPluginTraceFilePath[0] != '\0');
+
+	setDeformerLogicShadowEvaluations(numShadowEvaluations);
+
+	unsigned int numReloads = 0;
+	uint64_t reloadTicks = 0;
+	if (updateDeformerLogicDLL(kLogicLibrary, numReloads, reloadTicks) != LibraryStatus_Success) {
+		fprintf(stderr, "Failed to load the logic library: %s\n", kPluginLogicLibraryPath);
+		shutdownProfiler();
+		return 2;
+	}
+	if (trackAllocations && setDeformerLogicAllocationTracking(kLogicLibrary, true) != 0) {
+		fprintf(stderr, "Unable to track the allocations of the logic library on this platform!\n");
+		unloadDeformerLogicDLL(kLogicLibrary);
+		shutdownProfiler();
+		return 2;
+	}
+	printf("Using ssmath kernels for: %s\n", getSIMDKernelTableName(kSIMDKernels));
+	printf("%-24s %10s %7s %10s %10s %10s %14s %18s\n",
+		   "Mesh", "Points", "Frames", "Mean ms", "p50 ms", "p99 ms", "Points/s", "Checksum");
+
+	ReplayResult results[kMaxReplayMeshes];
+	unsigned int numResults = 0;
+	int exitCode = 0;
+	for (unsigned int i=0; i < numMeshes; ++i) {
+		ReplayResult &result = results[numResults];
+		if (replayMesh(meshes[i], host, savePath, result) != 0) {
+			exitCode = 2;
+			continue;
+		}
+		++numResults;
+		printf("%-24s %10u %7u %10.3f %10.3f %10.3f %14.1f   %016llx\n",
+			   result.mesh,
+			   result.numPoints,
+			   result.numFrames,
+			   result.meanFrameMs,
+			   result.p50FrameMs,
+			   result.p99FrameMs,
+			   result.pointsPerSecond,
+			   (unsigned long long)result.checksum);
+		if (trackAllocations) {
+			const AllocationCounts &allocations = result.logicAllocations;
+			double numEvaluations = result.numFrames > 0 ? (double)result.numFrames : 1.0;
+			double numPoints = result.numPoints > 0 ? (double)result.numPoints * numEvaluations : 1.0;
+			printf("  logic allocations: %.4f per point (%.1f bytes), %.2f leaked per frame (%.1f bytes)\n",
+				   (double)allocations.allocations / numPoints,
+				   (double)allocations.allocatedBytes / numPoints,
+				   ((double)allocations.allocations - (double)allocations.frees) / numEvaluations,
+				   ((double)allocations.allocatedBytes - (double)allocations.freedBytes) / numEvaluations);
+		}
+	}
+
+	if (outputPath && writeReplayResults(outputPath, results, numResults) != 0) {
+		exitCode = 2;
+	}
+
+	if (baselinePath) {
+		int numFailures = checkReplayBaseline(baselinePath, results, numResults, threshold);
+		if (numFailures < 0) {
+			exitCode = 2;
+		} else {
+			printf("%d mismatch(es) or regression(s) past a threshold of %.2fx.\n", numFailures, threshold);
+			if (numFailures > 0 && exitCode == 0) {
+				exitCode = 1;
+			}
+		}
+	}
+
+	unloadDeformerLogicDLL(kLogicLibrary);
+	setDeformerLogicShadowEvaluations(0);
+	if (kPluginTraceFilePath[0] != '\0' && writeProfileTrace(kPluginTraceFilePath) < 0) {
+		fprintf(stderr, "Failed to write the trace: %s\n", kPluginTraceFilePath);
+		exitCode = 2;
+	}
+	shutdownProfiler();
+	shutdownDeformerStats();
+
+	return exitCode;
+}
@@ -0,0 +1,1297 @@
+/**
+ * @brief	Microbenchmarks for the ``ssmath`` kernels. This is a standalone executable
+ * 		that does not need Maya.
+ *
+ * 		Every scalar function is timed once. Every batched kernel is timed for
+ * 		each instruction set that the CPU supports, and each variant's output is
+ * 		compared against the scalar variant's output to catch accuracy changes
+ * 		(e.g. from FMA contraction). Kernels that trade accuracy for speed are
+ * 		also compared against the exact kernel at the same instruction set.
+ * 		The timings of the operations that exist for both ``Vec3`` and ``Vec3A``
+ * 		are then listed side by side.
+ *
+ * 		Usage: ssmath_bench [--output <file>] [--baseline <file>] [--threshold <ratio>]
+ * 						[--filter <substring>]
+ *
+ * 		``--output`` writes the results as JSON, with one result per line. A
+ * 		results file can then be passed to ``--baseline`` on a later run, which
+ * 		fails (with an exit code of ``1``) if any kernel has become slower than
+ * 		its baseline time multiplied by ``--threshold`` (``1.25`` by default).
+ * 		Baselines are only meaningful on the machine that they were recorded on.
+ */
+#include <ssmath/platform.h>
+#include <ssmath/simd_kernels.h>
+#include <ssmath/expression_math.h>
+#include <ssmath/common_math.h>
+
+#include <ssmath/instrset.cpp>
+#include <ssmath/matrix_math.cpp>
+
+#include <math.h>
+#include <string.h>
+
+
+/// The number of elements that each kernel processes per call. This keeps the
+/// working set of the widest kernel inside the L2 cache, so that the benchmarks
+/// measure the kernels rather than memory bandwidth.
+static const unsigned int kBenchNumElements = 4096;
+
+/// Each benchmark is repeated for this many trials, and the fastest is reported.
+static const unsigned int kBenchNumTrials = 5;
+
+/// Each trial calls the kernel for at least this long.
+static const double kBenchMinTrialSeconds = 0.01;
+
+static const double kBenchDefaultThreshold = 1.25;
+
+static const unsigned int kMaxBenchResults = 512;
+static const unsigned int kBenchNameLen = 64;
+
+/// The most floats that any kernel writes per element (see ``copyBenchOutput``).
+static const unsigned int kBenchMaxOutputFloats = 25;
+
+/// The dimension of the ``MatX`` matrices, which is past the sizes that are
+/// specialized so that the LU decomposition is measured.
+static const int kBenchMatXDimension = 5;
+
+typedef MatX<float, kBenchMatXDimension, kBenchMatXDimension> BenchMatX;
+
+/// The number of dependent operations in each of the ``Vec3``/``Vec3A`` chains,
+/// where every operation takes the result of the one before it.
+static const unsigned int kBenchChainLength = 8;
+
+
+/// The inputs and outputs that the kernels are run over. Every kernel reads from
+/// the inputs and writes to one of the outputs, and never modifies the inputs.
+struct BenchData
+{
+	unsigned int count;
+
+	Vec3 *points;
+	Vec3 *pointsOut;
+	Mat44 *matrices;
+	Mat44 *matricesOut;
+	Quat *rotations;
+	float *scalarsOut;
+
+	Vec3Stream a;
+	Vec3Stream b;
+	Vec3Stream vecOut;
+	Vec3Stream temp;				/// The intermediate results of the operator-style chains.
+	Vec3Stream temp2;
+	FloatStream values;
+	FloatStream floatOut;
+	FloatStream floatOut2;
+	FloatStream weights[4];
+
+	QuatStream quatsA;
+	QuatStream quatsB;
+	QuatStream quatOut;
+	uint16_t *halves;
+
+	BenchMatX *matricesX;
+	BenchMatX *matricesXOut;
+	float **rowsX;					/// The rows of ``matricesX``, ``kBenchMatXDimension`` per matrix.
+
+	PointCache pointCache;			/// A keyframe of ``a`` and a frame of small deltas from it.
+	PointCacheDecoder pointCacheDecoder;
+
+	Mat44 transform;
+	Quat rotation;
+	DualQuat transforms[4];
+	NoiseSettings noise[NoiseType_Count];
+};
+
+
+/// Which of the outputs of ``BenchData`` a kernel writes to, so that the outputs of
+/// the different variants can be compared.
+enum BenchOutput
+{
+	BenchOutput_Points,
+	BenchOutput_Matrices,
+	BenchOutput_Scalars,
+	BenchOutput_Vec3Stream,
+	BenchOutput_FloatStream,
+	BenchOutput_QuatStream,
+	BenchOutput_Halves,
+	BenchOutput_MatricesX
+};
+
+/// Whether a kernel is run once, or for each variant of the kernel table.
+enum BenchVariants
+{
+	BenchVariants_Scalar,
+	BenchVariants_Table
+};
+
+typedef void (*BenchFunc)(BenchData &data, const SIMDKernelTable &table);
+
+struct BenchCase
+{
+	const char *name;
+	BenchFunc func;
+	BenchVariants variants;
+	BenchOutput output;
+	/// If not ``NULL``, the exact version of an approximate kernel, which writes
+	/// to the same output. Its error is reported alongside the timings.
+	BenchFunc exact;
+};
+
+struct BenchVariant
+{
+	const char *name;
+	int level;
+	bool useFMA;
+};
+
+struct BenchResult
+{
+	char kernel[kBenchNameLen];
+	char variant[kBenchNameLen];
+	double nsPerElement;
+	double maxDiff;
+	double maxError;	/// The error against the exact kernel, or ``-1`` if there is none.
+};
+
+
+static inline Quat normalizedQuat(float x, float y, float z, float w)
+{
+	float len = sqrtf((x * x) + (y * y) + (z * z) + (w * w));
+	return vec4(x / len, y / len, z / len, w / len);
+}
+
+static inline float randomBenchValue(float min, float max)
+{
+	return min + ((max - min) * ((float)rand() / (float)RAND_MAX));
+}
+
+
+/// The ``Vec3`` version of ``rotateBy`` from before it was evaluated on ``Vec3A``;
+/// every product loads its operands from and stores its result to memory. This is
+/// only kept as the reference that ``rotateBy(Vec3A, Vec4A)`` is measured against.
+static inline Vec3 rotateByLoadSpill(Vec3 v, Quat rotation)
+{
+	Vec3 axis = vec3(rotation.x, rotation.y, rotation.z);
+	float scalar = rotation.w;
+
+	Vec3 result =
+		(2.0f * innerProduct(axis, v) * axis) +
+		(((scalar * scalar) - innerProduct(axis, axis)) * v) +
+		(2.0f * scalar * crossProduct(axis, v));
+
+	return result;
+}
+
+
+/**
+ * Allocates and fills the inputs of the benchmarks. The inputs are random, but the
+ * same on every run.
+ *
+ * @param data		The data to initialize.
+ * @param count	The number of elements.
+ *
+ * @return			``0`` on success, ``-1`` if an allocation failed.
+ */
+static int initializeBenchData(BenchData &data, unsigned int count)
+{
+	memset(&data, 0, sizeof(BenchData));
+	data.count = count;
+
+	data.points = (Vec3 *)allocateAligned(sizeof(Vec3) * count);
+	data.pointsOut = (Vec3 *)allocateAligned(sizeof(Vec3) * count);
+	data.matrices = (Mat44 *)allocateAligned(sizeof(Mat44) * count);
+	data.matricesOut = (Mat44 *)allocateAligned(sizeof(Mat44) * count);
+	data.rotations = (Quat *)allocateAligned(sizeof(Quat) * count);
+	data.scalarsOut = (float *)allocateAligned(sizeof(float) * count);
+	data.halves = (uint16_t *)allocateAligned(sizeof(uint16_t) * padSIMDCount(count));
+	data.matricesX = (BenchMatX *)allocateAligned(sizeof(BenchMatX) * count);
+	data.matricesXOut = (BenchMatX *)allocateAligned(sizeof(BenchMatX) * count);
+	data.rowsX = (float **)malloc(sizeof(float *) * count * kBenchMatXDimension);
+	if (!data.points || !data.pointsOut || !data.matrices || !data.matricesOut
+		|| !data.rotations || !data.scalarsOut || !data.halves
+		|| !data.matricesX || !data.matricesXOut || !data.rowsX) {
+		return -1;
+	}
+
+	if (allocateVec3Stream(data.a, count) != 0
+		|| allocateVec3Stream(data.b, count) != 0
+		|| allocateVec3Stream(data.vecOut, count) != 0
+		|| allocateVec3Stream(data.temp, count) != 0
+		|| allocateVec3Stream(data.temp2, count) != 0
+		|| allocateFloatStream(data.values, count) != 0
+		|| allocateFloatStream(data.floatOut, count) != 0
+		|| allocateFloatStream(data.floatOut2, count) != 0
+		|| allocateQuatStream(data.quatsA, count) != 0
+		|| allocateQuatStream(data.quatsB, count) != 0
+		|| allocateQuatStream(data.quatOut, count) != 0) {
+		return -1;
+	}
+	for (unsigned int i=0; i < 4; ++i) {
+		if (allocateFloatStream(data.weights[i], count) != 0) {
+			return -1;
+		}
+	}
+
+	srand(1);
+	for (unsigned int i=0; i < count; ++i) {
+		data.points[i] = vec3(randomBenchValue(-10.0f, 10.0f),
+							  randomBenchValue(-10.0f, 10.0f),
+							  randomBenchValue(-10.0f, 10.0f));
+
+		// NOTE: (sonictk) Rotations with a translation and a non-uniform scale,
+		// which are always invertible.
+		Quat q = normalizedQuat(randomBenchValue(-1.0f, 1.0f),
+								randomBenchValue(-1.0f, 1.0f),
+								randomBenchValue(-1.0f, 1.0f),
+								randomBenchValue(-1.0f, 1.0f));
+		Mat44 mat = rotateBy(identityMat44(), q);
+		for (int r=0; r < 3; ++r) {
+			float scale = randomBenchValue(0.5f, 2.0f);
+			for (int c=0; c < 3; ++c) {
+				mat[r][c] *= scale;
+			}
+			mat[r][3] = randomBenchValue(-5.0f, 5.0f);
+		}
+		data.matrices[i] = mat;
+		data.rotations[i] = q;
+
+		// NOTE: (sonictk) The same matrix with an extra dimension that mixes into
+		// every row, so that the LU decomposition has to pivot.
+		BenchMatX &matX = data.matricesX[i];
+		for (int r=0; r < kBenchMatXDimension; ++r) {
+			for (int c=0; c < kBenchMatXDimension; ++c) {
+				matX[r][c] = r < 4 && c < 4 ? mat[r][c] : randomBenchValue(-1.0f, 1.0f);
+			}
+			data.rowsX[(i * kBenchMatXDimension) + r] = matX[r];
+		}
+		matX[4][4] = randomBenchValue(2.0f, 4.0f);
+
+		data.quatsA.x[i] = q.x;
+		data.quatsA.y[i] = q.y;
+		data.quatsA.z[i] = q.z;
+		data.quatsA.w[i] = q.w;
+
+		data.a.x[i] = randomBenchValue(-10.0f, 10.0f);
+		data.a.y[i] = randomBenchValue(-10.0f, 10.0f);
+		data.a.z[i] = randomBenchValue(-10.0f, 10.0f);
+		data.b.x[i] = randomBenchValue(-10.0f, 10.0f);
+		data.b.y[i] = randomBenchValue(-10.0f, 10.0f);
+		data.b.z[i] = randomBenchValue(-10.0f, 10.0f);
+		data.values.e[i] = randomBenchValue(0.01f, 4.0f);
+
+		float total = 0.0f;
+		for (unsigned int j=0; j < 4; ++j) {
+			data.weights[j].e[i] = randomBenchValue(0.0f, 1.0f);
+			total += data.weights[j].e[i];
+		}
+		for (unsigned int j=0; j < 4; ++j) {
+			data.weights[j].e[i] /= total;
+		}
+	}
+
+	// NOTE: (sonictk) The padding of the streams is processed too, so it must hold
+	// valid values to keep denormals and NaNs out of the timings.
+	for (unsigned int i=count; i < data.a.capacity; ++i) {
+		data.a.x[i] = data.a.y[i] = data.a.z[i] = 1.0f;
+		data.b.x[i] = data.b.y[i] = data.b.z[i] = 1.0f;
+		data.values.e[i] = 1.0f;
+		for (unsigned int j=0; j < 4; ++j) {
+			data.weights[j].e[i] = 0.25f;
+		}
+		data.quatsA.x[i] = data.quatsA.y[i] = data.quatsA.z[i] = 0.0f;
+		data.quatsA.w[i] = 1.0f;
+	}
+
+	// NOTE: (sonictk) Interpolate towards the rotations in reverse, so that every
+	// pair is a different angle apart.
+	for (unsigned int i=0; i < data.quatsB.capacity; ++i) {
+		unsigned int j = i < count ? count - 1 - i : i;
+		data.quatsB.x[i] = data.quatsA.x[j];
+		data.quatsB.y[i] = data.quatsA.y[j];
+		data.quatsB.z[i] = data.quatsA.z[j];
+		data.quatsB.w[i] = data.quatsA.w[j];
+	}
+
+	encodeHalvesScalar(data.values.e, data.halves, padSIMDCount(count));
+
+	if (createPointCache(data.pointCache, count, pointCacheSettings(0.001f)) != 0
+		|| createPointCacheDecoder(data.pointCacheDecoder, data.pointCache) != 0
+		|| appendPointCacheFrame(data.pointCache, data.a) != 0) {
+		return -1;
+	}
+	for (unsigned int i=0; i < count; ++i) {
+		data.vecOut.x[i] = data.a.x[i] + (0.01f * data.b.x[i]);
+		data.vecOut.y[i] = data.a.y[i] + (0.01f * data.b.y[i]);
+		data.vecOut.z[i] = data.a.z[i] + (0.01f * data.b.z[i]);
+	}
+	if (appendPointCacheFrame(data.pointCache, data.vecOut) != 0) {
+		return -1;
+	}
+
+	data.transform = data.matrices[0];
+	data.rotation = data.rotations[0];
+	for (unsigned int i=0; i < 4; ++i) {
+		data.transforms[i] = dualQuat(data.rotations[i + 1], data.points[i + 1]);
+	}
+	for (int i=0; i < NoiseType_Count; ++i) {
+		data.noise[i] = noiseSettings((NoiseType)i, 1);
+	}
+
+	return 0;
+}
+
+static void freeBenchData(BenchData &data)
+{
+	freeAligned(data.points);
+	freeAligned(data.pointsOut);
+	freeAligned(data.matrices);
+	freeAligned(data.matricesOut);
+	freeAligned(data.rotations);
+	freeAligned(data.scalarsOut);
+	freeAligned(data.halves);
+	freeAligned(data.matricesX);
+	freeAligned(data.matricesXOut);
+	free(data.rowsX);
+
+	freeVec3Stream(data.a);
+	freeVec3Stream(data.b);
+	freeVec3Stream(data.vecOut);
+	freeVec3Stream(data.temp);
+	freeVec3Stream(data.temp2);
+	freeFloatStream(data.values);
+	freeFloatStream(data.floatOut);
+	freeFloatStream(data.floatOut2);
+	for (unsigned int i=0; i < 4; ++i) {
+		freeFloatStream(data.weights[i]);
+	}
+	freeQuatStream(data.quatsA);
+	freeQuatStream(data.quatsB);
+	freeQuatStream(data.quatOut);
+
+	freePointCacheDecoder(data.pointCacheDecoder);
+	freePointCache(data.pointCache);
+}
+
+
+// ---------------------------------------------------------------------------------
+// Scalar functions
+// ---------------------------------------------------------------------------------
+
+static void benchCrossProduct(BenchData &data, const SIMDKernelTable &)
+{
+	for (unsigned int i=0; i < data.count; ++i) {
+		data.pointsOut[i] = crossProduct(data.points[i], data.points[data.count - 1 - i]);
+	}
+}
+
+static void benchInnerProduct(BenchData &data, const SIMDKernelTable &)
+{
+	for (unsigned int i=0; i < data.count; ++i) {
+		data.scalarsOut[i] = innerProduct(data.points[i], data.points[data.count - 1 - i]);
+	}
+}
+
+static void benchNormalize(BenchData &data, const SIMDKernelTable &)
+{
+	for (unsigned int i=0; i < data.count; ++i) {
+		data.pointsOut[i] = normalize(data.points[i]);
+	}
+}
+
+static void benchRotateVec3(BenchData &data, const SIMDKernelTable &)
+{
+	for (unsigned int i=0; i < data.count; ++i) {
+		data.pointsOut[i] = rotateByLoadSpill(data.points[i], data.rotations[i]);
+	}
+}
+
+static void benchCrossProductAligned(BenchData &data, const SIMDKernelTable &)
+{
+	for (unsigned int i=0; i < data.count; ++i) {
+		data.pointsOut[i] = toVec3(crossProduct(vec3a(data.points[i]), vec3a(data.points[data.count - 1 - i])));
+	}
+}
+
+static void benchInnerProductAligned(BenchData &data, const SIMDKernelTable &)
+{
+	for (unsigned int i=0; i < data.count; ++i) {
+		data.scalarsOut[i] = innerProduct(vec3a(data.points[i]), vec3a(data.points[data.count - 1 - i]));
+	}
+}
+
+static void benchNormalizeAligned(BenchData &data, const SIMDKernelTable &)
+{
+	for (unsigned int i=0; i < data.count; ++i) {
+		data.pointsOut[i] = toVec3(normalize(vec3a(data.points[i])));
+	}
+}
+
+static void benchRotateVec3Aligned(BenchData &data, const SIMDKernelTable &)
+{
+	for (unsigned int i=0; i < data.count; ++i) {
+		data.pointsOut[i] = toVec3(rotateBy(vec3a(data.points[i]), vec4a(data.rotations[i])));
+	}
+}
+
+// NOTE: (sonictk) The chains feed every result into the next operation, which is
+// where keeping the values in registers should pay off. The cross and dot chains
+// work against a unit vector so that the values neither grow nor vanish.
+static void benchRotateChain(BenchData &data, const SIMDKernelTable &)
+{
+	for (unsigned int i=0; i < data.count; ++i) {
+		Vec3 p = data.points[i];
+		for (unsigned int k=0; k < kBenchChainLength; ++k) {
+			p = rotateByLoadSpill(p, data.rotations[i]);
+		}
+		data.pointsOut[i] = p;
+	}
+}
+
+static void benchCrossProductChain(BenchData &data, const SIMDKernelTable &)
+{
+	for (unsigned int i=0; i < data.count; ++i) {
+		Vec3 p = data.points[i];
+		Vec3 axis = normalize(data.points[data.count - 1 - i]);
+		for (unsigned int k=0; k < kBenchChainLength; ++k) {
+			p = crossProduct(p, axis) + axis;
+		}
+		data.pointsOut[i] = p;
+	}
+}
+
+static void benchInnerProductChain(BenchData &data, const SIMDKernelTable &)
+{
+	for (unsigned int i=0; i < data.count; ++i) {
+		Vec3 p = data.points[i];
+		Vec3 axis = normalize(data.points[data.count - 1 - i]);
+		for (unsigned int k=0; k < kBenchChainLength; ++k) {
+			p = (p - (innerProduct(p, axis) * axis)) + axis;
+		}
+		data.pointsOut[i] = p;
+	}
+}
+
+static void benchRotateChainAligned(BenchData &data, const SIMDKernelTable &)
+{
+	for (unsigned int i=0; i < data.count; ++i) {
+		Vec3A p = vec3a(data.points[i]);
+		Vec4A rotation = vec4a(data.rotations[i]);
+		for (unsigned int k=0; k < kBenchChainLength; ++k) {
+			p = rotateBy(p, rotation);
+		}
+		data.pointsOut[i] = toVec3(p);
+	}
+}
+
+static void benchCrossProductChainAligned(BenchData &data, const SIMDKernelTable &)
+{
+	for (unsigned int i=0; i < data.count; ++i) {
+		Vec3A p = vec3a(data.points[i]);
+		Vec3A axis = normalize(vec3a(data.points[data.count - 1 - i]));
+		for (unsigned int k=0; k < kBenchChainLength; ++k) {
+			p = crossProduct(p, axis) + axis;
+		}
+		data.pointsOut[i] = toVec3(p);
+	}
+}
+
+static void benchInnerProductChainAligned(BenchData &data, const SIMDKernelTable &)
+{
+	for (unsigned int i=0; i < data.count; ++i) {
+		Vec3A p = vec3a(data.points[i]);
+		Vec3A axis = normalize(vec3a(data.points[data.count - 1 - i]));
+		for (unsigned int k=0; k < kBenchChainLength; ++k) {
+			p = (p - (innerProduct(p, axis) * axis)) + axis;
+		}
+		data.pointsOut[i] = toVec3(p);
+	}
+}
+
+static void benchMultiplyMat44(BenchData &data, const SIMDKernelTable &)
+{
+	for (unsigned int i=0; i < data.count; ++i) {
+		data.matricesOut[i] = data.matrices[i] * data.matrices[data.count - 1 - i];
+	}
+}
+
+static void benchDeterminant(BenchData &data, const SIMDKernelTable &)
+{
+	for (unsigned int i=0; i < data.count; ++i) {
+		data.scalarsOut[i] = determinant(data.matrices[i]);
+	}
+}
+
+static void benchInverse(BenchData &data, const SIMDKernelTable &)
+{
+	for (unsigned int i=0; i < data.count; ++i) {
+		inverse(data.matrices[i], data.matricesOut[i]);
+	}
+}
+
+static void benchInverseScalar(BenchData &data, const SIMDKernelTable &)
+{
+	for (unsigned int i=0; i < data.count; ++i) {
+		inverseScalar(data.matrices[i], data.matricesOut[i]);
+	}
+}
+
+static void benchInverseAffine(BenchData &data, const SIMDKernelTable &)
+{
+	for (unsigned int i=0; i < data.count; ++i) {
+		inverseAffine(data.matrices[i], data.matricesOut[i]);
+	}
+}
+
+static void benchRotateMat44(BenchData &data, const SIMDKernelTable &)
+{
+	for (unsigned int i=0; i < data.count; ++i) {
+		data.matricesOut[i] = rotateBy(data.matrices[i], data.points[i], 0.5f);
+	}
+}
+
+static void benchInverseMatX(BenchData &data, const SIMDKernelTable &)
+{
+	for (unsigned int i=0; i < data.count; ++i) {
+		inverse(data.matricesX[i], data.matricesXOut[i]);
+	}
+}
+
+static void benchDeterminantMatX(BenchData &data, const SIMDKernelTable &)
+{
+	for (unsigned int i=0; i < data.count; ++i) {
+		data.scalarsOut[i] = determinant(data.matricesX[i]);
+	}
+}
+
+static void benchDeterminantPointers(BenchData &data, const SIMDKernelTable &)
+{
+	for (unsigned int i=0; i < data.count; ++i) {
+		data.scalarsOut[i] = determinant(data.rowsX + (i * kBenchMatXDimension), kBenchMatXDimension);
+	}
+}
+
+static void benchGradientNoise(BenchData &data, const SIMDKernelTable &)
+{
+	for (unsigned int i=0; i < data.count; ++i) {
+		data.scalarsOut[i] = gradientNoise(data.points[i].x, data.points[i].y, data.points[i].z, 1);
+	}
+}
+
+static void benchSimplexNoise(BenchData &data, const SIMDKernelTable &)
+{
+	for (unsigned int i=0; i < data.count; ++i) {
+		data.scalarsOut[i] = simplexNoise(data.points[i].x, data.points[i].y, data.points[i].z, 1);
+	}
+}
+
+static void benchRandomFloat(BenchData &data, const SIMDKernelTable &)
+{
+	for (unsigned int i=0; i < data.count; ++i) {
+		data.scalarsOut[i] = randomFloat(1, i);
+	}
+}
+
+static void benchNextRandomFloat(BenchData &data, const SIMDKernelTable &)
+{
+	RandomState state;
+	seedRandomState(state, 1, 0);
+	for (unsigned int i=0; i < data.count; ++i) {
+		data.scalarsOut[i] = nextRandomFloat(state);
+	}
+}
+
+static void benchFloatToHalf(BenchData &data, const SIMDKernelTable &)
+{
+	encodeHalvesScalar(data.values.e, data.halves, data.count);
+}
+
+static void benchHalfToFloat(BenchData &data, const SIMDKernelTable &)
+{
+	decodeHalvesScalar(data.halves, data.floatOut.e, data.count);
+}
+
+
+// ---------------------------------------------------------------------------------
+// Batched kernels
+// ---------------------------------------------------------------------------------
+
+static void benchCrossProductStreams(BenchData &data, const SIMDKernelTable &table)
+{
+	table.crossProductStreams(data.a, data.b, data.vecOut);
+}
+
+static void benchInnerProductStreams(BenchData &data, const SIMDKernelTable &table)
+{
+	table.innerProductStreams(data.a, data.b, data.floatOut);
+}
+
+// NOTE: (sonictk) Each expression is paired with the same chain written one
+// operation at a time, which writes every intermediate result to a stream. Both
+// use the packet type of the compile-time instruction set.
+static void benchLerpExpression(BenchData &data, const SIMDKernelTable &)
+{
+	assign(data.vecOut, lerp(data.a, 0.25f, data.b));
+}
+
+static void benchLerpOperators(BenchData &data, const SIMDKernelTable &)
+{
+	scaleStreamKernel<SIMDFloat>(data.a, 0.75f, data.temp);
+	scaleStreamKernel<SIMDFloat>(data.b, 0.25f, data.temp2);
+	addStreamsKernel<SIMDFloat>(data.temp, data.temp2, data.vecOut);
+}
+
+static void benchNormalizedCrossExpression(BenchData &data, const SIMDKernelTable &)
+{
+	assign(data.vecOut, normalize(crossProduct(data.a, data.b)) + data.a);
+}
+
+static void benchNormalizedCrossOperators(BenchData &data, const SIMDKernelTable &)
+{
+	crossProductStreamsKernel<SIMDFloat>(data.a, data.b, data.temp);
+	normalizeStreamKernel<SIMDFloat>(data.temp, data.temp2);
+	addStreamsKernel<SIMDFloat>(data.temp2, data.a, data.vecOut);
+}
+
+static void benchDistanceExpression(BenchData &data, const SIMDKernelTable &)
+{
+	assign(data.floatOut, length(data.a - data.b));
+}
+
+static void benchDistanceOperators(BenchData &data, const SIMDKernelTable &)
+{
+	subtractStreamsKernel<SIMDFloat>(data.a, data.b, data.temp);
+	lengthStreamKernel<SIMDFloat>(data.temp, data.floatOut);
+}
+
+static void benchLerpMatXExpression(BenchData &data, const SIMDKernelTable &)
+{
+	for (unsigned int i=0; i < data.count; ++i) {
+		assign(data.matricesXOut[i], lerp(data.matricesX[i], 0.25f, data.matricesX[data.count - 1 - i]));
+	}
+}
+
+static void benchLerpMatXOperators(BenchData &data, const SIMDKernelTable &)
+{
+	for (unsigned int i=0; i < data.count; ++i) {
+		BenchMatX a = evaluate(data.matricesX[i] * 0.75f);
+		BenchMatX b = evaluate(data.matricesX[data.count - 1 - i] * 0.25f);
+		data.matricesXOut[i] = evaluate(a + b);
+	}
+}
+
+static void benchMultiplyMat44Array(BenchData &data, const SIMDKernelTable &table)
+{
+	table.multiplyMat44Array(data.matrices, data.matrices, data.matricesOut, data.count);
+}
+
+static void benchMultiplyMat44ArrayBroadcast(BenchData &data, const SIMDKernelTable &table)
+{
+	table.multiplyMat44ArrayBroadcast(data.transform, data.matrices, data.matricesOut, data.count);
+}
+
+static void benchInverseMat44Array(BenchData &data, const SIMDKernelTable &table)
+{
+	int result = 0;
+	table.inverseMat44Array(data.matrices, data.matricesOut, data.count, result);
+}
+
+static void benchInverseAffineMat44Array(BenchData &data, const SIMDKernelTable &table)
+{
+	int result = 0;
+	table.inverseAffineMat44Array(data.matrices, data.matricesOut, data.count, result);
+}
+
+static void benchBuildEulerRotationMatricesXYZ(BenchData &data, const SIMDKernelTable &table)
+{
+	table.buildEulerRotationMatrices[kXYZ](data.a, data.matricesOut);
+}
+
+static void benchBuildEulerRotationMatricesZYX(BenchData &data, const SIMDKernelTable &table)
+{
+	table.buildEulerRotationMatrices[kZYX](data.a, data.matricesOut);
+}
+
+static void benchTransformPoints(BenchData &data, const SIMDKernelTable &table)
+{
+	memcpy(data.pointsOut, data.points, sizeof(Vec3) * data.count);
+	table.transformPoints(data.transform, data.pointsOut, data.count);
+}
+
+static void benchTransformStream(BenchData &data, const SIMDKernelTable &table)
+{
+	table.transformStream(data.transform, data.a, data.vecOut);
+}
+
+static void benchLerpStreams(BenchData &data, const SIMDKernelTable &table)
+{
+	table.lerpStreams(data.a, 0.25f, data.b, data.vecOut);
+}
+
+static void benchLengthStream(BenchData &data, const SIMDKernelTable &table)
+{
+	table.lengthStream[PrecisionMode_Exact](data.a, data.floatOut);
+}
+
+static void benchNormalizeStream(BenchData &data, const SIMDKernelTable &table)
+{
+	table.normalizeStream[PrecisionMode_Exact](data.a, data.vecOut);
+}
+
+static void benchNormalizeStreamFast(BenchData &data, const SIMDKernelTable &table)
+{
+	table.normalizeStream[PrecisionMode_Fast](data.a, data.vecOut);
+}
+
+static void benchNormalizeStreamRefined(BenchData &data, const SIMDKernelTable &table)
+{
+	table.normalizeStream[PrecisionMode_Refined](data.a, data.vecOut);
+}
+
+static void benchLengthStreamRefined(BenchData &data, const SIMDKernelTable &table)
+{
+	table.lengthStream[PrecisionMode_Refined](data.a, data.floatOut);
+}
+
+static void benchLengthStreamFast(BenchData &data, const SIMDKernelTable &table)
+{
+	table.lengthStream[PrecisionMode_Fast](data.a, data.floatOut);
+}
+
+static void benchRotateStream(BenchData &data, const SIMDKernelTable &table)
+{
+	table.rotateStream(data.rotation, data.a, data.vecOut);
+}
+
+static void benchBlendDualQuaternions(BenchData &data, const SIMDKernelTable &table)
+{
+	table.blendDualQuaternions(data.transforms, data.weights, 4, data.a, data.vecOut);
+}
+
+static void benchNlerpQuatStreams(BenchData &data, const SIMDKernelTable &table)
+{
+	table.nlerpQuatStreams(data.quatsA, 0.3f, data.quatsB, data.quatOut);
+}
+
+static void benchSlerpQuatStreams(BenchData &data, const SIMDKernelTable &table)
+{
+	table.slerpQuatStreams(data.quatsA, 0.3f, data.quatsB, data.quatOut);
+}
+
+static void benchSineStream(BenchData &data, const SIMDKernelTable &table)
+{
+	table.sineStream(data.values, data.floatOut);
+}
+
+static void benchSinCosStream(BenchData &data, const SIMDKernelTable &table)
+{
+	table.sinCosStream(data.values, data.floatOut, data.floatOut2);
+}
+
+static void benchExponentialStream(BenchData &data, const SIMDKernelTable &table)
+{
+	table.exponentialStream(data.values, data.floatOut);
+}
+
+static void benchLogarithmStream(BenchData &data, const SIMDKernelTable &table)
+{
+	table.logarithmStream(data.values, data.floatOut);
+}
+
+static void benchPowerStream(BenchData &data, const SIMDKernelTable &table)
+{
+	table.powerStream(data.values, 2.2f, data.floatOut);
+}
+
+static void benchGradientNoiseStream(BenchData &data, const SIMDKernelTable &table)
+{
+	table.noiseStream[NoiseType_Gradient](data.a, data.noise[NoiseType_Gradient], data.floatOut);
+}
+
+static void benchSimplexNoiseStream(BenchData &data, const SIMDKernelTable &table)
+{
+	table.noiseStream[NoiseType_Simplex](data.a, data.noise[NoiseType_Simplex], data.floatOut);
+}
+
+static void benchFillRandomStream(BenchData &data, const SIMDKernelTable &table)
+{
+	table.fillRandomFloatStream(data.floatOut, 1, 0, 0.0f, 1.0f);
+}
+
+static void benchEncodeHalves(BenchData &data, const SIMDKernelTable &table)
+{
+	table.encodeHalves(data.values.e, data.halves, padSIMDCount(data.count));
+}
+
+static void benchDecodeHalves(BenchData &data, const SIMDKernelTable &table)
+{
+	table.decodeHalves(data.halves, data.floatOut.e, padSIMDCount(data.count));
+}
+
+static void benchDecodePointCacheFrame(BenchData &data, const SIMDKernelTable &table)
+{
+	// NOTE: (sonictk) The deltas are applied to the state of the keyframe, so both
+	// are decoded every call; this is the cost of the first two frames of playback.
+	table.decodePointCacheFrame(data.pointCache, 0, data.pointCacheDecoder, (Vec3Stream *)NULL);
+	table.decodePointCacheFrame(data.pointCache, 1, data.pointCacheDecoder, &data.vecOut);
+}
+
+
+static const BenchCase kBenchCases[] = {
+	{"crossProduct", benchCrossProduct, BenchVariants_Scalar, BenchOutput_Points},
+	{"innerProduct", benchInnerProduct, BenchVariants_Scalar, BenchOutput_Scalars},
+	{"normalize", benchNormalize, BenchVariants_Scalar, BenchOutput_Points},
+	{"rotateBy(Vec3, Quat)", benchRotateVec3, BenchVariants_Scalar, BenchOutput_Points},
+	{"crossProduct (Vec3A)", benchCrossProductAligned, BenchVariants_Scalar, BenchOutput_Points},
+	{"innerProduct (Vec3A)", benchInnerProductAligned, BenchVariants_Scalar, BenchOutput_Scalars},
+	{"normalize (Vec3A)", benchNormalizeAligned, BenchVariants_Scalar, BenchOutput_Points},
+	{"rotateBy(Vec3A, Vec4A)", benchRotateVec3Aligned, BenchVariants_Scalar, BenchOutput_Points},
+	{"rotateBy chain", benchRotateChain, BenchVariants_Scalar, BenchOutput_Points},
+	{"crossProduct chain", benchCrossProductChain, BenchVariants_Scalar, BenchOutput_Points},
+	{"innerProduct chain", benchInnerProductChain, BenchVariants_Scalar, BenchOutput_Points},
+	{"rotateBy chain (Vec3A)", benchRotateChainAligned, BenchVariants_Scalar, BenchOutput_Points},
+	{"crossProduct chain (Vec3A)", benchCrossProductChainAligned, BenchVariants_Scalar, BenchOutput_Points},
+	{"innerProduct chain (Vec3A)", benchInnerProductChainAligned, BenchVariants_Scalar, BenchOutput_Points},
+	{"Mat44 * Mat44", benchMultiplyMat44, BenchVariants_Scalar, BenchOutput_Matrices},
+	{"determinant(Mat44)", benchDeterminant, BenchVariants_Scalar, BenchOutput_Scalars},
+	{"inverse(Mat44)", benchInverse, BenchVariants_Scalar, BenchOutput_Matrices},
+	{"inverseScalar(Mat44)", benchInverseScalar, BenchVariants_Scalar, BenchOutput_Matrices},
+	{"inverseAffine(Mat44)", benchInverseAffine, BenchVariants_Scalar, BenchOutput_Matrices},
+	{"rotateBy(Mat44, axis, angle)", benchRotateMat44, BenchVariants_Scalar, BenchOutput_Matrices},
+	{"inverse(MatX<5, 5>)", benchInverseMatX, BenchVariants_Scalar, BenchOutput_MatricesX},
+	{"determinant(MatX<5, 5>)", benchDeterminantMatX, BenchVariants_Scalar, BenchOutput_Scalars},
+	{"determinant(float **, 5)", benchDeterminantPointers, BenchVariants_Scalar, BenchOutput_Scalars},
+	{"gradientNoise(x, y, z)", benchGradientNoise, BenchVariants_Scalar, BenchOutput_Scalars},
+	{"simplexNoise(x, y, z)", benchSimplexNoise, BenchVariants_Scalar, BenchOutput_Scalars},
+	{"randomFloat (hash)", benchRandomFloat, BenchVariants_Scalar, BenchOutput_Scalars},
+	{"nextRandomFloat (xoroshiro)", benchNextRandomFloat, BenchVariants_Scalar, BenchOutput_Scalars},
+	{"floatToHalf", benchFloatToHalf, BenchVariants_Scalar, BenchOutput_Halves},
+	{"halfToFloat", benchHalfToFloat, BenchVariants_Scalar, BenchOutput_FloatStream},
+
+	{"lerp (expression)", benchLerpExpression, BenchVariants_Scalar, BenchOutput_Vec3Stream},
+	{"lerp (operators)", benchLerpOperators, BenchVariants_Scalar, BenchOutput_Vec3Stream},
+	{"normalize(a x b) + a (expression)", benchNormalizedCrossExpression, BenchVariants_Scalar, BenchOutput_Vec3Stream},
+	{"normalize(a x b) + a (operators)", benchNormalizedCrossOperators, BenchVariants_Scalar, BenchOutput_Vec3Stream},
+	{"length(a - b) (expression)", benchDistanceExpression, BenchVariants_Scalar, BenchOutput_FloatStream},
+	{"length(a - b) (operators)", benchDistanceOperators, BenchVariants_Scalar, BenchOutput_FloatStream},
+	{"lerp(MatX<5, 5>) (expression)", benchLerpMatXExpression, BenchVariants_Scalar, BenchOutput_MatricesX},
+	{"lerp(MatX<5, 5>) (operators)", benchLerpMatXOperators, BenchVariants_Scalar, BenchOutput_MatricesX},
+
+	{"crossProductStreams", benchCrossProductStreams, BenchVariants_Table, BenchOutput_Vec3Stream},
+	{"innerProductStreams", benchInnerProductStreams, BenchVariants_Table, BenchOutput_FloatStream},
+	{"multiplyMat44Array", benchMultiplyMat44Array, BenchVariants_Table, BenchOutput_Matrices},
+	{"multiplyMat44Array (broadcast)", benchMultiplyMat44ArrayBroadcast, BenchVariants_Table, BenchOutput_Matrices},
+	{"inverseMat44Array", benchInverseMat44Array, BenchVariants_Table, BenchOutput_Matrices},
+	{"inverseAffineMat44Array", benchInverseAffineMat44Array, BenchVariants_Table, BenchOutput_Matrices},
+	{"buildEulerRotationMatrices (XYZ)", benchBuildEulerRotationMatricesXYZ, BenchVariants_Table, BenchOutput_Matrices},
+	{"buildEulerRotationMatrices (ZYX)", benchBuildEulerRotationMatricesZYX, BenchVariants_Table, BenchOutput_Matrices},
+	{"transformPoints", benchTransformPoints, BenchVariants_Table, BenchOutput_Points},
+	{"transformStream", benchTransformStream, BenchVariants_Table, BenchOutput_Vec3Stream},
+	{"lerpStreams", benchLerpStreams, BenchVariants_Table, BenchOutput_Vec3Stream},
+	{"lengthStream", benchLengthStream, BenchVariants_Table, BenchOutput_FloatStream},
+	{"lengthStream (Refined)", benchLengthStreamRefined, BenchVariants_Table, BenchOutput_FloatStream, benchLengthStream},
+	{"lengthStream (Fast)", benchLengthStreamFast, BenchVariants_Table, BenchOutput_FloatStream, benchLengthStream},
+	{"normalizeStream", benchNormalizeStream, BenchVariants_Table, BenchOutput_Vec3Stream},
+	{"normalizeStream (Refined)", benchNormalizeStreamRefined, BenchVariants_Table, BenchOutput_Vec3Stream, benchNormalizeStream},
+	{"normalizeStreamFast", benchNormalizeStreamFast, BenchVariants_Table, BenchOutput_Vec3Stream, benchNormalizeStream},
+	{"rotateStream", benchRotateStream, BenchVariants_Table, BenchOutput_Vec3Stream},
+	{"blendDualQuaternions (4)", benchBlendDualQuaternions, BenchVariants_Table, BenchOutput_Vec3Stream},
+	{"nlerpQuatStreams", benchNlerpQuatStreams, BenchVariants_Table, BenchOutput_QuatStream},
+	{"slerpQuatStreams", benchSlerpQuatStreams, BenchVariants_Table, BenchOutput_QuatStream},
+	{"sineStream", benchSineStream, BenchVariants_Table, BenchOutput_FloatStream},
+	{"sinCosStream", benchSinCosStream, BenchVariants_Table, BenchOutput_FloatStream},
+	{"exponentialStream", benchExponentialStream, BenchVariants_Table, BenchOutput_FloatStream},
+	{"logarithmStream", benchLogarithmStream, BenchVariants_Table, BenchOutput_FloatStream},
+	{"powerStream", benchPowerStream, BenchVariants_Table, BenchOutput_FloatStream},
+	{"noiseStream (gradient)", benchGradientNoiseStream, BenchVariants_Table, BenchOutput_FloatStream},
+	{"noiseStream (simplex)", benchSimplexNoiseStream, BenchVariants_Table, BenchOutput_FloatStream},
+	{"fillRandomStream", benchFillRandomStream, BenchVariants_Table, BenchOutput_FloatStream},
+	{"encodeHalves", benchEncodeHalves, BenchVariants_Table, BenchOutput_Halves},
+	{"decodeHalves", benchDecodeHalves, BenchVariants_Table, BenchOutput_FloatStream},
+	{"decodePointCacheFrame", benchDecodePointCacheFrame, BenchVariants_Table, BenchOutput_Vec3Stream}
+};
+
+
+/// A pair of cases that do the same work on ``Vec3`` and on ``Vec3A``, whose
+/// timings are reported side by side after all the cases have run.
+struct BenchComparison
+{
+	const char *name;
+	const char *vec3Case;
+	const char *vec3ACase;
+};
+
+static const BenchComparison kBenchComparisons[] = {
+	{"crossProduct", "crossProduct", "crossProduct (Vec3A)"},
+	{"innerProduct", "innerProduct", "innerProduct (Vec3A)"},
+	{"rotateBy", "rotateBy(Vec3, Quat)", "rotateBy(Vec3A, Vec4A)"},
+	{"crossProduct chain", "crossProduct chain", "crossProduct chain (Vec3A)"},
+	{"innerProduct chain", "innerProduct chain", "innerProduct chain (Vec3A)"},
+	{"rotateBy chain", "rotateBy chain", "rotateBy chain (Vec3A)"}
+};
+
+
+/**
+ * Copies the output that a kernel wrote to ``out``, so that it can be compared
+ * against the output of other variants.
+ *
+ * @return		The number of floats copied.
+ */
+static unsigned int copyBenchOutput(const BenchData &data, BenchOutput output, float *out)
+{
+	unsigned int count = data.count;
+	switch (output) {
+	case BenchOutput_Points:
+		memcpy(out, data.pointsOut, sizeof(Vec3) * count);
+		return count * 3;
+	case BenchOutput_Matrices:
+		memcpy(out, data.matricesOut, sizeof(Mat44) * count);
+		return count * 16;
+	case BenchOutput_Scalars:
+		memcpy(out, data.scalarsOut, sizeof(float) * count);
+		return count;
+	case BenchOutput_Vec3Stream:
+		memcpy(out, data.vecOut.x, sizeof(float) * count);
+		memcpy(out + count, data.vecOut.y, sizeof(float) * count);
+		memcpy(out + (count * 2), data.vecOut.z, sizeof(float) * count);
+		return count * 3;
+	case BenchOutput_FloatStream:
+		memcpy(out, data.floatOut.e, sizeof(float) * count);
+		return count;
+	case BenchOutput_QuatStream:
+		memcpy(out, data.quatOut.x, sizeof(float) * count);
+		memcpy(out + count, data.quatOut.y, sizeof(float) * count);
+		memcpy(out + (count * 2), data.quatOut.z, sizeof(float) * count);
+		memcpy(out + (count * 3), data.quatOut.w, sizeof(float) * count);
+		return count * 4;
+	case BenchOutput_Halves:
+		for (unsigned int i=0; i < count; ++i) {
+			out[i] = (float)data.halves[i];
+		}
+		return count;
+	case BenchOutput_MatricesX:
+		memcpy(out, data.matricesXOut, sizeof(BenchMatX) * count);
+		return count * kBenchMatXDimension * kBenchMatXDimension;
+	}
+
+	return 0;
+}
+
+
+/**
+ * Returns the largest error of ``output`` against ``exact``. The error is relative
+ * to the exact value, but absolute below a magnitude of ``1``, so that the
+ * components of unit vectors that are close to zero are not overstated.
+ */
+static double getBenchMaxError(const float *output, const float *exact, unsigned int numFloats)
+{
+	double maxError = 0.0;
+	for (unsigned int i=0; i < numFloats; ++i) {
+		double magnitude = fabs((double)exact[i]);
+		double error = fabs((double)output[i] - (double)exact[i]) / (magnitude > 1.0 ? magnitude : 1.0);
+		maxError = error > maxError ? error : maxError;
+	}
+
+	return maxError;
+}
+
+
+/**
+ * Times a kernel.
+ *
+ * @return		The time taken per element in nanoseconds, from the fastest trial.
+ */
+static double timeBenchCase(const BenchCase &benchCase, BenchData &data, const SIMDKernelTable &table)
+{
+	// NOTE: (sonictk) Warm up the caches and find how many calls fill a trial.
+	PerfTimer timer = perfTimer();
+	unsigned int numCalls = 1;
+	for (;;) {
+		startPerfTimer(timer);
+		for (unsigned int i=0; i < numCalls; ++i) {
+			benchCase.func(data, table);
+		}
+		endPerfTimer(timer);
+		if (getPerfTimerValue(timer) >= kBenchMinTrialSeconds) {
+			break;
+		}
+		numCalls *= 2;
+	}
+
+	double best = -1.0;
+	for (unsigned int trial=0; trial < kBenchNumTrials; ++trial) {
+		startPerfTimer(timer);
+		for (unsigned int i=0; i < numCalls; ++i) {
+			benchCase.func(data, table);
+		}
+		endPerfTimer(timer);
+
+		double seconds = getPerfTimerValue(timer);
+		if (best < 0.0 || seconds < best) {
+			best = seconds;
+		}
+	}
+
+	return (best * 1e9) / ((double)numCalls * (double)data.count);
+}
+
+
+/// Returns the result of the given kernel, or ``NULL`` if it was not run.
+static const BenchResult *findBenchResult(const BenchResult *results, unsigned int numResults, const char *kernel)
+{
+	for (unsigned int i=0; i < numResults; ++i) {
+		if (strcmp(results[i].kernel, kernel) == 0) {
+			return &results[i];
+		}
+	}
+
+	return NULL;
+}
+
+
+/**
+ * Reads a results file written by ``writeBenchResults``.
+ *
+ * @return		The number of results read, or ``-1`` if the file could not be read.
+ */
+static int readBenchResults(const char *filename, BenchResult *results, unsigned int maxResults)
+{
+	FILE *file = fopen(filename, "r");
+	if (!file) {
+		perror("Failed to open the baseline file!\n");
+		return -1;
+	}
+
+	unsigned int numResults = 0;
+	char line[512];
+	while (numResults < maxResults && fgets(line, sizeof(line), file)) {
+		BenchResult &result = results[numResults];
+		int numRead = sscanf(line,
+							 " {\"kernel\":\"%63[^\"]\",\"variant\":\"%63[^\"]\",\"nsPerElement\":%lf,\"maxDiff\":%lf",
+							 result.kernel,
+							 result.variant,
+							 &result.nsPerElement,
+							 &result.maxDiff);
+		if (numRead == 4) {
+			++numResults;
+		}
+	}
+	fclose(file);
+
+	return (int)numResults;
+}
+
+static int writeBenchResults(const char *filename, const BenchResult *results, unsigned int numResults)
+{
+	FILE *file = fopen(filename, "w");
+	if (!file) {
+		perror("Failed to open the output file!\n");
+		return -1;
+	}
+
+	fprintf(file, "[\n");
+	for (unsigned int i=0; i < numResults; ++i) {
+		fprintf(file,
+				"{\"kernel\":\"%s\",\"variant\":\"%s\",\"nsPerElement\":%.6f,\"maxDiff\":%.9g",
+				results[i].kernel,
+				results[i].variant,
+				results[i].nsPerElement,
+				results[i].maxDiff);
+		if (results[i].maxError >= 0.0) {
+			fprintf(file, ",\"maxError\":%.9g", results[i].maxError);
+		}
+		fprintf(file, "}%s\n", i + 1 < numResults ? "," : "");
+	}
+	fprintf(file, "]\n");
+
+	return fclose(file) == 0 ? 0 : -1;
+}
+
+
+int main(int argc, char **argv)
+{
+	const char *outputPath = NULL;
+	const char *baselinePath = NULL;
+	const char *filter = NULL;
+	double threshold = kBenchDefaultThreshold;
+
+	for (int i=1; i < argc; ++i) {
+		bool hasValue = i + 1 < argc;
+		if (strcmp(argv[i], "--output") == 0 && hasValue) {
+			outputPath = argv[++i];
+		} else if (strcmp(argv[i], "--baseline") == 0 && hasValue) {
+			baselinePath = argv[++i];
+		} else if (strcmp(argv[i], "--threshold") == 0 && hasValue) {
+			threshold = atof(argv[++i]);
+		} else if (strcmp(argv[i], "--filter") == 0 && hasValue) {
+			filter = argv[++i];
+		} else {
+			fprintf(stderr,
+					"Usage: %s [--output <file>] [--baseline <file>] [--threshold <ratio>] [--filter <substring>]\n",
+					argv[0]);
+			return 2;
+		}
+	}
+	if (threshold < 1.0) {
+		fprintf(stderr, "The threshold must be at least 1.0!\n");
+		return 2;
+	}
+
+	// NOTE: (sonictk) The variants are listed from the reference (the scalar one)
+	// upwards, and only the ones that the CPU supports are run.
+	int detectedLevel = getSIMDLevel();
+	bool hasFMA = hasFMA3();
+	BenchVariant variants[] = {
+		{"Scalar", SIMDLevel_Scalar, false},
+		{"SSE2", SIMDLevel_SSE2, false},
+		{"AVX2", SIMDLevel_AVX2, false},
+		{"AVX2 (FMA)", SIMDLevel_AVX2, true},
+		{"AVX-512", SIMDLevel_AVX512, false},
+		{"AVX-512 (FMA)", SIMDLevel_AVX512, true}
+	};
+	unsigned int numVariants = sizeof(variants) / sizeof(variants[0]);
+
+	BenchData data;
+	if (initializeBenchData(data, kBenchNumElements) != 0) {
+		fprintf(stderr, "Failed to allocate the benchmark data!\n");
+		return 2;
+	}
+
+	float *reference = (float *)malloc(sizeof(float) * kBenchNumElements * kBenchMaxOutputFloats);
+	float *output = (float *)malloc(sizeof(float) * kBenchNumElements * kBenchMaxOutputFloats);
+	float *exact = (float *)malloc(sizeof(float) * kBenchNumElements * kBenchMaxOutputFloats);
+	BenchResult *results = (BenchResult *)malloc(sizeof(BenchResult) * kMaxBenchResults);
+	if (!reference || !output || !exact || !results) {
+		fprintf(stderr, "Failed to allocate the benchmark results!\n");
+		return 2;
+	}
+	unsigned int numResults = 0;
+
+	printf("%-34s %-14s %14s %12s %12s\n", "Kernel", "Variant", "ns/element", "Max diff", "Max error");
+
+	unsigned int numCases = sizeof(kBenchCases) / sizeof(kBenchCases[0]);
+	for (unsigned int c=0; c < numCases; ++c) {
+		const BenchCase &benchCase = kBenchCases[c];
+		if (filter && !strstr(benchCase.name, filter)) {
+			continue;
+		}
+
+		bool hasReference = false;
+		for (unsigned int v=0; v < numVariants; ++v) {
+			const BenchVariant &variant = variants[v];
+			if (variant.level > detectedLevel || (variant.useFMA && !hasFMA)) {
+				continue;
+			}
+			if (benchCase.variants == BenchVariants_Scalar && v > 0) {
+				break;
+			}
+
+			SIMDKernelTable table;
+			bindSIMDKernelTable(table, variant.level, variant.useFMA);
+
+			double nsPerElement = timeBenchCase(benchCase, data, table);
+
+			unsigned int numFloats = copyBenchOutput(data, benchCase.output, output);
+			double maxDiff = 0.0;
+			if (!hasReference) {
+				memcpy(reference, output, sizeof(float) * numFloats);
+				hasReference = true;
+			} else {
+				for (unsigned int i=0; i < numFloats; ++i) {
+					double diff = fabs((double)output[i] - (double)reference[i]);
+					maxDiff = diff > maxDiff ? diff : maxDiff;
+				}
+			}
+
+			double maxError = -1.0;
+			if (benchCase.exact) {
+				benchCase.exact(data, table);
+				copyBenchOutput(data, benchCase.output, exact);
+				maxError = getBenchMaxError(output, exact, numFloats);
+			}
+
+			const char *variantName = benchCase.variants == BenchVariants_Scalar ? "-" : variant.name;
+			printf("%-34s %-14s %14.4f %12.3g", benchCase.name, variantName, nsPerElement, maxDiff);
+			if (maxError >= 0.0) {
+				printf(" %12.3g\n", maxError);
+			} else {
+				printf(" %12s\n", "-");
+			}
+
+			if (numResults < kMaxBenchResults) {
+				BenchResult &result = results[numResults++];
+				snprintf(result.kernel, kBenchNameLen, "%s", benchCase.name);
+				snprintf(result.variant, kBenchNameLen, "%s", variantName);
+				result.nsPerElement = nsPerElement;
+				result.maxDiff = maxDiff;
+				result.maxError = maxError;
+			}
+		}
+	}
+
+	bool hasComparisonHeader = false;
+	unsigned int numComparisons = sizeof(kBenchComparisons) / sizeof(kBenchComparisons[0]);
+	for (unsigned int c=0; c < numComparisons; ++c) {
+		const BenchComparison &comparison = kBenchComparisons[c];
+		const BenchResult *vec3Result = findBenchResult(results, numResults, comparison.vec3Case);
+		const BenchResult *vec3AResult = findBenchResult(results, numResults, comparison.vec3ACase);
+		if (!vec3Result || !vec3AResult) {
+			continue;
+		}
+		if (!hasComparisonHeader) {
+			printf("\n%-34s %14s %14s %12s\n", "Vec3 vs Vec3A", "Vec3 ns", "Vec3A ns", "Speedup");
+			hasComparisonHeader = true;
+		}
+		printf("%-34s %14.4f %14.4f %11.2fx\n",
+			   comparison.name,
+			   vec3Result->nsPerElement,
+			   vec3AResult->nsPerElement,
+			   vec3Result->nsPerElement / vec3AResult->nsPerElement);
+	}
+
+	int exitCode = 0;
+	if (outputPath && writeBenchResults(outputPath, results, numResults) != 0) {
+		exitCode = 2;
+	}
+
+	if (baselinePath) {
+		BenchResult *baseline = (BenchResult *)malloc(sizeof(BenchResult) * kMaxBenchResults);
+		int numBaseline = baseline ? readBenchResults(baselinePath, baseline, kMaxBenchResults) : -1;
+		if (numBaseline < 0) {
+			exitCode = 2;
+		} else {
+			unsigned int numRegressions = 0;
+			for (unsigned int i=0; i < numResults; ++i) {
+				for (int j=0; j < numBaseline; ++j) {
+					if (strcmp(results[i].kernel, baseline[j].kernel) != 0
+						|| strcmp(results[i].variant, baseline[j].variant) != 0) {
+						continue;
+					}
+					double ratio = results[i].nsPerElement / baseline[j].nsPerElement;
+					if (ratio > threshold) {
+						printf("REGRESSION: %s [%s] is %.2fx slower than the baseline (%.4f ns vs %.4f ns)\n",
+							   results[i].kernel,
+							   results[i].variant,
+							   ratio,
+							   results[i].nsPerElement,
+							   baseline[j].nsPerElement);
+						++numRegressions;
+					}
+					break;
+				}
+			}
+			printf("%u regression(s) past a threshold of %.2fx.\n", numRegressions, threshold);
+			if (numRegressions > 0 && exitCode == 0) {
+				exitCode = 1;
+			}
+		}
+		free(baseline);
+	}
+
+	free(results);
+	free(exact);
+	free(output);
+	free(reference);
+	freeBenchData(data);
+
+	return exitCode;
+}
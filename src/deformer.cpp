@@ -1,9 +1,533 @@
 #include "deformer.h"
 #include "logic.h"
-#include "deformer_platform.h"
 #include <ssmath/common_math.h>
 #include <maya/MPoint.h>
+#include <maya/MPointArray.h>
+#include <maya/MPlug.h>
+#include <maya/MPlugArray.h>
+#include <maya/MFnDependencyNode.h>
+#include <maya/MFnGeometryFilter.h>
+#include <maya/MFnSet.h>
+#include <maya/MSelectionList.h>
+#include <maya/MDagPath.h>
 #include <maya/MGlobal.h>
+#include <maya/MFnNumericAttribute.h>
+#include <maya/MNodeMessage.h>
+#include <maya/MObjectSetMessage.h>
+
+#include <string.h>
+
+
+MObject HotReloadableDeformer::worldSpace;
+MObject HotReloadableDeformer::fusionState;
+
+
+void displayDeformerInfo(const char *message)
+{
+	MGlobal::displayInfo(message);
+}
+
+
+void displayDeformerWarning(const char *message)
+{
+	MGlobal::displayWarning(message);
+}
+
+
+void displayDeformerError(const char *message)
+{
+	MGlobal::displayError(message);
+}
+
+
+/**
+ * Gets the given node if it is a hot-reloadable deformer that is currently enabled.
+ * Disabled nodes are passed through by Maya without calling ``deform`` and must
+ * never be fused, since any stage fused into them would be silently dropped. A
+ * node whose state is driven by a connection could be disabled without the links
+ * being updated, so it is never fused either.
+ *
+ * @param node		The node to check.
+ *
+ * @return			The deformer, or ``NULL`` if the node is not an enabled
+ * 				hot-reloadable deformer.
+ */
+static HotReloadableDeformer *getActiveHotReloadableDeformer(const MObject &node)
+{
+	MStatus status;
+	MFnDependencyNode fnNode(node, &status);
+	if (!status || fnNode.typeId() != kHotReloadableDeformerID) {
+		return NULL;
+	}
+
+	MPlug nodeStatePlug(node, MPxNode::state);
+	if (nodeStatePlug.isDestination() || nodeStatePlug.asShort() != 0) {
+		return NULL;
+	}
+
+	return (HotReloadableDeformer *)fnNode.userNode();
+}
+
+
+/**
+ * Checks if one selection list contains every item of another, including all of
+ * their components.
+ */
+static bool containsSelection(const MSelectionList &list, const MSelectionList &items)
+{
+	for (unsigned int i=0; i < items.length(); ++i) {
+		MDagPath path;
+		MObject component;
+		if (!items.getDagPath(i, path, component) || !list.hasItem(path, component)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+/**
+ * Checks if two deformers deform exactly the same components. A fused chain runs
+ * every stage over the points that the most downstream node was given, so a stage
+ * whose deformer set is any different can't be fused into it.
+ *
+ * @param upstreamNode		The upstream deformer.
+ * @param downstreamNode	The downstream deformer.
+ *
+ * @return					``true`` if the deformer sets have the same members.
+ */
+static bool haveIdenticalDeformerSets(const MObject &upstreamNode, const MObject &downstreamNode)
+{
+	MStatus status;
+	MFnGeometryFilter fnUpstream(upstreamNode, &status);
+	if (!status) {
+		return false;
+	}
+	MObject upstreamSet = fnUpstream.deformerSet(&status);
+	if (!status) {
+		return false;
+	}
+
+	MFnGeometryFilter fnDownstream(downstreamNode, &status);
+	if (!status) {
+		return false;
+	}
+	MObject downstreamSet = fnDownstream.deformerSet(&status);
+	if (!status) {
+		return false;
+	}
+
+	if (upstreamSet == downstreamSet) {
+		return true;
+	}
+
+	MSelectionList upstreamMembers;
+	MSelectionList downstreamMembers;
+	if (!MFnSet(upstreamSet).getMembers(upstreamMembers, true)
+		|| !MFnSet(downstreamSet).getMembers(downstreamMembers, true)) {
+		return false;
+	}
+
+	return upstreamMembers.length() == downstreamMembers.length()
+		&& containsSelection(upstreamMembers, downstreamMembers)
+		&& containsSelection(downstreamMembers, upstreamMembers);
+}
+
+
+/**
+ * Gets the plugs connected to the given plug, except for the other end of a
+ * connection that is being broken.
+ *
+ * @param plug				The plug whose connections should be found.
+ * @param asDestination	If ``true``, the sources of the plug are found, otherwise
+ * 						its destinations.
+ * @param broken			The connection that is being broken, or ``NULL``.
+ * @param connected		Will be set to the connected plugs.
+ *
+ * @return					The number of connected plugs.
+ */
+static unsigned int getConnectedPlugs(const MPlug &plug,
+									  bool asDestination,
+									  const BrokenConnection *broken,
+									  MPlugArray &connected)
+{
+	MPlugArray plugs;
+	plug.connectedTo(plugs, asDestination, !asDestination);
+	for (unsigned int i=0; i < plugs.length(); ++i) {
+		if (broken) {
+			const MPlug &source = asDestination ? plugs[i] : plug;
+			const MPlug &destination = asDestination ? plug : plugs[i];
+			if (source == broken->source && destination == broken->destination) {
+				continue;
+			}
+		}
+		connected.append(plugs[i]);
+	}
+
+	return connected.length();
+}
+
+
+/**
+ * Finds the source of the input geometry at ``multiIndex`` of the given node if
+ * it is the output geometry of another hot-reloadable deformer.
+ *
+ * @param node				The downstream node.
+ * @param multiIndex		The logical index of the input geometry.
+ * @param broken			The connection that is being broken, or ``NULL``.
+ * @param upstreamNode		Will be set to the upstream node, if found.
+ * @param upstreamIndex	Will be set to the logical index of the upstream node's
+ * 						output geometry, if found.
+ *
+ * @return					``true`` if an upstream hot-reloadable deformer was found.
+ */
+static bool findUpstreamDeformer(const MObject &node,
+								 unsigned int multiIndex,
+								 const BrokenConnection *broken,
+								 MObject &upstreamNode,
+								 unsigned int &upstreamIndex)
+{
+	MPlug inputPlug(node, MPxGeometryFilter::input);
+	MPlug inputGeomPlug = inputPlug.elementByLogicalIndex(multiIndex).child(MPxGeometryFilter::inputGeom);
+
+	MPlugArray sources;
+	if (getConnectedPlugs(inputGeomPlug, true, broken, sources) != 1) {
+		return false;
+	}
+
+	MPlug sourcePlug = sources[0];
+	if (sourcePlug.attribute() != MPxGeometryFilter::outputGeom
+		|| !getActiveHotReloadableDeformer(sourcePlug.node())) {
+		return false;
+	}
+
+	upstreamNode = sourcePlug.node();
+	upstreamIndex = sourcePlug.logicalIndex();
+
+	return true;
+}
+
+
+/**
+ * Checks if the output geometry at ``upstreamIndex`` of ``upstreamNode`` can be
+ * fused into the deformer that it is connected to (see ``updateFusedLinks``).
+ *
+ * @param upstreamNode		The node whose output geometry should be checked.
+ * @param upstreamIndex	The logical index of the output geometry.
+ * @param broken			The connection that is being broken, or ``NULL``.
+ * @param downstreamNode	Will be set to the downstream node, if fused.
+ * @param downstreamIndex	Will be set to the logical index of the downstream
+ * 						node's input geometry, if fused.
+ *
+ * @return					``true`` if the node's work can be done by the
+ * 						downstream deformer instead.
+ */
+static bool findFusedDownstreamDeformer(const MObject &upstreamNode,
+										unsigned int upstreamIndex,
+										const BrokenConnection *broken,
+										MObject &downstreamNode,
+										unsigned int &downstreamIndex)
+{
+	if (!getActiveHotReloadableDeformer(upstreamNode)) {
+		return false;
+	}
+
+	MPlug outputPlug(upstreamNode, MPxGeometryFilter::outputGeom);
+	MPlugArray destinations;
+
+	// NOTE: (sonictk) If the output fans out to several nodes, the intermediate
+	// result is needed by more than one consumer, so it must be materialized.
+	if (getConnectedPlugs(outputPlug.elementByLogicalIndex(upstreamIndex), false, broken, destinations) != 1) {
+		return false;
+	}
+
+	MPlug destPlug = destinations[0];
+	if (destPlug.attribute() != MPxGeometryFilter::inputGeom) {
+		return false;
+	}
+
+	MObject node = destPlug.node();
+	if (!getActiveHotReloadableDeformer(node) || !haveIdenticalDeformerSets(upstreamNode, node)) {
+		return false;
+	}
+
+	// NOTE: (sonictk) ``inputGeom`` is a child of the ``input`` array, which holds
+	// the logical index.
+	downstreamNode = node;
+	downstreamIndex = destPlug.parent().logicalIndex();
+
+	return true;
+}
+
+
+/// Dirties the output geometry of the given deformer after its links changed.
+static void markFusedLinksChanged(HotReloadableDeformer *deformer)
+{
+	MPlug fusionStatePlug(deformer->thisMObject(), HotReloadableDeformer::fusionState);
+	fusionStatePlug.setInt(fusionStatePlug.asInt() + 1);
+}
+
+
+/// Stops fusing the output geometry at ``index`` of the given deformer.
+static void unlinkFusedOutput(HotReloadableDeformer *deformer, unsigned int index)
+{
+	FusedLink &link = deformer->links[index];
+	if (!link.downstream) {
+		return;
+	}
+
+	HotReloadableDeformer *downstream = link.downstream;
+	downstream->links[link.downstreamIndex].upstream = NULL;
+	link.downstream = NULL;
+
+	markFusedLinksChanged(deformer);
+	markFusedLinksChanged(downstream);
+}
+
+
+/// Stops fusing the deformer upstream of the input geometry at ``index`` of the
+/// given deformer.
+static void unlinkFusedInput(HotReloadableDeformer *deformer, unsigned int index)
+{
+	FusedLink &link = deformer->links[index];
+	if (link.upstream) {
+		unlinkFusedOutput(link.upstream, link.upstreamIndex);
+	}
+}
+
+
+/// Fuses the output geometry at ``upstreamIndex`` of ``upstream`` into the input
+/// geometry at ``downstreamIndex`` of ``downstream``.
+static void linkFusedGeometry(HotReloadableDeformer *upstream,
+							  unsigned int upstreamIndex,
+							  HotReloadableDeformer *downstream,
+							  unsigned int downstreamIndex)
+{
+	FusedLink &upstreamLink = upstream->links[upstreamIndex];
+	if (upstreamLink.downstream == downstream && upstreamLink.downstreamIndex == downstreamIndex) {
+		return;
+	}
+
+	unlinkFusedOutput(upstream, upstreamIndex);
+	unlinkFusedInput(downstream, downstreamIndex);
+
+	upstreamLink.downstream = downstream;
+	upstreamLink.downstreamIndex = downstreamIndex;
+	downstream->links[downstreamIndex].upstream = upstream;
+	downstream->links[downstreamIndex].upstreamIndex = upstreamIndex;
+
+	markFusedLinksChanged(upstream);
+	markFusedLinksChanged(downstream);
+}
+
+
+void updateFusedLinks(HotReloadableDeformer *deformer, const BrokenConnection *broken)
+{
+	MObject node = deformer->thisMObject();
+
+	// NOTE: (sonictk) Only the existing elements are visited, since looking up an
+	// element by its logical index would create it.
+	HotReloadableDeformer *downstreams[kMaxFusedGeometries] = {};
+	unsigned int downstreamIndices[kMaxFusedGeometries];
+	MPlug outputPlug(node, MPxGeometryFilter::outputGeom);
+	for (unsigned int i=0; i < outputPlug.numElements(); ++i) {
+		unsigned int index = outputPlug.elementByPhysicalIndex(i).logicalIndex();
+		MObject downstreamNode;
+		unsigned int downstreamIndex;
+		if (index < kMaxFusedGeometries
+			&& findFusedDownstreamDeformer(node, index, broken, downstreamNode, downstreamIndex)
+			&& downstreamIndex < kMaxFusedGeometries) {
+			downstreams[index] = getActiveHotReloadableDeformer(downstreamNode);
+			downstreamIndices[index] = downstreamIndex;
+		}
+	}
+
+	HotReloadableDeformer *upstreams[kMaxFusedGeometries] = {};
+	unsigned int upstreamIndices[kMaxFusedGeometries];
+	MPlug inputPlug(node, MPxGeometryFilter::input);
+	for (unsigned int i=0; i < inputPlug.numElements(); ++i) {
+		unsigned int index = inputPlug.elementByPhysicalIndex(i).logicalIndex();
+		MObject upstreamNode;
+		unsigned int upstreamIndex;
+		MObject downstreamNode;
+		unsigned int downstreamIndex;
+		if (index < kMaxFusedGeometries
+			&& findUpstreamDeformer(node, index, broken, upstreamNode, upstreamIndex)
+			&& upstreamIndex < kMaxFusedGeometries
+			&& findFusedDownstreamDeformer(upstreamNode, upstreamIndex, broken, downstreamNode, downstreamIndex)
+			&& downstreamNode == node
+			&& downstreamIndex == index) {
+			upstreams[index] = getActiveHotReloadableDeformer(upstreamNode);
+			upstreamIndices[index] = upstreamIndex;
+		}
+	}
+
+	for (unsigned int i=0; i < kMaxFusedGeometries; ++i) {
+		if (downstreams[i]) {
+			linkFusedGeometry(deformer, i, downstreams[i], downstreamIndices[i]);
+		} else {
+			unlinkFusedOutput(deformer, i);
+		}
+
+		if (upstreams[i]) {
+			linkFusedGeometry(upstreams[i], upstreamIndices[i], deformer, i);
+		} else {
+			unlinkFusedInput(deformer, i);
+		}
+	}
+}
+
+
+unsigned int gatherFusedStages(const HotReloadableDeformer *deformer,
+							   unsigned int multiIndex,
+							   float envelope,
+							   bool worldSpace,
+							   FusedStage *stages,
+							   unsigned int maxStages)
+{
+	if (maxStages == 0) {
+		return 0;
+	}
+
+	// NOTE: (sonictk) The stages are gathered from downstream to upstream, and
+	// then reversed so that they are returned in evaluation order.
+	unsigned int numStages = 0;
+	stages[numStages].envelope = envelope;
+	stages[numStages].worldSpace = worldSpace;
+	++numStages;
+
+	const HotReloadableDeformer *cur = deformer;
+	unsigned int curIndex = multiIndex;
+	while (numStages < maxStages && curIndex < kMaxFusedGeometries && cur->links[curIndex].upstream) {
+		// NOTE: (sonictk) The upstream node has already been evaluated to provide
+		// our input geometry, and kept the values from its datablock then. Reading
+		// its plugs here would evaluate it outside of the dependency graph instead.
+		const FusedLink &link = cur->links[curIndex];
+		stages[numStages] = link.upstream->stage;
+		++numStages;
+
+		// NOTE: (sonictk) For geometry filters, each output geometry is computed
+		// from the input geometry at the same logical index.
+		cur = link.upstream;
+		curIndex = link.upstreamIndex;
+	}
+
+	for (unsigned int i=0; i < numStages / 2; ++i) {
+		FusedStage tmp = stages[i];
+		stages[i] = stages[numStages - 1 - i];
+		stages[numStages - 1 - i] = tmp;
+	}
+
+	return numStages;
+}
+
+
+/// Updates the links of the deformer when its node state is set.
+static void onDeformerAttributeChanged(MNodeMessage::AttributeMessage message,
+									   MPlug &plug,
+									   MPlug &,
+									   void *clientData)
+{
+	if ((message & MNodeMessage::kAttributeSet) && plug.attribute() == MPxNode::state) {
+		updateFusedLinks((HotReloadableDeformer *)clientData, NULL);
+	}
+}
+
+
+/// Updates the links of the deformer when the members of its deformer set change.
+static void onDeformerSetMembersModified(MObject &, void *clientData)
+{
+	updateFusedLinks((HotReloadableDeformer *)clientData, NULL);
+}
+
+
+/// Watches the members of the deformer's current deformer set, if it has one.
+static void watchDeformerSetMembers(HotReloadableDeformer *deformer)
+{
+	if (deformer->hasSetMembersCallback) {
+		MMessage::removeCallback(deformer->setMembersCallback);
+		deformer->hasSetMembersCallback = false;
+	}
+
+	MStatus status;
+	MFnGeometryFilter fnDeformer(deformer->thisMObject(), &status);
+	if (!status) {
+		return;
+	}
+	MObject deformerSet = fnDeformer.deformerSet(&status);
+	if (!status || deformerSet.isNull()) {
+		return;
+	}
+
+	deformer->setMembersCallback = MObjectSetMessage::addSetMembersModifiedCallback(deformerSet,
+																					onDeformerSetMembersModified,
+																					deformer,
+																					&status);
+	deformer->hasSetMembersCallback = status ? true : false;
+}
+
+
+/// Checks if a connection to the given plug can change how the deformer is fused.
+static bool affectsFusedLinks(const MPlug &plug)
+{
+	MObject attribute = plug.attribute();
+
+	return attribute == MPxGeometryFilter::outputGeom
+		|| attribute == MPxGeometryFilter::input
+		|| attribute == MPxGeometryFilter::inputGeom
+		|| attribute == MPxNode::state
+		|| attribute == MPxNode::message;
+}
+
+
+/**
+ * Converts a Maya matrix to the ``ssmath`` convention. Maya matrices transform
+ * row vectors (i.e. the translation is stored in the bottom row), while ``Mat44``
+ * transforms column vectors, so the matrix is transposed during the conversion.
+ */
+static Mat44 mat44FromMMatrix(const MMatrix &matrix)
+{
+	Mat44 result;
+	for (int r=0; r <= 3; ++r) {
+		for (int c=0; c <= 3; ++c) {
+			result[r][c] = (float)matrix(c, r);
+		}
+	}
+
+	return result;
+}
+
+
+HotReloadableDeformer::HotReloadableDeformer()
+{
+	stage.envelope = 1.0f;
+	stage.worldSpace = false;
+	memset(links, 0, sizeof(links));
+	hasSetMembersCallback = false;
+	initializeDeformerPipeline(pipeline, kNextDeformerStatsID.fetch_add(1) + 1);
+}
+
+
+HotReloadableDeformer::~HotReloadableDeformer()
+{
+	// NOTE: (sonictk) Deleting a node breaks its connections first, so this only
+	// matters if that was skipped (e.g. when the scene is closed).
+	for (unsigned int i=0; i < kMaxFusedGeometries; ++i) {
+		if (links[i].downstream) {
+			links[i].downstream->links[links[i].downstreamIndex].upstream = NULL;
+		}
+		if (links[i].upstream) {
+			links[i].upstream->links[links[i].upstreamIndex].downstream = NULL;
+		}
+	}
+	MMessage::removeCallback(attributeChangedCallback);
+	if (hasSetMembersCallback) {
+		MMessage::removeCallback(setMembersCallback);
+	}
+
+	freeDeformerPipeline(pipeline);
+}
 
 
 void *HotReloadableDeformer::creator()
@@ -14,6 +538,9 @@ void *HotReloadableDeformer::creator()
 
 void HotReloadableDeformer::postConstructor()
 {
+	MObject node = thisMObject();
+	attributeChangedCallback = MNodeMessage::addAttributeChangedCallback(node, onDeformerAttributeChanged, this);
+
 	LibraryStatus result = loadDeformerLogicDLL(kLogicLibrary);
 	if (result != LibraryStatus_Success) {
 		MGlobal::displayError("Failed to load shared library!");
@@ -28,80 +555,181 @@ MStatus HotReloadableDeformer::initialize()
 {
 	MStatus result;
 
+	MFnNumericAttribute fnNumAttr;
+	worldSpace = fnNumAttr.create("worldSpace", "ws", MFnNumericData::kBoolean, 0, &result);
+	CHECK_MSTATUS_AND_RETURN_IT(result);
+	fnNumAttr.setKeyable(true);
+	fnNumAttr.setStorable(true);
+
+	result = addAttribute(worldSpace);
+	CHECK_MSTATUS_AND_RETURN_IT(result);
+
+	fusionState = fnNumAttr.create("fusionState", "fus", MFnNumericData::kInt, 0, &result);
+	CHECK_MSTATUS_AND_RETURN_IT(result);
+	fnNumAttr.setStorable(false);
+	fnNumAttr.setHidden(true);
+
+	result = addAttribute(fusionState);
+	CHECK_MSTATUS_AND_RETURN_IT(result);
+
 	attributeAffects(envelope, outputGeom);
+	attributeAffects(worldSpace, outputGeom);
+	attributeAffects(fusionState, outputGeom);
 
 	return result;
 }
 
 
-MStatus HotReloadableDeformer::deform(MDataBlock &block,
-									  MItGeometry &iter,
-									  const MMatrix &matrix,
-									  unsigned int multiIndex)
+/// The inputs of a single call to ``HotReloadableDeformer::deform``, which the
+/// pipeline accesses through a ``DeformerHost``.
+struct MayaDeformerHostData
 {
-	LibraryStatus status;
-
-	if (!kLogicLibrary.isValid) {
-#ifdef _DEBUG_MODE
-		MGlobal::displayError("The logic DLL is not valid, attempting reload!");
-#endif
-		// NOTE: (sonictk) Just in case, we make sure the library is unloaded
-		unloadDeformerLogicDLL(kLogicLibrary);
-		status = loadDeformerLogicDLL(kLogicLibrary);
-		if (status != LibraryStatus_Success) {
-			return MStatus::kFailure;
-		}
+	const HotReloadableDeformer *deformer;
+	unsigned int multiIndex;
+	float envelope;
+	bool worldSpace;
+
+	const MMatrix *matrix;
+	MItGeometry *iter;
+	MPointArray points;
+};
+
+
+static unsigned int getMayaDeformerStages(void *data, FusedStage *stages, unsigned int maxStages)
+{
+	MayaDeformerHostData *host = (MayaDeformerHostData *)data;
+
+	// NOTE: (sonictk) If our output feeds straight into another hot-reloadable
+	// deformer, that node will run our stage as part of its own pass over the
+	// points, so we leave the geometry untouched here.
+	if (host->multiIndex < kMaxFusedGeometries && host->deformer->links[host->multiIndex].downstream) {
+		return 0;
 	}
 
-	// NOTE: (yliangsiew) Find the last modified time of the DLL and check if
-	// there is a newer version; if so, unload the existing DLL and load the new
-	// one, then fix up the function pointers again
-	if (kPluginLogicLibraryPath.numChars() == 0) {
-		return MStatus::kFailure;
+	return gatherFusedStages(host->deformer, host->multiIndex, host->envelope, host->worldSpace, stages, maxStages);
+}
+
+
+static void getMayaDeformerWorldMatrix(void *data, Mat44 &matrix)
+{
+	MayaDeformerHostData *host = (MayaDeformerHostData *)data;
+	matrix = mat44FromMMatrix(*host->matrix);
+}
+
+
+static unsigned int getMayaDeformerNumPoints(void *data)
+{
+	MayaDeformerHostData *host = (MayaDeformerHostData *)data;
+	host->iter->allPositions(host->points);
+
+	return host->points.length();
+}
+
+
+static int readMayaDeformerPoints(void *data, Vec3 *points, unsigned int numPoints)
+{
+	MayaDeformerHostData *host = (MayaDeformerHostData *)data;
+	if (host->points.length() < numPoints) {
+		return -1;
+	}
+	for (unsigned int i=0; i < numPoints; ++i) {
+		const MPoint &pt = host->points[i];
+		points[i] = vec3((float)pt.x, (float)pt.y, (float)pt.z);
 	}
 
-	// NOTE: (sonictk) We only reload the DLL *if* the DLL actually exists; this
-	// is so we can rename the DLL on Windows to avoid having the DLL handle be locked.
-	FileTime lastModified = getLastWriteTime(kPluginLogicLibraryPath.asChar());
-	if (lastModified >= 0 && lastModified != kLogicLibrary.lastModified) {
-#ifdef _DEBUG_MODE
-		MGlobal::displayInfo("DEBUG: Reloading logic DLL...");
-#endif // _DEBUG_MODE
-		status = unloadDeformerLogicDLL(kLogicLibrary);
-		if (status != LibraryStatus_Success) {
-#ifdef _DEBUG_MODE
-			MGlobal::displayError("Unable to unload logic library!");
-#endif
-			return MStatus::kFailure;
-		}
-		status = loadDeformerLogicDLL(kLogicLibrary);
-		if (status != LibraryStatus_Success) {
-#ifdef _DEBUG_MODE
-			MGlobal::displayError("Unable to load logic library!");
-#endif
-			return MStatus::kFailure;
-		}
+	return 0;
+}
+
+
+static int writeMayaDeformerPoints(void *data, const Vec3 *points, unsigned int numPoints)
+{
+	MayaDeformerHostData *host = (MayaDeformerHostData *)data;
+	if (host->points.length() < numPoints) {
+		return -1;
 	}
+	for (unsigned int i=0; i < numPoints; ++i) {
+		host->points[i] = MPoint(points[i].x, points[i].y, points[i].z, 1);
+	}
+
+	MStatus status = host->iter->setAllPositions(host->points);
+
+	return status ? 0 : -1;
+}
+
+
+MStatus HotReloadableDeformer::deform(MDataBlock &block,
+									  MItGeometry &iter,
+									  const MMatrix &matrix,
+									  unsigned int multiIndex)
+{
+	SS_PROFILE_ZONE("HotReloadableDeformer::deform");
 
 	MStatus result;
 
-	// NOTE: (yliangsiew) Simple example function code here
 	MDataHandle envelopeHandle = block.inputValue(envelope, &result);
 	CHECK_MSTATUS_AND_RETURN_IT(result);
 
-	float envelope = envelopeHandle.asFloat();
+	MDataHandle worldSpaceHandle = block.inputValue(worldSpace, &result);
+	CHECK_MSTATUS_AND_RETURN_IT(result);
 
-	for (; !iter.isDone(); iter.next())
-	{
+	// NOTE: (sonictk) The links are read instead, but the counter is cleaned so that
+	// the next change to them dirties the output geometry again.
+	block.inputValue(fusionState, &result);
+	CHECK_MSTATUS_AND_RETURN_IT(result);
+
+	stage.envelope = envelopeHandle.asFloat();
+	stage.worldSpace = worldSpaceHandle.asBool();
 
-		MPoint curPtPosPt = iter.position();
-		Vec3 curPtPos = vec3((float)curPtPosPt.x, (float)curPtPosPt.y, (float)curPtPosPt.z);
-		Vec3 finalPos = kLogicLibrary.deformCB(curPtPos, envelope);
+	MayaDeformerHostData hostData;
+	hostData.deformer = this;
+	hostData.multiIndex = multiIndex;
+	hostData.envelope = stage.envelope;
+	hostData.worldSpace = stage.worldSpace;
+	hostData.matrix = &matrix;
+	hostData.iter = &iter;
 
-		MPoint finalPosPt = MPoint(finalPos.x, finalPos.y, finalPos.z, 1);
+	DeformerHost host;
+	host.data = &hostData;
+	host.getStages = getMayaDeformerStages;
+	host.getWorldMatrix = getMayaDeformerWorldMatrix;
+	host.getNumPoints = getMayaDeformerNumPoints;
+	host.readPoints = readMayaDeformerPoints;
+	host.writePoints = writeMayaDeformerPoints;
 
-		iter.setPosition(finalPosPt);
+	if (evaluateDeformerPipeline(pipeline, host) != 0) {
+		return MStatus::kFailure;
 	}
 
 	return result;
 }
+
+
+MStatus HotReloadableDeformer::connectionMade(const MPlug &plug, const MPlug &otherPlug, bool asSrc)
+{
+	if (affectsFusedLinks(plug)) {
+		if (plug.attribute() == message) {
+			watchDeformerSetMembers(this);
+		}
+		updateFusedLinks(this, NULL);
+	}
+
+	return MPxGeometryFilter::connectionMade(plug, otherPlug, asSrc);
+}
+
+
+MStatus HotReloadableDeformer::connectionBroken(const MPlug &plug, const MPlug &otherPlug, bool asSrc)
+{
+	if (affectsFusedLinks(plug)) {
+		if (plug.attribute() == message && hasSetMembersCallback) {
+			MMessage::removeCallback(setMembersCallback);
+			hasSetMembersCallback = false;
+		}
+
+		BrokenConnection broken;
+		broken.source = asSrc ? plug : otherPlug;
+		broken.destination = asSrc ? otherPlug : plug;
+		updateFusedLinks(this, &broken);
+	}
+
+	return MPxGeometryFilter::connectionBroken(plug, otherPlug, asSrc);
+}
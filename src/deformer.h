@@ -4,15 +4,80 @@
 #include <maya/MPxGeometryFilter.h>
 #include <maya/MItGeometry.h>
 #include <maya/MGlobal.h>
+#include <maya/MObject.h>
+#include <maya/MMatrix.h>
+#include <maya/MPlug.h>
+#include <maya/MMessage.h>
+
+#include "deformer_host.h"
+#include <atomic>
 
 
 static const MTypeId kHotReloadableDeformerID = 0x0008002E;
 static const char *kHotReloadableDeformerName = "hotReloadableDeformer";
 
 
+/// The number of hot-reloadable deformers that have been created, which is used
+/// to give each one a unique statistics ID.
+globalVar std::atomic<unsigned int> kNextDeformerStatsID;
+
+/// The number of logical geometry indices of each deformer whose fusion is tracked.
+/// Geometry at higher indices is always evaluated unfused.
+static const unsigned int kMaxFusedGeometries = 64;
+
+
+struct HotReloadableDeformer;
+
+/// Where the geometry at one logical index of a deformer is fused. The links of
+/// two fused deformers always point at each other.
+struct FusedLink
+{
+	/// The deformer that runs this node's stage as part of its chain, in which case
+	/// this node leaves its output geometry untouched, or ``NULL``.
+	HotReloadableDeformer *downstream;
+	unsigned int downstreamIndex;
+
+	/// The deformer whose stage is run as part of this node's chain, or ``NULL``.
+	HotReloadableDeformer *upstream;
+	unsigned int upstreamIndex;
+};
+
 
 struct HotReloadableDeformer : MPxGeometryFilter
 {
+	/// When enabled, the logic library receives points in world space instead
+	/// of the geometry's local space.
+	static MObject worldSpace;
+
+	/// An internal counter that is incremented whenever ``links`` changes. It
+	/// affects the output geometry, so that changing whether the node is fused
+	/// re-evaluates it even though none of its own inputs changed.
+	static MObject fusionState;
+
+	/// The state of the node's evaluations, which are done by the Maya-independent
+	/// ``evaluateDeformerPipeline``.
+	DeformerPipeline pipeline;
+
+	/// The envelope and world space setting from the datablock of the node's last
+	/// evaluation. When the node is fused into a downstream node, that node runs
+	/// this stage with these values.
+	FusedStage stage;
+
+	/// The fusion of each logical index of the geometry. Deciding this reads the
+	/// plugs and deformer sets of the neighbouring nodes, so it is done by
+	/// ``updateFusedLinks`` when they change instead of in ``deform``.
+	FusedLink links[kMaxFusedGeometries];
+
+	/// The callbacks that update ``links`` when the node state or the members of
+	/// the deformer set change.
+	MCallbackId attributeChangedCallback;
+	MCallbackId setMembersCallback;
+	bool hasSetMembersCallback;
+
+	HotReloadableDeformer();
+
+	~HotReloadableDeformer();
+
 	static void *creator();
 
 	void postConstructor();
@@ -23,6 +88,59 @@ struct HotReloadableDeformer : MPxGeometryFilter
 				   MItGeometry &iterator,
 				   const MMatrix &matrix,
 				   unsigned int multiIndex);
+
+	MStatus connectionMade(const MPlug &plug, const MPlug &otherPlug, bool asSrc);
+
+	MStatus connectionBroken(const MPlug &plug, const MPlug &otherPlug, bool asSrc);
+};
+
+
+/// A connection that is being broken, which Maya may still report as connected
+/// while ``connectionBroken`` is running.
+struct BrokenConnection
+{
+	MPlug source;
+	MPlug destination;
 };
 
+
+/**
+ * Decides which of the deformer's geometry is fused into a downstream deformer, or
+ * has an upstream deformer fused into it, and updates the links of the deformer
+ * and its neighbours to match. A deformer's output geometry is fused if it feeds
+ * directly and exclusively into the input geometry of another hot-reloadable
+ * deformer; both deformers must be enabled and have deformer sets with identical
+ * members. The output geometry of every deformer whose links changed is dirtied.
+ *
+ * @param deformer		The deformer whose connections, node state or deformer set
+ * 					changed.
+ * @param broken		The connection that is being broken, which is ignored, or
+ * 					``NULL``.
+ */
+void updateFusedLinks(HotReloadableDeformer *deformer, const BrokenConnection *broken);
+
+
+/**
+ * Walks up the deformation chain from the given deformer, collecting every
+ * consecutive hot-reloadable deformer that has been fused into it. The stages are
+ * written in evaluation order, with the given deformer's own stage written last.
+ * Only the cached links are followed, so no plugs are read.
+ *
+ * @param deformer			The most downstream deformer of the chain.
+ * @param multiIndex		The logical index of the geometry being deformed.
+ * @param envelope			The envelope of the given deformer.
+ * @param worldSpace		Whether the given deformer deforms in world space.
+ * @param stages			The buffer to write the stages to.
+ * @param maxStages		The maximum number of stages that can be written.
+ *
+ * @return					The number of stages written.
+ */
+unsigned int gatherFusedStages(const HotReloadableDeformer *deformer,
+							   unsigned int multiIndex,
+							   float envelope,
+							   bool worldSpace,
+							   FusedStage *stages,
+							   unsigned int maxStages);
+
+
 #endif /* DEFORMER_H */
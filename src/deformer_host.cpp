@@ -0,0 +1,530 @@
+#include "deformer_host.h"
+#include "deformer_stats.h"
+#include <ssmath/simd_kernels.h>
+#include <math.h>
+#include <string.h>
+
+
+int reservePointBuffer(PointBuffer &buffer, unsigned int numPoints)
+{
+	if (buffer.points && buffer.capacity >= numPoints) {
+		return 0;
+	}
+
+	freePointBuffer(buffer);
+
+	buffer.points = (Vec3 *)malloc(sizeof(Vec3) * numPoints);
+	if (!buffer.points) {
+		return -1;
+	}
+	buffer.capacity = numPoints;
+
+	return 0;
+}
+
+
+void freePointBuffer(PointBuffer &buffer)
+{
+	free(buffer.points);
+	buffer.points = NULL;
+	buffer.capacity = 0;
+}
+
+
+void initializeDeformerPipeline(DeformerPipeline &pipeline, unsigned int statsID)
+{
+	pipeline.pointBuffer.points = NULL;
+	pipeline.pointBuffer.capacity = 0;
+	pipeline.shadowBuffer.points = NULL;
+	pipeline.shadowBuffer.capacity = 0;
+	pipeline.statsID = statsID;
+
+	pipeline.worldMatrix = identityMat44();
+	pipeline.worldInverseMatrix = identityMat44();
+	pipeline.isWorldMatrixCacheValid = false;
+	pipeline.isWorldMatrixInvertible = true;
+}
+
+
+void freeDeformerPipeline(DeformerPipeline &pipeline)
+{
+	freePointBuffer(pipeline.pointBuffer);
+	freePointBuffer(pipeline.shadowBuffer);
+	pipeline.isWorldMatrixCacheValid = false;
+}
+
+
+/// The world inverse is not computed when the determinant of the world matrix is
+/// less than this fraction of the product of the lengths of its rows (which is the
+/// largest that the determinant can be). Being relative to the scale of the matrix,
+/// tiny but uniform scales are still inverted.
+static const double kWorldMatrixSingularTolerance = 1e-12;
+
+
+/**
+ * Inverts an affine world matrix in double precision. Maya's world matrices are
+ * doubles to begin with, so this keeps the round trip to world space and back
+ * accurate even when the object is scaled far away from ``1``.
+ *
+ * @param matrix		The affine matrix to invert.
+ * @param inverse		The matrix to write the inverse to.
+ *
+ * @return			``0`` on success, ``-1`` if the matrix has collapsed.
+ */
+static int inverseWorldMatrix(const Mat44 &matrix, Mat44 &inverse)
+{
+	double m[3][4];
+	double rowLengths = 1.0;
+	for (int r=0; r < 3; ++r) {
+		for (int c=0; c < 4; ++c) {
+			m[r][c] = (double)matrix[r][c];
+		}
+		rowLengths *= sqrt((m[r][0] * m[r][0]) + (m[r][1] * m[r][1]) + (m[r][2] * m[r][2]));
+	}
+
+	// NOTE: (sonictk) The adjugate of the upper 3x3 block, whose first column also
+	// gives the determinant by expanding along the first row.
+	double adj[3][3];
+	adj[0][0] = (m[1][1] * m[2][2]) - (m[1][2] * m[2][1]);
+	adj[0][1] = (m[0][2] * m[2][1]) - (m[0][1] * m[2][2]);
+	adj[0][2] = (m[0][1] * m[1][2]) - (m[0][2] * m[1][1]);
+	adj[1][0] = (m[1][2] * m[2][0]) - (m[1][0] * m[2][2]);
+	adj[1][1] = (m[0][0] * m[2][2]) - (m[0][2] * m[2][0]);
+	adj[1][2] = (m[0][2] * m[1][0]) - (m[0][0] * m[1][2]);
+	adj[2][0] = (m[1][0] * m[2][1]) - (m[1][1] * m[2][0]);
+	adj[2][1] = (m[0][1] * m[2][0]) - (m[0][0] * m[2][1]);
+	adj[2][2] = (m[0][0] * m[1][1]) - (m[0][1] * m[1][0]);
+	double det = (m[0][0] * adj[0][0]) + (m[0][1] * adj[1][0]) + (m[0][2] * adj[2][0]);
+
+	// NOTE: (sonictk) Written so that a NaN determinant is also rejected.
+	if (!(fabs(det) > rowLengths * kWorldMatrixSingularTolerance)) {
+		return -1;
+	}
+
+	double invDet = 1.0 / det;
+	for (int r=0; r < 3; ++r) {
+		double translation = 0.0;
+		for (int c=0; c < 3; ++c) {
+			double value = adj[r][c] * invDet;
+			inverse[r][c] = (float)value;
+			translation -= value * m[c][3];
+		}
+		inverse[r][3] = (float)translation;
+		inverse[3][r] = 0.0f;
+	}
+	inverse[3][3] = 1.0f;
+
+	return 0;
+}
+
+
+/**
+ * Runs a single deformer stage over the given points using the logic library's
+ * batched entry point if it is available, falling back to the per-point one.
+ */
+static int runDeformStage(const DeformerLogicLibrary &library,
+						  Vec3 *points,
+						  unsigned int numPoints,
+						  float envelope)
+{
+	SS_PROFILE_ZONE("deform: logic stage");
+
+	DEFORMER_PROBE3(logic_entry, tDeformerProbeContext.nodeID, numPoints, library.version);
+
+	int result = 0;
+	if (library.deformPointsCB) {
+		result = library.deformPointsCB(points, numPoints, envelope);
+	} else {
+		for (unsigned int i=0; i < numPoints; ++i) {
+			points[i] = library.deformCB(points[i], envelope);
+		}
+	}
+
+	DEFORMER_PROBE4(logic_return, tDeformerProbeContext.nodeID, numPoints, library.version, result);
+
+	return result;
+}
+
+
+/**
+ * Runs every stage over the given points, a chunk at a time.
+ *
+ * @param library				The logic library to run the stages with.
+ * @param stages				The stages to run, in evaluation order.
+ * @param numStages			The number of stages.
+ * @param pipeline				The state of the node, which holds its world matrices.
+ * @param points				The points to deform in-place.
+ * @param numPoints			The number of points.
+ * @param perfCounters			If not ``NULL``, the hardware events of each call into
+ * 							the logic library are added to ``logicCounters``.
+ * @param logicCounters		The events counted in the logic library.
+ *
+ * @return						``0`` on success, ``-1`` if any stage failed.
+ */
+static int runDeformStages(const DeformerLogicLibrary &library,
+						   const FusedStage *stages,
+						   unsigned int numStages,
+						   const DeformerPipeline &pipeline,
+						   Vec3 *points,
+						   unsigned int numPoints,
+						   PerfCounterGroup *perfCounters,
+						   PerfCounterValues &logicCounters)
+{
+	const Mat44 &worldMatrix = pipeline.worldMatrix;
+	const Mat44 &worldInverseMatrix = pipeline.worldInverseMatrix;
+	for (unsigned int start=0; start < numPoints; start += kFusedChunkSize) {
+		SS_PROFILE_ZONE("deform: chunk");
+
+		unsigned int chunkSize = numPoints - start;
+		if (chunkSize > kFusedChunkSize) {
+			chunkSize = kFusedChunkSize;
+		}
+		// NOTE: (sonictk) The chunk is only moved between spaces when consecutive
+		// stages disagree, and is always returned to local space at the end.
+		bool isChunkInWorldSpace = false;
+		for (unsigned int i=0; i < numStages; ++i) {
+			if (stages[i].worldSpace != isChunkInWorldSpace) {
+				SS_PROFILE_ZONE("deform: transformPoints");
+				kSIMDKernels.transformPoints(stages[i].worldSpace ? worldMatrix : worldInverseMatrix,
+											 points + start,
+											 chunkSize);
+				isChunkInWorldSpace = stages[i].worldSpace;
+			}
+			PerfCounterValues stageStart;
+			bool isCountingStage = perfCounters && readPerfCounterGroup(*perfCounters, stageStart) == 0;
+			int stageResult = runDeformStage(library, points + start, chunkSize, stages[i].envelope);
+			PerfCounterValues stageEnd;
+			if (isCountingStage && readPerfCounterGroup(*perfCounters, stageEnd) == 0) {
+				accumulatePerfCounters(logicCounters, stageStart, stageEnd);
+			}
+			if (stageResult != 0) {
+				return -1;
+			}
+		}
+		if (isChunkInWorldSpace) {
+			SS_PROFILE_ZONE("deform: transformPoints");
+			kSIMDKernels.transformPoints(worldInverseMatrix, points + start, chunkSize);
+		}
+	}
+
+	return 0;
+}
+
+
+/**
+ * Runs the stages over the same input with the previous version of the logic
+ * library, and adds the difference to the current version to ``kLogicShadowComparison``.
+ * Once enough evaluations have been compared, the result is reported and the
+ * previous version is unloaded.
+ *
+ * @param stages				The stages that were run, in evaluation order.
+ * @param numStages			The number of stages.
+ * @param pipeline				The state of the node; its shadow buffer holds the input.
+ * @param points				The points that the current version deformed.
+ * @param numPoints			The number of points.
+ * @param currentTicks			The time that the current version took to run the stages.
+ */
+static void runShadowEvaluation(const FusedStage *stages,
+								unsigned int numStages,
+								DeformerPipeline &pipeline,
+								const Vec3 *points,
+								unsigned int numPoints,
+								uint64_t currentTicks)
+{
+	SS_PROFILE_ZONE("deform: shadow evaluation");
+
+	// NOTE: (sonictk) This holds the lock while the previous version runs so that
+	// no other thread can unload it in the meantime. Since it is only held for the
+	// first few evaluations after a reload, the contention does not matter.
+	std::lock_guard<std::mutex> guard(kPreviousLogicLibraryLock);
+	if (!kPreviousLogicLibrary.isValid) {
+		return;
+	}
+	LogicShadowComparison &comparison = kLogicShadowComparison;
+	if (comparison.previousVersion != kPreviousLogicLibrary.version
+		|| comparison.currentVersion != kLogicLibrary.version) {
+		comparison = {};
+		comparison.previousVersion = kPreviousLogicLibrary.version;
+		comparison.currentVersion = kLogicLibrary.version;
+	}
+
+	Vec3 *shadowPoints = pipeline.shadowBuffer.points;
+	PerfCounterValues logicCounters = {};
+	uint64_t startTicks = readProfilerTicks();
+	int status = runDeformStages(kPreviousLogicLibrary,
+								 stages,
+								 numStages,
+								 pipeline,
+								 shadowPoints,
+								 numPoints,
+								 NULL,
+								 logicCounters);
+	uint64_t previousTicks = readProfilerTicks() - startTicks;
+	if (status != 0) {
+		displayDeformerError("The previous version of the logic library failed; it will no longer be compared.");
+		unloadPreviousDeformerLogicDLL();
+		return;
+	}
+
+	for (unsigned int i=0; i < numPoints; ++i) {
+		double dx = (double)points[i].x - (double)shadowPoints[i].x;
+		double dy = (double)points[i].y - (double)shadowPoints[i].y;
+		double dz = (double)points[i].z - (double)shadowPoints[i].z;
+		double squaredError = dx*dx + dy*dy + dz*dz;
+		comparison.sumSquaredError += squaredError;
+		if (squaredError > comparison.maxError) {
+			comparison.maxError = squaredError;
+		}
+	}
+	comparison.numPoints += numPoints;
+	comparison.previousTicks += previousTicks;
+	comparison.currentTicks += currentTicks;
+	++comparison.numEvaluations;
+
+	if (comparison.numEvaluations < kLogicShadowEvaluations.load(std::memory_order_relaxed)) {
+		return;
+	}
+
+	// NOTE: (sonictk) The maximum is kept squared until now to avoid a square root
+	// per point.
+	double maxError = sqrt(comparison.maxError);
+	double rmsError = comparison.numPoints > 0 ? sqrt(comparison.sumSquaredError / (double)comparison.numPoints) : 0.0;
+	double slowdown = comparison.previousTicks > 0 ? (double)comparison.currentTicks / (double)comparison.previousTicks : 1.0;
+	bool isSlower = slowdown > kLogicShadowSlowdownThreshold;
+	bool hasDiverged = maxError > kLogicShadowErrorThreshold;
+
+	char message[512];
+	snprintf(message,
+			 sizeof(message),
+			 "%sLogic library version %u took %.2fx the time of version %u over %u evaluation(s) "
+			 "of %llu points, with a max error of %g and an RMS error of %g.",
+			 isSlower || hasDiverged ? "REGRESSION: " : "",
+			 comparison.currentVersion,
+			 slowdown,
+			 comparison.previousVersion,
+			 comparison.numEvaluations,
+			 (unsigned long long)comparison.numPoints,
+			 maxError,
+			 rmsError);
+	if (isSlower || hasDiverged) {
+		displayDeformerWarning(message);
+	} else {
+		displayDeformerInfo(message);
+	}
+
+	unloadPreviousDeformerLogicDLL();
+}
+
+
+/**
+ * Does the work of ``evaluateDeformerPipeline`` once the stages to run and the
+ * number of points are known.
+ *
+ * @param pipeline		The state of the node.
+ * @param host			The host that provides the geometry and the node's attributes.
+ * @param stages		The stages to run, in evaluation order.
+ * @param numStages	The number of stages, which may be ``0``.
+ * @param numPoints	The number of points in the geometry.
+ * @param startTicks	When the evaluation started.
+ *
+ * @return				The result of the evaluation.
+ */
+static int runDeformerPipeline(DeformerPipeline &pipeline,
+							   const DeformerHost &host,
+							   const FusedStage *stages,
+							   unsigned int numStages,
+							   unsigned int numPoints,
+							   uint64_t startTicks)
+{
+	uint64_t reloadTicks = 0;
+	unsigned int numReloads = 0;
+
+	if (updateDeformerLogicDLL(kLogicLibrary, numReloads, reloadTicks) != LibraryStatus_Success) {
+		return -1;
+	}
+
+	// NOTE: (sonictk) Reloads are recorded straight away, since any node can be the
+	// one that notices the change, including one that returns early below.
+	if (numReloads > 0) {
+		DeformerStatsEntry *reloadStats = getDeformerStatsEntry(pipeline.statsID, kLogicLibrary.version);
+		if (reloadStats) {
+			addDeformerStat(reloadStats, DeformerCounter_Reloads, numReloads);
+			addDeformerStat(reloadStats, DeformerCounter_ReloadNanoseconds, (uint64_t)profilerTicksToNanoseconds(reloadTicks));
+		}
+	}
+
+	if (numStages == 0) {
+		return 0;
+	}
+
+	bool needsWorldSpace = false;
+	for (unsigned int i=0; i < numStages; ++i) {
+		needsWorldSpace |= stages[i].worldSpace;
+	}
+
+	// NOTE: (sonictk) Inverting the matrix is comparatively expensive, so we only
+	// do it when the geometry has actually moved since the last evaluation. The
+	// matrices are compared exactly, since ``operator==`` allows for some error.
+	bool isMatrixCacheHit = true;
+	if (needsWorldSpace) {
+		Mat44 matrix;
+		host.getWorldMatrix(host.data, matrix);
+		if (!pipeline.isWorldMatrixCacheValid || memcmp(&matrix, &pipeline.worldMatrix, sizeof(Mat44)) != 0) {
+			isMatrixCacheHit = false;
+			pipeline.worldMatrix = matrix;
+			pipeline.isWorldMatrixInvertible = inverseWorldMatrix(matrix, pipeline.worldInverseMatrix) == 0;
+			pipeline.isWorldMatrixCacheValid = true;
+			if (!pipeline.isWorldMatrixInvertible) {
+				displayDeformerWarning("The world matrix of the geometry has collapsed and cannot be inverted; "
+									   "its world space stages are skipped until it changes.");
+			}
+		}
+	}
+
+	// NOTE: (sonictk) A world matrix is always affine; if it has collapsed (e.g.
+	// been scaled to zero) there is no way back to local space, so the stages that
+	// need it are left out of this evaluation rather than run with a made-up inverse.
+	FusedStage localStages[kMaxFusedStages];
+	if (needsWorldSpace && !pipeline.isWorldMatrixInvertible) {
+		unsigned int numLocalStages = 0;
+		for (unsigned int i=0; i < numStages && numLocalStages < kMaxFusedStages; ++i) {
+			if (!stages[i].worldSpace) {
+				localStages[numLocalStages] = stages[i];
+				++numLocalStages;
+			}
+		}
+		stages = localStages;
+		numStages = numLocalStages;
+		if (numStages == 0) {
+			return 0;
+		}
+	}
+
+	if (numPoints == 0) {
+		return 0;
+	}
+
+	PointBuffer &pointBuffer = pipeline.pointBuffer;
+	bool isPointBufferHit = pointBuffer.points && pointBuffer.capacity >= numPoints;
+	if (reservePointBuffer(pointBuffer, numPoints) != 0) {
+		displayDeformerError("Unable to allocate the point buffer!");
+		return -1;
+	}
+
+	// NOTE: (sonictk) The counters are read around the whole evaluation below, and
+	// separately around each call into the logic library.
+	PerfCounterGroup *perfCounters = getDeformerPerfCounters();
+	PerfCounterValues deformCounters;
+	PerfCounterValues logicCounters = {};
+	bool isCountingEvents = perfCounters && readPerfCounterGroup(*perfCounters, deformCounters) == 0;
+
+	// NOTE: (yliangsiew) Load the points into the host buffer once, run every
+	// stage over cache-sized chunks of it, and then write the result back once.
+	Vec3 *buffer = pointBuffer.points;
+	if (host.readPoints(host.data, buffer, numPoints) != 0) {
+		return -1;
+	}
+
+	// NOTE: (sonictk) If the previous version of the logic library is still being
+	// compared against the current one, it needs its own copy of the input.
+	bool isShadowing = kLogicShadowEvaluations.load(std::memory_order_relaxed) > 0 && kHasPreviousLogicLibrary.load();
+	if (isShadowing) {
+		isShadowing = reservePointBuffer(pipeline.shadowBuffer, numPoints) == 0;
+		if (isShadowing) {
+			memcpy(pipeline.shadowBuffer.points, buffer, sizeof(Vec3) * numPoints);
+		}
+	}
+
+	// NOTE: (sonictk) Only the logic library's own calls are hooked, so this can
+	// be read around the whole loop rather than around each stage.
+	bool isTrackingAllocations = kLogicAllocationTrackingEnabled.load(std::memory_order_relaxed);
+	AllocationCounts allocationsStart = getThreadAllocationCounts();
+
+	uint64_t stagesStartTicks = readProfilerTicks();
+	if (runDeformStages(kLogicLibrary,
+						stages,
+						numStages,
+						pipeline,
+						buffer,
+						numPoints,
+						isCountingEvents ? perfCounters : NULL,
+						logicCounters) != 0) {
+		return -1;
+	}
+	uint64_t stagesTicks = readProfilerTicks() - stagesStartTicks;
+
+	AllocationCounts allocations = subtractAllocationCounts(getThreadAllocationCounts(), allocationsStart);
+
+	if (host.writePoints(host.data, buffer, numPoints) != 0) {
+		return -1;
+	}
+
+	PerfCounterValues deformEnd;
+	if (isCountingEvents && readPerfCounterGroup(*perfCounters, deformEnd) == 0) {
+		for (int i=0; i < PerfCounter_Count; ++i) {
+			deformCounters.values[i] = deformEnd.values[i] - deformCounters.values[i];
+		}
+	} else {
+		isCountingEvents = false;
+	}
+
+	// NOTE: (sonictk) Only evaluations that actually deformed the points are
+	// counted, so that the throughput is not skewed by fused or empty ones.
+	DeformerStatsEntry *stats = getDeformerStatsEntry(pipeline.statsID, kLogicLibrary.version);
+	if (stats) {
+		uint64_t deformNanoseconds = (uint64_t)profilerTicksToNanoseconds(readProfilerTicks() - startTicks);
+		addDeformerStat(stats, DeformerCounter_Evaluations, 1);
+		addDeformerStat(stats, DeformerCounter_Points, numPoints);
+		addDeformerStat(stats, DeformerCounter_DeformNanoseconds, deformNanoseconds);
+		if (needsWorldSpace) {
+			addDeformerStat(stats, DeformerCounter_MatrixCacheLookups, 1);
+			addDeformerStat(stats, DeformerCounter_MatrixCacheHits, isMatrixCacheHit ? 1 : 0);
+		}
+		addDeformerStat(stats, DeformerCounter_PointBufferLookups, 1);
+		addDeformerStat(stats, DeformerCounter_PointBufferHits, isPointBufferHit ? 1 : 0);
+		recordDeformerLatency(stats, deformNanoseconds);
+		if (isCountingEvents) {
+			addDeformerStat(stats, DeformerCounter_CountedPoints, numPoints);
+			addDeformerPerfCounters(stats, DeformerCounter_Cycles, deformCounters);
+			addDeformerPerfCounters(stats, DeformerCounter_LogicCycles, logicCounters);
+		}
+		if (isTrackingAllocations) {
+			addDeformerStat(stats, DeformerCounter_TrackedEvaluations, 1);
+			addDeformerStat(stats, DeformerCounter_TrackedPoints, numPoints);
+			addDeformerStat(stats, DeformerCounter_LogicAllocations, allocations.allocations);
+			addDeformerStat(stats, DeformerCounter_LogicFrees, allocations.frees);
+			addDeformerStat(stats, DeformerCounter_LogicAllocatedBytes, allocations.allocatedBytes);
+			addDeformerStat(stats, DeformerCounter_LogicFreedBytes, allocations.freedBytes);
+		}
+	}
+
+	// NOTE: (sonictk) This is done last so that the time the previous version takes
+	// is not counted in the statistics of this evaluation.
+	if (isShadowing) {
+		runShadowEvaluation(stages, numStages, pipeline, buffer, numPoints, stagesTicks);
+	}
+
+	return 0;
+}
+
+
+int evaluateDeformerPipeline(DeformerPipeline &pipeline, const DeformerHost &host)
+{
+	uint64_t startTicks = readProfilerTicks();
+
+	// NOTE: (sonictk) The number of points is only needed if the node deforms the
+	// points itself; fetching it can mean copying them out of the host.
+	FusedStage stages[kMaxFusedStages];
+	unsigned int numStages = host.getStages(host.data, stages, kMaxFusedStages);
+	unsigned int numPoints = numStages > 0 ? host.getNumPoints(host.data) : 0;
+
+	DEFORMER_PROBE3(deform_entry, pipeline.statsID, numPoints, kLogicLibrary.version);
+	DEFORMER_SET_PROBE_CONTEXT(pipeline.statsID, numPoints);
+
+	int result = runDeformerPipeline(pipeline, host, stages, numStages, numPoints, startTicks);
+
+	DEFORMER_SET_PROBE_CONTEXT(0, 0);
+	DEFORMER_PROBE4(deform_return, pipeline.statsID, numPoints, kLogicLibrary.version, result);
+
+	return result;
+}
@@ -0,0 +1,183 @@
+/**
+ * @brief	The part of the deformer that does not depend on Maya: it keeps the
+ * 		logic library up to date, loads the points into a host-side buffer, runs
+ * 		every fused stage over it and writes the result back.
+ *
+ * 		The application that owns the geometry (Maya, or the replay harness)
+ * 		provides access to the points and the node's attributes through a
+ * 		``DeformerHost``.
+ */
+#ifndef DEFORMER_HOST_H
+#define DEFORMER_HOST_H
+
+#include "deformer_platform.h"
+#include <ssmath/vector_math.h>
+#include <ssmath/matrix_math.h>
+
+
+/// The number of points that each fused stage processes at a time. This is
+/// chosen so that a chunk of points (12 bytes each) stays resident in L1 cache
+/// while every stage of the chain runs over it.
+static const unsigned int kFusedChunkSize = 1024;
+
+/// The maximum number of consecutive deformers that will be fused into a single
+/// pass. This also guards against walking a cyclic graph forever.
+static const unsigned int kMaxFusedStages = 32;
+
+
+/// This is a host-side buffer that the geometry's points are loaded into once
+/// per evaluation, so that all fused stages can run over it before the result
+/// is written back to the host.
+struct PointBuffer
+{
+	Vec3 *points;
+	unsigned int capacity;
+};
+
+
+/**
+ * Ensures that the given buffer has enough storage for at least ``numPoints``
+ * points. Existing contents are not preserved when the buffer grows.
+ *
+ * @param buffer		The buffer to resize.
+ * @param numPoints	The number of points that the buffer must be able to hold.
+ *
+ * @return				``0`` on success, a negative value if the allocation failed.
+ */
+int reservePointBuffer(PointBuffer &buffer, unsigned int numPoints);
+
+
+/**
+ * Frees the storage held by the given buffer.
+ *
+ * @param buffer		The buffer to free.
+ */
+void freePointBuffer(PointBuffer &buffer);
+
+
+/// This describes a single hot-reloadable deformer in a fused chain; all
+/// stages share the same logic library, so only the per-node inputs are stored.
+struct FusedStage
+{
+	float envelope;
+	bool worldSpace;
+};
+
+
+/// The callbacks through which the pipeline accesses the geometry being deformed
+/// and the attributes of the node(s) deforming it. Each is passed ``data``.
+struct DeformerHost
+{
+	void *data;
+
+	/**
+	 * Writes the stages to run over the points, in evaluation order.
+	 *
+	 * @return		The number of stages written, which may be ``0`` if the node has
+	 * 			nothing to do (e.g. its work is done by a downstream node).
+	 */
+	unsigned int (*getStages)(void *data, FusedStage *stages, unsigned int maxStages);
+
+	/// Sets ``matrix`` to the geometry's local-to-world matrix. This is only called
+	/// if any of the stages deforms in world space.
+	void (*getWorldMatrix)(void *data, Mat44 &matrix);
+
+	/// Returns the number of points in the geometry.
+	unsigned int (*getNumPoints)(void *data);
+
+	/// Copies the local-space positions of the geometry's points into ``points``.
+	/// Returns ``0`` on success, ``-1`` on failure.
+	int (*readPoints)(void *data, Vec3 *points, unsigned int numPoints);
+
+	/// Sets the positions of the geometry's points to the deformed ``points``.
+	/// Returns ``0`` on success, ``-1`` on failure.
+	int (*writePoints)(void *data, const Vec3 *points, unsigned int numPoints);
+};
+
+
+/// The state that a single deformer node keeps between its evaluations.
+struct DeformerPipeline
+{
+	PointBuffer pointBuffer;
+
+	/// Identifies the node's entries in the deformer statistics. Unlike the node's
+	/// name, this never changes.
+	unsigned int statsID;
+
+	/// The last world matrix that was used along with its inverse; the inverse is
+	/// only recomputed when the world matrix changes. If the world matrix has no
+	/// inverse, the world space stages are skipped until it changes.
+	Mat44 worldMatrix;
+	Mat44 worldInverseMatrix;
+	bool isWorldMatrixCacheValid;
+	bool isWorldMatrixInvertible;
+
+	/// A copy of the input points that the previous version of the logic library is
+	/// run on while it is being compared against the new one.
+	PointBuffer shadowBuffer;
+};
+
+
+/// A regression is reported if the new version of the logic library is slower
+/// than the previous one by more than this ratio, or if any point it deforms is
+/// further than this distance from where the previous version put it.
+static const double kLogicShadowSlowdownThreshold = 1.1;
+static const double kLogicShadowErrorThreshold = 1e-4;
+
+
+/// The comparison of the two versions of the logic library either side of the last
+/// reload (see ``kLogicShadowEvaluations``). Guarded by ``kPreviousLogicLibraryLock``.
+struct LogicShadowComparison
+{
+	unsigned int previousVersion;
+	unsigned int currentVersion;
+	unsigned int numEvaluations;
+	uint64_t numPoints;
+
+	/// The time that each version spent running the stages over the same points.
+	uint64_t previousTicks;
+	uint64_t currentTicks;
+
+	/// The distances between the points that the versions deformed.
+	double maxError;
+	double sumSquaredError;
+};
+
+globalVar LogicShadowComparison kLogicShadowComparison = {};
+
+
+/**
+ * Sets up the state of a new deformer node.
+ *
+ * @param pipeline		The state to set up.
+ * @param statsID		The ID of the node's entries in the deformer statistics. Must
+ * 					not be ``0``.
+ */
+void initializeDeformerPipeline(DeformerPipeline &pipeline, unsigned int statsID);
+
+
+/**
+ * Frees the storage held by the state of a deformer node.
+ *
+ * @param pipeline		The state to free.
+ */
+void freeDeformerPipeline(DeformerPipeline &pipeline);
+
+
+/**
+ * Evaluates a deformer node once with ``kLogicLibrary``, reloading the library first
+ * if it has changed on disk, and records the evaluation in the deformer statistics.
+ * Shortly after a reload, this may also run the previous version of the library
+ * on the same points to compare the two (see ``kLogicShadowEvaluations``).
+ *
+ * @param pipeline		The state of the node.
+ * @param host			The host that provides the geometry and the node's attributes.
+ *
+ * @return				``0`` on success, ``-1`` if the logic library could not be
+ * 					loaded, the points could not be read or written or any stage
+ * 					failed.
+ */
+int evaluateDeformerPipeline(DeformerPipeline &pipeline, const DeformerHost &host);
+
+
+#endif /* DEFORMER_HOST_H */
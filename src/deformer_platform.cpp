@@ -1,32 +1,69 @@
 #include "deformer_platform.h"
-#include <maya/MString.h>
-#include <maya/MGlobal.h>
 
 
-MString getDeformerLogicLibraryPath(const char *pluginPath)
+int getDeformerLogicLibraryPath(const char *pluginPath, char *libraryPath, unsigned int len)
 {
 	if (strlen(pluginPath) <= 0) {
-		return MString();
+		return -1;
+	}
+	int written = snprintf(libraryPath, len, "%s%c%s", pluginPath, kPathDelimiter, kDeformerLogicLibraryName);
+	if (written < 0 || (unsigned int)written >= len) {
+		libraryPath[0] = '\0';
+		return -1;
 	}
-	char pathDelimiter[2] = {kPathDelimiter, '\0'};
-	MString delimiter(pathDelimiter);
-	MString pluginPathStr(pluginPath);
-	MString libFilename = pluginPathStr + delimiter + kDeformerLogicLibraryName;
 
-	return libFilename;
+	return 0;
 }
 
 
 LibraryStatus loadDeformerLogicDLL(DeformerLogicLibrary &library)
 {
-	const char *libFilenameC = kPluginLogicLibraryPath.asChar();
+	SS_PROFILE_FUNCTION();
+
+	const char *libFilenameC = kPluginLogicLibraryPath;
 
-	FileTime lastModified = getLastWriteTime(libFilenameC);
+	FileTime lastModified;
+	{
+		SS_PROFILE_ZONE("reload: getLastWriteTime");
+		lastModified = getLastWriteTime(libFilenameC);
+	}
 	library.lastModified = lastModified;
 
-	DLLHandle handle = loadSharedLibrary(libFilenameC);
+	// NOTE: (sonictk) While versions are being compared, the previous version may
+	// still be loaded from the same path, in which case the OS would just hand its
+	// handle back. Each version is loaded from its own copy of the library instead.
+	library.loadedPath[0] = '\0';
+	if (kLogicShadowEvaluations.load() > 0) {
+		SS_PROFILE_ZONE("reload: copyFile");
+		int written = snprintf(library.loadedPath,
+							   kMaxPathLen,
+							   "%s.%u",
+							   kPluginLogicLibraryPath,
+							   kLogicLibraryLoadCount + 1);
+		if (written < 0 || (unsigned int)written >= kMaxPathLen
+			|| copyFile(kPluginLogicLibraryPath, library.loadedPath) != 0) {
+			displayDeformerError("Unable to copy logic library!");
+			library.handle = NULL;
+			library.lastModified = {};
+			library.loadedPath[0] = '\0';
+			library.isValid = false;
+
+			return LibraryStatus_InvalidLibrary;
+		}
+		libFilenameC = library.loadedPath;
+	}
+
+	DLLHandle handle;
+	{
+		SS_PROFILE_ZONE("reload: loadSharedLibrary");
+		handle = loadSharedLibrary(libFilenameC);
+	}
 	if (!handle) {
-		MGlobal::displayError("Unable to load logic library!");
+		displayDeformerError("Unable to load logic library!");
+		if (library.loadedPath[0] != '\0') {
+			deleteFile(library.loadedPath);
+			library.loadedPath[0] = '\0';
+		}
 		library.handle = NULL;
 		library.lastModified = {};
 		library.isValid = false;
@@ -36,16 +73,44 @@ LibraryStatus loadDeformerLogicDLL(DeformerLogicLibrary &library)
 
 	library.handle = handle;
 
-	FuncPtr getValueFuncAddr = loadSymbolFromLibrary(handle, "getValue");
+	FuncPtr getValueFuncAddr;
+	FuncPtr deformPointsFuncAddr;
+	{
+		SS_PROFILE_ZONE("reload: resolve symbols");
+		getValueFuncAddr = loadSymbolFromLibrary(handle, "getValue");
+		// NOTE: (sonictk) The batched entry point is optional; if a library does not
+		// export it, the host falls back to calling ``getValue`` for each point.
+		deformPointsFuncAddr = findSymbolInLibrary(handle, "deformPoints");
+	}
 	if (!getValueFuncAddr) {
-		MGlobal::displayError("Could not find symbols in library!");
+		displayDeformerError("Could not find symbols in library!");
+		unloadSharedLibrary(handle);
+		if (library.loadedPath[0] != '\0') {
+			deleteFile(library.loadedPath);
+			library.loadedPath[0] = '\0';
+		}
+		library.handle = NULL;
+		library.lastModified = {};
+		library.isValid = false;
+
 		return LibraryStatus_InvalidSymbol;
 	}
 
 	library.deformCB = (DeformFunc)getValueFuncAddr;
+	library.deformPointsCB = (DeformPointsFunc)deformPointsFuncAddr;
+	library.version = ++kLogicLibraryLoadCount;
 	library.isValid = true;
 
-	MGlobal::displayInfo("Loaded library from: " + kPluginLogicLibraryPath);
+	DEFORMER_CONTEXT_PROBE4(library_open, library.version, libFilenameC);
+
+	library.allocationHooks.numSlots = 0;
+	if (kLogicAllocationTrackingEnabled.load() && installAllocationHooks(handle, library.allocationHooks) != 0) {
+		displayDeformerError("Unable to track the allocations of the logic library!");
+	}
+
+	char message[kMaxPathLen + 32];
+	snprintf(message, sizeof(message), "Loaded library from: %s", kPluginLogicLibraryPath);
+	displayDeformerInfo(message);
 
 	return LibraryStatus_Success;
 }
@@ -53,18 +118,153 @@ LibraryStatus loadDeformerLogicDLL(DeformerLogicLibrary &library)
 
 LibraryStatus unloadDeformerLogicDLL(DeformerLogicLibrary &library)
 {
-	if (!kLogicLibrary.isValid) {
+	SS_PROFILE_FUNCTION();
+
+	if (!library.isValid) {
 		return LibraryStatus_InvalidHandle;
 	}
-	int unload = unloadSharedLibrary(kLogicLibrary.handle);
+	removeAllocationHooks(library.allocationHooks);
+
+	DEFORMER_CONTEXT_PROBE4(library_close,
+							library.version,
+							library.loadedPath[0] != '\0' ? library.loadedPath : kPluginLogicLibraryPath);
+
+	int unload;
+	{
+		SS_PROFILE_ZONE("reload: unloadSharedLibrary");
+		unload = unloadSharedLibrary(library.handle);
+	}
 	if (unload != 0) {
-		MGlobal::displayError("Unable to unload shared library!");
+		displayDeformerError("Unable to unload shared library!");
 		return LibraryStatus_UnloadFailure;
 	}
+	if (library.loadedPath[0] != '\0') {
+		deleteFile(library.loadedPath);
+		library.loadedPath[0] = '\0';
+	}
 
 	library.deformCB = NULL;
+	library.deformPointsCB = NULL;
 	library.lastModified = {};
 	library.isValid = false;
 
 	return LibraryStatus_Success;
 }
+
+
+int setDeformerLogicAllocationTracking(DeformerLogicLibrary &library, bool enable)
+{
+	if (!enable) {
+		kLogicAllocationTrackingEnabled.store(false);
+		removeAllocationHooks(library.allocationHooks);
+		return 0;
+	}
+
+	if (!kAllocationHooksSupported) {
+		return -1;
+	}
+	if (library.isValid && installAllocationHooks(library.handle, library.allocationHooks) != 0) {
+		return -1;
+	}
+	kLogicAllocationTrackingEnabled.store(true);
+
+	return 0;
+}
+
+
+void setDeformerLogicShadowEvaluations(unsigned int numEvaluations)
+{
+	kLogicShadowEvaluations.store(numEvaluations);
+	if (numEvaluations == 0) {
+		std::lock_guard<std::mutex> guard(kPreviousLogicLibraryLock);
+		unloadPreviousDeformerLogicDLL();
+	}
+}
+
+
+void unloadPreviousDeformerLogicDLL()
+{
+	unloadDeformerLogicDLL(kPreviousLogicLibrary);
+	kHasPreviousLogicLibrary.store(false);
+}
+
+
+LibraryStatus updateDeformerLogicDLL(DeformerLogicLibrary &library,
+									 unsigned int &numReloads,
+									 uint64_t &reloadTicks)
+{
+	LibraryStatus status;
+
+	if (!library.isValid) {
+#ifdef _DEBUG_MODE
+		displayDeformerError("The logic DLL is not valid, attempting reload!");
+#endif
+		DEFORMER_CONTEXT_PROBE3(reload_detected, 0);
+		uint64_t reloadStartTicks = readProfilerTicks();
+
+		// NOTE: (sonictk) Just in case, we make sure the library is unloaded
+		unloadDeformerLogicDLL(library);
+		status = loadDeformerLogicDLL(library);
+		if (status != LibraryStatus_Success) {
+			return status;
+		}
+		reloadTicks += readProfilerTicks() - reloadStartTicks;
+		++numReloads;
+	}
+
+	// NOTE: (yliangsiew) Find the last modified time of the DLL and check if
+	// there is a newer version; if so, unload the existing DLL and load the new
+	// one, then fix up the function pointers again
+	if (kPluginLogicLibraryPath[0] == '\0') {
+		return LibraryStatus_Failure;
+	}
+
+	// NOTE: (sonictk) We only reload the DLL *if* the DLL actually exists; this
+	// is so we can rename the DLL on Windows to avoid having the DLL handle be locked.
+	FileTime lastModified;
+	{
+		SS_PROFILE_ZONE("deform: check for reload");
+		lastModified = getLastWriteTime(kPluginLogicLibraryPath);
+	}
+	if (lastModified >= 0 && lastModified != library.lastModified) {
+		SS_PROFILE_ZONE("deform: reload logic library");
+		DEFORMER_CONTEXT_PROBE3(reload_detected, library.version);
+
+		uint64_t reloadStartTicks = readProfilerTicks();
+#ifdef _DEBUG_MODE
+		displayDeformerInfo("DEBUG: Reloading logic DLL...");
+#endif // _DEBUG_MODE
+		// NOTE: (sonictk) If versions are being compared, the current version is
+		// kept loaded as the previous one instead, replacing the one before it.
+		if (kLogicShadowEvaluations.load() > 0 && library.isValid) {
+			std::lock_guard<std::mutex> guard(kPreviousLogicLibraryLock);
+			unloadPreviousDeformerLogicDLL();
+			kPreviousLogicLibrary = library;
+			kHasPreviousLogicLibrary.store(true);
+			library.handle = NULL;
+			library.deformCB = NULL;
+			library.deformPointsCB = NULL;
+			library.loadedPath[0] = '\0';
+			library.isValid = false;
+		} else {
+			status = unloadDeformerLogicDLL(library);
+			if (status != LibraryStatus_Success) {
+#ifdef _DEBUG_MODE
+				displayDeformerError("Unable to unload logic library!");
+#endif
+				return status;
+			}
+		}
+		status = loadDeformerLogicDLL(library);
+		if (status != LibraryStatus_Success) {
+#ifdef _DEBUG_MODE
+			displayDeformerError("Unable to load logic library!");
+#endif
+			return status;
+		}
+		reloadTicks += readProfilerTicks() - reloadStartTicks;
+		++numReloads;
+	}
+
+	return LibraryStatus_Success;
+}
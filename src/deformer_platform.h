@@ -3,15 +3,32 @@
 
 #include <ssmath/platform.h>
 #include <ssmath/vector_math.h>
+#include <ssmath/alloc_tracker.h>
+#include "deformer_probes.h"
 #include <limits.h>
+#include <atomic>
+#include <mutex>
 
 /// This is the prototype for the function that will be dynamically hotloaded.
 typedef Vec3 (*DeformFunc)(Vec3&, float);
 
+/// This is the prototype for the batched version of ``DeformFunc``, which deforms
+/// a contiguous array of points in-place. Libraries are not required to export it.
+typedef int (*DeformPointsFunc)(Vec3 *, unsigned int, float);
+
 
 /// This is initialized to the path of the deformer's **business logic** DLL
-/// whenever the plugin is initialized.
-globalVar MString kPluginLogicLibraryPath;
+/// whenever the plugin (or any other host) is initialized.
+globalVar char kPluginLogicLibraryPath[kMaxPathLen];
+
+
+/// If set, the plugin writes a trace of the most recent zones on each thread (see
+/// ``kProfilerBufferSize``) to the file named by this environment variable when it
+/// is unloaded.
+globalVar const char *kDeformerTraceFileEnvVar = "HOTRELOAD_DEFORMER_TRACE_FILE";
+
+/// The path of the trace file to write, or empty if no trace should be written.
+globalVar char kPluginTraceFilePath[kMaxPathLen];
 
 
 #ifdef _WIN32
@@ -43,6 +60,10 @@ struct DeformerLogicLibrary
 	FileTime lastModified;
 
 	DeformFunc deformCB;
+	DeformPointsFunc deformPointsCB; // NOTE: (sonictk) Optional; may be ``NULL``
+	unsigned int version; // NOTE: (sonictk) The value of ``kLogicLibraryLoadCount`` when loaded
+	AllocationHooks allocationHooks; // NOTE: (sonictk) Only installed while allocations are tracked
+	char loadedPath[kMaxPathLen]; // NOTE: (sonictk) The copy that was loaded instead, if any; deleted on unload
 	bool isValid;
 };
 
@@ -50,17 +71,55 @@ struct DeformerLogicLibrary
 /// This is the global reference to the *business logic* DLL that is loaded.
 globalVar DeformerLogicLibrary kLogicLibrary = {};
 
+/// The number of times that a logic library has been loaded, which is used to tell
+/// the different versions of it apart.
+globalVar unsigned int kLogicLibraryLoadCount = 0;
+
+/// When set, the heap allocations that the logic library makes are counted (see
+/// ``alloc_tracker.h``), and every version of it that is loaded is hooked as well.
+globalVar std::atomic<bool> kLogicAllocationTrackingEnabled;
+
+/// When this is not ``0``, the version of the logic library that a reload replaces
+/// is kept loaded, and for this many evaluations afterwards it is also run on the
+/// same points as the new version so that the two can be compared.
+globalVar std::atomic<unsigned int> kLogicShadowEvaluations;
+
+/// The version of the logic library that was replaced by the last reload, if it
+/// is still being compared against the new one. Guarded by ``kPreviousLogicLibraryLock``.
+globalVar DeformerLogicLibrary kPreviousLogicLibrary = {};
+globalVar std::mutex kPreviousLogicLibraryLock;
+
+/// Mirrors ``kPreviousLogicLibrary.isValid`` so that evaluations can check whether
+/// there is anything to compare without taking the lock. Only written while
+/// holding ``kPreviousLogicLibraryLock``.
+globalVar std::atomic<bool> kHasPreviousLogicLibrary;
+
 
 /**
  * This function gets the full path to the *business logic* DLL. This file may/may
  * not exist on disk yet at the time this path is formatted.
  *
- * @param pluginPath	The path to the host Maya plugin DLL. Must use the OS-specific
- * 					path separators.
+ * @param pluginPath	The directory of the host Maya plugin DLL (or other host
+ * 					executable). Must use the OS-specific path separators.
+ * @param libraryPath	The buffer to write the path to the *business logic* DLL to.
+ * @param len			The size of ``libraryPath``, in bytes.
  *
- * @return				The path to the *business logic* DLL.
+ * @return				``0`` on success, ``-1`` if the plugin path is empty or the
+ * 					result does not fit in the buffer.
  */
-MString getDeformerLogicLibraryPath(const char *pluginPath);
+int getDeformerLogicLibraryPath(const char *pluginPath, char *libraryPath, unsigned int len);
+
+
+/**
+ * These are used to report the progress and errors of loading the logic library.
+ * The loader is shared between the Maya plugin and other hosts, such as the replay
+ * harness, so each host implements them to report messages in its own way.
+ *
+ * @param message	The message to report.
+ */
+void displayDeformerInfo(const char *message);
+void displayDeformerWarning(const char *message);
+void displayDeformerError(const char *message);
 
 
 LibraryStatus loadDeformerLogicDLL(DeformerLogicLibrary &library);
@@ -69,4 +128,52 @@ LibraryStatus loadDeformerLogicDLL(DeformerLogicLibrary &library);
 LibraryStatus unloadDeformerLogicDLL(DeformerLogicLibrary &library);
 
 
+/**
+ * Starts or stops counting the heap allocations that the logic library makes,
+ * including in every version of it that is loaded from now on.
+ *
+ * @param library		The library that is currently loaded, if any.
+ * @param enable		Whether allocations should be counted.
+ *
+ * @return				``0`` on success, ``-1`` if the library could not be hooked
+ * 					(e.g. on platforms other than Linux), in which case tracking
+ * 					is left disabled.
+ */
+int setDeformerLogicAllocationTracking(DeformerLogicLibrary &library, bool enable);
+
+
+/**
+ * Sets the number of evaluations after each reload for which the previous version
+ * of the logic library is compared against the new one (see ``kLogicShadowEvaluations``).
+ * Setting it to ``0`` unloads the previous version if it is still loaded.
+ *
+ * @param numEvaluations	The number of evaluations to compare, or ``0`` to disable
+ * 						the comparison.
+ */
+void setDeformerLogicShadowEvaluations(unsigned int numEvaluations);
+
+
+/**
+ * Unloads ``kPreviousLogicLibrary`` if it is loaded. The caller must hold
+ * ``kPreviousLogicLibraryLock``.
+ */
+void unloadPreviousDeformerLogicDLL();
+
+
+/**
+ * Makes sure that the given library is loaded and is the latest version on disk,
+ * (re)loading it if it is not.
+ *
+ * @param library		The library to update.
+ * @param numReloads	Incremented for every time the library was (re)loaded.
+ * @param reloadTicks	Incremented by the profiler ticks that the reloads took.
+ *
+ * @return				``LibraryStatus_Success`` if the library is ready to be
+ * 					called, or the reason it is not.
+ */
+LibraryStatus updateDeformerLogicDLL(DeformerLogicLibrary &library,
+									 unsigned int &numReloads,
+									 uint64_t &reloadTicks);
+
+
 #endif /* DEFORMER_PLATFORM_H */
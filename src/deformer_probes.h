@@ -0,0 +1,81 @@
+/**
+ * @brief	Static tracepoints (SystemTap SDT probes) in the deformer, which can be
+ * 		attached to in a running session with ``bpftrace`` or ``perf`` without
+ * 		rebuilding the plugin. For example:
+ *
+ * 		bpftrace -e 'usdt:/path/to/hotReloadableDeformer.so:hotreload_deformer:deform_return
+ * 		             { @points[arg0] = sum(arg1); }'
+ *
+ * 		A probe that is not attached to is a single ``nop`` instruction, and its
+ * 		arguments are values that are already at hand, so they are always compiled
+ * 		in when ``<sys/sdt.h>`` is available (on Linux, from ``systemtap-sdt-dev``).
+ * 		Define ``DEFORMER_DISABLE_PROBES`` to compile them out entirely.
+ *
+ * 		Every probe of the ``hotreload_deformer`` provider takes the ID of the node
+ * 		(see ``DeformerPipeline::statsID``), the number of points and the version
+ * 		of the logic library (see ``DeformerLogicLibrary::version``) as its first
+ * 		three arguments:
+ *
+ * 		- ``deform_entry``, ``deform_return``: Around each evaluation of a node.
+ * 		  ``deform_return`` also takes the result of the evaluation (``0`` or ``-1``).
+ * 		  Nodes whose work is done by a downstream node report ``0`` points.
+ * 		- ``reload_detected``: When the logic library has changed on disk (or is not
+ * 		  loaded), with the version that is about to be replaced (or ``0``).
+ * 		- ``library_open``, ``library_close``: After the logic library is loaded and
+ * 		  before it is unloaded, with the path that it was loaded from.
+ * 		- ``logic_entry``, ``logic_return``: Around each call into the logic library,
+ * 		  with the number of points in the call. ``logic_return`` also takes the
+ * 		  result of the call.
+ *
+ * 		The loader does not know which node it is loading the library for, so the
+ * 		node and number of points of the evaluation that the calling thread is in
+ * 		are kept in ``tDeformerProbeContext``; outside of an evaluation, both are ``0``.
+ */
+#ifndef DEFORMER_PROBES_H
+#define DEFORMER_PROBES_H
+
+#if defined(__linux__) && defined(__has_include) && !defined(DEFORMER_DISABLE_PROBES)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define DEFORMER_HAS_PROBES 1
+#endif
+#endif // Probe support
+
+
+#ifdef DEFORMER_HAS_PROBES
+
+/// The node and number of points of the evaluation that the thread is in.
+struct DeformerProbeContext
+{
+	unsigned int nodeID;
+	unsigned int numPoints;
+};
+
+static thread_local DeformerProbeContext tDeformerProbeContext;
+
+#define DEFORMER_PROBE3(name, node, points, version) \
+	STAP_PROBE3(hotreload_deformer, name, node, points, version)
+#define DEFORMER_PROBE4(name, node, points, version, arg) \
+	STAP_PROBE4(hotreload_deformer, name, node, points, version, arg)
+
+/// Fires a probe with the node and number of points of the current evaluation.
+#define DEFORMER_CONTEXT_PROBE3(name, version) \
+	DEFORMER_PROBE3(name, tDeformerProbeContext.nodeID, tDeformerProbeContext.numPoints, version)
+#define DEFORMER_CONTEXT_PROBE4(name, version, arg) \
+	DEFORMER_PROBE4(name, tDeformerProbeContext.nodeID, tDeformerProbeContext.numPoints, version, arg)
+
+#define DEFORMER_SET_PROBE_CONTEXT(node, points) \
+	do { tDeformerProbeContext.nodeID = (node); tDeformerProbeContext.numPoints = (points); } while (0)
+
+#else
+
+#define DEFORMER_PROBE3(name, node, points, version)
+#define DEFORMER_PROBE4(name, node, points, version, arg)
+#define DEFORMER_CONTEXT_PROBE3(name, version)
+#define DEFORMER_CONTEXT_PROBE4(name, version, arg)
+#define DEFORMER_SET_PROBE_CONTEXT(node, points)
+
+#endif // DEFORMER_HAS_PROBES
+
+
+#endif /* DEFORMER_PROBES_H */
@@ -0,0 +1,298 @@
+#include "deformer_stats.h"
+#include <new>
+
+
+/// Packs a node and library version into the key of an entry. Node IDs start from
+/// ``1``, so a used entry never has a key of ``0``.
+static inline uint64_t deformerStatsKey(unsigned int nodeID, unsigned int libraryVersion)
+{
+	return ((uint64_t)nodeID << 32) | (uint64_t)libraryVersion;
+}
+
+
+/// The key of an entry that was evicted. It is never the key of a used entry, since
+/// the library versions count up from ``1``.
+static const uint64_t kDeformerStatsEvictedKey = ~0ull;
+
+
+static void clearDeformerStatsCounters(DeformerStatsEntry &entry)
+{
+	for (unsigned int i=0; i < DeformerCounter_Count; ++i) {
+		entry.counters[i].store(0, std::memory_order_relaxed);
+	}
+	for (unsigned int i=0; i < kNumDeformerLatencyBuckets; ++i) {
+		entry.latencies[i].store(0, std::memory_order_relaxed);
+	}
+}
+
+
+static void clearDeformerStatsEntry(DeformerStatsEntry &entry)
+{
+	entry.key.store(0, std::memory_order_relaxed);
+	clearDeformerStatsCounters(entry);
+}
+
+
+/**
+ * Evicts the entries of a thread's table that belong to library versions older than
+ * the last ``kDeformerStatsVersionsKept`` up to and including ``libraryVersion``.
+ *
+ * @param table			The calling thread's table.
+ * @param libraryVersion	The newest version of the logic library.
+ */
+static void evictStaleDeformerStatsEntries(DeformerStatsThreadTable *table, unsigned int libraryVersion)
+{
+	for (unsigned int i=0; i < kMaxDeformerStatsEntries; ++i) {
+		DeformerStatsEntry &entry = table->entries[i];
+		uint64_t key = entry.key.load(std::memory_order_relaxed);
+		if (key == 0 || key == kDeformerStatsEvictedKey) {
+			continue;
+		}
+		unsigned int entryVersion = (unsigned int)(key & 0xffffffff);
+		if (entryVersion + kDeformerStatsVersionsKept > libraryVersion) {
+			continue;
+		}
+
+		// NOTE: (sonictk) The entry cannot simply be emptied, since that would cut
+		// short the probe sequence of any entry after it. Readers stop merging it as
+		// soon as they see the new key, before its counters are cleared for reuse.
+		entry.key.store(kDeformerStatsEvictedKey, std::memory_order_release);
+		clearDeformerStatsCounters(entry);
+	}
+}
+
+
+static DeformerStatsThreadTable *getDeformerStatsThreadTable()
+{
+	uint32_t generation = kDeformerStats.generation.load(std::memory_order_relaxed);
+	if (tDeformerStatsTable && tDeformerStatsGeneration == generation) {
+		return tDeformerStatsTable;
+	}
+
+	void *memory = malloc(sizeof(DeformerStatsThreadTable));
+	if (!memory) {
+		return NULL;
+	}
+	DeformerStatsThreadTable *table = new (memory) DeformerStatsThreadTable;
+	for (unsigned int i=0; i < kMaxDeformerStatsEntries; ++i) {
+		clearDeformerStatsEntry(table->entries[i]);
+	}
+	table->epoch.store(kDeformerStats.epoch.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	table->latestLibraryVersion = 0;
+	table->hasOpenedPerfCounters = false;
+	table->perfCounters.isValid = false;
+
+	table->next = kDeformerStats.threads.load(std::memory_order_relaxed);
+	while (!kDeformerStats.threads.compare_exchange_weak(table->next,
+														 table,
+														 std::memory_order_release,
+														 std::memory_order_relaxed)) {}
+
+	tDeformerStatsTable = table;
+	tDeformerStatsGeneration = generation;
+
+	return table;
+}
+
+
+DeformerStatsEntry *getDeformerStatsEntry(unsigned int nodeID, unsigned int libraryVersion)
+{
+	DeformerStatsThreadTable *table = getDeformerStatsThreadTable();
+	if (!table) {
+		return NULL;
+	}
+
+	uint32_t epoch = kDeformerStats.epoch.load(std::memory_order_relaxed);
+	if (table->epoch.load(std::memory_order_relaxed) != epoch) {
+		for (unsigned int i=0; i < kMaxDeformerStatsEntries; ++i) {
+			clearDeformerStatsEntry(table->entries[i]);
+		}
+		table->epoch.store(epoch, std::memory_order_release);
+		table->latestLibraryVersion = 0;
+	}
+
+	if (libraryVersion > table->latestLibraryVersion) {
+		evictStaleDeformerStatsEntries(table, libraryVersion);
+		table->latestLibraryVersion = libraryVersion;
+	}
+
+	uint64_t key = deformerStatsKey(nodeID, libraryVersion);
+	unsigned int slot = (unsigned int)((key * 0x9e3779b97f4a7c15ull) >> 32) & (kMaxDeformerStatsEntries - 1);
+	DeformerStatsEntry *evictedEntry = NULL;
+	for (unsigned int i=0; i < kMaxDeformerStatsEntries; ++i) {
+		DeformerStatsEntry &entry = table->entries[(slot + i) & (kMaxDeformerStatsEntries - 1)];
+		uint64_t entryKey = entry.key.load(std::memory_order_relaxed);
+		if (entryKey == key) {
+			return &entry;
+		}
+		if (entryKey == kDeformerStatsEvictedKey) {
+			if (!evictedEntry) {
+				evictedEntry = &entry;
+			}
+			continue;
+		}
+		if (entryKey == 0) {
+			evictedEntry = evictedEntry ? evictedEntry : &entry;
+			break;
+		}
+	}
+
+	if (evictedEntry) {
+		// NOTE: (sonictk) The counters are already zero, so publishing the key
+		// is all that is needed for readers to start merging the entry.
+		evictedEntry->key.store(key, std::memory_order_release);
+	}
+
+	return evictedEntry;
+}
+
+
+PerfCounterGroup *getDeformerPerfCounters()
+{
+	if (!kDeformerPerfCountersEnabled.load(std::memory_order_relaxed)) {
+		return NULL;
+	}
+
+	DeformerStatsThreadTable *table = getDeformerStatsThreadTable();
+	if (!table) {
+		return NULL;
+	}
+
+	// NOTE: (sonictk) The counters only count the thread that opened them, so each
+	// thread opens its own, and keeps them open until the plugin is unloaded.
+	if (!table->hasOpenedPerfCounters) {
+		openPerfCounterGroup(table->perfCounters);
+		table->hasOpenedPerfCounters = true;
+	}
+
+	return table->perfCounters.isValid ? &table->perfCounters : NULL;
+}
+
+
+void recordDeformerLatency(DeformerStatsEntry *entry, uint64_t nanoseconds)
+{
+	unsigned int bucket = 0;
+	if (nanoseconds >= (1ull << kDeformerLatencyMinOctave)) {
+		unsigned int octave = kDeformerLatencyMinOctave;
+		while ((nanoseconds >> (octave + 1)) != 0) {
+			++octave;
+		}
+		unsigned int subBucket = (unsigned int)(nanoseconds >> (octave - 3)) & (kDeformerLatencySubBuckets - 1);
+		bucket = ((octave - kDeformerLatencyMinOctave) * kDeformerLatencySubBuckets) + subBucket;
+		if (bucket >= kNumDeformerLatencyBuckets) {
+			bucket = kNumDeformerLatencyBuckets - 1;
+		}
+	}
+
+	std::atomic<uint32_t> &count = entry->latencies[bucket];
+	count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+
+double getDeformerLatencyBucketValue(unsigned int bucket)
+{
+	unsigned int octave = (bucket / kDeformerLatencySubBuckets) + kDeformerLatencyMinOctave;
+	unsigned int subBucket = bucket % kDeformerLatencySubBuckets;
+	double width = (double)(1ull << (octave - 3));
+
+	return ((double)(kDeformerLatencySubBuckets + subBucket) * width) + (width * 0.5);
+}
+
+
+double getDeformerLatencyPercentile(const DeformerStatsSummary &summary, double percentile)
+{
+	uint64_t total = 0;
+	for (unsigned int i=0; i < kNumDeformerLatencyBuckets; ++i) {
+		total += summary.latencies[i];
+	}
+	if (total == 0) {
+		return 0.0;
+	}
+
+	// NOTE: (sonictk) This is the nearest-rank percentile, i.e. the smallest latency
+	// that at least ``percentile`` percent of the evaluations were no slower than.
+	double rank = (percentile / 100.0) * (double)total;
+	uint64_t seen = 0;
+	for (unsigned int i=0; i < kNumDeformerLatencyBuckets; ++i) {
+		seen += summary.latencies[i];
+		if (seen > 0 && (double)seen >= rank) {
+			return getDeformerLatencyBucketValue(i);
+		}
+	}
+
+	return getDeformerLatencyBucketValue(kNumDeformerLatencyBuckets - 1);
+}
+
+
+unsigned int gatherDeformerStats(DeformerStatsSummary *summaries, unsigned int maxSummaries)
+{
+	uint32_t epoch = kDeformerStats.epoch.load(std::memory_order_relaxed);
+	unsigned int numSummaries = 0;
+
+	for (DeformerStatsThreadTable *table = kDeformerStats.threads.load(std::memory_order_acquire);
+		 table;
+		 table = table->next) {
+		// NOTE: (sonictk) Tables that have not been cleared since the last reset
+		// only hold stale statistics.
+		if (table->epoch.load(std::memory_order_acquire) != epoch) {
+			continue;
+		}
+
+		for (unsigned int i=0; i < kMaxDeformerStatsEntries; ++i) {
+			const DeformerStatsEntry &entry = table->entries[i];
+			uint64_t key = entry.key.load(std::memory_order_acquire);
+			if (key == 0 || key == kDeformerStatsEvictedKey) {
+				continue;
+			}
+
+			unsigned int nodeID = (unsigned int)(key >> 32);
+			unsigned int libraryVersion = (unsigned int)(key & 0xffffffff);
+
+			DeformerStatsSummary *summary = NULL;
+			for (unsigned int j=0; j < numSummaries; ++j) {
+				if (summaries[j].nodeID == nodeID && summaries[j].libraryVersion == libraryVersion) {
+					summary = &summaries[j];
+					break;
+				}
+			}
+			if (!summary) {
+				if (numSummaries >= maxSummaries) {
+					continue;
+				}
+				summary = &summaries[numSummaries++];
+				memset(summary, 0, sizeof(DeformerStatsSummary));
+				summary->nodeID = nodeID;
+				summary->libraryVersion = libraryVersion;
+			}
+
+			for (unsigned int c=0; c < DeformerCounter_Count; ++c) {
+				summary->counters[c] += entry.counters[c].load(std::memory_order_relaxed);
+			}
+			for (unsigned int b=0; b < kNumDeformerLatencyBuckets; ++b) {
+				summary->latencies[b] += entry.latencies[b].load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	return numSummaries;
+}
+
+
+void resetDeformerStats()
+{
+	kDeformerStats.epoch.fetch_add(1);
+}
+
+
+void shutdownDeformerStats()
+{
+	DeformerStatsThreadTable *table = kDeformerStats.threads.exchange(NULL);
+	while (table) {
+		DeformerStatsThreadTable *next = table->next;
+		closePerfCounterGroup(table->perfCounters);
+		table->~DeformerStatsThreadTable();
+		free(table);
+		table = next;
+	}
+	kDeformerStats.generation.fetch_add(1);
+}
@@ -0,0 +1,229 @@
+/**
+ * @brief	Statistics about the evaluations of every hot-reloadable deformer, kept
+ * 		separately for each version of the logic library that a node has run.
+ *
+ * 		Every thread counts into its own table, so recording never takes a lock
+ * 		and never contends with another thread; the tables are only merged when
+ * 		the statistics are queried.
+ */
+#ifndef DEFORMER_STATS_H
+#define DEFORMER_STATS_H
+
+#include <ssmath/platform.h>
+#include <ssmath/perf_counters.h>
+#include <atomic>
+
+
+/// The counters that are kept for each node and library version.
+enum DeformerCounter
+{
+	DeformerCounter_Evaluations = 0,
+	DeformerCounter_Points,
+	DeformerCounter_DeformNanoseconds,
+	DeformerCounter_Reloads,
+	DeformerCounter_ReloadNanoseconds,
+	DeformerCounter_MatrixCacheLookups,
+	DeformerCounter_MatrixCacheHits,
+	DeformerCounter_PointBufferLookups,
+	DeformerCounter_PointBufferHits,
+
+	// NOTE: (sonictk) These are only counted while the hardware performance
+	// counters are enabled; ``CountedPoints`` are the points of those evaluations.
+	// Each block is laid out in the same order as ``PerfCounter``.
+	DeformerCounter_CountedPoints,
+	DeformerCounter_Cycles,
+	DeformerCounter_Instructions,
+	DeformerCounter_CacheMisses,
+	DeformerCounter_BranchMisses,
+	DeformerCounter_LogicCycles,
+	DeformerCounter_LogicInstructions,
+	DeformerCounter_LogicCacheMisses,
+	DeformerCounter_LogicBranchMisses,
+
+	// NOTE: (sonictk) These are only counted while the allocations of the logic
+	// library are tracked; ``TrackedPoints`` are the points of those evaluations.
+	DeformerCounter_TrackedEvaluations,
+	DeformerCounter_TrackedPoints,
+	DeformerCounter_LogicAllocations,
+	DeformerCounter_LogicFrees,
+	DeformerCounter_LogicAllocatedBytes,
+	DeformerCounter_LogicFreedBytes,
+
+	DeformerCounter_Count
+};
+
+
+/// Latencies are binned into buckets that are an eighth of a power of two wide,
+/// starting from 64 ns, so percentiles are accurate to within about 6%.
+static const unsigned int kDeformerLatencySubBuckets = 8;
+static const unsigned int kDeformerLatencyMinOctave = 6;
+static const unsigned int kNumDeformerLatencyBuckets = 256;
+
+/// The number of distinct node and library version pairs that each thread can
+/// count. Must be a power of two.
+static const unsigned int kMaxDeformerStatsEntries = 128;
+
+/// The number of the most recent versions of the logic library that statistics are
+/// kept for, i.e. the current one and the one it replaced. Older entries are
+/// evicted once a thread first records anything for a newer version, so that the
+/// table does not fill up over the course of a session of reloads.
+static const unsigned int kDeformerStatsVersionsKept = 2;
+
+
+/// The statistics of a single node running a single version of the logic library
+/// on a single thread. Only the owning thread writes to it.
+struct DeformerStatsEntry
+{
+	std::atomic<uint64_t> key; /// ``0`` if the entry is unused, ``kDeformerStatsEvictedKey`` if it was evicted.
+	std::atomic<uint64_t> counters[DeformerCounter_Count];
+	std::atomic<uint32_t> latencies[kNumDeformerLatencyBuckets];
+};
+
+struct DeformerStatsThreadTable
+{
+	DeformerStatsEntry entries[kMaxDeformerStatsEntries];
+	std::atomic<uint32_t> epoch; /// The reset that the entries were last cleared for.
+	uint32_t latestLibraryVersion; /// The newest version recorded since then. Only the owning thread uses it.
+
+	PerfCounterGroup perfCounters;
+	bool hasOpenedPerfCounters; /// Set even if opening them failed, so it is only tried once.
+
+	DeformerStatsThreadTable *next;
+};
+
+struct DeformerStatsRegistry
+{
+	std::atomic<DeformerStatsThreadTable *> threads;
+	std::atomic<uint32_t> epoch; 		/// Incremented whenever the statistics are reset.
+	std::atomic<uint32_t> generation; 	/// Incremented whenever the tables are freed.
+};
+
+globalVar DeformerStatsRegistry kDeformerStats;
+
+/// When set, the hardware performance counters are read around each evaluation
+/// and each call into the logic library. This is off by default since each
+/// reading is a system call.
+globalVar std::atomic<bool> kDeformerPerfCountersEnabled;
+
+static thread_local DeformerStatsThreadTable *tDeformerStatsTable;
+static thread_local uint32_t tDeformerStatsGeneration;
+
+
+/// The merged statistics of a single node running a single version of the logic
+/// library, across all threads.
+struct DeformerStatsSummary
+{
+	unsigned int nodeID;
+	unsigned int libraryVersion;
+
+	uint64_t counters[DeformerCounter_Count];
+	uint64_t latencies[kNumDeformerLatencyBuckets];
+};
+
+
+/**
+ * Gets the calling thread's entry for the given node and library version,
+ * creating it the first time. The first time that a newer library version is seen,
+ * the entries of versions older than the last ``kDeformerStatsVersionsKept`` are
+ * evicted.
+ *
+ * @param nodeID			The ID of the node. Must not be ``0``.
+ * @param libraryVersion	The version of the logic library that the node is running.
+ *
+ * @return					The entry, or ``NULL`` if the thread's table is full or
+ * 						could not be allocated.
+ */
+DeformerStatsEntry *getDeformerStatsEntry(unsigned int nodeID, unsigned int libraryVersion);
+
+
+/// Adds ``value`` to one of the counters of an entry.
+inline void addDeformerStat(DeformerStatsEntry *entry, DeformerCounter counter, uint64_t value)
+{
+	// NOTE: (sonictk) Only the owning thread writes to the entry, so a plain
+	// load/store is enough and avoids a locked instruction.
+	std::atomic<uint64_t> &stat = entry->counters[counter];
+	stat.store(stat.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+
+/**
+ * Adds hardware event counts to a block of counters of an entry.
+ *
+ * @param entry		The entry to add the events to.
+ * @param first		The first counter of the block, i.e. ``DeformerCounter_Cycles``
+ * 					or ``DeformerCounter_LogicCycles``.
+ * @param values		The events that were counted.
+ */
+inline void addDeformerPerfCounters(DeformerStatsEntry *entry,
+									DeformerCounter first,
+									const PerfCounterValues &values)
+{
+	for (int i=0; i < PerfCounter_Count; ++i) {
+		addDeformerStat(entry, (DeformerCounter)(first + i), values.values[i]);
+	}
+}
+
+
+/**
+ * Gets the hardware performance counters of the calling thread, opening them the
+ * first time.
+ *
+ * @return		The counters, or ``NULL`` if they are disabled or not available.
+ */
+PerfCounterGroup *getDeformerPerfCounters();
+
+
+/**
+ * Records the latency of a single evaluation of a deformer.
+ *
+ * @param entry			The entry to record the latency in.
+ * @param nanoseconds		The latency.
+ */
+void recordDeformerLatency(DeformerStatsEntry *entry, uint64_t nanoseconds);
+
+
+/**
+ * Returns the latency that a bucket represents, which is the midpoint of the
+ * range of latencies that fall into it.
+ *
+ * @param bucket	The index of the bucket.
+ *
+ * @return			The latency in nanoseconds.
+ */
+double getDeformerLatencyBucketValue(unsigned int bucket);
+
+
+/**
+ * Gets a percentile of the latencies in a summary.
+ *
+ * @param summary		The summary to get the percentile of.
+ * @param percentile	The percentile, between ``0`` and ``100``.
+ *
+ * @return				The latency in nanoseconds, or ``0`` if nothing was recorded.
+ */
+double getDeformerLatencyPercentile(const DeformerStatsSummary &summary, double percentile);
+
+
+/**
+ * Merges the statistics of every thread. This can be called while other threads
+ * are recording, in which case the results may miss their latest evaluations.
+ *
+ * @param summaries		The buffer to write the summaries to.
+ * @param maxSummaries		The maximum number of summaries that can be written.
+ *
+ * @return					The number of summaries written.
+ */
+unsigned int gatherDeformerStats(DeformerStatsSummary *summaries, unsigned int maxSummaries);
+
+
+/// Clears the statistics of every thread. Each thread clears its own table the
+/// next time it records anything.
+void resetDeformerStats();
+
+
+/// Frees every thread's table. This must not be called while anything is being
+/// recorded.
+void shutdownDeformerStats();
+
+
+#endif /* DEFORMER_STATS_H */
@@ -1,9 +1,18 @@
 #include "logic.h"
 #include <ssmath/common_math.h>
 
+// NOTE: (sonictk) This is only compiled here, since this file is built both on its
+// own and as part of the plugin's unity build.
+#include <ssmath/instrset.cpp>
+
 
 globalVar int kMySize;
 
+/// The logic library (and the plugin, which includes this file) binds its ``ssmath``
+/// kernel table as soon as it is loaded, so that every hot-reload picks the best
+/// variants for the CPU before any of its functions can be called.
+globalVar int kSIMDKernelLevel = initializeSIMDKernels();
+
 
 void foo(int *thing, int size)
 {
@@ -33,4 +42,20 @@ Shared
 
 		return result;
 	}
+
+
+	DLLExport int deformPoints(Vec3 *points, unsigned int numPoints, float factor)
+	{
+		if (!points) {
+			return DeformResult_Failure;
+		}
+
+		// NOTE: (sonictk) The host prefers this entry point, so it calls ``getValue``
+		// instead of repeating its logic; otherwise edits made there would never run.
+		for (unsigned int i=0; i < numPoints; ++i) {
+			points[i] = getValue(points[i], factor);
+		}
+
+		return DeformResult_Success;
+	}
 }
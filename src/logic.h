@@ -6,6 +6,9 @@
 #define PLATFORM_LEAN
 #include <ssmath/platform.h>
 #include <ssmath/vector_math.h>
+#include <ssmath/vector_stream.h>
+#include <ssmath/simd_kernels.h>
+#include <ssmath/noise.h>
 
 
 enum DeformResult
@@ -19,6 +22,9 @@ Shared
 {
 	/// Simple example function
 	DLLExport Vec3 getValue(Vec3 &v, float factor);
+
+	/// Batched version of ``getValue`` that deforms ``numPoints`` points in-place.
+	DLLExport int deformPoints(Vec3 *points, unsigned int numPoints, float factor);
 }
 
 
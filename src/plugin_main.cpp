@@ -27,7 +27,22 @@ MStatus initializePlugin(MObject obj)
 		return MStatus::kFailure;
 	}
 
-	kPluginLogicLibraryPath = getDeformerLogicLibraryPath(OSPluginPath);
+	if (getDeformerLogicLibraryPath(OSPluginPath, kPluginLogicLibraryPath, kMaxPathLen) != 0) {
+		MGlobal::displayError("The path to the logic library is too long!");
+		return MStatus::kFailure;
+	}
+
+	// NOTE: (sonictk) The kernel table has already been bound when the plugin was
+	// loaded (see ``logic.cpp``); this just reports what was picked for this CPU.
+	MGlobal::displayInfo(MString("Using ssmath kernels for: ") + getSIMDKernelTableName(kSIMDKernels));
+
+	// NOTE: (sonictk) The profiler is cheap enough to leave on all the time, so that
+	// the timings of the last few thousand zones on every thread are always available.
+	initializeProfiler();
+	setProfilerEnabled(true);
+
+	const char *traceFilePath = getenv(kDeformerTraceFileEnvVar);
+	snprintf(kPluginTraceFilePath, kMaxPathLen, "%s", traceFilePath ? traceFilePath : "");
 
 	status = plugin.registerNode(kHotReloadableDeformerName,
 								 kHotReloadableDeformerID,
@@ -36,6 +51,11 @@ MStatus initializePlugin(MObject obj)
 								 MPxNode::kGeometryFilter);
 	CHECK_MSTATUS_AND_RETURN_IT(status);
 
+	status = plugin.registerCommand(kDeformerStatsCommandName,
+									DeformerStatsCommand::creator,
+									DeformerStatsCommand::newSyntax);
+	CHECK_MSTATUS_AND_RETURN_IT(status);
+
 	return status;
 }
 
@@ -48,6 +68,21 @@ MStatus uninitializePlugin(MObject obj)
 	if (kLogicLibrary.isValid && kLogicLibrary.handle) {
 		unloadDeformerLogicDLL(kLogicLibrary);
 	}
+	setDeformerLogicShadowEvaluations(0);
+
+	if (kPluginTraceFilePath[0] != '\0') {
+		int numZones = writeProfileTrace(kPluginTraceFilePath);
+		if (numZones < 0) {
+			MGlobal::displayError(MString("Unable to write the trace file: ") + kPluginTraceFilePath);
+		} else {
+			MGlobal::displayInfo(MString("Wrote trace to: ") + kPluginTraceFilePath);
+		}
+	}
+	shutdownProfiler();
+	shutdownDeformerStats();
+
+	status = plugin.deregisterCommand(kDeformerStatsCommandName);
+	CHECK_MSTATUS_AND_RETURN_IT(status);
 
 	status =  plugin.deregisterNode(kHotReloadableDeformerID);
 	CHECK_MSTATUS_AND_RETURN_IT(status);
@@ -15,7 +15,12 @@
 // NOTE: (yliangsiew) Setup of unity build here
 #include "deformer_platform.cpp"
 #include "logic.cpp"
+#include "deformer_host.cpp"
 #include "deformer.cpp"
+#include "deformer_stats.cpp"
+#include "stats_command.cpp"
+
+#include <ssmath/matrix_math.cpp>
 
 
 /**
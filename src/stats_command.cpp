@@ -0,0 +1,178 @@
+#include "stats_command.h"
+#include "deformer.h"
+#include "deformer_stats.h"
+#include <maya/MArgDatabase.h>
+#include <maya/MItDependencyNodes.h>
+#include <maya/MFnDependencyNode.h>
+#include <maya/MStringArray.h>
+
+
+void *DeformerStatsCommand::creator()
+{
+	return new DeformerStatsCommand;
+}
+
+
+MSyntax DeformerStatsCommand::newSyntax()
+{
+	MSyntax syntax;
+	syntax.addFlag(kDeformerStatsResetFlag, kDeformerStatsResetFlagLong);
+	syntax.addFlag(kDeformerStatsPerfCountersFlag, kDeformerStatsPerfCountersFlagLong, MSyntax::kBoolean);
+	syntax.addFlag(kDeformerStatsAllocationTrackingFlag, kDeformerStatsAllocationTrackingFlagLong, MSyntax::kBoolean);
+	syntax.addFlag(kDeformerStatsShadowEvaluationsFlag, kDeformerStatsShadowEvaluationsFlagLong, MSyntax::kUnsigned);
+
+	return syntax;
+}
+
+
+bool DeformerStatsCommand::isUndoable() const
+{
+	return false;
+}
+
+
+/// Returns ``numerator / denominator``, or ``0`` if the denominator is ``0``.
+static inline double getDeformerStatsRatio(uint64_t numerator, uint64_t denominator)
+{
+	return denominator > 0 ? (double)numerator / (double)denominator : 0.0;
+}
+
+
+/// Returns ``(added - removed) / denominator``, which is negative if more was
+/// removed than added, or ``0`` if the denominator is ``0``.
+static inline double getDeformerStatsNetRatio(uint64_t added, uint64_t removed, uint64_t denominator)
+{
+	return denominator > 0 ? ((double)added - (double)removed) / (double)denominator : 0.0;
+}
+
+
+MStatus DeformerStatsCommand::doIt(const MArgList &args)
+{
+	MStatus status;
+	MArgDatabase argDb(syntax(), args, &status);
+	CHECK_MSTATUS_AND_RETURN_IT(status);
+
+	if (argDb.isFlagSet(kDeformerStatsResetFlag)) {
+		resetDeformerStats();
+		return status;
+	}
+
+	if (argDb.isFlagSet(kDeformerStatsPerfCountersFlag)) {
+		bool enable = false;
+		status = argDb.getFlagArgument(kDeformerStatsPerfCountersFlag, 0, enable);
+		CHECK_MSTATUS_AND_RETURN_IT(status);
+
+		// NOTE: (sonictk) Check that the counters can be opened at all, so that the
+		// user finds out now rather than from a column of zeros later.
+		if (enable) {
+			PerfCounterGroup group;
+			if (openPerfCounterGroup(group) != 0) {
+				MGlobal::displayError("Hardware performance counters are not available on this machine!");
+				return MStatus::kFailure;
+			}
+			closePerfCounterGroup(group);
+		}
+		kDeformerPerfCountersEnabled.store(enable);
+
+		return status;
+	}
+
+	if (argDb.isFlagSet(kDeformerStatsAllocationTrackingFlag)) {
+		bool enable = false;
+		status = argDb.getFlagArgument(kDeformerStatsAllocationTrackingFlag, 0, enable);
+		CHECK_MSTATUS_AND_RETURN_IT(status);
+
+		if (setDeformerLogicAllocationTracking(kLogicLibrary, enable) != 0) {
+			MGlobal::displayError("Unable to track the allocations of the logic library on this platform!");
+			return MStatus::kFailure;
+		}
+
+		return status;
+	}
+
+	if (argDb.isFlagSet(kDeformerStatsShadowEvaluationsFlag)) {
+		unsigned int numEvaluations = 0;
+		status = argDb.getFlagArgument(kDeformerStatsShadowEvaluationsFlag, 0, numEvaluations);
+		CHECK_MSTATUS_AND_RETURN_IT(status);
+
+		setDeformerLogicShadowEvaluations(numEvaluations);
+
+		return status;
+	}
+
+	// NOTE: (sonictk) Every thread can have at most this many entries, so this is
+	// enough for every distinct node and library version as long as the same ones
+	// are evaluated on every thread, which is the common case.
+	DeformerStatsSummary *summaries = (DeformerStatsSummary *)malloc(sizeof(DeformerStatsSummary) * kMaxDeformerStatsEntries);
+	if (!summaries) {
+		MGlobal::displayError("Unable to allocate memory for the deformer statistics!");
+		return MStatus::kFailure;
+	}
+	unsigned int numSummaries = gatherDeformerStats(summaries, kMaxDeformerStatsEntries);
+
+	// NOTE: (sonictk) Nodes that have been deleted since they were evaluated are
+	// not found here, so their statistics are not reported.
+	MStringArray result;
+	for (MItDependencyNodes it(MFn::kInvalid, &status); status && !it.isDone(); it.next()) {
+		MFnDependencyNode fnNode(it.thisNode());
+		if (fnNode.typeId() != kHotReloadableDeformerID) {
+			continue;
+		}
+		HotReloadableDeformer *deformer = (HotReloadableDeformer *)fnNode.userNode();
+		if (!deformer) {
+			continue;
+		}
+		MString nodeName = fnNode.name();
+
+		for (unsigned int i=0; i < numSummaries; ++i) {
+			const DeformerStatsSummary &summary = summaries[i];
+			if (summary.nodeID != deformer->pipeline.statsID) {
+				continue;
+			}
+			const uint64_t *counters = summary.counters;
+			double deformSeconds = (double)counters[DeformerCounter_DeformNanoseconds] * 1e-9;
+
+			char row[1536];
+			snprintf(row,
+					 sizeof(row),
+					 "{\"node\":\"%s\",\"libraryVersion\":%u,\"evaluations\":%llu,\"pointsPerSecond\":%.1f,"
+					 "\"p50Ms\":%.4f,\"p95Ms\":%.4f,\"p99Ms\":%.4f,\"reloads\":%llu,\"reloadMs\":%.4f,"
+					 "\"matrixCacheHitRate\":%.4f,\"pointBufferHitRate\":%.4f,"
+					 "\"ipc\":%.3f,\"cacheMissesPerPoint\":%.4f,\"branchMissesPerPoint\":%.4f,"
+					 "\"logicIpc\":%.3f,\"logicCacheMissesPerPoint\":%.4f,\"logicBranchMissesPerPoint\":%.4f,"
+					 "\"allocationsPerPoint\":%.4f,\"allocatedBytesPerPoint\":%.4f,"
+					 "\"leaksPerEvaluation\":%.2f,\"leakedBytesPerEvaluation\":%.1f}",
+					 nodeName.asChar(),
+					 summary.libraryVersion,
+					 (unsigned long long)counters[DeformerCounter_Evaluations],
+					 deformSeconds > 0.0 ? (double)counters[DeformerCounter_Points] / deformSeconds : 0.0,
+					 getDeformerLatencyPercentile(summary, 50.0) * 1e-6,
+					 getDeformerLatencyPercentile(summary, 95.0) * 1e-6,
+					 getDeformerLatencyPercentile(summary, 99.0) * 1e-6,
+					 (unsigned long long)counters[DeformerCounter_Reloads],
+					 (double)counters[DeformerCounter_ReloadNanoseconds] * 1e-6,
+					 getDeformerStatsRatio(counters[DeformerCounter_MatrixCacheHits], counters[DeformerCounter_MatrixCacheLookups]),
+					 getDeformerStatsRatio(counters[DeformerCounter_PointBufferHits], counters[DeformerCounter_PointBufferLookups]),
+					 getDeformerStatsRatio(counters[DeformerCounter_Instructions], counters[DeformerCounter_Cycles]),
+					 getDeformerStatsRatio(counters[DeformerCounter_CacheMisses], counters[DeformerCounter_CountedPoints]),
+					 getDeformerStatsRatio(counters[DeformerCounter_BranchMisses], counters[DeformerCounter_CountedPoints]),
+					 getDeformerStatsRatio(counters[DeformerCounter_LogicInstructions], counters[DeformerCounter_LogicCycles]),
+					 getDeformerStatsRatio(counters[DeformerCounter_LogicCacheMisses], counters[DeformerCounter_CountedPoints]),
+					 getDeformerStatsRatio(counters[DeformerCounter_LogicBranchMisses], counters[DeformerCounter_CountedPoints]),
+					 getDeformerStatsRatio(counters[DeformerCounter_LogicAllocations], counters[DeformerCounter_TrackedPoints]),
+					 getDeformerStatsRatio(counters[DeformerCounter_LogicAllocatedBytes], counters[DeformerCounter_TrackedPoints]),
+					 getDeformerStatsNetRatio(counters[DeformerCounter_LogicAllocations],
+											  counters[DeformerCounter_LogicFrees],
+											  counters[DeformerCounter_TrackedEvaluations]),
+					 getDeformerStatsNetRatio(counters[DeformerCounter_LogicAllocatedBytes],
+											  counters[DeformerCounter_LogicFreedBytes],
+											  counters[DeformerCounter_TrackedEvaluations]));
+			result.append(row);
+		}
+	}
+
+	free(summaries);
+	setResult(result);
+
+	return status;
+}
@@ -0,0 +1,68 @@
+#ifndef STATS_COMMAND_H
+#define STATS_COMMAND_H
+
+#include <maya/MPxCommand.h>
+#include <maya/MArgList.h>
+#include <maya/MSyntax.h>
+
+
+static const char *kDeformerStatsCommandName = "hotReloadableDeformerStats";
+
+static const char *kDeformerStatsResetFlag = "-r";
+static const char *kDeformerStatsResetFlagLong = "-reset";
+
+static const char *kDeformerStatsPerfCountersFlag = "-pc";
+static const char *kDeformerStatsPerfCountersFlagLong = "-perfCounters";
+
+static const char *kDeformerStatsAllocationTrackingFlag = "-at";
+static const char *kDeformerStatsAllocationTrackingFlagLong = "-allocationTracking";
+
+static const char *kDeformerStatsShadowEvaluationsFlag = "-se";
+static const char *kDeformerStatsShadowEvaluationsFlagLong = "-shadowEvaluations";
+
+
+/**
+ * This command reports the statistics of every hot-reloadable deformer in the
+ * scene, with one row for each version of the logic library that a node has run.
+ * Each row is returned as a string containing a JSON object with the fields:
+ *
+ * - ``node``: The name of the node.
+ * - ``libraryVersion``: The number of times the logic library had been loaded
+ *   when the version was loaded.
+ * - ``evaluations``: The number of times the node was evaluated.
+ * - ``pointsPerSecond``: The number of points deformed per second of evaluation.
+ * - ``p50Ms``, ``p95Ms``, ``p99Ms``: Percentiles of the evaluation latency.
+ * - ``reloads``, ``reloadMs``: The number of reloads that the node triggered to
+ *   load the version, and the total time they took.
+ * - ``matrixCacheHitRate``, ``pointBufferHitRate``: The fractions of evaluations
+ *   that reused the cached world matrices and the existing point buffer.
+ * - ``ipc``, ``cacheMissesPerPoint``, ``branchMissesPerPoint``: Derived from the
+ *   hardware performance counters over whole evaluations, and the same again
+ *   prefixed with ``logic`` over just the calls into the logic library. These are
+ *   ``0`` unless the counters have been enabled.
+ * - ``allocationsPerPoint``, ``allocatedBytesPerPoint``: The heap allocations that
+ *   the logic library made, and ``leaksPerEvaluation``, ``leakedBytesPerEvaluation``:
+ *   how many more blocks (and bytes) it allocated than it freed in each evaluation.
+ *   These are ``0`` unless allocation tracking has been enabled.
+ *
+ * Passing ``-reset`` clears the statistics instead, ``-perfCounters on/off``
+ * enables or disables reading the hardware performance counters, and
+ * ``-allocationTracking on/off`` enables or disables counting the allocations of
+ * the logic library (both Linux only). ``-shadowEvaluations <count>`` compares each
+ * new version of the logic library against the previous one for that many
+ * evaluations after it is reloaded, and reports whether it is slower or deforms
+ * the points differently; ``0`` disables the comparison.
+ */
+struct DeformerStatsCommand : MPxCommand
+{
+	static void *creator();
+
+	static MSyntax newSyntax();
+
+	MStatus doIt(const MArgList &args);
+
+	bool isUndoable() const;
+};
+
+
+#endif /* STATS_COMMAND_H */
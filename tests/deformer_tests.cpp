@@ -0,0 +1,534 @@
+/**
+ * @brief	Tests for the deformer's pipeline. This is a standalone executable that
+ * 		does not need Maya, and is run by ``ctest``. Like the replay harness, it
+ * 		loads the logic library from next to the executable (or ``--library``).
+ *
+ * 		The output of every fused chain is checked against a golden output: the
+ * 		same stages evaluated one at a time, each by its own evaluation of the
+ * 		pipeline that moves the points to world space and back as needed. This is
+ * 		what Maya would compute if the nodes were not fused, so the tests do not
+ * 		depend on what the logic library does. Points are also moved to world space
+ * 		and back at several scales, which must give back the points that went in,
+ * 		and a world matrix that has collapsed must skip the world space stages.
+ *
+ * 		Usage: deformer_tests [--library <file>]
+ *
+ * 		Like the plugin, a trace of the evaluations is written to the file named by
+ * 		``HOTRELOAD_DEFORMER_TRACE_FILE`` if it is set.
+ *
+ * 		The exit code is ``1`` if any test failed.
+ */
+#include "deformer_host.h"
+#include "deformer_stats.h"
+#include <ssmath/simd_kernels.h>
+
+#include "deformer_platform.cpp"
+#include "deformer_host.cpp"
+#include "deformer_stats.cpp"
+
+#include <ssmath/instrset.cpp>
+#include <ssmath/matrix_math.cpp>
+
+#include <math.h>
+#include <string.h>
+
+
+/// The largest difference allowed between a fused chain and its golden output,
+/// relative to the length of the golden point (or absolute, below ``1``). The
+/// golden output moves the points between spaces once per stage instead of once
+/// per run of stages, so the two differ by the rounding of those transforms.
+static const double kFusedChainTolerance = 1e-5;
+
+/// These are chosen to test a single point, a partial chunk, and several chunks
+/// with a partial one at the end.
+static const unsigned int kTestPointCounts[] = {1, kFusedChunkSize - 1, (kFusedChunkSize * 2) + 5};
+
+static const unsigned int kTestNumFrames = 3;
+
+static const unsigned int kMaxTestStages = 8;
+
+/// The uniform scales of the world matrix that points are moved to world space and
+/// back with. A world matrix that is small but not collapsed must still be inverted.
+static const float kTestWorldScales[] = {1e-4f, 1e-2f, 1.0f, 1e3f};
+
+/// The largest difference allowed between a point and itself after a round trip
+/// to world space, relative to the length of the point.
+static const double kWorldRoundTripTolerance = 1e-5;
+
+/// Every evaluation is made by a new node, which needs its own statistics ID.
+globalVar unsigned int kNextTestStatsID = 1;
+
+/// The number of warnings that the pipeline has displayed.
+globalVar unsigned int kNumTestWarnings = 0;
+
+
+/// A chain of stages, as gathered by ``gatherFusedStages``.
+struct FusedChainTest
+{
+	const char *name;
+	unsigned int numStages;
+	FusedStage stages[kMaxTestStages];
+};
+
+/// The geometry and stages of a single evaluation, which the pipeline accesses
+/// through a ``DeformerHost``.
+struct TestHostData
+{
+	const Vec3 *points;
+	Vec3 *deformed;
+	unsigned int numPoints;
+
+	Mat44 worldMatrix;
+	const FusedStage *stages;
+	unsigned int numStages;
+};
+
+
+static const FusedChainTest kFusedChainTests[] = {
+	{"local", 3, {{0.5f, false}, {0.25f, false}, {1.0f, false}}},
+	{"world", 3, {{0.5f, true}, {0.75f, true}, {0.1f, true}}},
+	{"local, world, world, local", 4, {{0.3f, false}, {0.6f, true}, {0.2f, true}, {0.9f, false}}},
+	{"world, local, world", 3, {{1.0f, true}, {0.4f, false}, {0.8f, true}}},
+	{"zero envelopes", 4, {{0.0f, true}, {0.5f, false}, {0.0f, false}, {0.5f, true}}}
+};
+
+
+void displayDeformerInfo(const char *message)
+{
+	fprintf(stderr, "%s\n", message);
+}
+
+
+void displayDeformerWarning(const char *message)
+{
+	fprintf(stderr, "WARNING: %s\n", message);
+	++kNumTestWarnings;
+}
+
+
+void displayDeformerError(const char *message)
+{
+	fprintf(stderr, "ERROR: %s\n", message);
+}
+
+
+static unsigned int getTestStages(void *data, FusedStage *stages, unsigned int maxStages)
+{
+	TestHostData *host = (TestHostData *)data;
+	unsigned int numStages = host->numStages < maxStages ? host->numStages : maxStages;
+	memcpy(stages, host->stages, sizeof(FusedStage) * numStages);
+
+	return numStages;
+}
+
+
+static void getTestWorldMatrix(void *data, Mat44 &matrix)
+{
+	TestHostData *host = (TestHostData *)data;
+	matrix = host->worldMatrix;
+}
+
+
+static unsigned int getTestNumPoints(void *data)
+{
+	TestHostData *host = (TestHostData *)data;
+	return host->numPoints;
+}
+
+
+static int readTestPoints(void *data, Vec3 *points, unsigned int numPoints)
+{
+	TestHostData *host = (TestHostData *)data;
+	memcpy(points, host->points, sizeof(Vec3) * numPoints);
+
+	return 0;
+}
+
+
+static int writeTestPoints(void *data, const Vec3 *points, unsigned int numPoints)
+{
+	TestHostData *host = (TestHostData *)data;
+	memcpy(host->deformed, points, sizeof(Vec3) * numPoints);
+
+	return 0;
+}
+
+
+/**
+ * Generates a frame of a rippling sheet of points, like the replay harness does.
+ *
+ * @param points		Storage for ``numPoints`` points.
+ * @param numPoints	The number of points.
+ * @param frame		The frame to generate.
+ */
+static void generateTestFrame(Vec3 *points, unsigned int numPoints, unsigned int frame)
+{
+	unsigned int width = (unsigned int)ceil(sqrt((double)numPoints));
+	float time = (float)frame * 0.1f;
+	float spacing = 10.0f / (float)width;
+	for (unsigned int i=0; i < numPoints; ++i) {
+		float col = (float)(i % width);
+		float row = (float)(i / width);
+		points[i] = vec3((col * spacing) - 5.0f,
+						 0.5f * sinf((row * spacing) + time) * cosf((col * spacing * 0.5f) + time),
+						 (row * spacing) - 5.0f);
+	}
+}
+
+
+/// The world matrix at the given frame: a rotation, a non-uniform scale and a
+/// translation, all of which change every frame.
+static Mat44 getTestWorldMatrixAtFrame(unsigned int frame)
+{
+	float angle = 0.3f + ((float)frame * 0.2f);
+	Mat44 matrix = rotateBy(identityMat44(), vec3(0.2f, 1.0f, 0.4f), angle * (180.0f / PI));
+	for (int r=0; r < 3; ++r) {
+		float scale = 0.5f + (0.25f * (float)(r + frame));
+		for (int c=0; c < 3; ++c) {
+			matrix[r][c] *= scale;
+		}
+	}
+	matrix[0][3] = (float)frame * 0.5f;
+	matrix[1][3] = 1.0f;
+	matrix[2][3] = -2.0f;
+
+	return matrix;
+}
+
+
+/**
+ * Evaluates the stages with a new pipeline, as a single node would.
+ *
+ * @return		The result of ``evaluateDeformerPipeline``.
+ */
+static int evaluateTestStages(TestHostData &hostData)
+{
+	DeformerPipeline pipeline;
+	initializeDeformerPipeline(pipeline, kNextTestStatsID++);
+
+	DeformerHost host;
+	host.data = &hostData;
+	host.getStages = getTestStages;
+	host.getWorldMatrix = getTestWorldMatrix;
+	host.getNumPoints = getTestNumPoints;
+	host.readPoints = readTestPoints;
+	host.writePoints = writeTestPoints;
+
+	int status = evaluateDeformerPipeline(pipeline, host);
+	freeDeformerPipeline(pipeline);
+
+	return status;
+}
+
+
+/**
+ * Runs a chain fused into one evaluation and one stage at a time, over every frame,
+ * and compares the two outputs.
+ *
+ * @param test			The chain to run.
+ * @param numPoints	The number of points to deform.
+ * @param maxError		Set to the largest difference between the outputs.
+ *
+ * @return				``0`` on success, ``-1`` if an evaluation failed.
+ */
+static int runFusedChainTest(const FusedChainTest &test, unsigned int numPoints, double &maxError)
+{
+	Vec3 *points = (Vec3 *)malloc(sizeof(Vec3) * numPoints);
+	Vec3 *fused = (Vec3 *)malloc(sizeof(Vec3) * numPoints);
+	Vec3 *golden = (Vec3 *)malloc(sizeof(Vec3) * numPoints);
+	if (!points || !fused || !golden) {
+		free(points);
+		free(fused);
+		free(golden);
+		return -1;
+	}
+
+	int status = 0;
+	maxError = 0.0;
+	for (unsigned int frame=0; frame < kTestNumFrames && status == 0; ++frame) {
+		generateTestFrame(points, numPoints, frame);
+
+		TestHostData host;
+		host.numPoints = numPoints;
+		host.worldMatrix = getTestWorldMatrixAtFrame(frame);
+
+		host.points = points;
+		host.deformed = fused;
+		host.stages = test.stages;
+		host.numStages = test.numStages;
+		status = evaluateTestStages(host);
+
+		// NOTE: (sonictk) Each stage of the golden output reads what the previous
+		// one wrote, just like a chain of nodes that aren't fused.
+		memcpy(golden, points, sizeof(Vec3) * numPoints);
+		host.points = golden;
+		host.deformed = golden;
+		host.numStages = 1;
+		for (unsigned int i=0; i < test.numStages && status == 0; ++i) {
+			host.stages = test.stages + i;
+			status = evaluateTestStages(host);
+		}
+
+		// NOTE: (sonictk) The error is measured against the length of the whole point,
+		// since a component that is near zero after the round trip through world space
+		// carries the rounding of the other, much larger ones.
+		for (unsigned int i=0; i < numPoints && status == 0; ++i) {
+			double dx = (double)fused[i].x - (double)golden[i].x;
+			double dy = (double)fused[i].y - (double)golden[i].y;
+			double dz = (double)fused[i].z - (double)golden[i].z;
+			double magnitude = sqrt(((double)golden[i].x * golden[i].x)
+									+ ((double)golden[i].y * golden[i].y)
+									+ ((double)golden[i].z * golden[i].z));
+			magnitude = magnitude > 1.0 ? magnitude : 1.0;
+			double error = sqrt((dx * dx) + (dy * dy) + (dz * dz)) / magnitude;
+			if (isnan(error) || error > maxError) {
+				maxError = isnan(error) ? INFINITY : error;
+			}
+		}
+	}
+
+	free(points);
+	free(fused);
+	free(golden);
+
+	return status;
+}
+
+
+/**
+ * Moves points to world space and back with a stage that does not deform them,
+ * and compares them to where they started.
+ *
+ * @param scale		The uniform scale of the world matrix.
+ * @param maxError		Set to the largest difference between the points.
+ *
+ * @return				``0`` on success, ``-1`` if the evaluation failed.
+ */
+static int runWorldRoundTripTest(float scale, double &maxError)
+{
+	const unsigned int numPoints = kFusedChunkSize + 5;
+	Vec3 *points = (Vec3 *)malloc(sizeof(Vec3) * numPoints);
+	Vec3 *deformed = (Vec3 *)malloc(sizeof(Vec3) * numPoints);
+	if (!points || !deformed) {
+		free(points);
+		free(deformed);
+		return -1;
+	}
+	generateTestFrame(points, numPoints, 0);
+
+	FusedStage stage;
+	stage.envelope = 0.0f;
+	stage.worldSpace = true;
+
+	TestHostData host;
+	host.points = points;
+	host.deformed = deformed;
+	host.numPoints = numPoints;
+	host.stages = &stage;
+	host.numStages = 1;
+	host.worldMatrix = rotateBy(identityMat44(), vec3(0.2f, 1.0f, 0.4f), 30.0f);
+	for (int r=0; r < 3; ++r) {
+		for (int c=0; c < 4; ++c) {
+			host.worldMatrix[r][c] *= scale;
+		}
+	}
+
+	int status = evaluateTestStages(host);
+
+	maxError = 0.0;
+	for (unsigned int i=0; i < numPoints && status == 0; ++i) {
+		double dx = (double)deformed[i].x - (double)points[i].x;
+		double dy = (double)deformed[i].y - (double)points[i].y;
+		double dz = (double)deformed[i].z - (double)points[i].z;
+		double magnitude = sqrt(((double)points[i].x * points[i].x)
+								+ ((double)points[i].y * points[i].y)
+								+ ((double)points[i].z * points[i].z));
+		magnitude = magnitude > 1.0 ? magnitude : 1.0;
+		double error = sqrt((dx * dx) + (dy * dy) + (dz * dz)) / magnitude;
+		if (isnan(error) || error > maxError) {
+			maxError = isnan(error) ? INFINITY : error;
+		}
+	}
+
+	free(points);
+	free(deformed);
+
+	return status;
+}
+
+
+
+/**
+ * Runs a local and a world space stage with a world matrix that has been scaled to
+ * zero. The world space stage must be skipped with a warning, which leaves exactly
+ * the output of the local stage on its own.
+ *
+ * @param maxError		Set to the largest difference from the local stage's output.
+ * @param numWarnings	Set to the number of warnings that the evaluation displayed.
+ *
+ * @return				``0`` on success, ``-1`` if an evaluation failed.
+ */
+static int runCollapsedWorldMatrixTest(double &maxError, unsigned int &numWarnings)
+{
+	const unsigned int numPoints = kFusedChunkSize + 5;
+	Vec3 *points = (Vec3 *)malloc(sizeof(Vec3) * numPoints);
+	Vec3 *deformed = (Vec3 *)malloc(sizeof(Vec3) * numPoints);
+	Vec3 *golden = (Vec3 *)malloc(sizeof(Vec3) * numPoints);
+	if (!points || !deformed || !golden) {
+		free(points);
+		free(deformed);
+		free(golden);
+		return -1;
+	}
+	generateTestFrame(points, numPoints, 0);
+
+	FusedStage stages[2];
+	stages[0].envelope = 0.5f;
+	stages[0].worldSpace = false;
+	stages[1].envelope = 0.5f;
+	stages[1].worldSpace = true;
+
+	TestHostData host;
+	host.points = points;
+	host.deformed = golden;
+	host.numPoints = numPoints;
+	host.stages = stages;
+	host.numStages = 1;
+	host.worldMatrix = identityMat44();
+	int status = evaluateTestStages(host);
+
+	unsigned int numWarningsStart = kNumTestWarnings;
+	host.deformed = deformed;
+	host.numStages = 2;
+	memset(&host.worldMatrix, 0, sizeof(Mat44));
+	host.worldMatrix[3][3] = 1.0f;
+	if (status == 0) {
+		status = evaluateTestStages(host);
+	}
+	numWarnings = kNumTestWarnings - numWarningsStart;
+
+	maxError = 0.0;
+	for (unsigned int i=0; i < numPoints && status == 0; ++i) {
+		double dx = (double)deformed[i].x - (double)golden[i].x;
+		double dy = (double)deformed[i].y - (double)golden[i].y;
+		double dz = (double)deformed[i].z - (double)golden[i].z;
+		double error = sqrt((dx * dx) + (dy * dy) + (dz * dz));
+		if (isnan(error) || error > maxError) {
+			maxError = isnan(error) ? INFINITY : error;
+		}
+	}
+
+	free(points);
+	free(deformed);
+	free(golden);
+
+	return status;
+}
+
+int main(int argc, char **argv)
+{
+	const char *libraryPath = NULL;
+	for (int i=1; i < argc; ++i) {
+		if (strcmp(argv[i], "--library") == 0 && i + 1 < argc) {
+			libraryPath = argv[++i];
+		} else {
+			fprintf(stderr, "Usage: %s [--library <file>]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	if (libraryPath) {
+		snprintf(kPluginLogicLibraryPath, kMaxPathLen, "%s", libraryPath);
+	} else {
+		char appPath[kMaxPathLen] = {};
+		char appDir[kMaxPathLen] = {};
+		if (getAppPath(appPath, kMaxPathLen - 1) < 0
+			|| getDirPath(appPath, appDir) < 0
+			|| getDeformerLogicLibraryPath(appDir, kPluginLogicLibraryPath, kMaxPathLen) != 0) {
+			fprintf(stderr, "Could not find the logic library; pass it with --library.\n");
+			return 2;
+		}
+	}
+
+	const char *tracePath = getenv(kDeformerTraceFileEnvVar);
+	snprintf(kPluginTraceFilePath, kMaxPathLen, "%s", tracePath ? tracePath : "");
+
+	initializeSIMDKernels();
+	initializeProfiler();
+	setProfilerEnabled(kPluginTraceFilePath[0] != '\0');
+
+	unsigned int numReloads = 0;
+	uint64_t reloadTicks = 0;
+	if (updateDeformerLogicDLL(kLogicLibrary, numReloads, reloadTicks) != LibraryStatus_Success) {
+		fprintf(stderr, "Failed to load the logic library: %s\n", kPluginLogicLibraryPath);
+		shutdownProfiler();
+		return 2;
+	}
+
+	printf("%-32s %10s %12s %12s\n", "Fused chain", "Points", "Max error", "Tolerance");
+
+	unsigned int numTests = 0;
+	unsigned int numFailures = 0;
+	unsigned int numChains = sizeof(kFusedChainTests) / sizeof(kFusedChainTests[0]);
+	unsigned int numCounts = sizeof(kTestPointCounts) / sizeof(kTestPointCounts[0]);
+	for (unsigned int c=0; c < numChains; ++c) {
+		for (unsigned int p=0; p < numCounts; ++p) {
+			double maxError = 0.0;
+			int status = runFusedChainTest(kFusedChainTests[c], kTestPointCounts[p], maxError);
+			bool passed = status == 0 && maxError <= kFusedChainTolerance;
+			printf("%-32s %10u %12.3g %12.3g%s\n",
+				   kFusedChainTests[c].name,
+				   kTestPointCounts[p],
+				   maxError,
+				   kFusedChainTolerance,
+				   passed ? "" : (status == 0 ? "   FAILED" : "   FAILED (evaluation failed)"));
+
+			++numTests;
+			numFailures += passed ? 0 : 1;
+		}
+	}
+
+	printf("\n%-32s %10s %12s %12s\n", "World round trip", "Scale", "Max error", "Tolerance");
+
+	unsigned int numScales = sizeof(kTestWorldScales) / sizeof(kTestWorldScales[0]);
+	for (unsigned int i=0; i < numScales; ++i) {
+		double maxError = 0.0;
+		int status = runWorldRoundTripTest(kTestWorldScales[i], maxError);
+		bool passed = status == 0 && maxError <= kWorldRoundTripTolerance;
+		printf("%-32s %10g %12.3g %12.3g%s\n",
+			   "uniform scale",
+			   kTestWorldScales[i],
+			   maxError,
+			   kWorldRoundTripTolerance,
+			   passed ? "" : (status == 0 ? "   FAILED" : "   FAILED (evaluation failed)"));
+
+		++numTests;
+		numFailures += passed ? 0 : 1;
+	}
+
+	printf("\n%-32s %10s %12s %12s\n", "Collapsed world matrix", "Warnings", "Max error", "Tolerance");
+
+	double collapsedError = 0.0;
+	unsigned int numCollapsedWarnings = 0;
+	int collapsedStatus = runCollapsedWorldMatrixTest(collapsedError, numCollapsedWarnings);
+	bool collapsedPassed = collapsedStatus == 0 && collapsedError == 0.0 && numCollapsedWarnings == 1;
+	printf("%-32s %10u %12.3g %12.3g%s\n",
+		   "world space stage skipped",
+		   numCollapsedWarnings,
+		   collapsedError,
+		   0.0,
+		   collapsedPassed ? "" : (collapsedStatus == 0 ? "   FAILED" : "   FAILED (evaluation failed)"));
+
+	++numTests;
+	numFailures += collapsedPassed ? 0 : 1;
+
+	printf("%u of %u test(s) failed.\n", numFailures, numTests);
+
+	unloadDeformerLogicDLL(kLogicLibrary);
+	if (kPluginTraceFilePath[0] != '\0' && writeProfileTrace(kPluginTraceFilePath) < 0) {
+		fprintf(stderr, "Failed to write the trace: %s\n", kPluginTraceFilePath);
+	}
+	shutdownProfiler();
+
+	return numFailures > 0 ? 1 : 0;
+}
@@ -0,0 +1,1567 @@
+/**
+ * @brief	Tests for the ``ssmath`` kernels. This is a standalone executable that does
+ * 		not need Maya, and is run by ``ctest``.
+ *
+ * 		Every entry of the kernel table is run at each instruction set that the CPU
+ * 		supports, and its output is compared against a reference computed with
+ * 		the scalar (per-element) functions, or against the scalar variant of the
+ * 		kernel where there is no such function. The kernels that promise the same
+ * 		results at every width must match their reference exactly.
+ *
+ * 		The inverses and determinants of matrices are compared against a reference
+ * 		computed in double precision, over matrices whose scales span several orders
+ * 		of magnitude. Singular matrices must be rejected at every scale, and no
+ * 		other matrix may be.
+ *
+ * 		Usage: ssmath_tests [--filter <substring>]
+ *
+ * 		The exit code is ``1`` if any test failed.
+ */
+#include <ssmath/platform.h>
+#include <ssmath/simd_kernels.h>
+
+#include <ssmath/instrset.cpp>
+#include <ssmath/matrix_math.cpp>
+
+#include <math.h>
+#include <string.h>
+
+
+/// The number of elements that each kernel processes. This is not a multiple of
+/// any packet width, so that the remainders are tested too.
+static const unsigned int kTestNumElements = 1003;
+
+static const unsigned int kTestNumInfluences = 4;
+
+/// The error bound of the point cache that the decoder is tested with, and the
+/// frame that is decoded from it.
+static const float kTestCacheErrorBound = 1e-3f;
+static const unsigned int kTestCacheFrame = 2;
+
+/// Every this many of the input matrices of the kernels is singular.
+static const unsigned int kTestSingularMatrixInterval = 11;
+
+/// The number of matrices that each matrix function is tested with, half of which
+/// are singular. Their scales span ``kTestMatrixScaleDecades`` orders of magnitude
+/// either side of ``1``.
+static const unsigned int kTestNumMatrices = 1000;
+static const float kTestMatrixScaleDecades = 4.0f;
+
+/// The largest matrix that the matrix functions are tested with.
+static const int kTestMaxMatrixDimension = 7;
+
+/// The matrix that ``determinant`` is tested with when given a scratch buffer,
+/// which is larger than ``kMaxDeterminantDimension``.
+static const int kTestLargeMatrixDimension = 40;
+
+
+/// The inputs and outputs that the kernels are run over. Every kernel reads from
+/// the inputs and writes to one of the outputs, and never modifies the inputs.
+struct TestData
+{
+	unsigned int count;
+
+	Vec3Stream a;
+	Vec3Stream b;
+	Vec3Stream rotations;		/// Euler rotations, in degrees.
+	FloatStream angles;		/// In radians.
+	FloatStream exponents;	/// Inputs for ``exponential``.
+	FloatStream values;		/// Positive inputs for ``logarithm`` and ``power``.
+	FloatStream powers;
+	FloatStream halfInputs;
+	HalfStream halves;
+	QuatStream qa;
+	QuatStream qb;
+	FloatStream weights[kTestNumInfluences];
+	Vec3 *points;
+	Mat44 *matrices;			/// Some of these are singular.
+	Mat44 *affineMatrices;	/// Some of these are singular.
+	PointCache cache;
+
+	Mat44 transform;
+	Quat rotation;
+	DualQuat transforms[kTestNumInfluences];
+
+	Vec3Stream vecOut;
+	FloatStream floatOut;
+	FloatStream floatOut2;
+	QuatStream quatOut;
+	HalfStream halfOut;
+	Vec3 *pointsOut;
+	Mat44 *matricesOut;
+	PointCacheDecoder decoder;
+};
+
+
+/// Which of the outputs of ``TestData`` a kernel writes to.
+enum TestOutput
+{
+	TestOutput_Vec3Stream,
+	TestOutput_FloatStream,
+	TestOutput_FloatStreams,	/// ``floatOut`` followed by ``floatOut2``.
+	TestOutput_QuatStream,
+	TestOutput_HalfStream,
+	TestOutput_Points,
+	TestOutput_Matrices
+};
+
+typedef void (*TestFunc)(TestData &data, const SIMDKernelTable &table);
+
+struct KernelTest
+{
+	const char *name;
+	TestFunc func;
+	/// Writes the expected output with the scalar functions. If ``NULL``, the output
+	/// of the scalar variant of the kernel is expected instead.
+	TestFunc reference;
+	TestOutput output;
+	/// The largest error allowed, relative to the magnitude of the expected value
+	/// (or absolute, for expected values smaller than ``1``).
+	double tolerance;
+	/// Whether the output must have exactly the same bits as the expected output.
+	bool isExact;
+};
+
+struct TestVariant
+{
+	const char *name;
+	int level;
+	bool useFMA;
+};
+
+
+static inline float randomTestValue(float min, float max)
+{
+	return min + ((max - min) * ((float)rand() / (float)RAND_MAX));
+}
+
+static inline Quat randomTestQuat()
+{
+	float x = randomTestValue(-1.0f, 1.0f);
+	float y = randomTestValue(-1.0f, 1.0f);
+	float z = randomTestValue(-1.0f, 1.0f);
+	float w = randomTestValue(-1.0f, 1.0f);
+	float len = sqrtf((x * x) + (y * y) + (z * z) + (w * w));
+
+	return vec4(x / len, y / len, z / len, w / len);
+}
+
+static inline Vec3 getStreamVec3(const Vec3Stream &stream, unsigned int i)
+{
+	return vec3(stream.x[i], stream.y[i], stream.z[i]);
+}
+
+static inline void setStreamVec3(Vec3Stream &stream, unsigned int i, const Vec3 &v)
+{
+	stream.x[i] = v.x;
+	stream.y[i] = v.y;
+	stream.z[i] = v.z;
+}
+
+static inline Quat getStreamQuat(const QuatStream &stream, unsigned int i)
+{
+	return vec4(stream.x[i], stream.y[i], stream.z[i], stream.w[i]);
+}
+
+
+/**
+ * Allocates and fills the inputs of the tests. The inputs are random, but the same
+ * on every run.
+ *
+ * @param data		The data to initialize.
+ * @param count	The number of elements.
+ *
+ * @return			``0`` on success, ``-1`` if an allocation failed.
+ */
+static int initializeTestData(TestData &data, unsigned int count)
+{
+	memset(&data, 0, sizeof(TestData));
+	data.count = count;
+
+	data.points = (Vec3 *)allocateAligned(sizeof(Vec3) * count);
+	data.pointsOut = (Vec3 *)allocateAligned(sizeof(Vec3) * count);
+	data.matrices = (Mat44 *)allocateAligned(sizeof(Mat44) * count);
+	data.affineMatrices = (Mat44 *)allocateAligned(sizeof(Mat44) * count);
+	data.matricesOut = (Mat44 *)allocateAligned(sizeof(Mat44) * count);
+	if (!data.points || !data.pointsOut || !data.matrices || !data.affineMatrices || !data.matricesOut) {
+		return -1;
+	}
+
+	if (allocateVec3Stream(data.a, count) != 0
+		|| allocateVec3Stream(data.b, count) != 0
+		|| allocateVec3Stream(data.rotations, count) != 0
+		|| allocateVec3Stream(data.vecOut, count) != 0
+		|| allocateFloatStream(data.angles, count) != 0
+		|| allocateFloatStream(data.exponents, count) != 0
+		|| allocateFloatStream(data.values, count) != 0
+		|| allocateFloatStream(data.powers, count) != 0
+		|| allocateFloatStream(data.halfInputs, count) != 0
+		|| allocateFloatStream(data.floatOut, count) != 0
+		|| allocateFloatStream(data.floatOut2, count) != 0
+		|| allocateHalfStream(data.halves, count) != 0
+		|| allocateHalfStream(data.halfOut, count) != 0
+		|| allocateQuatStream(data.qa, count) != 0
+		|| allocateQuatStream(data.qb, count) != 0
+		|| allocateQuatStream(data.quatOut, count) != 0) {
+		return -1;
+	}
+	for (unsigned int j=0; j < kTestNumInfluences; ++j) {
+		if (allocateFloatStream(data.weights[j], count) != 0) {
+			return -1;
+		}
+	}
+
+	srand(1);
+	unsigned int capacity = data.a.capacity;
+	for (unsigned int i=0; i < capacity; ++i) {
+		// NOTE: (sonictk) The padding is processed by the kernels too, so it is
+		// filled with valid values as well.
+		data.a.x[i] = randomTestValue(-10.0f, 10.0f);
+		data.a.y[i] = randomTestValue(-10.0f, 10.0f);
+		data.a.z[i] = randomTestValue(-10.0f, 10.0f);
+		data.b.x[i] = randomTestValue(-10.0f, 10.0f);
+		data.b.y[i] = randomTestValue(-10.0f, 10.0f);
+		data.b.z[i] = randomTestValue(-10.0f, 10.0f);
+		data.rotations.x[i] = randomTestValue(-360.0f, 360.0f);
+		data.rotations.y[i] = randomTestValue(-360.0f, 360.0f);
+		data.rotations.z[i] = randomTestValue(-360.0f, 360.0f);
+		data.angles.e[i] = randomTestValue(-100.0f, 100.0f);
+		data.exponents.e[i] = randomTestValue(-20.0f, 20.0f);
+		data.values.e[i] = randomTestValue(0.1f, 10.0f);
+		data.powers.e[i] = randomTestValue(-3.0f, 3.0f);
+
+		// NOTE: (sonictk) The floats cover the subnormal, normal and overflowing
+		// ranges of halves, and the halves are spread over every bit pattern.
+		float magnitude = powf(2.0f, randomTestValue(-26.0f, 17.0f));
+		data.halfInputs.e[i] = (i & 1) ? -magnitude : magnitude;
+		data.halves.e[i] = (uint16_t)(i * 65);
+
+		Quat qa = randomTestQuat();
+		Quat qb = randomTestQuat();
+		data.qa.x[i] = qa.x;
+		data.qa.y[i] = qa.y;
+		data.qa.z[i] = qa.z;
+		data.qa.w[i] = qa.w;
+		data.qb.x[i] = qb.x;
+		data.qb.y[i] = qb.y;
+		data.qb.z[i] = qb.z;
+		data.qb.w[i] = qb.w;
+
+		float total = 0.0f;
+		for (unsigned int j=0; j < kTestNumInfluences; ++j) {
+			data.weights[j].e[i] = randomTestValue(0.0f, 1.0f);
+			total += data.weights[j].e[i];
+		}
+		for (unsigned int j=0; j < kTestNumInfluences; ++j) {
+			data.weights[j].e[i] /= total;
+		}
+	}
+	for (unsigned int i=0; i < count; ++i) {
+		data.points[i] = getStreamVec3(data.a, i);
+	}
+
+	// NOTE: (sonictk) The matrices are comfortably invertible, except for the ones
+	// whose last row (or for the affine ones, the last row of the 3x3 block) is
+	// made a multiple of the first.
+	for (unsigned int i=0; i < count; ++i) {
+		Mat44 &mat = data.matrices[i];
+		Mat44 &affine = data.affineMatrices[i];
+		affine = rotateBy(identityMat44(), randomTestQuat());
+		for (int r=0; r <= 3; ++r) {
+			float scale = randomTestValue(0.5f, 2.0f);
+			for (int c=0; c <= 3; ++c) {
+				mat[r][c] = randomTestValue(-1.0f, 1.0f) + (r == c ? 4.0f : 0.0f);
+				affine[r][c] *= r < 3 && c < 3 ? scale : 1.0f;
+			}
+			affine[r][3] = r < 3 ? randomTestValue(-5.0f, 5.0f) : 1.0f;
+		}
+		if (i % kTestSingularMatrixInterval == kTestSingularMatrixInterval - 1) {
+			for (int c=0; c <= 3; ++c) {
+				mat[3][c] = mat[0][c] * 2.0f;
+				affine[2][c] = affine[0][c] * 2.0f;
+			}
+		}
+	}
+
+	data.rotation = randomTestQuat();
+	data.transform = rotateBy(identityMat44(), data.rotation);
+	for (int r=0; r < 3; ++r) {
+		float scale = randomTestValue(0.5f, 2.0f);
+		for (int c=0; c < 3; ++c) {
+			data.transform[r][c] *= scale;
+		}
+		data.transform[r][3] = randomTestValue(-5.0f, 5.0f);
+	}
+	for (unsigned int j=0; j < kTestNumInfluences; ++j) {
+		data.transforms[j] = dualQuat(randomTestQuat(),
+									  vec3(randomTestValue(-5.0f, 5.0f),
+										   randomTestValue(-5.0f, 5.0f),
+										   randomTestValue(-5.0f, 5.0f)));
+	}
+
+	// NOTE: (sonictk) A few frames of the points moving around, so that the decoder
+	// has deltas to apply after the keyframe.
+	if (createPointCache(data.cache, count, pointCacheSettings(kTestCacheErrorBound)) != 0) {
+		return -1;
+	}
+	Vec3Stream frame = {};
+	if (allocateVec3Stream(frame, count) != 0) {
+		return -1;
+	}
+	int status = 0;
+	for (unsigned int f=0; f <= kTestCacheFrame && status == 0; ++f) {
+		for (unsigned int i=0; i < count; ++i) {
+			Vec3 offset = vec3(sinf((float)(f + i)), cosf((float)(f * i)), 0.1f * (float)f);
+			setStreamVec3(frame, i, getStreamVec3(data.a, i) + offset);
+		}
+		status = appendPointCacheFrame(data.cache, frame);
+	}
+	freeVec3Stream(frame);
+
+	return status;
+}
+
+
+static void freeTestData(TestData &data)
+{
+	freeAligned(data.points);
+	freeAligned(data.pointsOut);
+	freeAligned(data.matrices);
+	freeAligned(data.affineMatrices);
+	freeAligned(data.matricesOut);
+	freeVec3Stream(data.a);
+	freeVec3Stream(data.b);
+	freeVec3Stream(data.rotations);
+	freeVec3Stream(data.vecOut);
+	freeFloatStream(data.angles);
+	freeFloatStream(data.exponents);
+	freeFloatStream(data.values);
+	freeFloatStream(data.powers);
+	freeFloatStream(data.halfInputs);
+	freeFloatStream(data.floatOut);
+	freeFloatStream(data.floatOut2);
+	freeHalfStream(data.halves);
+	freeHalfStream(data.halfOut);
+	freeQuatStream(data.qa);
+	freeQuatStream(data.qb);
+	freeQuatStream(data.quatOut);
+	for (unsigned int j=0; j < kTestNumInfluences; ++j) {
+		freeFloatStream(data.weights[j]);
+	}
+	freePointCacheDecoder(data.decoder);
+	freePointCache(data.cache);
+}
+
+
+// ---------------------------------------------------------------------------------
+// Vector streams
+// ---------------------------------------------------------------------------------
+
+static void testAddStreams(TestData &data, const SIMDKernelTable &table)
+{
+	table.addStreams(data.a, data.b, data.vecOut);
+}
+
+static void referenceAddStreams(TestData &data, const SIMDKernelTable &)
+{
+	for (unsigned int i=0; i < data.count; ++i) {
+		setStreamVec3(data.vecOut, i, getStreamVec3(data.a, i) + getStreamVec3(data.b, i));
+	}
+}
+
+static void testSubtractStreams(TestData &data, const SIMDKernelTable &table)
+{
+	table.subtractStreams(data.a, data.b, data.vecOut);
+}
+
+static void referenceSubtractStreams(TestData &data, const SIMDKernelTable &)
+{
+	for (unsigned int i=0; i < data.count; ++i) {
+		setStreamVec3(data.vecOut, i, getStreamVec3(data.a, i) - getStreamVec3(data.b, i));
+	}
+}
+
+static void testScaleStream(TestData &data, const SIMDKernelTable &table)
+{
+	table.scaleStream(data.a, 0.3f, data.vecOut);
+}
+
+static void referenceScaleStream(TestData &data, const SIMDKernelTable &)
+{
+	for (unsigned int i=0; i < data.count; ++i) {
+		setStreamVec3(data.vecOut, i, getStreamVec3(data.a, i) * 0.3f);
+	}
+}
+
+static void testLerpStreams(TestData &data, const SIMDKernelTable &table)
+{
+	table.lerpStreams(data.a, 0.25f, data.b, data.vecOut);
+}
+
+static void referenceLerpStreams(TestData &data, const SIMDKernelTable &)
+{
+	for (unsigned int i=0; i < data.count; ++i) {
+		Vec3 a = getStreamVec3(data.a, i);
+		Vec3 b = getStreamVec3(data.b, i);
+		setStreamVec3(data.vecOut, i, lerp(a, 0.25f, b));
+	}
+}
+
+static void testInnerProductStreams(TestData &data, const SIMDKernelTable &table)
+{
+	table.innerProductStreams(data.a, data.b, data.floatOut);
+}
+
+static void referenceInnerProductStreams(TestData &data, const SIMDKernelTable &)
+{
+	for (unsigned int i=0; i < data.count; ++i) {
+		data.floatOut.e[i] = innerProduct(getStreamVec3(data.a, i), getStreamVec3(data.b, i));
+	}
+}
+
+static void testCrossProductStreams(TestData &data, const SIMDKernelTable &table)
+{
+	table.crossProductStreams(data.a, data.b, data.vecOut);
+}
+
+static void referenceCrossProductStreams(TestData &data, const SIMDKernelTable &)
+{
+	for (unsigned int i=0; i < data.count; ++i) {
+		setStreamVec3(data.vecOut, i, crossProduct(getStreamVec3(data.a, i), getStreamVec3(data.b, i)));
+	}
+}
+
+template <PrecisionMode mode>
+static void testLengthStream(TestData &data, const SIMDKernelTable &table)
+{
+	table.lengthStream[mode](data.a, data.floatOut);
+}
+
+static void referenceLengthStream(TestData &data, const SIMDKernelTable &)
+{
+	for (unsigned int i=0; i < data.count; ++i) {
+		double x = data.a.x[i];
+		double y = data.a.y[i];
+		double z = data.a.z[i];
+		data.floatOut.e[i] = (float)sqrt((x * x) + (y * y) + (z * z));
+	}
+}
+
+template <PrecisionMode mode>
+static void testNormalizeStream(TestData &data, const SIMDKernelTable &table)
+{
+	table.normalizeStream[mode](data.a, data.vecOut);
+}
+
+static void referenceNormalizeStream(TestData &data, const SIMDKernelTable &)
+{
+	for (unsigned int i=0; i < data.count; ++i) {
+		double x = data.a.x[i];
+		double y = data.a.y[i];
+		double z = data.a.z[i];
+		double len = sqrt((x * x) + (y * y) + (z * z));
+		setStreamVec3(data.vecOut, i, vec3((float)(x / len), (float)(y / len), (float)(z / len)));
+	}
+}
+
+
+// ---------------------------------------------------------------------------------
+// Matrices
+// ---------------------------------------------------------------------------------
+
+static void testTransformPoints(TestData &data, const SIMDKernelTable &table)
+{
+	memcpy(data.pointsOut, data.points, sizeof(Vec3) * data.count);
+	table.transformPoints(data.transform, data.pointsOut, data.count);
+}
+
+static Vec3 transformPointReference(const Mat44 &mat, const Vec3 &v)
+{
+	double result[3];
+	for (int r=0; r < 3; ++r) {
+		result[r] = ((double)v.x * mat[r][0]) + ((double)v.y * mat[r][1]) + ((double)v.z * mat[r][2]) + mat[r][3];
+	}
+
+	return vec3((float)result[0], (float)result[1], (float)result[2]);
+}
+
+static void referenceTransformPoints(TestData &data, const SIMDKernelTable &)
+{
+	for (unsigned int i=0; i < data.count; ++i) {
+		data.pointsOut[i] = transformPointReference(data.transform, data.points[i]);
+	}
+}
+
+static void testTransformStream(TestData &data, const SIMDKernelTable &table)
+{
+	table.transformStream(data.transform, data.a, data.vecOut);
+}
+
+static void referenceTransformStream(TestData &data, const SIMDKernelTable &)
+{
+	for (unsigned int i=0; i < data.count; ++i) {
+		setStreamVec3(data.vecOut, i, transformPointReference(data.transform, getStreamVec3(data.a, i)));
+	}
+}
+
+template <RotationOrder order>
+static void testBuildEulerRotationMatrices(TestData &data, const SIMDKernelTable &table)
+{
+	table.buildEulerRotationMatrices[order](data.rotations, data.matricesOut);
+}
+
+/// A rotation of ``degrees`` around the given axis (``0`` for X, ``1`` for Y and
+/// ``2`` for Z), with the sine and cosine computed in double precision.
+static Mat44 axisRotationReference(int axis, float degrees)
+{
+	double radians = (double)(degrees * PI / 180.0f);
+	float c = (float)cos(radians);
+	float s = (float)sin(radians);
+	int a = (axis + 1) % 3;
+	int b = (axis + 2) % 3;
+
+	Mat44 result = identityMat44();
+	result[a][a] = c;
+	result[a][b] = -s;
+	result[b][a] = s;
+	result[b][b] = c;
+
+	return result;
+}
+
+/// The axes of each rotation order, in the order that their rotations are
+/// multiplied: an order ``ABC`` is ``R_A * R_B * R_C``.
+static const int kTestRotationOrderAxes[][3] = {
+	{0, 1, 2},	// kXYZ
+	{1, 2, 0},	// kYZX
+	{2, 0, 1},	// kZXY
+	{0, 2, 1},	// kXZY
+	{1, 0, 2},	// kYXZ
+	{2, 1, 0}	// kZYX
+};
+
+/// Builds each matrix from the product of its three axis rotations, instead of the
+/// expanded products of ``EulerRotationBuilder`` that the kernel shares with
+/// ``rotateBy``.
+template <RotationOrder order>
+static void referenceBuildEulerRotationMatrices(TestData &data, const SIMDKernelTable &)
+{
+	const int *axes = kTestRotationOrderAxes[order];
+	for (unsigned int i=0; i < data.count; ++i) {
+		float degrees[3] = {data.rotations.x[i], data.rotations.y[i], data.rotations.z[i]};
+		Mat44 result = multiplyScalar(axisRotationReference(axes[0], degrees[axes[0]]),
+									  axisRotationReference(axes[1], degrees[axes[1]]));
+		data.matricesOut[i] = multiplyScalar(result, axisRotationReference(axes[2], degrees[axes[2]]));
+	}
+}
+
+
+// ---------------------------------------------------------------------------------
+// Quaternions
+// ---------------------------------------------------------------------------------
+
+static void testMultiplyMat44Array(TestData &data, const SIMDKernelTable &table)
+{
+	table.multiplyMat44Array(data.matrices, data.affineMatrices, data.matricesOut, data.count);
+}
+
+static void referenceMultiplyMat44Array(TestData &data, const SIMDKernelTable &)
+{
+	for (unsigned int i=0; i < data.count; ++i) {
+		data.matricesOut[i] = multiplyScalar(data.matrices[i], data.affineMatrices[i]);
+	}
+}
+
+
+static void testMultiplyMat44ArrayBroadcast(TestData &data, const SIMDKernelTable &table)
+{
+	table.multiplyMat44ArrayBroadcast(data.transform, data.matrices, data.matricesOut, data.count);
+}
+
+static void referenceMultiplyMat44ArrayBroadcast(TestData &data, const SIMDKernelTable &)
+{
+	for (unsigned int i=0; i < data.count; ++i) {
+		data.matricesOut[i] = multiplyScalar(data.transform, data.matrices[i]);
+	}
+}
+
+
+/// Inverts the matrices with ``inverseScalar``, writing identity for the singular ones.
+static void referenceInverseMatrices(const Mat44 *in, Mat44 *out, unsigned int count)
+{
+	for (unsigned int i=0; i < count; ++i) {
+		if (inverseScalar(in[i], out[i]) != 0) {
+			out[i] = identityMat44();
+		}
+	}
+}
+
+
+static void testInverseMat44Array(TestData &data, const SIMDKernelTable &table)
+{
+	int result = 0;
+	table.inverseMat44Array(data.matrices, data.matricesOut, data.count, result);
+}
+
+static void referenceInverseMat44Array(TestData &data, const SIMDKernelTable &)
+{
+	referenceInverseMatrices(data.matrices, data.matricesOut, data.count);
+}
+
+
+static void testInverseAffineMat44Array(TestData &data, const SIMDKernelTable &table)
+{
+	int result = 0;
+	table.inverseAffineMat44Array(data.affineMatrices, data.matricesOut, data.count, result);
+}
+
+static void referenceInverseAffineMat44Array(TestData &data, const SIMDKernelTable &)
+{
+	referenceInverseMatrices(data.affineMatrices, data.matricesOut, data.count);
+}
+
+
+static void testRotateStream(TestData &data, const SIMDKernelTable &table)
+{
+	table.rotateStream(data.rotation, data.a, data.vecOut);
+}
+
+static void referenceRotateStream(TestData &data, const SIMDKernelTable &)
+{
+	for (unsigned int i=0; i < data.count; ++i) {
+		setStreamVec3(data.vecOut, i, rotateBy(getStreamVec3(data.a, i), data.rotation));
+	}
+}
+
+static void testRotateStreamPerPoint(TestData &data, const SIMDKernelTable &table)
+{
+	table.rotateStreamPerPoint(data.qa, data.a, data.vecOut);
+}
+
+static void referenceRotateStreamPerPoint(TestData &data, const SIMDKernelTable &)
+{
+	for (unsigned int i=0; i < data.count; ++i) {
+		setStreamVec3(data.vecOut, i, rotateBy(getStreamVec3(data.a, i), getStreamQuat(data.qa, i)));
+	}
+}
+
+static void testNormalizeQuatStream(TestData &data, const SIMDKernelTable &table)
+{
+	table.normalizeQuatStream(data.qa, data.quatOut);
+}
+
+static void testNlerpQuatStreams(TestData &data, const SIMDKernelTable &table)
+{
+	table.nlerpQuatStreams(data.qa, 0.3f, data.qb, data.quatOut);
+}
+
+static void testSlerpQuatStreams(TestData &data, const SIMDKernelTable &table)
+{
+	table.slerpQuatStreams(data.qa, 0.3f, data.qb, data.quatOut);
+}
+
+static void testBlendDualQuaternions(TestData &data, const SIMDKernelTable &table)
+{
+	table.blendDualQuaternions(data.transforms, data.weights, kTestNumInfluences, data.a, data.vecOut);
+}
+
+
+// ---------------------------------------------------------------------------------
+// Transcendental functions
+// ---------------------------------------------------------------------------------
+
+static void testSineStream(TestData &data, const SIMDKernelTable &table)
+{
+	table.sineStream(data.angles, data.floatOut);
+}
+
+static void referenceSineStream(TestData &data, const SIMDKernelTable &)
+{
+	for (unsigned int i=0; i < data.count; ++i) {
+		data.floatOut.e[i] = (float)sin((double)data.angles.e[i]);
+	}
+}
+
+static void testCosineStream(TestData &data, const SIMDKernelTable &table)
+{
+	table.cosineStream(data.angles, data.floatOut);
+}
+
+static void referenceCosineStream(TestData &data, const SIMDKernelTable &)
+{
+	for (unsigned int i=0; i < data.count; ++i) {
+		data.floatOut.e[i] = (float)cos((double)data.angles.e[i]);
+	}
+}
+
+static void testSinCosStream(TestData &data, const SIMDKernelTable &table)
+{
+	table.sinCosStream(data.angles, data.floatOut, data.floatOut2);
+}
+
+static void referenceSinCosStream(TestData &data, const SIMDKernelTable &table)
+{
+	referenceSineStream(data, table);
+	for (unsigned int i=0; i < data.count; ++i) {
+		data.floatOut2.e[i] = (float)cos((double)data.angles.e[i]);
+	}
+}
+
+static void testExponentialStream(TestData &data, const SIMDKernelTable &table)
+{
+	table.exponentialStream(data.exponents, data.floatOut);
+}
+
+static void referenceExponentialStream(TestData &data, const SIMDKernelTable &)
+{
+	for (unsigned int i=0; i < data.count; ++i) {
+		data.floatOut.e[i] = (float)exp((double)data.exponents.e[i]);
+	}
+}
+
+static void testLogarithmStream(TestData &data, const SIMDKernelTable &table)
+{
+	table.logarithmStream(data.values, data.floatOut);
+}
+
+static void referenceLogarithmStream(TestData &data, const SIMDKernelTable &)
+{
+	for (unsigned int i=0; i < data.count; ++i) {
+		data.floatOut.e[i] = (float)log((double)data.values.e[i]);
+	}
+}
+
+static void testPowerStreams(TestData &data, const SIMDKernelTable &table)
+{
+	table.powerStreams(data.values, data.powers, data.floatOut);
+}
+
+static void referencePowerStreams(TestData &data, const SIMDKernelTable &)
+{
+	for (unsigned int i=0; i < data.count; ++i) {
+		data.floatOut.e[i] = (float)pow((double)data.values.e[i], (double)data.powers.e[i]);
+	}
+}
+
+static void testPowerStream(TestData &data, const SIMDKernelTable &table)
+{
+	table.powerStream(data.values, 2.2f, data.floatOut);
+}
+
+static void referencePowerStream(TestData &data, const SIMDKernelTable &)
+{
+	for (unsigned int i=0; i < data.count; ++i) {
+		data.floatOut.e[i] = (float)pow((double)data.values.e[i], 2.2);
+	}
+}
+
+/// Fills ``floatOut2`` with zeros, negative values and positive values, which
+/// the domain tests below read as their input.
+static void fillDomainTestValues(TestData &data)
+{
+	unsigned int capacity = data.floatOut2.capacity;
+	for (unsigned int i=0; i < capacity; ++i) {
+		float value = data.values.e[i];
+		switch (i % 4) {
+		case 0: data.floatOut2.e[i] = 0.0f; break;
+		case 1: data.floatOut2.e[i] = -value; break;
+		case 2: data.floatOut2.e[i] = -0.0f; break;
+		default: data.floatOut2.e[i] = value; break;
+		}
+	}
+}
+
+static void testLogarithmStreamDomain(TestData &data, const SIMDKernelTable &table)
+{
+	fillDomainTestValues(data);
+	table.logarithmStream(data.floatOut2, data.floatOut);
+}
+
+static void referenceLogarithmStreamDomain(TestData &data, const SIMDKernelTable &)
+{
+	fillDomainTestValues(data);
+	for (unsigned int i=0; i < data.count; ++i) {
+		data.floatOut.e[i] = (float)log((double)data.floatOut2.e[i]);
+	}
+}
+
+static void testPowerStreamsDomain(TestData &data, const SIMDKernelTable &table)
+{
+	fillDomainTestValues(data);
+	table.powerStreams(data.floatOut2, data.powers, data.floatOut);
+}
+
+static void referencePowerStreamsDomain(TestData &data, const SIMDKernelTable &)
+{
+	fillDomainTestValues(data);
+	for (unsigned int i=0; i < data.count; ++i) {
+		data.floatOut.e[i] = (float)pow((double)data.floatOut2.e[i], (double)data.powers.e[i]);
+	}
+}
+
+
+// ---------------------------------------------------------------------------------
+// Noise and random numbers
+// ---------------------------------------------------------------------------------
+
+static NoiseSettings getTestNoiseSettings(NoiseType type)
+{
+	NoiseSettings settings = noiseSettings(type, 7);
+	settings.octaves = 3;
+	settings.frequency = 0.35f;
+
+	return settings;
+}
+
+/// The same fractal sum as ``fractalNoise``, with the scalar noise functions.
+static float fractalNoiseReference(NoiseType type, float x, float y, float z, const float *w, const NoiseSettings &settings)
+{
+	float result = 0.0f;
+	float frequency = settings.frequency;
+	float amplitude = 1.0f;
+	float totalAmplitude = 0.0f;
+	for (unsigned int octave=0; octave < settings.octaves; ++octave) {
+		float fx = x * frequency;
+		float fy = y * frequency;
+		float fz = z * frequency;
+		uint32_t seed = settings.seed + octave;
+		float noise;
+		if (type == NoiseType_Simplex) {
+			noise = w ? simplexNoise(fx, fy, fz, *w, seed) : simplexNoise(fx, fy, fz, seed);
+		} else {
+			noise = w ? gradientNoise(fx, fy, fz, *w, seed) : gradientNoise(fx, fy, fz, seed);
+		}
+		result = result + (noise * amplitude);
+
+		totalAmplitude += amplitude;
+		frequency *= settings.lacunarity;
+		amplitude *= settings.gain;
+	}
+
+	return result * (1.0f / totalAmplitude);
+}
+
+template <NoiseType type>
+static void testNoiseStream(TestData &data, const SIMDKernelTable &table)
+{
+	table.noiseStream[type](data.a, getTestNoiseSettings(type), data.floatOut);
+}
+
+template <NoiseType type>
+static void referenceNoiseStream(TestData &data, const SIMDKernelTable &)
+{
+	NoiseSettings settings = getTestNoiseSettings(type);
+	for (unsigned int i=0; i < data.count; ++i) {
+		data.floatOut.e[i] = fractalNoiseReference(type, data.a.x[i], data.a.y[i], data.a.z[i], NULL, settings);
+	}
+}
+
+template <NoiseType type>
+static void testNoiseStream4D(TestData &data, const SIMDKernelTable &table)
+{
+	table.noiseStream4D[type](data.a, 1.7f, getTestNoiseSettings(type), data.floatOut);
+}
+
+template <NoiseType type>
+static void referenceNoiseStream4D(TestData &data, const SIMDKernelTable &)
+{
+	NoiseSettings settings = getTestNoiseSettings(type);
+	float w = 1.7f;
+	for (unsigned int i=0; i < data.count; ++i) {
+		data.floatOut.e[i] = fractalNoiseReference(type, data.a.x[i], data.a.y[i], data.a.z[i], &w, settings);
+	}
+}
+
+static void testFillRandomFloatStream(TestData &data, const SIMDKernelTable &table)
+{
+	table.fillRandomFloatStream(data.floatOut, 11, 100, -2.0f, 3.0f);
+}
+
+static void referenceFillRandomFloatStream(TestData &data, const SIMDKernelTable &)
+{
+	for (unsigned int i=0; i < data.count; ++i) {
+		data.floatOut.e[i] = -2.0f + (randomFloat(11, 100 + i) * 5.0f);
+	}
+}
+
+static void testFillRandomVec3Stream(TestData &data, const SIMDKernelTable &table)
+{
+	table.fillRandomVec3Stream(data.vecOut, 11, 100, -2.0f, 3.0f);
+}
+
+static void referenceFillRandomVec3Stream(TestData &data, const SIMDKernelTable &)
+{
+	for (unsigned int i=0; i < data.count; ++i) {
+		uint32_t index = (100 + i) * 3;
+		setStreamVec3(data.vecOut,
+					  i,
+					  vec3(-2.0f + (randomFloat(11, index) * 5.0f),
+						   -2.0f + (randomFloat(11, index + 1) * 5.0f),
+						   -2.0f + (randomFloat(11, index + 2) * 5.0f)));
+	}
+}
+
+
+// ---------------------------------------------------------------------------------
+// Caches
+// ---------------------------------------------------------------------------------
+
+static void testEncodeHalves(TestData &data, const SIMDKernelTable &table)
+{
+	table.encodeHalves(data.halfInputs.e, data.halfOut.e, padSIMDCount(data.count));
+}
+
+static void referenceEncodeHalves(TestData &data, const SIMDKernelTable &)
+{
+	for (unsigned int i=0; i < data.count; ++i) {
+		data.halfOut.e[i] = floatToHalf(data.halfInputs.e[i]);
+	}
+}
+
+static void testDecodeHalves(TestData &data, const SIMDKernelTable &table)
+{
+	table.decodeHalves(data.halves.e, data.floatOut.e, padSIMDCount(data.count));
+}
+
+static void referenceDecodeHalves(TestData &data, const SIMDKernelTable &)
+{
+	for (unsigned int i=0; i < data.count; ++i) {
+		data.floatOut.e[i] = halfToFloat(data.halves.e[i]);
+	}
+}
+
+static void testDecodePointCacheFrame(TestData &data, const SIMDKernelTable &table)
+{
+	freePointCacheDecoder(data.decoder);
+	if (createPointCacheDecoder(data.decoder, data.cache) != 0) {
+		memset(data.vecOut.x, 0, sizeof(float) * data.count);
+		return;
+	}
+	for (unsigned int f=0; f <= kTestCacheFrame; ++f) {
+		table.decodePointCacheFrame(data.cache, f, data.decoder, f == kTestCacheFrame ? &data.vecOut : NULL);
+	}
+}
+
+
+static const KernelTest kKernelTests[] = {
+	{"addStreams", testAddStreams, referenceAddStreams, TestOutput_Vec3Stream, 0.0, true},
+	{"subtractStreams", testSubtractStreams, referenceSubtractStreams, TestOutput_Vec3Stream, 0.0, true},
+	{"scaleStream", testScaleStream, referenceScaleStream, TestOutput_Vec3Stream, 0.0, true},
+	{"lerpStreams", testLerpStreams, referenceLerpStreams, TestOutput_Vec3Stream, 1e-6, false},
+	{"innerProductStreams", testInnerProductStreams, referenceInnerProductStreams, TestOutput_FloatStream, 2e-5, false},
+	{"crossProductStreams", testCrossProductStreams, referenceCrossProductStreams, TestOutput_Vec3Stream, 2e-5, false},
+	{"lengthStream (Exact)", testLengthStream<PrecisionMode_Exact>, referenceLengthStream, TestOutput_FloatStream, 1e-6, false},
+	{"lengthStream (Refined)", testLengthStream<PrecisionMode_Refined>, referenceLengthStream, TestOutput_FloatStream, 1e-6, false},
+	{"lengthStream (Fast)", testLengthStream<PrecisionMode_Fast>, referenceLengthStream, TestOutput_FloatStream, 4e-4, false},
+	{"normalizeStream (Exact)", testNormalizeStream<PrecisionMode_Exact>, referenceNormalizeStream, TestOutput_Vec3Stream, 3e-7, false},
+	{"normalizeStream (Refined)", testNormalizeStream<PrecisionMode_Refined>, referenceNormalizeStream, TestOutput_Vec3Stream, 5e-7, false},
+	{"normalizeStream (Fast)", testNormalizeStream<PrecisionMode_Fast>, referenceNormalizeStream, TestOutput_Vec3Stream, 4e-4, false},
+
+	{"transformPoints", testTransformPoints, referenceTransformPoints, TestOutput_Points, 1e-5, false},
+	{"transformStream", testTransformStream, referenceTransformStream, TestOutput_Vec3Stream, 1e-5, false},
+	{"buildEulerRotationMatrices (XYZ)", testBuildEulerRotationMatrices<kXYZ>, referenceBuildEulerRotationMatrices<kXYZ>, TestOutput_Matrices, 2e-6, false},
+	{"buildEulerRotationMatrices (YZX)", testBuildEulerRotationMatrices<kYZX>, referenceBuildEulerRotationMatrices<kYZX>, TestOutput_Matrices, 2e-6, false},
+	{"buildEulerRotationMatrices (ZXY)", testBuildEulerRotationMatrices<kZXY>, referenceBuildEulerRotationMatrices<kZXY>, TestOutput_Matrices, 2e-6, false},
+	{"buildEulerRotationMatrices (XZY)", testBuildEulerRotationMatrices<kXZY>, referenceBuildEulerRotationMatrices<kXZY>, TestOutput_Matrices, 2e-6, false},
+	{"buildEulerRotationMatrices (YXZ)", testBuildEulerRotationMatrices<kYXZ>, referenceBuildEulerRotationMatrices<kYXZ>, TestOutput_Matrices, 2e-6, false},
+	{"buildEulerRotationMatrices (ZYX)", testBuildEulerRotationMatrices<kZYX>, referenceBuildEulerRotationMatrices<kZYX>, TestOutput_Matrices, 2e-6, false},
+	{"multiplyMat44Array", testMultiplyMat44Array, referenceMultiplyMat44Array, TestOutput_Matrices, 1e-6, false},
+	{"multiplyMat44Array (broadcast)", testMultiplyMat44ArrayBroadcast, referenceMultiplyMat44ArrayBroadcast, TestOutput_Matrices, 1e-6, false},
+	{"inverseMat44Array", testInverseMat44Array, referenceInverseMat44Array, TestOutput_Matrices, 1e-6, false},
+	{"inverseAffineMat44Array", testInverseAffineMat44Array, referenceInverseAffineMat44Array, TestOutput_Matrices, 1e-6, false},
+
+	{"rotateStream", testRotateStream, referenceRotateStream, TestOutput_Vec3Stream, 1e-5, false},
+	{"rotateStream (per point)", testRotateStreamPerPoint, referenceRotateStreamPerPoint, TestOutput_Vec3Stream, 1e-5, false},
+	{"normalizeQuatStream", testNormalizeQuatStream, NULL, TestOutput_QuatStream, 1e-6, false},
+	{"nlerpQuatStreams", testNlerpQuatStreams, NULL, TestOutput_QuatStream, 1e-6, false},
+	{"slerpQuatStreams", testSlerpQuatStreams, NULL, TestOutput_QuatStream, 1e-5, false},
+	{"blendDualQuaternions", testBlendDualQuaternions, NULL, TestOutput_Vec3Stream, 1e-5, false},
+
+	{"sineStream", testSineStream, referenceSineStream, TestOutput_FloatStream, 3e-7, false},
+	{"cosineStream", testCosineStream, referenceCosineStream, TestOutput_FloatStream, 3e-7, false},
+	{"sinCosStream", testSinCosStream, referenceSinCosStream, TestOutput_FloatStreams, 3e-7, false},
+	{"exponentialStream", testExponentialStream, referenceExponentialStream, TestOutput_FloatStream, 2e-7, false},
+	{"logarithmStream", testLogarithmStream, referenceLogarithmStream, TestOutput_FloatStream, 2e-7, false},
+	{"powerStreams", testPowerStreams, referencePowerStreams, TestOutput_FloatStream, 2e-6, false},
+	{"powerStream", testPowerStream, referencePowerStream, TestOutput_FloatStream, 2e-6, false},
+	{"logarithmStream (domain)", testLogarithmStreamDomain, referenceLogarithmStreamDomain, TestOutput_FloatStream, 2e-7, false},
+	{"powerStreams (domain)", testPowerStreamsDomain, referencePowerStreamsDomain, TestOutput_FloatStream, 2e-6, false},
+
+	{"noiseStream (Gradient)", testNoiseStream<NoiseType_Gradient>, referenceNoiseStream<NoiseType_Gradient>, TestOutput_FloatStream, 0.0, true},
+	{"noiseStream (Simplex)", testNoiseStream<NoiseType_Simplex>, referenceNoiseStream<NoiseType_Simplex>, TestOutput_FloatStream, 0.0, true},
+	{"noiseStream4D (Gradient)", testNoiseStream4D<NoiseType_Gradient>, referenceNoiseStream4D<NoiseType_Gradient>, TestOutput_FloatStream, 0.0, true},
+	{"noiseStream4D (Simplex)", testNoiseStream4D<NoiseType_Simplex>, referenceNoiseStream4D<NoiseType_Simplex>, TestOutput_FloatStream, 0.0, true},
+	{"fillRandomFloatStream", testFillRandomFloatStream, referenceFillRandomFloatStream, TestOutput_FloatStream, 0.0, true},
+	{"fillRandomVec3Stream", testFillRandomVec3Stream, referenceFillRandomVec3Stream, TestOutput_Vec3Stream, 0.0, true},
+
+	{"encodeHalves", testEncodeHalves, referenceEncodeHalves, TestOutput_HalfStream, 0.0, true},
+	{"decodeHalves", testDecodeHalves, referenceDecodeHalves, TestOutput_FloatStream, 0.0, true},
+	{"decodePointCacheFrame", testDecodePointCacheFrame, NULL, TestOutput_Vec3Stream, 0.0, true}
+};
+
+
+/**
+ * Copies the output that a kernel wrote to ``out``, so that it can be compared
+ * against the expected output. Halves are widened to floats without rounding.
+ *
+ * @return		The number of floats copied.
+ */
+static unsigned int copyTestOutput(const TestData &data, TestOutput output, float *out)
+{
+	unsigned int count = data.count;
+	switch (output) {
+	case TestOutput_Vec3Stream:
+		memcpy(out, data.vecOut.x, sizeof(float) * count);
+		memcpy(out + count, data.vecOut.y, sizeof(float) * count);
+		memcpy(out + (count * 2), data.vecOut.z, sizeof(float) * count);
+		return count * 3;
+	case TestOutput_FloatStream:
+		memcpy(out, data.floatOut.e, sizeof(float) * count);
+		return count;
+	case TestOutput_FloatStreams:
+		memcpy(out, data.floatOut.e, sizeof(float) * count);
+		memcpy(out + count, data.floatOut2.e, sizeof(float) * count);
+		return count * 2;
+	case TestOutput_QuatStream:
+		memcpy(out, data.quatOut.x, sizeof(float) * count);
+		memcpy(out + count, data.quatOut.y, sizeof(float) * count);
+		memcpy(out + (count * 2), data.quatOut.z, sizeof(float) * count);
+		memcpy(out + (count * 3), data.quatOut.w, sizeof(float) * count);
+		return count * 4;
+	case TestOutput_HalfStream:
+		for (unsigned int i=0; i < count; ++i) {
+			out[i] = (float)data.halfOut.e[i];
+		}
+		return count;
+	case TestOutput_Points:
+		memcpy(out, data.pointsOut, sizeof(Vec3) * count);
+		return count * 3;
+	case TestOutput_Matrices:
+		memcpy(out, data.matricesOut, sizeof(Mat44) * count);
+		return count * 16;
+	default:
+		return 0;
+	}
+}
+
+
+/**
+ * Compares an output against the expected output.
+ *
+ * @param output		The output of the kernel.
+ * @param expected		The expected output.
+ * @param numFloats	The number of floats in each.
+ * @param maxError		Set to the largest error (see ``KernelTest::tolerance``).
+ * @param numMismatches	Set to the number of values whose bits differ.
+ */
+static void compareTestOutput(const float *output,
+							  const float *expected,
+							  unsigned int numFloats,
+							  double &maxError,
+							  unsigned int &numMismatches)
+{
+	maxError = 0.0;
+	numMismatches = 0;
+	for (unsigned int i=0; i < numFloats; ++i) {
+		if (memcmp(output + i, expected + i, sizeof(float)) == 0) {
+			continue;
+		}
+		++numMismatches;
+
+		double value = output[i];
+		double reference = expected[i];
+		double error;
+		if (isnan(value) || isnan(reference)) {
+			error = isnan(value) && isnan(reference) ? 0.0 : INFINITY;
+		} else if (isinf(value) || isinf(reference)) {
+			error = value == reference ? 0.0 : INFINITY;
+		} else {
+			double magnitude = fabs(reference) > 1.0 ? fabs(reference) : 1.0;
+			error = fabs(value - reference) / magnitude;
+		}
+		maxError = error > maxError ? error : maxError;
+	}
+}
+
+
+/// What a matrix test returns for a single matrix.
+struct MatrixTestResult
+{
+	/// Whether the function reported the matrix as singular (or, for the
+	/// determinants, returned exactly ``0``).
+	bool isSingular;
+	/// The largest error against the reference, relative to the largest magnitude
+	/// of the reference. Only set if the matrix was not singular.
+	double error;
+};
+
+typedef MatrixTestResult (*MatrixTestFunc)(float scale, bool isSingular);
+
+struct MatrixTest
+{
+	const char *name;
+	MatrixTestFunc func;
+	double tolerance;
+};
+
+
+/**
+ * Generates a random square matrix that is comfortably invertible, unless it is
+ * made singular by setting its last row to a combination of the first and the
+ * second to last.
+ *
+ * @param mat			Storage for ``dimension * stride`` floats.
+ * @param dimension	The dimension of the matrix.
+ * @param stride		The number of floats between the rows.
+ * @param scale		The scale of the matrix.
+ * @param isSingular	Whether to make the matrix singular.
+ */
+static void generateTestMatrix(float *mat, int dimension, int stride, float scale, bool isSingular)
+{
+	for (int r=0; r < dimension; ++r) {
+		for (int c=0; c < dimension; ++c) {
+			float value = randomTestValue(-1.0f, 1.0f) + (r == c ? (float)dimension : 0.0f);
+			mat[(r * stride) + c] = value * scale;
+		}
+	}
+
+	if (isSingular) {
+		float a = randomTestValue(-1.0f, 1.0f);
+		float b = randomTestValue(-1.0f, 1.0f);
+		const float *other = mat + ((dimension - 2) * stride);
+		float *last = mat + ((dimension - 1) * stride);
+		// NOTE: (sonictk) The row is combined in double precision, since the two
+		// terms can cancel out and leave a row that is not a combination in float.
+		for (int c=0; c < dimension; ++c) {
+			last[c] = (float)(((double)a * mat[c]) + ((double)b * other[c]));
+		}
+	}
+}
+
+
+/// Generates a random affine matrix, whose upper 3x3 block is generated like
+/// ``generateTestMatrix`` and whose translation is of the same scale.
+static Mat44 generateTestAffineMatrix(float scale, bool isSingular)
+{
+	Mat44 mat = identityMat44();
+	generateTestMatrix(mat[0], 3, 4, scale, isSingular);
+	for (int r=0; r < 3; ++r) {
+		mat[r][3] = randomTestValue(-10.0f, 10.0f) * scale;
+	}
+
+	return mat;
+}
+
+
+/**
+ * Inverts a square matrix with Gauss-Jordan elimination in double precision.
+ *
+ * @param mat			The matrix, whose rows are ``stride`` floats apart.
+ * @param dimension	The dimension of the matrix.
+ * @param stride		The number of floats between the rows.
+ * @param inverse		Storage for the ``dimension * dimension`` elements of the
+ * 					inverse, which is tightly packed.
+ * @param det			Set to the determinant of the matrix.
+ */
+static void referenceInverse(const float *mat, int dimension, int stride, double *inverse, double &det)
+{
+	double work[kTestLargeMatrixDimension][kTestLargeMatrixDimension];
+	for (int r=0; r < dimension; ++r) {
+		for (int c=0; c < dimension; ++c) {
+			work[r][c] = mat[(r * stride) + c];
+			inverse[(r * dimension) + c] = r == c ? 1.0 : 0.0;
+		}
+	}
+
+	det = 1.0;
+	for (int k=0; k < dimension; ++k) {
+		int pivotRow = k;
+		for (int r=k + 1; r < dimension; ++r) {
+			if (fabs(work[r][k]) > fabs(work[pivotRow][k])) {
+				pivotRow = r;
+			}
+		}
+		if (pivotRow != k) {
+			for (int c=0; c < dimension; ++c) {
+				double tmp = work[k][c];
+				work[k][c] = work[pivotRow][c];
+				work[pivotRow][c] = tmp;
+				tmp = inverse[(k * dimension) + c];
+				inverse[(k * dimension) + c] = inverse[(pivotRow * dimension) + c];
+				inverse[(pivotRow * dimension) + c] = tmp;
+			}
+			det = -det;
+		}
+
+		double pivot = work[k][k];
+		det *= pivot;
+		if (pivot == 0.0) {
+			return;
+		}
+		for (int c=0; c < dimension; ++c) {
+			work[k][c] /= pivot;
+			inverse[(k * dimension) + c] /= pivot;
+		}
+		for (int r=0; r < dimension; ++r) {
+			if (r == k) {
+				continue;
+			}
+			double factor = work[r][k];
+			for (int c=0; c < dimension; ++c) {
+				work[r][c] -= factor * work[k][c];
+				inverse[(r * dimension) + c] -= factor * inverse[(k * dimension) + c];
+			}
+		}
+	}
+}
+
+
+/// The largest difference between a matrix and the reference, relative to the
+/// largest magnitude of the reference.
+static double matrixError(const float *mat, int dimension, int stride, const double *reference)
+{
+	double maxDifference = 0.0;
+	double maxMagnitude = 0.0;
+	for (int r=0; r < dimension; ++r) {
+		for (int c=0; c < dimension; ++c) {
+			double expected = reference[(r * dimension) + c];
+			double difference = fabs((double)mat[(r * stride) + c] - expected);
+			maxDifference = isnan(difference) || difference > maxDifference ? difference : maxDifference;
+			maxMagnitude = fabs(expected) > maxMagnitude ? fabs(expected) : maxMagnitude;
+		}
+	}
+
+	return maxDifference / maxMagnitude;
+}
+
+
+/// The difference between a determinant and the reference, relative to the reference.
+static double determinantError(float det, double reference)
+{
+	return fabs((double)det - reference) / fabs(reference);
+}
+
+
+template<int (*Inverse)(const Mat44 &, Mat44 &)>
+static MatrixTestResult testInverseMat44(float scale, bool isSingular)
+{
+	Mat44 mat;
+	generateTestMatrix(mat[0], 4, 4, scale, isSingular);
+
+	MatrixTestResult result = {};
+	Mat44 inv;
+	result.isSingular = Inverse(mat, inv) != 0;
+	if (!result.isSingular) {
+		double reference[16];
+		double det;
+		referenceInverse(mat[0], 4, 4, reference, det);
+		result.error = matrixError(inv[0], 4, 4, reference);
+	}
+
+	return result;
+}
+
+
+template<int (*Inverse)(const Mat44 &, Mat44 &)>
+static MatrixTestResult testInverseAffineMat44(float scale, bool isSingular)
+{
+	Mat44 mat = generateTestAffineMatrix(scale, isSingular);
+
+	MatrixTestResult result = {};
+	Mat44 inv;
+	result.isSingular = Inverse(mat, inv) != 0;
+	if (!result.isSingular) {
+		double reference[16];
+		double det;
+		referenceInverse(mat[0], 4, 4, reference, det);
+		result.error = matrixError(inv[0], 4, 4, reference);
+	}
+
+	return result;
+}
+
+
+static MatrixTestResult testDeterminantMat44(float scale, bool isSingular)
+{
+	Mat44 mat;
+	generateTestMatrix(mat[0], 4, 4, scale, isSingular);
+
+	// NOTE: (sonictk) This determinant is a plain expansion that does not tell
+	// singular matrices apart, so only the others are checked.
+	MatrixTestResult result = {};
+	result.isSingular = isSingular;
+	if (!isSingular) {
+		double reference[16];
+		double det;
+		referenceInverse(mat[0], 4, 4, reference, det);
+		result.error = determinantError(determinant(mat), det);
+	}
+
+	return result;
+}
+
+
+template<int dimension, typename DimensionType>
+static MatrixTestResult testDeterminantPointers(float scale, bool isSingular)
+{
+	float mat[dimension][dimension];
+	float *rows[dimension];
+	for (int r=0; r < dimension; ++r) {
+		rows[r] = mat[r];
+	}
+	generateTestMatrix(mat[0], dimension, dimension, scale, isSingular);
+
+	MatrixTestResult result = {};
+	float det = determinant(rows, (DimensionType)dimension);
+	result.isSingular = det == 0.0f;
+	if (!result.isSingular) {
+		double reference[dimension * dimension];
+		double referenceDet;
+		referenceInverse(mat[0], dimension, dimension, reference, referenceDet);
+		result.error = determinantError(det, referenceDet);
+	}
+
+	return result;
+}
+
+
+template<int dimension>
+static MatrixTestResult testDeterminantPointersScratch(float scale, bool isSingular)
+{
+	float mat[dimension][dimension];
+	float *rows[dimension];
+	for (int r=0; r < dimension; ++r) {
+		rows[r] = mat[r];
+	}
+	// NOTE: (sonictk) The scale is reduced so that the determinant spans the same
+	// range as that of the largest of the other matrices, instead of overflowing.
+	float matrixScale = powf(scale, (float)kTestMaxMatrixDimension / (float)dimension) / (float)dimension;
+	generateTestMatrix(mat[0], dimension, dimension, matrixScale, isSingular);
+
+	MatrixTestResult result = {};
+	float scratch[dimension * dimension];
+	float det = determinant(rows, dimension, scratch);
+	result.isSingular = det == 0.0f;
+	if (!result.isSingular) {
+		double reference[dimension * dimension];
+		double referenceDet;
+		referenceInverse(mat[0], dimension, dimension, reference, referenceDet);
+		result.error = determinantError(det, referenceDet);
+	}
+
+	return result;
+}
+
+
+template<int dimension>
+static MatrixTestResult testInverseMatX(float scale, bool isSingular)
+{
+	MatX<float, dimension, dimension> mat;
+	generateTestMatrix(mat[0], dimension, dimension, scale, isSingular);
+
+	MatrixTestResult result = {};
+	MatX<float, dimension, dimension> inv;
+	result.isSingular = inverse(mat, inv) != 0;
+	if (!result.isSingular) {
+		double reference[dimension * dimension];
+		double det;
+		referenceInverse(mat[0], dimension, dimension, reference, det);
+		result.error = matrixError(inv[0], dimension, dimension, reference);
+	}
+
+	return result;
+}
+
+
+template<int dimension>
+static MatrixTestResult testDeterminantMatX(float scale, bool isSingular)
+{
+	MatX<float, dimension, dimension> mat;
+	generateTestMatrix(mat[0], dimension, dimension, scale, isSingular);
+
+	MatrixTestResult result = {};
+	float det = determinant(mat);
+	result.isSingular = det == 0.0f;
+	// NOTE: (sonictk) The closed-form determinants do not tell singular matrices
+	// apart either, so only the others are checked for those sizes.
+	if (dimension <= 3 && isSingular) {
+		result.isSingular = true;
+	} else if (!result.isSingular) {
+		double reference[dimension * dimension];
+		double referenceDet;
+		referenceInverse(mat[0], dimension, dimension, reference, referenceDet);
+		result.error = determinantError(det, referenceDet);
+	}
+
+	return result;
+}
+
+
+static const MatrixTest kMatrixTests[] = {
+	{"inverseScalar(Mat44)", testInverseMat44<inverseScalar>, 2e-6},
+	{"inverse(Mat44)", testInverseMat44<inverse>, 2e-6},
+	{"inverse(Mat44) (affine)", testInverseAffineMat44<inverse>, 2e-6},
+	{"inverseAffine(Mat44)", testInverseAffineMat44<inverseAffine>, 2e-6},
+	{"determinant(Mat44)", testDeterminantMat44, 2e-6},
+	{"determinant(float **, 4)", testDeterminantPointers<4, int>, 2e-6},
+	{"determinant(float **, 7)", testDeterminantPointers<kTestMaxMatrixDimension, int>, 2e-6},
+	{"determinant(float **, 7u)", testDeterminantPointers<kTestMaxMatrixDimension, unsigned int>, 2e-6},
+	{"determinant(float **, 40, float *)", testDeterminantPointersScratch<kTestLargeMatrixDimension>, 1e-5},
+	{"inverse(MatX<2, 2>)", testInverseMatX<2>, 2e-6},
+	{"inverse(MatX<3, 3>)", testInverseMatX<3>, 2e-6},
+	{"inverse(MatX<5, 5>)", testInverseMatX<5>, 2e-6},
+	{"determinant(MatX<3, 3>)", testDeterminantMatX<3>, 2e-6},
+	{"determinant(MatX<5, 5>)", testDeterminantMatX<5>, 2e-6}
+};
+
+
+/**
+ * Runs a matrix test over matrices of every scale, half of which are singular.
+ *
+ * @param test				The test to run.
+ * @param maxError			Set to the largest error of the matrices that are not singular.
+ * @param numMisjudged		Set to the number of matrices that were reported as
+ * 						singular when they were not, or the other way around.
+ */
+static void runMatrixTest(const MatrixTest &test, double &maxError, unsigned int &numMisjudged)
+{
+	maxError = 0.0;
+	numMisjudged = 0;
+	for (unsigned int i=0; i < kTestNumMatrices; ++i) {
+		float decades = kTestMatrixScaleDecades * (((2.0f * (float)(i / 2)) / (float)(kTestNumMatrices / 2)) - 1.0f);
+		bool isSingular = (i % 2) == 1;
+		MatrixTestResult result = test.func(powf(10.0f, decades), isSingular);
+		if (result.isSingular != isSingular) {
+			++numMisjudged;
+		} else if (!isSingular && (isnan(result.error) || result.error > maxError)) {
+			maxError = isnan(result.error) ? INFINITY : result.error;
+		}
+	}
+}
+
+
+int main(int argc, char **argv)
+{
+	const char *filter = NULL;
+	for (int i=1; i < argc; ++i) {
+		if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+			filter = argv[++i];
+		} else {
+			fprintf(stderr, "Usage: %s [--filter <substring>]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	int detectedLevel = instrset_detect();
+	bool hasFMA = hasFMA3();
+	static const TestVariant variants[] = {
+		{"Scalar", SIMDLevel_Scalar, false},
+		{"SSE2", SIMDLevel_SSE2, false},
+		{"AVX2", SIMDLevel_AVX2, false},
+		{"AVX2 (FMA)", SIMDLevel_AVX2, true},
+		{"AVX-512", SIMDLevel_AVX512, false},
+		{"AVX-512 (FMA)", SIMDLevel_AVX512, true}
+	};
+	unsigned int numVariants = sizeof(variants) / sizeof(variants[0]);
+
+	TestData data;
+	if (initializeTestData(data, kTestNumElements) != 0) {
+		fprintf(stderr, "Failed to allocate the test data!\n");
+		return 2;
+	}
+
+	float *expected = (float *)malloc(sizeof(float) * kTestNumElements * 16);
+	float *output = (float *)malloc(sizeof(float) * kTestNumElements * 16);
+	if (!expected || !output) {
+		fprintf(stderr, "Failed to allocate the test outputs!\n");
+		return 2;
+	}
+
+	printf("%-36s %-14s %12s %12s\n", "Kernel", "Variant", "Max error", "Tolerance");
+
+	unsigned int numTests = 0;
+	unsigned int numFailures = 0;
+	unsigned int numCases = sizeof(kKernelTests) / sizeof(kKernelTests[0]);
+	for (unsigned int c=0; c < numCases; ++c) {
+		const KernelTest &test = kKernelTests[c];
+		if (filter && !strstr(test.name, filter)) {
+			continue;
+		}
+
+		SIMDKernelTable table;
+		bool hasExpected = false;
+		if (test.reference) {
+			bindSIMDKernelTable(table, SIMDLevel_Scalar, false);
+			test.reference(data, table);
+			copyTestOutput(data, test.output, expected);
+			hasExpected = true;
+		}
+
+		for (unsigned int v=0; v < numVariants; ++v) {
+			const TestVariant &variant = variants[v];
+			if (variant.level > detectedLevel || (variant.useFMA && !hasFMA)) {
+				continue;
+			}
+
+			bindSIMDKernelTable(table, variant.level, variant.useFMA);
+			test.func(data, table);
+			unsigned int numFloats = copyTestOutput(data, test.output, output);
+			if (!hasExpected) {
+				memcpy(expected, output, sizeof(float) * numFloats);
+				hasExpected = true;
+			}
+
+			double maxError;
+			unsigned int numMismatches;
+			compareTestOutput(output, expected, numFloats, maxError, numMismatches);
+			bool passed = test.isExact ? numMismatches == 0 : maxError <= test.tolerance;
+
+			printf("%-36s %-14s %12.3g %12.3g%s",
+				   test.name,
+				   variant.name,
+				   maxError,
+				   test.tolerance,
+				   passed ? "\n" : "   FAILED");
+			if (!passed && test.isExact) {
+				printf(" (%u values differ)\n", numMismatches);
+			} else if (!passed) {
+				printf("\n");
+			}
+
+			++numTests;
+			numFailures += passed ? 0 : 1;
+		}
+	}
+
+	printf("\n%-36s %-14s %12s %12s\n", "Matrix function", "Misjudged", "Max error", "Tolerance");
+
+	unsigned int numMatrixTests = sizeof(kMatrixTests) / sizeof(kMatrixTests[0]);
+	for (unsigned int m=0; m < numMatrixTests; ++m) {
+		const MatrixTest &test = kMatrixTests[m];
+		if (filter && !strstr(test.name, filter)) {
+			continue;
+		}
+
+		double maxError;
+		unsigned int numMisjudged;
+		runMatrixTest(test, maxError, numMisjudged);
+		bool passed = numMisjudged == 0 && maxError <= test.tolerance;
+		printf("%-36s %-14u %12.3g %12.3g%s\n",
+			   test.name,
+			   numMisjudged,
+			   maxError,
+			   test.tolerance,
+			   passed ? "" : "   FAILED");
+
+		++numTests;
+		numFailures += passed ? 0 : 1;
+	}
+
+	printf("%u of %u test(s) failed.\n", numFailures, numTests);
+
+	free(output);
+	free(expected);
+	freeTestData(data);
+
+	return numFailures > 0 ? 1 : 0;
+}
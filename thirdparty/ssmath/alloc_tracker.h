@@ -0,0 +1,575 @@
+/**
+ * @brief  	Counts the heap allocations made by the code of a single shared library,
+ * 			without affecting the rest of the process.
+ *
+ * 			On Linux, the library's relocations are walked and every GOT slot that
+ * 			refers to one of the C or C++ allocation functions is redirected to a
+ * 			wrapper, which counts the call on the calling thread before forwarding
+ * 			it to the real function. Since only the slots of that library are
+ * 			changed, only the calls that its own code makes are counted, and not
+ * 			the ones made by other libraries that it calls into (e.g. inside
+ * 			``printf``). The hooks are not available on other platforms, where
+ * 			installing them always fails.
+ *
+ * 			Sizes are counted with ``malloc_usable_size``, so that a block that is
+ * 			allocated by one side and freed by the other is counted the same way by
+ * 			both, without having to store anything in the block.
+ */
+#ifndef ALLOC_TRACKER_H
+#define ALLOC_TRACKER_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+
+#ifdef __linux__
+#include <dlfcn.h>
+#include <link.h>
+#include <malloc.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif // __linux__
+
+
+/// The allocations that the hooked libraries have made on a single thread. These
+/// only ever increase, so the allocations made over some work are the difference
+/// of the counts before and after it.
+struct AllocationCounts
+{
+	uint64_t allocations;
+	uint64_t frees;
+	uint64_t allocatedBytes;
+	uint64_t freedBytes;
+};
+
+static thread_local AllocationCounts tAllocationCounts;
+
+
+/// The maximum number of slots that can be hooked in a single library. Each
+/// function can have both a PLT and a GOT slot.
+static const unsigned int kMaxAllocationHooks = 128;
+
+/// The slots of a library that have been redirected, and what they held before.
+struct AllocationHooks
+{
+	void **slots[kMaxAllocationHooks];
+	void *originals[kMaxAllocationHooks];
+	unsigned int numSlots;
+
+	/// The range of the library's relocations that are made read-only once it has
+	/// been loaded (i.e. its ``PT_GNU_RELRO`` segment).
+	uintptr_t relroStart;
+	uintptr_t relroEnd;
+};
+
+
+/// Returns the allocations counted on the calling thread so far.
+inline AllocationCounts getThreadAllocationCounts()
+{
+	return tAllocationCounts;
+}
+
+
+/// Returns the allocations made between two readings of the counts.
+inline AllocationCounts subtractAllocationCounts(const AllocationCounts &end, const AllocationCounts &start)
+{
+	AllocationCounts result;
+	result.allocations = end.allocations - start.allocations;
+	result.frees = end.frees - start.frees;
+	result.allocatedBytes = end.allocatedBytes - start.allocatedBytes;
+	result.freedBytes = end.freedBytes - start.freedBytes;
+
+	return result;
+}
+
+
+#ifdef __linux__
+
+inline void countAllocation(void *ptr)
+{
+	if (ptr) {
+		++tAllocationCounts.allocations;
+		tAllocationCounts.allocatedBytes += malloc_usable_size(ptr);
+	}
+}
+
+inline void countFree(void *ptr)
+{
+	if (ptr) {
+		++tAllocationCounts.frees;
+		tAllocationCounts.freedBytes += malloc_usable_size(ptr);
+	}
+}
+
+
+static void *trackedMalloc(size_t size)
+{
+	void *ptr = malloc(size);
+	countAllocation(ptr);
+
+	return ptr;
+}
+
+static void *trackedCalloc(size_t count, size_t size)
+{
+	void *ptr = calloc(count, size);
+	countAllocation(ptr);
+
+	return ptr;
+}
+
+static void *trackedRealloc(void *ptr, size_t size)
+{
+	// NOTE: (sonictk) A reallocation is counted as freeing the old block and
+	// allocating the new one, unless it failed and the old block is still live.
+	size_t oldSize = ptr ? malloc_usable_size(ptr) : 0;
+	void *result = realloc(ptr, size);
+	if (result || size == 0) {
+		if (ptr) {
+			++tAllocationCounts.frees;
+			tAllocationCounts.freedBytes += oldSize;
+		}
+		countAllocation(result);
+	}
+
+	return result;
+}
+
+static int trackedPosixMemalign(void **ptr, size_t alignment, size_t size)
+{
+	int result = posix_memalign(ptr, alignment, size);
+	if (result == 0) {
+		countAllocation(*ptr);
+	}
+
+	return result;
+}
+
+static void *trackedAlignedAlloc(size_t alignment, size_t size)
+{
+	void *ptr = aligned_alloc(alignment, size);
+	countAllocation(ptr);
+
+	return ptr;
+}
+
+static void trackedFree(void *ptr)
+{
+	countFree(ptr);
+	free(ptr);
+}
+
+static void *trackedNew(size_t size)
+{
+	void *ptr = ::operator new(size);
+	countAllocation(ptr);
+
+	return ptr;
+}
+
+static void *trackedNewArray(size_t size)
+{
+	void *ptr = ::operator new[](size);
+	countAllocation(ptr);
+
+	return ptr;
+}
+
+static void trackedDelete(void *ptr)
+{
+	countFree(ptr);
+	::operator delete(ptr);
+}
+
+static void trackedDeleteArray(void *ptr)
+{
+	countFree(ptr);
+	::operator delete[](ptr);
+}
+
+static void trackedSizedDelete(void *ptr, size_t)
+{
+	countFree(ptr);
+	::operator delete(ptr);
+}
+
+static void trackedSizedDeleteArray(void *ptr, size_t)
+{
+	countFree(ptr);
+	::operator delete[](ptr);
+}
+
+static void *trackedNewNothrow(size_t size, const std::nothrow_t &tag)
+{
+	void *ptr = ::operator new(size, tag);
+	countAllocation(ptr);
+
+	return ptr;
+}
+
+static void *trackedNewArrayNothrow(size_t size, const std::nothrow_t &tag)
+{
+	void *ptr = ::operator new[](size, tag);
+	countAllocation(ptr);
+
+	return ptr;
+}
+
+static void trackedDeleteNothrow(void *ptr, const std::nothrow_t &tag)
+{
+	countFree(ptr);
+	::operator delete(ptr, tag);
+}
+
+static void trackedDeleteArrayNothrow(void *ptr, const std::nothrow_t &tag)
+{
+	countFree(ptr);
+	::operator delete[](ptr, tag);
+}
+
+
+// NOTE: (sonictk) The aligned operators only exist from C++17 onwards, so they
+// cannot be called by name here. Their ``std::align_val_t`` argument is passed
+// just like a ``size_t``, so the real functions are looked up when the hooks are
+// installed and called through these instead.
+typedef void *(*AlignedNewFunc)(size_t, size_t);
+typedef void *(*AlignedNewNothrowFunc)(size_t, size_t, const std::nothrow_t &);
+typedef void (*AlignedDeleteFunc)(void *, size_t);
+typedef void (*SizedAlignedDeleteFunc)(void *, size_t, size_t);
+typedef void (*AlignedDeleteNothrowFunc)(void *, size_t, const std::nothrow_t &);
+
+static AlignedNewFunc kAlignedNew;
+static AlignedNewFunc kAlignedNewArray;
+static AlignedNewNothrowFunc kAlignedNewNothrow;
+static AlignedNewNothrowFunc kAlignedNewArrayNothrow;
+static AlignedDeleteFunc kAlignedDelete;
+static AlignedDeleteFunc kAlignedDeleteArray;
+static SizedAlignedDeleteFunc kSizedAlignedDelete;
+static SizedAlignedDeleteFunc kSizedAlignedDeleteArray;
+static AlignedDeleteNothrowFunc kAlignedDeleteNothrow;
+static AlignedDeleteNothrowFunc kAlignedDeleteArrayNothrow;
+
+static void *trackedAlignedNew(size_t size, size_t alignment)
+{
+	void *ptr = kAlignedNew(size, alignment);
+	countAllocation(ptr);
+
+	return ptr;
+}
+
+static void *trackedAlignedNewArray(size_t size, size_t alignment)
+{
+	void *ptr = kAlignedNewArray(size, alignment);
+	countAllocation(ptr);
+
+	return ptr;
+}
+
+static void *trackedAlignedNewNothrow(size_t size, size_t alignment, const std::nothrow_t &tag)
+{
+	void *ptr = kAlignedNewNothrow(size, alignment, tag);
+	countAllocation(ptr);
+
+	return ptr;
+}
+
+static void *trackedAlignedNewArrayNothrow(size_t size, size_t alignment, const std::nothrow_t &tag)
+{
+	void *ptr = kAlignedNewArrayNothrow(size, alignment, tag);
+	countAllocation(ptr);
+
+	return ptr;
+}
+
+static void trackedAlignedDelete(void *ptr, size_t alignment)
+{
+	countFree(ptr);
+	kAlignedDelete(ptr, alignment);
+}
+
+static void trackedAlignedDeleteArray(void *ptr, size_t alignment)
+{
+	countFree(ptr);
+	kAlignedDeleteArray(ptr, alignment);
+}
+
+static void trackedSizedAlignedDelete(void *ptr, size_t size, size_t alignment)
+{
+	countFree(ptr);
+	kSizedAlignedDelete(ptr, size, alignment);
+}
+
+static void trackedSizedAlignedDeleteArray(void *ptr, size_t size, size_t alignment)
+{
+	countFree(ptr);
+	kSizedAlignedDeleteArray(ptr, size, alignment);
+}
+
+static void trackedAlignedDeleteNothrow(void *ptr, size_t alignment, const std::nothrow_t &tag)
+{
+	countFree(ptr);
+	kAlignedDeleteNothrow(ptr, alignment, tag);
+}
+
+static void trackedAlignedDeleteArrayNothrow(void *ptr, size_t alignment, const std::nothrow_t &tag)
+{
+	countFree(ptr);
+	kAlignedDeleteArrayNothrow(ptr, alignment, tag);
+}
+
+
+struct AllocationHookSymbol
+{
+	const char *name;
+	void *replacement;
+	void **function; /// If not ``NULL``, where the real function is looked up to.
+};
+
+/// The functions that are hooked. The C++ operators are listed by their mangled
+/// names, since that is what the relocations refer to.
+static const AllocationHookSymbol kAllocationHookSymbols[] = {
+	{"malloc", (void *)trackedMalloc, NULL},
+	{"calloc", (void *)trackedCalloc, NULL},
+	{"realloc", (void *)trackedRealloc, NULL},
+	{"posix_memalign", (void *)trackedPosixMemalign, NULL},
+	{"aligned_alloc", (void *)trackedAlignedAlloc, NULL},
+	{"free", (void *)trackedFree, NULL},
+	{"_Znwm", (void *)trackedNew, NULL},
+	{"_Znam", (void *)trackedNewArray, NULL},
+	{"_ZdlPv", (void *)trackedDelete, NULL},
+	{"_ZdaPv", (void *)trackedDeleteArray, NULL},
+	{"_ZdlPvm", (void *)trackedSizedDelete, NULL},
+	{"_ZdaPvm", (void *)trackedSizedDeleteArray, NULL},
+	{"_ZnwmRKSt9nothrow_t", (void *)trackedNewNothrow, NULL},
+	{"_ZnamRKSt9nothrow_t", (void *)trackedNewArrayNothrow, NULL},
+	{"_ZdlPvRKSt9nothrow_t", (void *)trackedDeleteNothrow, NULL},
+	{"_ZdaPvRKSt9nothrow_t", (void *)trackedDeleteArrayNothrow, NULL},
+	{"_ZnwmSt11align_val_t", (void *)trackedAlignedNew, (void **)&kAlignedNew},
+	{"_ZnamSt11align_val_t", (void *)trackedAlignedNewArray, (void **)&kAlignedNewArray},
+	{"_ZnwmSt11align_val_tRKSt9nothrow_t", (void *)trackedAlignedNewNothrow, (void **)&kAlignedNewNothrow},
+	{"_ZnamSt11align_val_tRKSt9nothrow_t", (void *)trackedAlignedNewArrayNothrow, (void **)&kAlignedNewArrayNothrow},
+	{"_ZdlPvSt11align_val_t", (void *)trackedAlignedDelete, (void **)&kAlignedDelete},
+	{"_ZdaPvSt11align_val_t", (void *)trackedAlignedDeleteArray, (void **)&kAlignedDeleteArray},
+	{"_ZdlPvmSt11align_val_t", (void *)trackedSizedAlignedDelete, (void **)&kSizedAlignedDelete},
+	{"_ZdaPvmSt11align_val_t", (void *)trackedSizedAlignedDeleteArray, (void **)&kSizedAlignedDeleteArray},
+	{"_ZdlPvSt11align_val_tRKSt9nothrow_t", (void *)trackedAlignedDeleteNothrow, (void **)&kAlignedDeleteNothrow},
+	{"_ZdaPvSt11align_val_tRKSt9nothrow_t", (void *)trackedAlignedDeleteArrayNothrow, (void **)&kAlignedDeleteArrayNothrow}
+};
+
+
+/// The kinds of relocations that can refer to a hooked function.
+#if defined(__x86_64__)
+static const uint32_t kAllocationHookRelocTypes[] = {R_X86_64_JUMP_SLOT, R_X86_64_GLOB_DAT, R_X86_64_64};
+#elif defined(__aarch64__)
+static const uint32_t kAllocationHookRelocTypes[] = {R_AARCH64_JUMP_SLOT, R_AARCH64_GLOB_DAT, R_AARCH64_ABS64};
+#else
+#define SS_ALLOCATION_HOOKS_UNSUPPORTED 1
+#endif
+
+
+#ifndef SS_ALLOCATION_HOOKS_UNSUPPORTED
+
+static const bool kAllocationHooksSupported = true;
+
+static int findAllocationHookRelro(struct dl_phdr_info *info, size_t, void *data)
+{
+	AllocationHooks *hooks = (AllocationHooks *)data;
+	if ((uintptr_t)info->dlpi_addr != hooks->relroStart) {
+		return 0;
+	}
+	hooks->relroStart = hooks->relroEnd = 0;
+	for (ElfW(Half) i=0; i < info->dlpi_phnum; ++i) {
+		const ElfW(Phdr) &phdr = info->dlpi_phdr[i];
+		if (phdr.p_type == PT_GNU_RELRO) {
+			hooks->relroStart = (uintptr_t)(info->dlpi_addr + phdr.p_vaddr);
+			hooks->relroEnd = hooks->relroStart + phdr.p_memsz;
+		}
+	}
+
+	return 1;
+}
+
+
+/**
+ * Writes a function pointer into a slot of a loaded library, temporarily making
+ * its page writable if the slot is in the library's read-only relocations.
+ *
+ * @return		``0`` on success, ``-1`` if the page could not be made writable.
+ */
+inline int writeAllocationHookSlot(const AllocationHooks &hooks, void **slot, void *value)
+{
+	bool isReadOnly = (uintptr_t)slot >= hooks.relroStart && (uintptr_t)slot < hooks.relroEnd;
+	uintptr_t pageSize = (uintptr_t)sysconf(_SC_PAGESIZE);
+	void *page = (void *)((uintptr_t)slot & ~(pageSize - 1));
+	if (isReadOnly && mprotect(page, pageSize, PROT_READ|PROT_WRITE) != 0) {
+		return -1;
+	}
+	// NOTE: (sonictk) Other threads may be calling through the slot right now, so
+	// it is replaced in a single store.
+	__atomic_store_n(slot, value, __ATOMIC_RELEASE);
+	if (isReadOnly) {
+		mprotect(page, pageSize, PROT_READ);
+	}
+
+	return 0;
+}
+
+
+/**
+ * Restores the slots that were redirected by ``installAllocationHooks``. A library
+ * that has been unloaded must not be unhooked; its hooks can just be discarded.
+ *
+ * @param hooks	The hooks to remove.
+ */
+inline void removeAllocationHooks(AllocationHooks &hooks)
+{
+	for (unsigned int i=0; i < hooks.numSlots; ++i) {
+		writeAllocationHookSlot(hooks, hooks.slots[i], hooks.originals[i]);
+	}
+	hooks.numSlots = 0;
+}
+
+
+/**
+ * Redirects the allocation functions that the code of a loaded library calls to
+ * wrappers that count them on the calling thread. Blocks that were allocated
+ * before the hooks were installed are still counted when they are freed.
+ *
+ * @param handle	The handle of the library, as returned by ``loadSharedLibrary``.
+ * @param hooks	Set to the slots that were redirected. If these are already
+ * 				installed, they are removed first.
+ *
+ * @return			``0`` on success (even if the library doesn't allocate at all),
+ * 				``-1`` if the library's relocations could not be read or hooked,
+ * 				in which case nothing is hooked.
+ */
+inline int installAllocationHooks(void *handle, AllocationHooks &hooks)
+{
+	removeAllocationHooks(hooks);
+
+	struct link_map *map = NULL;
+	if (!handle || dlinfo(handle, RTLD_DI_LINKMAP, &map) != 0 || !map) {
+		return -1;
+	}
+
+	// NOTE: (sonictk) glibc relocates the addresses in the dynamic section when it
+	// loads the library, but other loaders leave them relative to the base.
+	ElfW(Addr) base = map->l_addr;
+	const ElfW(Sym) *symbols = NULL;
+	const char *strings = NULL;
+	const ElfW(Rela) *tables[2] = {NULL, NULL};
+	size_t tableSizes[2] = {0, 0};
+	bool isRela = true;
+	for (const ElfW(Dyn) *dyn=map->l_ld; dyn->d_tag != DT_NULL; ++dyn) {
+		ElfW(Addr) ptr = dyn->d_un.d_ptr < base ? base + dyn->d_un.d_ptr : dyn->d_un.d_ptr;
+		switch (dyn->d_tag) {
+		case DT_SYMTAB:
+			symbols = (const ElfW(Sym) *)ptr;
+			break;
+		case DT_STRTAB:
+			strings = (const char *)ptr;
+			break;
+		case DT_JMPREL:
+			tables[0] = (const ElfW(Rela) *)ptr;
+			break;
+		case DT_PLTRELSZ:
+			tableSizes[0] = dyn->d_un.d_val;
+			break;
+		case DT_PLTREL:
+			isRela = dyn->d_un.d_val == DT_RELA;
+			break;
+		case DT_RELA:
+			tables[1] = (const ElfW(Rela) *)ptr;
+			break;
+		case DT_RELASZ:
+			tableSizes[1] = dyn->d_un.d_val;
+			break;
+		default:
+			break;
+		}
+	}
+	if (!symbols || !strings || !isRela) {
+		return -1;
+	}
+
+	hooks.relroStart = (uintptr_t)base;
+	hooks.relroEnd = 0;
+	if (dl_iterate_phdr(findAllocationHookRelro, &hooks) == 0) {
+		hooks.relroStart = 0;
+	}
+
+	unsigned int numSymbols = sizeof(kAllocationHookSymbols) / sizeof(kAllocationHookSymbols[0]);
+	unsigned int numTypes = sizeof(kAllocationHookRelocTypes) / sizeof(kAllocationHookRelocTypes[0]);
+	for (int t=0; t < 2; ++t) {
+		size_t numRelocs = tables[t] ? tableSizes[t] / sizeof(ElfW(Rela)) : 0;
+		for (size_t r=0; r < numRelocs; ++r) {
+			const ElfW(Rela) &reloc = tables[t][r];
+			uint32_t type = (uint32_t)ELF64_R_TYPE(reloc.r_info);
+			bool isHookableType = false;
+			for (unsigned int i=0; i < numTypes; ++i) {
+				isHookableType |= type == kAllocationHookRelocTypes[i];
+			}
+			uint32_t symbol = (uint32_t)ELF64_R_SYM(reloc.r_info);
+			if (!isHookableType || symbol == 0) {
+				continue;
+			}
+
+			const char *name = strings + symbols[symbol].st_name;
+			for (unsigned int i=0; i < numSymbols; ++i) {
+				if (strcmp(name, kAllocationHookSymbols[i].name) != 0) {
+					continue;
+				}
+				// NOTE: (sonictk) The library could not have been loaded if the function
+				// did not exist, so this only fails if it is hidden from us somehow; in
+				// that case, the slot is left alone rather than hooked to nothing.
+				void **function = kAllocationHookSymbols[i].function;
+				if (function && !*function) {
+					*function = dlsym(RTLD_DEFAULT, name);
+				}
+				if (function && !*function) {
+					break;
+				}
+				void **slot = (void **)(base + reloc.r_offset);
+				void *original = *slot;
+				if (hooks.numSlots == kMaxAllocationHooks
+					|| writeAllocationHookSlot(hooks, slot, kAllocationHookSymbols[i].replacement) != 0) {
+					removeAllocationHooks(hooks);
+					return -1;
+				}
+				hooks.slots[hooks.numSlots] = slot;
+				hooks.originals[hooks.numSlots] = original;
+				++hooks.numSlots;
+				break;
+			}
+		}
+	}
+
+	return 0;
+}
+
+#endif // SS_ALLOCATION_HOOKS_UNSUPPORTED
+
+#endif // __linux__
+
+
+#if !defined(__linux__) || defined(SS_ALLOCATION_HOOKS_UNSUPPORTED)
+
+static const bool kAllocationHooksSupported = false;
+
+inline void removeAllocationHooks(AllocationHooks &hooks)
+{
+	hooks.numSlots = 0;
+}
+
+inline int installAllocationHooks(void *handle, AllocationHooks &hooks)
+{
+	hooks.numSlots = 0;
+
+	return -1;
+}
+
+#endif // Allocation hooks are not supported
+
+
+#endif /* ALLOC_TRACKER_H */
@@ -36,6 +36,10 @@ inline bool areFloatsEqual(float a, float b)
 /**
  * This function will return a random value between ``0`` and ``1``.
  *
+ * This uses ``rand()``, which is not safe to call from several threads at once and
+ * whose results depend on the order of the calls. Prefer the generators in
+ * ``random.h`` for anything that runs in parallel or needs to be reproducible.
+ *
  * @return		A normalized random value.
  */
 inline float getNormalizedRandomValue()
@@ -0,0 +1,781 @@
+/**
+ * @brief  	Expression templates for ``MatX`` and the SoA vector streams. The
+ * 			operators here do not compute anything when called; they build up a
+ * 			lightweight tree of the expression instead, which is only evaluated
+ * 			when it is assigned to a destination. This way, compound expressions
+ * 			such as ``(a * (1 - t)) + (b * t)`` compile down to a single loop over
+ * 			the elements without any intermediate matrices or streams.
+ *
+ * 			Expressions hold references to the matrices and streams they were built
+ * 			from, so they must not outlive them.
+ */
+#ifndef EXPRESSION_MATH_H
+#define EXPRESSION_MATH_H
+
+#include "matrix_math.h"
+#include "vector_stream.h"
+#include <limits.h>
+
+
+/// Equivalent of ``std::enable_if``, so that the operators below only take part
+/// in overload resolution for expression types.
+template<bool condition, class T>
+struct SSEnableIf {};
+
+template<class T>
+struct SSEnableIf<true, T>
+{
+	typedef T type;
+};
+
+
+// ---------------------------------------------------------------------------------
+// MatX expressions
+// ---------------------------------------------------------------------------------
+
+/// Describes a type that can be used as an operand of a ``MatX`` expression. This
+/// is specialized for ``MatX`` itself, which is held by reference, and for each of
+/// the expression nodes below, which are cheap to copy and are held by value.
+template<class E>
+struct MatXExpressionTraits
+{
+	static const bool isExpression = false;
+};
+
+template<class T, int rows, int columns>
+struct MatXExpressionTraits<MatX<T, rows, columns> >
+{
+	static const bool isExpression = true;
+	static const int numRows = rows;
+	static const int numColumns = columns;
+	typedef T ValueType;
+	typedef const MatX<T, rows, columns> &StorageType;
+};
+
+/// The traits shared by all of the expression nodes below.
+template<class Node>
+struct MatXNodeTraits
+{
+	static const bool isExpression = true;
+	static const int numRows = Node::numRows;
+	static const int numColumns = Node::numColumns;
+	typedef typename Node::ValueType ValueType;
+	typedef const Node StorageType;
+};
+
+
+/// ``a + b`` and ``a - b``, element-wise.
+template<class A, class B, bool isSubtraction>
+struct MatXSumExpression
+{
+	static const int numRows = MatXExpressionTraits<A>::numRows;
+	static const int numColumns = MatXExpressionTraits<A>::numColumns;
+	typedef typename MatXExpressionTraits<A>::ValueType ValueType;
+
+	static_assert(numRows == MatXExpressionTraits<B>::numRows
+				  && numColumns == MatXExpressionTraits<B>::numColumns,
+				  "The matrices must have the same dimensions");
+
+	typename MatXExpressionTraits<A>::StorageType a;
+	typename MatXExpressionTraits<B>::StorageType b;
+
+	constexpr MatXSumExpression(const A &a, const B &b) : a(a), b(b) {}
+
+	constexpr ValueType operator()(int row, int col) const {
+		return isSubtraction ? a(row, col) - b(row, col) : a(row, col) + b(row, col);
+	}
+};
+
+template<class A, class B, bool isSubtraction>
+struct MatXExpressionTraits<MatXSumExpression<A, B, isSubtraction> >
+	: MatXNodeTraits<MatXSumExpression<A, B, isSubtraction> > {};
+
+
+/// ``-a``, element-wise.
+template<class A>
+struct MatXNegateExpression
+{
+	static const int numRows = MatXExpressionTraits<A>::numRows;
+	static const int numColumns = MatXExpressionTraits<A>::numColumns;
+	typedef typename MatXExpressionTraits<A>::ValueType ValueType;
+
+	typename MatXExpressionTraits<A>::StorageType a;
+
+	constexpr explicit MatXNegateExpression(const A &a) : a(a) {}
+
+	constexpr ValueType operator()(int row, int col) const {
+		return -a(row, col);
+	}
+};
+
+template<class A>
+struct MatXExpressionTraits<MatXNegateExpression<A> > : MatXNodeTraits<MatXNegateExpression<A> > {};
+
+
+/// ``a * s``, where ``s`` is a scalar.
+template<class A>
+struct MatXScaleExpression
+{
+	static const int numRows = MatXExpressionTraits<A>::numRows;
+	static const int numColumns = MatXExpressionTraits<A>::numColumns;
+	typedef typename MatXExpressionTraits<A>::ValueType ValueType;
+
+	typename MatXExpressionTraits<A>::StorageType a;
+	ValueType factor;
+
+	constexpr MatXScaleExpression(const A &a, ValueType factor) : a(a), factor(factor) {}
+
+	constexpr ValueType operator()(int row, int col) const {
+		return a(row, col) * factor;
+	}
+};
+
+template<class A>
+struct MatXExpressionTraits<MatXScaleExpression<A> > : MatXNodeTraits<MatXScaleExpression<A> > {};
+
+
+template<class A, class B>
+constexpr typename SSEnableIf<MatXExpressionTraits<A>::isExpression && MatXExpressionTraits<B>::isExpression,
+							  MatXSumExpression<A, B, false> >::type
+operator+(const A &a, const B &b)
+{
+	return MatXSumExpression<A, B, false>(a, b);
+}
+
+template<class A, class B>
+constexpr typename SSEnableIf<MatXExpressionTraits<A>::isExpression && MatXExpressionTraits<B>::isExpression,
+							  MatXSumExpression<A, B, true> >::type
+operator-(const A &a, const B &b)
+{
+	return MatXSumExpression<A, B, true>(a, b);
+}
+
+template<class A>
+constexpr typename SSEnableIf<MatXExpressionTraits<A>::isExpression, MatXNegateExpression<A> >::type
+operator-(const A &a)
+{
+	return MatXNegateExpression<A>(a);
+}
+
+template<class A>
+constexpr typename SSEnableIf<MatXExpressionTraits<A>::isExpression, MatXScaleExpression<A> >::type
+operator*(const A &a, typename MatXExpressionTraits<A>::ValueType factor)
+{
+	return MatXScaleExpression<A>(a, factor);
+}
+
+template<class A>
+constexpr typename SSEnableIf<MatXExpressionTraits<A>::isExpression, MatXScaleExpression<A> >::type
+operator*(typename MatXExpressionTraits<A>::ValueType factor, const A &a)
+{
+	return MatXScaleExpression<A>(a, factor);
+}
+
+template<class A>
+constexpr typename SSEnableIf<MatXExpressionTraits<A>::isExpression, MatXScaleExpression<A> >::type
+operator/(const A &a, typename MatXExpressionTraits<A>::ValueType divisor)
+{
+	return MatXScaleExpression<A>(a, typename MatXExpressionTraits<A>::ValueType(1) / divisor);
+}
+
+
+/**
+ * Linearly interpolates between two matrices, element-wise. This is built from the
+ * operators above, so it is also evaluated lazily.
+ */
+template<class A, class B>
+constexpr typename SSEnableIf<MatXExpressionTraits<A>::isExpression && MatXExpressionTraits<B>::isExpression,
+							  MatXSumExpression<MatXScaleExpression<A>, MatXScaleExpression<B>, false> >::type
+lerp(const A &a, typename MatXExpressionTraits<A>::ValueType t, const B &b)
+{
+	return (a * (typename MatXExpressionTraits<A>::ValueType(1) - t)) + (b * t);
+}
+
+
+/**
+ * Evaluates the given expression into the destination matrix in a single pass.
+ * Since every node is element-wise, the destination may also appear in the
+ * expression.
+ *
+ * @param out		The matrix to write the result to.
+ * @param expr		The expression to evaluate.
+ */
+template<class T, int rows, int columns, class E>
+inline typename SSEnableIf<MatXExpressionTraits<E>::isExpression, void>::type
+assign(MatX<T, rows, columns> &out, const E &expr)
+{
+	static_assert(rows == MatXExpressionTraits<E>::numRows && columns == MatXExpressionTraits<E>::numColumns,
+				  "The matrices must have the same dimensions");
+
+	for (int r=0; r < rows; ++r) {
+		for (int c=0; c < columns; ++c) {
+			out(r, c) = expr(r, c);
+		}
+	}
+}
+
+/**
+ * Evaluates the given expression into a new matrix.
+ *
+ * @param expr		The expression to evaluate.
+ *
+ * @return			The result.
+ */
+template<class E>
+inline typename SSEnableIf<MatXExpressionTraits<E>::isExpression,
+						   MatX<typename MatXExpressionTraits<E>::ValueType,
+								MatXExpressionTraits<E>::numRows,
+								MatXExpressionTraits<E>::numColumns> >::type
+evaluate(const E &expr)
+{
+	MatX<typename MatXExpressionTraits<E>::ValueType,
+		 MatXExpressionTraits<E>::numRows,
+		 MatXExpressionTraits<E>::numColumns> result;
+	assign(result, expr);
+
+	return result;
+}
+
+
+// ---------------------------------------------------------------------------------
+// Stream expressions
+// ---------------------------------------------------------------------------------
+
+/// The count of an expression made up only of constants; it matches any stream.
+static const unsigned int kStreamCountAny = UINT_MAX;
+
+/// The count of an expression whose streams do not all have the same count.
+static const unsigned int kStreamCountMismatch = UINT_MAX - 1;
+
+SS_FORCE_INLINE unsigned int combineStreamCounts(unsigned int a, unsigned int b)
+{
+	if (a == kStreamCountAny) {
+		return b;
+	}
+	if (b == kStreamCountAny || a == b) {
+		return a;
+	}
+
+	return kStreamCountMismatch;
+}
+
+
+/// The value of a stream expression when it is evaluated with packet type ``F``.
+/// Vector expressions produce a ``Vec3Packet``, scalar expressions a plain packet.
+template<class F, bool isVector>
+struct StreamValue
+{
+	typedef F type;
+};
+
+template<class F>
+struct StreamValue<F, true>
+{
+	typedef Vec3Packet<F> type;
+};
+
+
+// NOTE: (sonictk) Every node of a stream expression exposes the same interface:
+// ``isVector`` tells whether it produces vectors or scalars, ``count()`` returns the
+// number of elements it covers, and ``load<F>(i)`` evaluates the packet of
+// elements starting at ``i``.
+
+struct Vec3StreamOperand
+{
+	static const bool isVector = true;
+
+	const Vec3Stream &stream;
+
+	explicit Vec3StreamOperand(const Vec3Stream &stream) : stream(stream) {}
+
+	SS_FORCE_INLINE unsigned int count() const { return stream.count; }
+
+	template<class F>
+	SS_FORCE_INLINE Vec3Packet<F> load(unsigned int index) const {
+		return loadVec3Packet<F>(stream, index);
+	}
+};
+
+struct FloatStreamOperand
+{
+	static const bool isVector = false;
+
+	const FloatStream &stream;
+
+	explicit FloatStreamOperand(const FloatStream &stream) : stream(stream) {}
+
+	SS_FORCE_INLINE unsigned int count() const { return stream.count; }
+
+	template<class F>
+	SS_FORCE_INLINE F load(unsigned int index) const {
+		return F::load(stream.e + index);
+	}
+};
+
+struct Vec3ConstantOperand
+{
+	static const bool isVector = true;
+
+	Vec3 value;
+
+	explicit Vec3ConstantOperand(const Vec3 &value) : value(value) {}
+
+	SS_FORCE_INLINE unsigned int count() const { return kStreamCountAny; }
+
+	template<class F>
+	SS_FORCE_INLINE Vec3Packet<F> load(unsigned int) const {
+		return vec3Packet<F>(value);
+	}
+};
+
+struct FloatConstantOperand
+{
+	static const bool isVector = false;
+
+	float value;
+
+	explicit FloatConstantOperand(float value) : value(value) {}
+
+	SS_FORCE_INLINE unsigned int count() const { return kStreamCountAny; }
+
+	template<class F>
+	SS_FORCE_INLINE F load(unsigned int) const {
+		return F::broadcast(value);
+	}
+};
+
+
+/// Maps each type that can appear in a stream expression to the node that wraps
+/// it. ``isStream`` is ``false`` for constants, so that the operators below never
+/// take over expressions between plain ``Vec3`` and ``float`` values.
+template<class E>
+struct StreamOperand
+{
+	static const bool isOperand = false;
+	static const bool isStream = false;
+};
+
+template<>
+struct StreamOperand<Vec3Stream>
+{
+	static const bool isOperand = true;
+	static const bool isStream = true;
+	typedef Vec3StreamOperand Type;
+	static SS_FORCE_INLINE Type wrap(const Vec3Stream &s) { return Type(s); }
+};
+
+template<>
+struct StreamOperand<FloatStream>
+{
+	static const bool isOperand = true;
+	static const bool isStream = true;
+	typedef FloatStreamOperand Type;
+	static SS_FORCE_INLINE Type wrap(const FloatStream &s) { return Type(s); }
+};
+
+template<>
+struct StreamOperand<Vec3>
+{
+	static const bool isOperand = true;
+	static const bool isStream = false;
+	typedef Vec3ConstantOperand Type;
+	static SS_FORCE_INLINE Type wrap(const Vec3 &v) { return Type(v); }
+};
+
+template<>
+struct StreamOperand<float>
+{
+	static const bool isOperand = true;
+	static const bool isStream = false;
+	typedef FloatConstantOperand Type;
+	static SS_FORCE_INLINE Type wrap(float f) { return Type(f); }
+};
+
+/// The operand traits shared by all of the expression nodes below.
+template<class Node>
+struct StreamNodeOperand
+{
+	static const bool isOperand = true;
+	static const bool isStream = true;
+	typedef Node Type;
+	static SS_FORCE_INLINE const Type &wrap(const Node &n) { return n; }
+};
+
+
+/// Enables an operator when both operands can appear in a stream expression and
+/// at least one of them is a stream.
+template<class A, class B, class Result>
+struct StreamBinaryEnable
+	: SSEnableIf<StreamOperand<A>::isOperand && StreamOperand<B>::isOperand
+				 && (StreamOperand<A>::isStream || StreamOperand<B>::isStream), Result> {};
+
+
+enum StreamBinaryOp
+{
+	StreamBinaryOp_Add,
+	StreamBinaryOp_Subtract,
+	StreamBinaryOp_Multiply,
+	StreamBinaryOp_Divide,
+	StreamBinaryOp_InnerProduct,
+	StreamBinaryOp_CrossProduct
+};
+
+template<StreamBinaryOp op>
+struct StreamBinaryOpImpl;
+
+template<>
+struct StreamBinaryOpImpl<StreamBinaryOp_Add>
+{
+	template<bool aIsVector, bool bIsVector>
+	struct Result
+	{
+		static_assert(aIsVector == bIsVector, "Cannot add a vector and a scalar");
+		static const bool isVector = aIsVector;
+	};
+
+	template<class X, class Y>
+	static SS_FORCE_INLINE X apply(const X &a, const Y &b) { return a + b; }
+};
+
+template<>
+struct StreamBinaryOpImpl<StreamBinaryOp_Subtract>
+{
+	template<bool aIsVector, bool bIsVector>
+	struct Result
+	{
+		static_assert(aIsVector == bIsVector, "Cannot subtract a vector and a scalar");
+		static const bool isVector = aIsVector;
+	};
+
+	template<class X, class Y>
+	static SS_FORCE_INLINE X apply(const X &a, const Y &b) { return a - b; }
+};
+
+template<>
+struct StreamBinaryOpImpl<StreamBinaryOp_Multiply>
+{
+	template<bool aIsVector, bool bIsVector>
+	struct Result
+	{
+		static_assert(!(aIsVector && bIsVector),
+					  "Vectors can only be multiplied by scalars; use innerProduct or crossProduct");
+		static const bool isVector = aIsVector || bIsVector;
+	};
+
+	template<class F>
+	static SS_FORCE_INLINE F apply(const F &a, const F &b) { return a * b; }
+
+	template<class F>
+	static SS_FORCE_INLINE Vec3Packet<F> apply(const Vec3Packet<F> &a, const F &b) { return a * b; }
+
+	template<class F>
+	static SS_FORCE_INLINE Vec3Packet<F> apply(const F &a, const Vec3Packet<F> &b) { return a * b; }
+};
+
+template<>
+struct StreamBinaryOpImpl<StreamBinaryOp_Divide>
+{
+	template<bool aIsVector, bool bIsVector>
+	struct Result
+	{
+		static_assert(!bIsVector, "Cannot divide by a vector");
+		static const bool isVector = aIsVector;
+	};
+
+	template<class F>
+	static SS_FORCE_INLINE F apply(const F &a, const F &b) { return a / b; }
+
+	template<class F>
+	static SS_FORCE_INLINE Vec3Packet<F> apply(const Vec3Packet<F> &a, const F &b) {
+		return a * (F::broadcast(1.0f) / b);
+	}
+};
+
+template<>
+struct StreamBinaryOpImpl<StreamBinaryOp_InnerProduct>
+{
+	template<bool aIsVector, bool bIsVector>
+	struct Result
+	{
+		static_assert(aIsVector && bIsVector, "The inner product is only defined for vectors");
+		static const bool isVector = false;
+	};
+
+	template<class F>
+	static SS_FORCE_INLINE F apply(const Vec3Packet<F> &a, const Vec3Packet<F> &b) { return innerProduct(a, b); }
+};
+
+template<>
+struct StreamBinaryOpImpl<StreamBinaryOp_CrossProduct>
+{
+	template<bool aIsVector, bool bIsVector>
+	struct Result
+	{
+		static_assert(aIsVector && bIsVector, "The cross product is only defined for vectors");
+		static const bool isVector = true;
+	};
+
+	template<class F>
+	static SS_FORCE_INLINE Vec3Packet<F> apply(const Vec3Packet<F> &a, const Vec3Packet<F> &b) {
+		return crossProduct(a, b);
+	}
+};
+
+
+template<StreamBinaryOp op, class A, class B>
+struct StreamBinaryExpression
+{
+	typedef typename StreamOperand<A>::Type OperandA;
+	typedef typename StreamOperand<B>::Type OperandB;
+	static const bool isVector = StreamBinaryOpImpl<op>::template Result<OperandA::isVector, OperandB::isVector>::isVector;
+
+	OperandA a;
+	OperandB b;
+
+	StreamBinaryExpression(const A &a, const B &b) : a(StreamOperand<A>::wrap(a)), b(StreamOperand<B>::wrap(b)) {}
+
+	SS_FORCE_INLINE unsigned int count() const { return combineStreamCounts(a.count(), b.count()); }
+
+	template<class F>
+	SS_FORCE_INLINE typename StreamValue<F, isVector>::type load(unsigned int index) const {
+		return StreamBinaryOpImpl<op>::apply(a.template load<F>(index), b.template load<F>(index));
+	}
+};
+
+template<StreamBinaryOp op, class A, class B>
+struct StreamOperand<StreamBinaryExpression<op, A, B> > : StreamNodeOperand<StreamBinaryExpression<op, A, B> > {};
+
+
+enum StreamUnaryOp
+{
+	StreamUnaryOp_Negate,
+	StreamUnaryOp_Length,
+	StreamUnaryOp_Normalize
+};
+
+template<StreamUnaryOp op>
+struct StreamUnaryOpImpl;
+
+template<>
+struct StreamUnaryOpImpl<StreamUnaryOp_Negate>
+{
+	template<bool aIsVector>
+	struct Result
+	{
+		static const bool isVector = aIsVector;
+	};
+
+	template<class X>
+	static SS_FORCE_INLINE X apply(const X &a) { return -a; }
+};
+
+template<>
+struct StreamUnaryOpImpl<StreamUnaryOp_Length>
+{
+	template<bool aIsVector>
+	struct Result
+	{
+		static_assert(aIsVector, "The length is only defined for vectors");
+		static const bool isVector = false;
+	};
+
+	template<class F>
+	static SS_FORCE_INLINE F apply(const Vec3Packet<F> &a) { return length(a); }
+};
+
+template<>
+struct StreamUnaryOpImpl<StreamUnaryOp_Normalize>
+{
+	template<bool aIsVector>
+	struct Result
+	{
+		static_assert(aIsVector, "Only vectors can be normalized");
+		static const bool isVector = true;
+	};
+
+	template<class F>
+	static SS_FORCE_INLINE Vec3Packet<F> apply(const Vec3Packet<F> &a) { return normalize(a); }
+};
+
+
+template<StreamUnaryOp op, class A>
+struct StreamUnaryExpression
+{
+	typedef typename StreamOperand<A>::Type OperandA;
+	static const bool isVector = StreamUnaryOpImpl<op>::template Result<OperandA::isVector>::isVector;
+
+	OperandA a;
+
+	explicit StreamUnaryExpression(const A &a) : a(StreamOperand<A>::wrap(a)) {}
+
+	SS_FORCE_INLINE unsigned int count() const { return a.count(); }
+
+	template<class F>
+	SS_FORCE_INLINE typename StreamValue<F, isVector>::type load(unsigned int index) const {
+		return StreamUnaryOpImpl<op>::apply(a.template load<F>(index));
+	}
+};
+
+template<StreamUnaryOp op, class A>
+struct StreamOperand<StreamUnaryExpression<op, A> > : StreamNodeOperand<StreamUnaryExpression<op, A> > {};
+
+
+template<class A, class B>
+inline typename StreamBinaryEnable<A, B, StreamBinaryExpression<StreamBinaryOp_Add, A, B> >::type
+operator+(const A &a, const B &b)
+{
+	return StreamBinaryExpression<StreamBinaryOp_Add, A, B>(a, b);
+}
+
+template<class A, class B>
+inline typename StreamBinaryEnable<A, B, StreamBinaryExpression<StreamBinaryOp_Subtract, A, B> >::type
+operator-(const A &a, const B &b)
+{
+	return StreamBinaryExpression<StreamBinaryOp_Subtract, A, B>(a, b);
+}
+
+template<class A, class B>
+inline typename StreamBinaryEnable<A, B, StreamBinaryExpression<StreamBinaryOp_Multiply, A, B> >::type
+operator*(const A &a, const B &b)
+{
+	return StreamBinaryExpression<StreamBinaryOp_Multiply, A, B>(a, b);
+}
+
+template<class A, class B>
+inline typename StreamBinaryEnable<A, B, StreamBinaryExpression<StreamBinaryOp_Divide, A, B> >::type
+operator/(const A &a, const B &b)
+{
+	return StreamBinaryExpression<StreamBinaryOp_Divide, A, B>(a, b);
+}
+
+template<class A, class B>
+inline typename StreamBinaryEnable<A, B, StreamBinaryExpression<StreamBinaryOp_InnerProduct, A, B> >::type
+innerProduct(const A &a, const B &b)
+{
+	return StreamBinaryExpression<StreamBinaryOp_InnerProduct, A, B>(a, b);
+}
+
+template<class A, class B>
+inline typename StreamBinaryEnable<A, B, StreamBinaryExpression<StreamBinaryOp_CrossProduct, A, B> >::type
+crossProduct(const A &a, const B &b)
+{
+	return StreamBinaryExpression<StreamBinaryOp_CrossProduct, A, B>(a, b);
+}
+
+template<class A>
+inline typename SSEnableIf<StreamOperand<A>::isStream, StreamUnaryExpression<StreamUnaryOp_Negate, A> >::type
+operator-(const A &a)
+{
+	return StreamUnaryExpression<StreamUnaryOp_Negate, A>(a);
+}
+
+template<class A>
+inline typename SSEnableIf<StreamOperand<A>::isStream, StreamUnaryExpression<StreamUnaryOp_Length, A> >::type
+length(const A &a)
+{
+	return StreamUnaryExpression<StreamUnaryOp_Length, A>(a);
+}
+
+template<class A>
+inline typename SSEnableIf<StreamOperand<A>::isStream, StreamUnaryExpression<StreamUnaryOp_Normalize, A> >::type
+normalize(const A &a)
+{
+	return StreamUnaryExpression<StreamUnaryOp_Normalize, A>(a);
+}
+
+
+/**
+ * Linearly interpolates between two vector expressions, where ``t`` may either be
+ * a constant or a scalar expression (e.g. per-vector weights in a ``FloatStream``).
+ * This uses the same formulation as the ``Vec3`` version so that results match.
+ */
+template<class A, class T, class B>
+inline typename SSEnableIf<StreamOperand<A>::isOperand && StreamOperand<T>::isOperand && StreamOperand<B>::isOperand,
+						   StreamBinaryExpression<StreamBinaryOp_Add,
+												  StreamBinaryExpression<StreamBinaryOp_Multiply,
+																		 StreamBinaryExpression<StreamBinaryOp_Subtract, float, T>,
+																		 A>,
+												  StreamBinaryExpression<StreamBinaryOp_Multiply, T, B> > >::type
+lerp(const A &a, const T &t, const B &b)
+{
+	typedef StreamBinaryExpression<StreamBinaryOp_Subtract, float, T> OneMinusT;
+	typedef StreamBinaryExpression<StreamBinaryOp_Multiply, OneMinusT, A> WeightedA;
+	typedef StreamBinaryExpression<StreamBinaryOp_Multiply, T, B> WeightedB;
+
+	return StreamBinaryExpression<StreamBinaryOp_Add, WeightedA, WeightedB>(WeightedA(OneMinusT(1.0f, t), a),
+																			 WeightedB(t, b));
+}
+
+
+// NOTE: (sonictk) Since streams are padded, the whole expression is evaluated over
+// complete packets without a scalar tail, the same as the kernels in ``vector_stream.h``.
+template<class F, class E>
+SS_FORCE_INLINE void assignStreamKernel(Vec3Stream &out, const E &expr, unsigned int count)
+{
+	for (unsigned int i=0; i < count; i += F::width) {
+		storeVec3Packet(out, i, expr.template load<F>(i));
+	}
+}
+
+template<class F, class E>
+SS_FORCE_INLINE void assignStreamKernel(FloatStream &out, const E &expr, unsigned int count)
+{
+	for (unsigned int i=0; i < count; i += F::width) {
+		expr.template load<F>(i).store(out.e + i);
+	}
+}
+
+
+/**
+ * Evaluates the given expression into the destination stream in a single pass
+ * over the elements. The destination may also appear in the expression, since
+ * every operation only reads the elements at the index being written. Its count
+ * will be set to the count of the streams in the expression.
+ *
+ * @param out		The stream to write the result to. This must have been allocated
+ * 				with at least as much capacity as the streams in the expression.
+ * @param expr		The expression to evaluate. This must produce vectors.
+ *
+ * @return			``0`` on success, a negative value if the streams of the
+ * 				expression have different counts or the destination is too small.
+ */
+template<class E>
+inline typename SSEnableIf<StreamOperand<E>::isStream, int>::type assign(Vec3Stream &out, const E &expr)
+{
+	typedef typename StreamOperand<E>::Type Node;
+	static_assert(Node::isVector, "Cannot assign a scalar expression to a Vec3Stream");
+
+	const Node &node = StreamOperand<E>::wrap(expr);
+	unsigned int count = node.count();
+	if (count == kStreamCountMismatch || out.capacity < count) {
+		return -1;
+	}
+	out.count = count;
+	assignStreamKernel<SIMDFloat>(out, node, count);
+
+	return 0;
+}
+
+/**
+ * Evaluates the given scalar expression into the destination stream. See the
+ * ``Vec3Stream`` version for details.
+ */
+template<class E>
+inline typename SSEnableIf<StreamOperand<E>::isStream, int>::type assign(FloatStream &out, const E &expr)
+{
+	typedef typename StreamOperand<E>::Type Node;
+	static_assert(!Node::isVector, "Cannot assign a vector expression to a FloatStream");
+
+	const Node &node = StreamOperand<E>::wrap(expr);
+	unsigned int count = node.count();
+	if (count == kStreamCountMismatch || out.capacity < count) {
+		return -1;
+	}
+	out.count = count;
+	assignStreamKernel<SIMDFloat>(out, node, count);
+
+	return 0;
+}
+
+
+#endif /* EXPRESSION_MATH_H */
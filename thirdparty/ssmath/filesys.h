@@ -85,6 +85,28 @@ inline dlong unixSecondsToWin32Ticks(timet seconds)
 inline int renameFile(const char *oldPath, const char *newPath);
 
 
+/**
+ * This function will copy the file at ``oldPath`` to ``newPath``.
+ * **This will overwrite the file specified in the new location!**
+ *
+ * @param oldPath 		The path to the file to copy.
+ * @param newPath 		The path that the copy will have.
+ *
+ * @return			``0`` on success, a negative value on failure.
+ */
+inline int copyFile(const char *oldPath, const char *newPath);
+
+
+/**
+ * This function will delete the file at the given ``path``.
+ *
+ * @param path 		The path to the file to delete.
+ *
+ * @return			``0`` on success, a negative value on failure.
+ */
+inline int deleteFile(const char *path);
+
+
 #ifdef _WIN32
 #include <Shlwapi.h>
 #include <strsafe.h>
@@ -182,6 +204,30 @@ inline int renameFile(const char *oldPath, const char *newPath)
 }
 
 
+inline int copyFile(const char *oldPath, const char *newPath)
+{
+	BOOL result = CopyFile((LPCTSTR)oldPath, (LPCTSTR)newPath, FALSE);
+	if (result == 0) {
+		OSPrintLastError();
+		return -1;
+	}
+
+	return 0;
+}
+
+
+inline int deleteFile(const char *path)
+{
+	BOOL result = DeleteFile((LPCTSTR)path);
+	if (result == 0) {
+		OSPrintLastError();
+		return -1;
+	}
+
+	return 0;
+}
+
+
 #elif __linux__ || __APPLE__
 #include <unistd.h>
 #include <limits.h>
@@ -268,6 +314,59 @@ inline int renameFile(const char *oldPath, const char *newPath)
 }
 
 
+inline int copyFile(const char *oldPath, const char *newPath)
+{
+	int src = open(oldPath, O_RDONLY);
+	if (src == -1) {
+		OSPrintLastError();
+		return -1;
+	}
+	struct stat attrib = {};
+	int dst = fstat(src, &attrib) == 0 ? open(newPath, O_WRONLY|O_CREAT|O_TRUNC, attrib.st_mode & 0777) : -1;
+	if (dst == -1) {
+		OSPrintLastError();
+		close(src);
+		return -1;
+	}
+
+	int result = 0;
+	char buffer[65536];
+	ssize_t numRead = 0;
+	while (result == 0 && (numRead = read(src, buffer, sizeof(buffer))) > 0) {
+		for (ssize_t written=0; written < numRead;) {
+			ssize_t numWritten = write(dst, buffer + written, (size_t)(numRead - written));
+			if (numWritten <= 0) {
+				result = -1;
+				break;
+			}
+			written += numWritten;
+		}
+	}
+	if (numRead < 0 || result != 0) {
+		OSPrintLastError();
+		result = -1;
+	}
+	close(src);
+	if (close(dst) != 0) {
+		result = -1;
+	}
+
+	return result;
+}
+
+
+inline int deleteFile(const char *path)
+{
+	int result = unlink(path);
+	if (result != 0) {
+		OSPrintLastError();
+		return -1;
+	}
+
+	return 0;
+}
+
+
 #endif // Platform layer
 
 
@@ -0,0 +1,246 @@
+/**
+ * @brief  	Half-precision (IEEE 754 binary16) storage for streams, for caches that
+ * 			can afford to lose precision in exchange for half the memory. Values
+ * 			are always converted back to ``FloatStream``s/``Vec3Stream``s to be
+ * 			worked on; there is no half-precision arithmetic.
+ *
+ * 			Half floats have an 11-bit significand, so the relative rounding error
+ * 			is at most ``2^-11`` (about 0.05%), and the largest finite value is
+ * 			``65504``. Values below ``2^-14`` lose precision gradually (denormals)
+ * 			down to ``2^-24``. As a rule of thumb, positions within 1000 units of
+ * 			the origin are stored to within 0.25 units, so rest positions usually
+ * 			need to be stored relative to something nearby (e.g. as deltas).
+ *
+ * 			The conversions (``encodeHalfStream``/``decodeHalfStream`` in
+ * 			``simd_kernels.h``) use the F16C instructions when the CPU has them, and
+ * 			an exact software conversion otherwise. Both round to nearest even
+ * 			and give identical results.
+ */
+#ifndef HALF_STREAM_H
+#define HALF_STREAM_H
+
+#include "vector_stream.h"
+#include <stdint.h>
+#include <string.h>
+
+
+#if defined(SS_SIMD_TARGET_ATTRIBUTES)
+#define SS_HAS_F16C_TARGET 1
+#define SS_TARGET_F16C __attribute__((target("avx,f16c")))
+#elif defined(SS_SIMD_ANY_TARGET) || (INSTRSET >= 8 && defined(__F16C__))
+#define SS_HAS_F16C_TARGET 1
+#define SS_TARGET_F16C
+#endif // SS_SIMD_TARGET_ATTRIBUTES
+
+
+/// A stream of half-precision scalars, with the same alignment and padding as
+/// ``FloatStream``.
+struct HalfStream
+{
+	uint16_t *e;
+
+	unsigned int count;
+	unsigned int capacity;
+};
+
+/// A stream of half-precision 3D vectors, stored as structure-of-arrays like
+/// ``Vec3Stream``.
+struct HalfVec3Stream
+{
+	uint16_t *x;
+	uint16_t *y;
+	uint16_t *z;
+
+	unsigned int count;
+	unsigned int capacity;
+};
+
+
+/**
+ * Converts a float to a half, rounding to nearest even. Values too large for a half
+ * become infinity, and NaNs stay NaNs. This gives the same results as ``vcvtps2ph``.
+ */
+inline uint16_t floatToHalf(float f)
+{
+	uint32_t x;
+	memcpy(&x, &f, sizeof(x));
+
+	uint32_t sign = (x >> 16) & 0x8000;
+	uint32_t absolute = x & 0x7fffffff;
+
+	if (absolute >= 0x7f800000) {
+		// NOTE: (sonictk) NaNs are quietened, keeping the top bits of the payload.
+		return (uint16_t)(sign | (absolute > 0x7f800000 ? 0x7e00 | ((absolute >> 13) & 0x3ff) : 0x7c00));
+	}
+
+	// NOTE: (sonictk) Anything from halfway between the largest half (65504) and the
+	// next power of two upwards rounds to infinity.
+	if (absolute >= 0x477ff000) {
+		return (uint16_t)(sign | 0x7c00);
+	}
+
+	if (absolute < 0x38800000) {
+		// NOTE: (sonictk) The result is a denormal. Adding 0.5 lines the half's
+		// significand up with the bottom of the float's, so that the FPU does the
+		// rounding, and the bits can then be read off directly.
+		float magnitude;
+		memcpy(&magnitude, &absolute, sizeof(magnitude));
+		magnitude += 0.5f;
+
+		uint32_t bits;
+		memcpy(&bits, &magnitude, sizeof(bits));
+
+		return (uint16_t)(sign | (bits - 0x3f000000));
+	}
+
+	// NOTE: (sonictk) Rebias the exponent, and round to nearest even by adding just
+	// under half of the dropped bits, plus one more if the result would be odd.
+	uint32_t isOdd = (absolute >> 13) & 1;
+	absolute += 0xc8000fff + isOdd;
+
+	return (uint16_t)(sign | (absolute >> 13));
+}
+
+/// Converts a half to a float. This is exact, and gives the same results as
+/// ``vcvtph2ps``.
+inline float halfToFloat(uint16_t h)
+{
+	uint32_t sign = (uint32_t)(h & 0x8000) << 16;
+	uint32_t exponent = (h >> 10) & 0x1f;
+	uint32_t mantissa = h & 0x3ff;
+
+	uint32_t bits;
+	if (exponent == 0) {
+		// NOTE: (sonictk) Zero or a denormal, both of which are exact as floats.
+		float magnitude = (float)mantissa * (1.0f / 16777216.0f);
+		memcpy(&bits, &magnitude, sizeof(bits));
+		bits |= sign;
+	} else if (exponent == 0x1f) {
+		bits = sign | 0x7f800000 | (mantissa << 13) | (mantissa ? 0x400000 : 0);
+	} else {
+		bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+	}
+
+	float f;
+	memcpy(&f, &bits, sizeof(f));
+
+	return f;
+}
+
+
+/**
+ * Allocates storage for at least ``count`` halves and sets the stream's count. See
+ * ``allocateFloatStream`` for details.
+ *
+ * @param stream	The stream to allocate.
+ * @param count	The number of halves the stream should hold.
+ *
+ * @return			``0`` on success, a negative value if the allocation failed.
+ */
+inline int allocateHalfStream(HalfStream &stream, unsigned int count)
+{
+	if (stream.e && stream.capacity >= count) {
+		stream.count = count;
+		return 0;
+	}
+
+	freeAligned(stream.e);
+
+	unsigned int capacity = padSIMDCount(count > 0 ? count : 1);
+	stream.e = (uint16_t *)allocateAligned(sizeof(uint16_t) * capacity);
+	if (!stream.e) {
+		stream.count = stream.capacity = 0;
+		return -1;
+	}
+	stream.count = count;
+	stream.capacity = capacity;
+
+	return 0;
+}
+
+inline void freeHalfStream(HalfStream &stream)
+{
+	freeAligned(stream.e);
+	stream.e = NULL;
+	stream.count = stream.capacity = 0;
+}
+
+/**
+ * Allocates storage for at least ``count`` vectors and sets the stream's count. See
+ * ``allocateVec3Stream`` for details.
+ *
+ * @param stream	The stream to allocate.
+ * @param count	The number of vectors the stream should hold.
+ *
+ * @return			``0`` on success, a negative value if the allocation failed.
+ */
+inline int allocateHalfVec3Stream(HalfVec3Stream &stream, unsigned int count)
+{
+	if (stream.x && stream.capacity >= count) {
+		stream.count = count;
+		return 0;
+	}
+
+	freeAligned(stream.x);
+
+	unsigned int capacity = padSIMDCount(count > 0 ? count : 1);
+	uint16_t *storage = (uint16_t *)allocateAligned(sizeof(uint16_t) * capacity * 3);
+	if (!storage) {
+		stream.x = stream.y = stream.z = NULL;
+		stream.count = stream.capacity = 0;
+		return -1;
+	}
+
+	stream.x = storage;
+	stream.y = storage + capacity;
+	stream.z = storage + (capacity * 2);
+	stream.count = count;
+	stream.capacity = capacity;
+
+	return 0;
+}
+
+inline void freeHalfVec3Stream(HalfVec3Stream &stream)
+{
+	freeAligned(stream.x);
+	stream.x = stream.y = stream.z = NULL;
+	stream.count = stream.capacity = 0;
+}
+
+
+// NOTE: (sonictk) The converters work on whole padded blocks of ``kSIMDPadding``
+// elements, the same as the stream kernels.
+inline void encodeHalvesScalar(const float *in, uint16_t *out, unsigned int count)
+{
+	for (unsigned int i=0; i < count; ++i) {
+		out[i] = floatToHalf(in[i]);
+	}
+}
+
+inline void decodeHalvesScalar(const uint16_t *in, float *out, unsigned int count)
+{
+	for (unsigned int i=0; i < count; ++i) {
+		out[i] = halfToFloat(in[i]);
+	}
+}
+
+#ifdef SS_HAS_F16C_TARGET
+SS_TARGET_F16C inline void encodeHalvesF16C(const float *in, uint16_t *out, unsigned int count)
+{
+	for (unsigned int i=0; i < count; i += 8) {
+		__m128i halves = _mm256_cvtps_ph(_mm256_load_ps(in + i), _MM_FROUND_TO_NEAREST_INT);
+		_mm_storeu_si128((__m128i *)(out + i), halves);
+	}
+}
+
+SS_TARGET_F16C inline void decodeHalvesF16C(const uint16_t *in, float *out, unsigned int count)
+{
+	for (unsigned int i=0; i < count; i += 8) {
+		__m128i halves = _mm_loadu_si128((const __m128i *)(in + i));
+		_mm256_store_ps(out + i, _mm256_cvtph_ps(halves));
+	}
+}
+#endif // SS_HAS_F16C_TARGET
+
+
+#endif /* HALF_STREAM_H */
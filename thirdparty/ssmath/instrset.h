@@ -157,6 +157,7 @@ bool hasFMA3(void);								 // true if FMA3 instructions supported
 bool hasFMA4(void);								 // true if FMA4 instructions supported
 bool hasXOP(void);								 // true if XOP	 instructions supported
 bool hasAVX512ER(void);							 // true if AVX512ER instructions supported
+bool hasF16C(void);								 // true if F16C instructions supported
 
 // GCC version
 #if defined(__GNUC__) && !defined (GCC_VERSION) && !defined (__clang__)
@@ -45,6 +45,14 @@ inline FuncPtr loadSymbolFromLibrary(DLLHandle handle, const char *symbol)
 }
 
 
+/// Same as ``loadSymbolFromLibrary``, but does not report an error if the symbol
+/// is missing. Use this for symbols that a library is not required to export.
+inline FuncPtr findSymbolInLibrary(DLLHandle handle, const char *symbol)
+{
+	return GetProcAddress(handle, (LPCSTR)symbol);
+}
+
+
 #elif __linux__ || __APPLE__
 #include <dlfcn.h>
 
@@ -110,6 +118,20 @@ inline FuncPtr loadSymbolFromLibrary(DLLHandle handle, const char *symbol)
 	return symbolAddr;
 }
 
+
+/// Same as ``loadSymbolFromLibrary``, but does not report an error if the symbol
+/// is missing. Use this for symbols that a library is not required to export.
+inline FuncPtr findSymbolInLibrary(DLLHandle handle, const char *symbol)
+{
+	if (!handle) {
+		return NULL;
+	}
+	void *symbolAddr = dlsym(handle, symbol);
+	dlerror();
+
+	return symbolAddr;
+}
+
 #endif // Exports platform layer
 
 
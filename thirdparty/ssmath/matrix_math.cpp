@@ -1,11 +1,7 @@
 #include "matrix_math.h"
 #include "common_math.h"
-#include <cstdlib>
 #include <math.h>
 
-using std::malloc;
-using std::free;
-
 
 Mat44 rotateBy(const Mat44 &mat, Vec3 axis, float angle)
 {
@@ -45,54 +41,64 @@ Mat44 rotateBy(const Mat44 &mat, Quat rotation)
 	return rotateBy(mat, vec3(rotation.x, rotation.y, rotation.z), rotation.w);
 }
 
+template<RotationOrder order>
+static inline Mat44 eulerRotationMatrix(float cx, float sx, float cy, float sy, float cz, float sz)
+{
+	float m[3][3];
+	EulerRotationBuilder<order>::build(cx, sx, cy, sy, cz, sz, m);
+
+	Mat44 rotMat;
+	for (int i=0; i < 3; ++i) {
+		for (int j=0; j < 3; ++j) {
+			rotMat[i][j] = m[i][j];
+		}
+	}
+
+	rotMat[0][3] = rotMat[1][3] = rotMat[2][3] = rotMat[3][0] = rotMat[3][1] = rotMat[3][2] = 0;
+	rotMat[3][3] = 1.0f;
+
+	return rotMat;
+}
+
+
 Mat44 rotateBy(const Mat44 &mat, EulerRotation rotation, RotationOrder order)
 {
 	// NOTE: (sonictk) Implementation from:
 	// http://www.opengl-tutorial.org/assets/faq_quaternions/index.html#Q36
-	Mat44 rotMat;
-
+	// The product of the three axis rotations is expanded for every order in
+	// ``EulerRotationBuilder``, so the sines and cosines are only computed once.
 	float x = rotation.x * PI / 180.0f;
-	float y = rotation.y * PI / 180.0f;;
-	float z = rotation.z * PI / 180.0f;;
+	float y = rotation.y * PI / 180.0f;
+	float z = rotation.z * PI / 180.0f;
 
-	// TODO: (sonictk) Finish the other rotation order implementations
-	// NOTE: (sonictk) Basically, the rotation matrix is generated from ``X.Y.Z`` and
-	// then simplified to get the optimized version seen below.
+	float cx = cosf(x);
+	float sx = sinf(x);
+	float cy = cosf(y);
+	float sy = sinf(y);
+	float cz = cosf(z);
+	float sz = sinf(z);
+
+	Mat44 rotMat;
 	switch(order) {
 	case RotationOrder::kXZY:
+		rotMat = eulerRotationMatrix<kXZY>(cx, sx, cy, sy, cz, sz);
 		break;
 	case RotationOrder::kYXZ:
+		rotMat = eulerRotationMatrix<kYXZ>(cx, sx, cy, sy, cz, sz);
 		break;
 	case RotationOrder::kYZX:
+		rotMat = eulerRotationMatrix<kYZX>(cx, sx, cy, sy, cz, sz);
 		break;
 	case RotationOrder::kZXY:
+		rotMat = eulerRotationMatrix<kZXY>(cx, sx, cy, sy, cz, sz);
 		break;
 	case RotationOrder::kZYX:
+		rotMat = eulerRotationMatrix<kZYX>(cx, sx, cy, sy, cz, sz);
 		break;
 	case RotationOrder::kXYZ:
 	default:
-		float a = cosf(x);
-		float b = sinf(x);
-		float c = cosf(y);
-		float d = sinf(y);
-		float e = cosf(z);
-		float f = sinf(z);
-
-		float ad = a * d;
-		float bd = b * d;
-
-		rotMat[0][0] = c * e;
-		rotMat[0][1] = -c * f;
-		rotMat[0][2] = d;
-		rotMat[1][0] = (bd * e) + (a * f);
-		rotMat[1][1] = (-bd * f) + (a * e);
-		rotMat[1][2] = -b * c;
-		rotMat[2][0] = (-ad * e) + (b * f);
-		rotMat[2][1] = (ad * f) + (b * e);
-		rotMat[2][2] = a * c;
-
-		rotMat[0][3] = rotMat[1][3] = rotMat[2][3] = rotMat[3][0] = rotMat[3][1] = rotMat[3][2] = 0;
-		rotMat[3][3] = 1.0f;
+		rotMat = eulerRotationMatrix<kXYZ>(cx, sx, cy, sy, cz, sz);
+		break;
 	}
 
 	return mat * rotMat;
@@ -106,105 +112,135 @@ Mat44 rotateBy(const Mat44 &mat, EulerRotation rotation)
 
 float determinant(const Mat44 &mat)
 {
-	/* NOTE: (sonictk) After expansion, the formula for a determinant of a 4x4
-	   matrix is:
+	/* NOTE: (sonictk) Laplace expansion using the 2x2 minors of the bottom two
+	   rows, so that each of them is only computed once:
 	   ```
-	   + a.[f.(k.p - l.o) - g.(j.p - l.n) + h.(j.o - k.n)]
-	   - b.[e.(k.p - l.o) - g.(i.p - l.m) + h.(i.o - k.m)]
-	   + c.[e.(j.p - l.n) - f.(i.p - l.m) + h.(i.n - j.m)]
-	   - d.[e.(j.o - k.n) - f.(i.o - k.m) + g.(i.n - j.m)]
+	   + a.(f.s5 - g.s4 + h.s3)
+	   - b.(e.s5 - g.s2 + h.s1)
+	   + c.(e.s4 - f.s2 + h.s0)
+	   - d.(e.s3 - f.s1 + g.s0)
 	   ```
 	   where the 4x4 matrix is composed as such:
 	       0 1 2 3
 	   0  |a b c d|
 	   1  |e f g h|
-	   2  |i k j l|
+	   2  |i j k l|
 	   3  |m n o p|
 	*/
-	// TODO: (sonictk) Check if this is correct
+	float s0 = mat(2,0) * mat(3,1) - mat(2,1) * mat(3,0);
+	float s1 = mat(2,0) * mat(3,2) - mat(2,2) * mat(3,0);
+	float s2 = mat(2,0) * mat(3,3) - mat(2,3) * mat(3,0);
+	float s3 = mat(2,1) * mat(3,2) - mat(2,2) * mat(3,1);
+	float s4 = mat(2,1) * mat(3,3) - mat(2,3) * mat(3,1);
+	float s5 = mat(2,2) * mat(3,3) - mat(2,3) * mat(3,2);
+
 	return
-		+ (mat(0,0) * ((mat(1,1) * ((mat(2,1) * mat(3,3)) - (mat(2,3) * mat(3,2))))
-					   - (mat(1,2) * (mat(2,2) * mat(3,3) - mat(2,3) * mat(3,1)))
-					   + (mat(1,3) * (mat(2,2) * mat(3,2) - mat(2,1) * mat(3,1)))))
-		- (mat(0,1) * ((mat(1,0) * ((mat(2,1) * mat(3,3)) - (mat(2,3) * mat(3,2))))
-					   - (mat(1,2) * (mat(2,0) * mat(3,3) - mat(2,3) * mat(3,0)))
-					   + (mat(1,3) * (mat(2,0) * mat(3,2) - mat(2,1) * mat(3,0)))))
-		+ (mat(0,2) * ((mat(1,0) * ((mat(2,2) * mat(3,3)) - (mat(2,3) * mat(3,1))))
-					   - (mat(1,1) * (mat(2,0) * mat(3,3) - mat(2,3) * mat(3,0)))
-					   + (mat(1,3) * (mat(2,0) * mat(3,1) - mat(2,2) * mat(3,0)))))
-		- (mat(0,3) * ((mat(1,0) * ((mat(2,2) * mat(3,2)) - (mat(2,1) * mat(3,1))))
-					   - (mat(1,1) * (mat(2,0) * mat(3,2) - mat(2,1) * mat(3,0)))
-					   + (mat(1,2) * (mat(2,0) * mat(3,1) - mat(2,2) * mat(3,0)))));
+		+ mat(0,0) * (mat(1,1) * s5 - mat(1,2) * s4 + mat(1,3) * s3)
+		- mat(0,1) * (mat(1,0) * s5 - mat(1,2) * s2 + mat(1,3) * s1)
+		+ mat(0,2) * (mat(1,0) * s4 - mat(1,1) * s2 + mat(1,3) * s0)
+		- mat(0,3) * (mat(1,0) * s3 - mat(1,1) * s1 + mat(1,2) * s0);
 }
 
 
-// * Referenced from **Paul Bourke's** implementation available at:
-// * ``http://paulbourke.net/miscellaneous/determinant/determinant.c``
-// TODO: (sonictk) clean this up and understand it and possibly optimize it
-float determinant(float **mat, unsigned int dimension)
+float determinant(float **mat, int dimension, float *scratch)
 {
-	unsigned int i, j, j1, j2 ;				// general loop and matrix subscripts
-	float det = 0;
-	float **m = NULL ;				// pointer to pointers to implement 2d square array
-
-	switch (dimension) {
-	case 0:
+	if (dimension <= 0) {
 		return 0;
-		break;
-	case 1:
-		return mat[0][0];
-		break;
-	case 2:	// the recursion series
-		det = mat[0][0] * mat[1][1] - mat[1][0] * mat[0][1];
-		break;
-	default:
-		// for each column in sub-matrix
-		for (j1 = 0 ; j1 < dimension ; j1++) {
-			// get space for the pointer list
-			m = (float **)malloc((dimension - 1) * sizeof(float *));
-			for (i = 0 ; i < dimension-1 ; i++)
-				m[i] = (float *)malloc((dimension - 1) * sizeof(float));
-			//	  i[0][1][2][3]	 first malloc
-			//  m -> +  +  +	 +	 space for 4 pointers
-			//		|  |  |	 |			j  second malloc
-			//		|  |  |	 +-> _ _ _ [0] pointers to
-			//		|  |  +----> _ _ _ [1] and memory for
-			//		|  +-------> _ a _ [2] 4 floats
-			//		+----------> _ _ _ [3]
-			//
-			//					a[1][2]
-			// build sub-matrix with minor elements excluded
-			for (i=1; i < dimension; ++i) {
-				j2 = 0;			   // start at first sum-matrix column position
-									   // loop to copy source matrix less one column
-				for (j=0; j < dimension; ++j) {
-					if (j == j1) continue; // don't copy the minor column element
-
-					m[i - 1][j2] = mat[i][j];	// copy source element into new sub-matrix
-					// i-1 because new sub-matrix is one row
-					// (and column) smaller with excluded minors
-					j2++;	// move to next sub-matrix column position
-				}
+	}
+
+	// NOTE: (sonictk) Gaussian elimination with partial pivoting on a copy of the
+	// matrix; the determinant is the product of the pivots, with the sign flipped
+	// for every row swap. This is the same as ``luDecompose``, but for a size that
+	// is only known at runtime.
+	float *lu = scratch;
+	for (int r=0; r < dimension; ++r) {
+		for (int c=0; c < dimension; ++c) {
+			lu[(r * dimension) + c] = mat[r][c];
+		}
+	}
+
+	// NOTE: (sonictk) The determinant is also divided by the lengths of the rows and
+	// columns as it is built up, to check whether it is negligible for the scale of
+	// the matrix (see ``isSingularDeterminant``) without overflowing.
+	float detByRows = 1.0f;
+	float detByColumns = 1.0f;
+	for (int i=0; i < dimension; ++i) {
+		float rowSum = 0.0f;
+		float columnSum = 0.0f;
+		for (int j=0; j < dimension; ++j) {
+			rowSum += lu[(i * dimension) + j] * lu[(i * dimension) + j];
+			columnSum += lu[(j * dimension) + i] * lu[(j * dimension) + i];
+		}
+		float rowLength = sqrtf(rowSum);
+		float columnLength = sqrtf(columnSum);
+		detByRows = rowLength > 0.0f ? detByRows / rowLength : 0.0f;
+		detByColumns = columnLength > 0.0f ? detByColumns / columnLength : 0.0f;
+	}
+
+	float det = 1.0f;
+	for (int k=0; k < dimension; ++k) {
+		int pivotRow = k;
+		float pivotAbs = fabsf(lu[(k * dimension) + k]);
+		for (int r=k + 1; r < dimension; ++r) {
+			if (fabsf(lu[(r * dimension) + k]) > pivotAbs) {
+				pivotAbs = fabsf(lu[(r * dimension) + k]);
+				pivotRow = r;
 			}
+		}
 
-			// sum x raised to y power recursively get determinant of
-			// next sub-matrix which is now one row & column smaller
-			det += pow(-1.0f, 1.0f + j1 + 1.0f) * mat[0][j1] * determinant(m, dimension - 1);
+		detByRows *= pivotAbs;
+		detByColumns *= pivotAbs;
+		if (pivotAbs == 0.0f) {
+			return 0;
+		}
 
-			for (i = 0 ; i < dimension-1 ; i++) {
-				// free the storage allocated to to this minor's set of pointers
-				free(m[i]);
+		if (pivotRow != k) {
+			for (int c=k; c < dimension; ++c) {
+				float tmp = lu[(k * dimension) + c];
+				lu[(k * dimension) + c] = lu[(pivotRow * dimension) + c];
+				lu[(pivotRow * dimension) + c] = tmp;
 			}
-			// free the storage for the original pointer to pointer
-			free(m);
+			det = -det;
 		}
 
-		break;
+		float pivot = lu[(k * dimension) + k];
+		det *= pivot;
+		for (int r=k + 1; r < dimension; ++r) {
+			float factor = lu[(r * dimension) + k] / pivot;
+			for (int c=k + 1; c < dimension; ++c) {
+				lu[(r * dimension) + c] -= factor * lu[(k * dimension) + c];
+			}
+		}
+	}
+
+	if (isSingularDeterminant(detByRows > detByColumns ? detByRows : detByColumns, 1.0f)) {
+		return 0;
 	}
 
 	return det;
 }
 
+
+float determinant(float **mat, int dimension)
+{
+	if (dimension > kMaxDeterminantDimension) {
+		return NAN;
+	}
+
+	float lu[kMaxDeterminantDimension * kMaxDeterminantDimension];
+	return determinant(mat, dimension, lu);
+}
+
+
+float determinant(float **mat, unsigned int dimension)
+{
+	if (dimension > (unsigned int)kMaxDeterminantDimension) {
+		return NAN;
+	}
+
+	return determinant(mat, (int)dimension);
+}
+
 Mat44 cofactor(const Mat44 &mat)
 {
 	// TODO: (sonictk) Unit test this and make sure it works correctly
@@ -317,7 +353,24 @@ Mat44 adjugate(const Mat44 &mat)
 }
 
 
-int inverse(const Mat44 &inMat, Mat44 &outMat)
+/// The product of the lengths of the rows of the matrix, or of its columns if that
+/// is smaller, which ``isSingularDeterminant`` compares its determinant against.
+static inline float lengthProduct(const Mat44 &mat)
+{
+	float rowProduct = 1.0f;
+	float columnProduct = 1.0f;
+	for (int i=0; i <= 3; ++i) {
+		rowProduct *= sqrtf((mat[i][0] * mat[i][0]) + (mat[i][1] * mat[i][1])
+							+ (mat[i][2] * mat[i][2]) + (mat[i][3] * mat[i][3]));
+		columnProduct *= sqrtf((mat[0][i] * mat[0][i]) + (mat[1][i] * mat[1][i])
+							   + (mat[2][i] * mat[2][i]) + (mat[3][i] * mat[3][i]));
+	}
+
+	return rowProduct < columnProduct ? rowProduct : columnProduct;
+}
+
+
+int inverseScalar(const Mat44 &inMat, Mat44 &outMat)
 {
 	// NOTE: (sonictk) This code is from the MESA implementation of the GLU library.
 	// It (probably) expands from ``A^-1 = 1 / determinant(A) * adjugate(A)``.
@@ -450,14 +503,16 @@ int inverse(const Mat44 &inMat, Mat44 &outMat)
 		+ inMat[2][0] * inMat[0][1] * inMat[1][2]
 		- inMat[2][0] * inMat[0][2] * inMat[1][1];
 
+	// NOTE: (sonictk) Laplace expansion along the first row, re-using the cofactors
+	// that were just computed above.
 	float det =
-		+ inMat[0][0] * outMat[0][0]
-		+ inMat[0][1] * outMat[1][0]
-		+ inMat[0][2]* outMat[2][0]
-		+ inMat[0][3] * outMat[3][0];
+		+ inMat[0][0] * invMat[0][0]
+		+ inMat[0][1] * invMat[1][0]
+		+ inMat[0][2] * invMat[2][0]
+		+ inMat[0][3] * invMat[3][0];
 
 	// NOTE: (sonictk) If the determinant is 0, there is no inverse matrix
-	if (areFloatsEqual(det, 0.0f)) {
+	if (isSingularDeterminant(det, lengthProduct(inMat))) {
 		return -1;
 	}
 
@@ -470,3 +525,177 @@ int inverse(const Mat44 &inMat, Mat44 &outMat)
 
 	return 0;
 }
+
+
+#if INSTRSET >= 2 // NOTE: (sonictk) Require SSE2 support for these intrinsics
+
+// NOTE: (sonictk) The general inverse uses the 2x2 block matrix method from:
+// https://lxjk.github.io/2017/09/03/Fast-4x4-Matrix-Inverse-with-SSE-SIMD-Explained.html
+// Each ``__m128`` holds a row-major 2x2 sub-matrix ``| A0 A1 |``.
+//                                                   ``| A2 A3 |``
+#define SS_SWIZZLE(v, x, y, z, w) _mm_shuffle_ps(v, v, _MM_SHUFFLE(w, z, y, x))
+#define SS_SHUFFLE(v1, v2, x, y, z, w) _mm_shuffle_ps(v1, v2, _MM_SHUFFLE(w, z, y, x))
+
+/// 2x2 matrix multiply ``A * B``.
+static inline __m128 mat22Mul(__m128 a, __m128 b)
+{
+	return _mm_add_ps(_mm_mul_ps(a, SS_SWIZZLE(b, 0, 3, 0, 3)),
+					  _mm_mul_ps(SS_SWIZZLE(a, 1, 0, 3, 2), SS_SWIZZLE(b, 2, 1, 2, 1)));
+}
+
+/// 2x2 matrix adjugate multiply ``adj(A) * B``.
+static inline __m128 mat22AdjMul(__m128 a, __m128 b)
+{
+	return _mm_sub_ps(_mm_mul_ps(SS_SWIZZLE(a, 3, 3, 0, 0), b),
+					  _mm_mul_ps(SS_SWIZZLE(a, 1, 1, 2, 2), SS_SWIZZLE(b, 2, 3, 0, 1)));
+}
+
+/// 2x2 matrix multiply adjugate ``A * adj(B)``.
+static inline __m128 mat22MulAdj(__m128 a, __m128 b)
+{
+	return _mm_sub_ps(_mm_mul_ps(a, SS_SWIZZLE(b, 3, 0, 3, 0)),
+					  _mm_mul_ps(SS_SWIZZLE(a, 1, 0, 3, 2), SS_SWIZZLE(b, 2, 1, 2, 1)));
+}
+
+
+int inverse(const Mat44 &inMat, Mat44 &outMat)
+{
+	__m128 row0 = _mm_loadu_ps(inMat[0]);
+	__m128 row1 = _mm_loadu_ps(inMat[1]);
+	__m128 row2 = _mm_loadu_ps(inMat[2]);
+	__m128 row3 = _mm_loadu_ps(inMat[3]);
+
+	// NOTE: (sonictk) Split the matrix into the sub-matrices ``| A B |``
+	//                                                         ``| C D |``
+	__m128 a = _mm_movelh_ps(row0, row1);
+	__m128 b = _mm_movehl_ps(row1, row0);
+	__m128 c = _mm_movelh_ps(row2, row3);
+	__m128 d = _mm_movehl_ps(row3, row2);
+
+	// NOTE: (sonictk) Determinants of the sub-matrices as ``(|A|, |B|, |C|, |D|)``
+	__m128 detSub = _mm_sub_ps(
+		_mm_mul_ps(SS_SHUFFLE(row0, row2, 0, 2, 0, 2), SS_SHUFFLE(row1, row3, 1, 3, 1, 3)),
+		_mm_mul_ps(SS_SHUFFLE(row0, row2, 1, 3, 1, 3), SS_SHUFFLE(row1, row3, 0, 2, 0, 2)));
+	__m128 detA = SS_SWIZZLE(detSub, 0, 0, 0, 0);
+	__m128 detB = SS_SWIZZLE(detSub, 1, 1, 1, 1);
+	__m128 detC = SS_SWIZZLE(detSub, 2, 2, 2, 2);
+	__m128 detD = SS_SWIZZLE(detSub, 3, 3, 3, 3);
+
+	// NOTE: (sonictk) Let the inverse be ``1/|M| * | X Y |``; we compute the
+	//                                               ``| Z W |``
+	// adjugates of each block first.
+	__m128 adjDC = mat22AdjMul(d, c);
+	__m128 adjAB = mat22AdjMul(a, b);
+	__m128 x = _mm_sub_ps(_mm_mul_ps(detD, a), mat22Mul(b, adjDC));
+	__m128 w = _mm_sub_ps(_mm_mul_ps(detA, d), mat22Mul(c, adjAB));
+	__m128 y = _mm_sub_ps(_mm_mul_ps(detB, c), mat22MulAdj(d, adjAB));
+	__m128 z = _mm_sub_ps(_mm_mul_ps(detC, b), mat22MulAdj(a, adjDC));
+
+	// NOTE: (sonictk) ``|M| = |A||D| + |B||C| - tr(adj(A)B * adj(D)C)``
+	__m128 tr = _mm_mul_ps(adjAB, SS_SWIZZLE(adjDC, 0, 2, 1, 3));
+	tr = _mm_add_ps(tr, SS_SWIZZLE(tr, 1, 0, 3, 2));
+	tr = _mm_add_ps(tr, SS_SWIZZLE(tr, 2, 3, 0, 1));
+	__m128 detM = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(detA, detD), _mm_mul_ps(detB, detC)), tr);
+
+	// NOTE: (sonictk) If the determinant is 0, there is no inverse matrix. The
+	// lengths of all four columns are found at once by adding the squared rows, and
+	// those of the rows by doing the same after transposing them.
+	__m128 sq0 = _mm_mul_ps(row0, row0);
+	__m128 sq1 = _mm_mul_ps(row1, row1);
+	__m128 sq2 = _mm_mul_ps(row2, row2);
+	__m128 sq3 = _mm_mul_ps(row3, row3);
+	__m128 columnLengths = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(sq0, sq1), _mm_add_ps(sq2, sq3)));
+	_MM_TRANSPOSE4_PS(sq0, sq1, sq2, sq3);
+	__m128 rowLengths = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(sq0, sq1), _mm_add_ps(sq2, sq3)));
+	__m128 lengths = _mm_unpacklo_ps(rowLengths, columnLengths);
+	lengths = _mm_mul_ps(lengths, _mm_unpackhi_ps(rowLengths, columnLengths));
+	lengths = _mm_mul_ps(lengths, _mm_movehl_ps(lengths, lengths));
+	lengths = _mm_min_ss(lengths, SS_SWIZZLE(lengths, 1, 1, 1, 1));
+	if (isSingularDeterminant(_mm_cvtss_f32(detM), _mm_cvtss_f32(lengths))) {
+		return -1;
+	}
+
+	__m128 invDetM = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), detM);
+	x = _mm_mul_ps(x, invDetM);
+	y = _mm_mul_ps(y, invDetM);
+	z = _mm_mul_ps(z, invDetM);
+	w = _mm_mul_ps(w, invDetM);
+
+	// NOTE: (sonictk) The final shuffle applies the adjugate and puts the
+	// blocks back into rows at the same time.
+	_mm_storeu_ps(outMat[0], SS_SHUFFLE(x, y, 3, 1, 3, 1));
+	_mm_storeu_ps(outMat[1], SS_SHUFFLE(x, y, 2, 0, 2, 0));
+	_mm_storeu_ps(outMat[2], SS_SHUFFLE(z, w, 3, 1, 3, 1));
+	_mm_storeu_ps(outMat[3], SS_SHUFFLE(z, w, 2, 0, 2, 0));
+
+	return 0;
+}
+
+#undef SS_SHUFFLE
+#undef SS_SWIZZLE
+
+
+int inverseAffine(const Mat44 &inMat, Mat44 &outMat)
+{
+	// NOTE: (sonictk) For ``M = | R t |``, the inverse is ``| R^-1  -R^-1.t |``
+	//                           ``| 0 1 |``                    ``| 0      1       |``
+	// where ``R^-1`` is the transposed matrix of ``(r1 x r2, r2 x r0, r0 x r1)``
+	// divided by the determinant ``r0 . (r1 x r2)``.
+	const __m128 xyzMask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+	Vec3A r0 = vec3a(_mm_and_ps(_mm_loadu_ps(inMat[0]), xyzMask));
+	Vec3A r1 = vec3a(_mm_and_ps(_mm_loadu_ps(inMat[1]), xyzMask));
+	Vec3A r2 = vec3a(_mm_and_ps(_mm_loadu_ps(inMat[2]), xyzMask));
+
+	Vec3A c0 = crossProduct(r1, r2);
+	Vec3A c1 = crossProduct(r2, r0);
+	Vec3A c2 = crossProduct(r0, r1);
+
+	// NOTE: (sonictk) The lengths of the columns of ``R`` are found from the sum of
+	// its squared rows.
+	__m128 det = innerProductSplat(r0, c0);
+	__m128 columnLengths = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(r0.v, r0.v), _mm_mul_ps(r1.v, r1.v)),
+												  _mm_mul_ps(r2.v, r2.v)));
+	columnLengths = _mm_mul_ss(_mm_mul_ss(columnLengths, _mm_movehl_ps(columnLengths, columnLengths)),
+							   _mm_shuffle_ps(columnLengths, columnLengths, _MM_SHUFFLE(1, 1, 1, 1)));
+	float rowProduct = length(r0) * length(r1) * length(r2);
+	float columnProduct = _mm_cvtss_f32(columnLengths);
+	if (isSingularDeterminant(_mm_cvtss_f32(det), rowProduct < columnProduct ? rowProduct : columnProduct)) {
+		return -1;
+	}
+
+	__m128 invDet = _mm_div_ps(_mm_set1_ps(1.0f), det);
+	__m128 col0 = _mm_mul_ps(c0.v, invDet);
+	__m128 col1 = _mm_mul_ps(c1.v, invDet);
+	__m128 col2 = _mm_mul_ps(c2.v, invDet);
+
+	// NOTE: (sonictk) The translation is ``-(R^-1 . t)``, computed as a linear
+	// combination of the columns of ``R^-1``. Its ``w`` lane becomes the ``1`` of
+	// the bottom row once everything is transposed back into rows.
+	__m128 translation = _mm_add_ps(
+		_mm_add_ps(_mm_mul_ps(col0, _mm_set1_ps(inMat[0][3])), _mm_mul_ps(col1, _mm_set1_ps(inMat[1][3]))),
+		_mm_mul_ps(col2, _mm_set1_ps(inMat[2][3])));
+	translation = _mm_or_ps(_mm_and_ps(_mm_sub_ps(_mm_setzero_ps(), translation), xyzMask),
+							_mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f));
+
+	_MM_TRANSPOSE4_PS(col0, col1, col2, translation);
+
+	_mm_storeu_ps(outMat[0], col0);
+	_mm_storeu_ps(outMat[1], col1);
+	_mm_storeu_ps(outMat[2], col2);
+	_mm_storeu_ps(outMat[3], translation);
+
+	return 0;
+}
+
+#else
+int inverse(const Mat44 &inMat, Mat44 &outMat)
+{
+	return inverseScalar(inMat, outMat);
+}
+
+int inverseAffine(const Mat44 &inMat, Mat44 &outMat)
+{
+	return inverseScalar(inMat, outMat);
+}
+
+#endif // INSTRSET
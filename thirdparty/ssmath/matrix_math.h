@@ -6,22 +6,29 @@
 #define MATRIX_MATH_H
 
 #include "vector_math.h"
+#include "simd_float.h"
 #include <math.h>
 
 
 /// A variable-size matrix data structure. These are assumed to be **row-major**.
-// TODO: (sonictk) Test if this works and implement more math ops for it
 template<class T, int rows, int columns>
 struct MatX
 {
 	T e[rows][columns];
 
 	inline T *operator[](int row) {
-		float *ptr = e[row];
-		return ptr;
+		return e[row];
+	}
+
+	inline const T *operator[](int row) const {
+		return e[row];
 	}
 
-	inline const T operator()(int row, int col) const {
+	constexpr const T &operator()(int row, int col) const {
+		return e[row][col];
+	}
+
+	inline T &operator()(int row, int col) {
 		return e[row][col];
 	}
 };
@@ -152,9 +159,12 @@ inline Mat44 operator*(const Mat44 &mat, float factor)
 	return result;
 }
 
-inline Mat44 operator*(const Mat44 &a, const Mat44 &b)
+/**
+ * The scalar reference implementation of ``operator*(const Mat44 &, const Mat44 &)``.
+ * This is kept around to validate the SIMD versions against.
+ */
+inline Mat44 multiplyScalar(const Mat44 &a, const Mat44 &b)
 {
-	// TODO: (sonictk) Investigate optimizing this using SIMD
 	Mat44 result = {};
 	for (int r=0; r <= 3; ++r) {
 		for (int c=0; c <=3; ++c) {
@@ -167,6 +177,63 @@ inline Mat44 operator*(const Mat44 &a, const Mat44 &b)
 	return result;
 }
 
+#if INSTRSET >= 7 // NOTE: (sonictk) Require AVX support for these intrinsics
+inline Mat44 operator*(const Mat44 &a, const Mat44 &b)
+{
+	// NOTE: (sonictk) Each row of the result is a linear combination of the rows
+	// of ``b``, weighted by the elements of the same row of ``a``. With AVX, we
+	// can work on two rows of the result at once.
+	__m256 b0 = _mm256_broadcast_ps((const __m128 *)b[0]);
+	__m256 b1 = _mm256_broadcast_ps((const __m128 *)b[1]);
+	__m256 b2 = _mm256_broadcast_ps((const __m128 *)b[2]);
+	__m256 b3 = _mm256_broadcast_ps((const __m128 *)b[3]);
+
+	Mat44 result;
+	for (int r=0; r <= 2; r += 2) {
+		__m256 rows = _mm256_loadu_ps(a[r]);
+		__m256 sum = _mm256_add_ps(
+			_mm256_add_ps(_mm256_mul_ps(_mm256_shuffle_ps(rows, rows, _MM_SHUFFLE(0, 0, 0, 0)), b0),
+						  _mm256_mul_ps(_mm256_shuffle_ps(rows, rows, _MM_SHUFFLE(1, 1, 1, 1)), b1)),
+			_mm256_add_ps(_mm256_mul_ps(_mm256_shuffle_ps(rows, rows, _MM_SHUFFLE(2, 2, 2, 2)), b2),
+						  _mm256_mul_ps(_mm256_shuffle_ps(rows, rows, _MM_SHUFFLE(3, 3, 3, 3)), b3)));
+		_mm256_storeu_ps(result[r], sum);
+	}
+
+	return result;
+}
+
+#elif INSTRSET >= 2 // NOTE: (sonictk) Require SSE2 support for these intrinsics
+inline Mat44 operator*(const Mat44 &a, const Mat44 &b)
+{
+	// NOTE: (sonictk) Each row of the result is a linear combination of the rows
+	// of ``b``, weighted by the elements of the same row of ``a``.
+	__m128 b0 = _mm_loadu_ps(b[0]);
+	__m128 b1 = _mm_loadu_ps(b[1]);
+	__m128 b2 = _mm_loadu_ps(b[2]);
+	__m128 b3 = _mm_loadu_ps(b[3]);
+
+	Mat44 result;
+	for (int r=0; r <= 3; ++r) {
+		__m128 row = _mm_loadu_ps(a[r]);
+		__m128 sum = _mm_add_ps(
+			_mm_add_ps(_mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(0, 0, 0, 0)), b0),
+					   _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(1, 1, 1, 1)), b1)),
+			_mm_add_ps(_mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(2, 2, 2, 2)), b2),
+					   _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(3, 3, 3, 3)), b3)));
+		_mm_storeu_ps(result[r], sum);
+	}
+
+	return result;
+}
+
+#else
+inline Mat44 operator*(const Mat44 &a, const Mat44 &b)
+{
+	return multiplyScalar(a, b);
+}
+
+#endif // INSTRSET
+
 inline Mat44 &operator*=(Mat44 &mat, float factor)
 {
 	mat = mat * factor;
@@ -197,6 +264,28 @@ inline Vec3 operator*(const Mat44 &mat, Vec3 vec)
 	return result;
 }
 
+#if INSTRSET >= 2 // NOTE: (sonictk) Require SSE2 support for these intrinsics
+inline Vec4A operator*(const Mat44 &mat, const Vec4A &vec)
+{
+	// NOTE: (sonictk) Multiply each row by the vector, then transpose the products
+	// so that summing the registers gives the dot product of every row at once.
+	__m128 r0 = _mm_mul_ps(_mm_loadu_ps(mat[0]), vec.v);
+	__m128 r1 = _mm_mul_ps(_mm_loadu_ps(mat[1]), vec.v);
+	__m128 r2 = _mm_mul_ps(_mm_loadu_ps(mat[2]), vec.v);
+	__m128 r3 = _mm_mul_ps(_mm_loadu_ps(mat[3]), vec.v);
+	_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+	return vec4a(_mm_add_ps(_mm_add_ps(r0, r1), _mm_add_ps(r2, r3)));
+}
+
+/// Transforms the vector as a position (i.e. ``w = 1``).
+inline Vec3A operator*(const Mat44 &mat, const Vec3A &vec)
+{
+	return toVec3A(mat * vec4a(vec, 1.0f));
+}
+
+#endif // INSTRSET
+
 inline Mat44 operator/(const Mat44 &mat, float factor)
 {
 	// TODO: (sonictk) Investigate optimizing this using SIMD
@@ -355,6 +444,127 @@ Mat44 rotateBy(const Mat44 &mat, EulerRotation rotation, RotationOrder order);
 Mat44 rotateBy(const Mat44 &mat, EulerRotation rotation);
 
 
+/**
+ * Builds the upper 3x3 block of a rotation matrix from the sines and cosines of
+ * Euler angles. There is one specialization per rotation order; an order ``ABC``
+ * results in ``R_A * R_B * R_C``. Each one is the expanded product, so there is
+ * no branching on the order once the builder has been chosen.
+ *
+ * This is a template over the element type so that it can also be used with the
+ * packet types from ``simd_float.h`` to build many matrices at once.
+ */
+template<RotationOrder order>
+struct EulerRotationBuilder;
+
+template<>
+struct EulerRotationBuilder<kXYZ>
+{
+	template <typename T>
+	static SS_FORCE_INLINE void build(T cx, T sx, T cy, T sy, T cz, T sz, T m[3][3])
+	{
+		m[0][0] = cy * cz;
+		m[0][1] = -(cy * sz);
+		m[0][2] = sy;
+		m[1][0] = (cx * sz) + (cz * sx * sy);
+		m[1][1] = (cx * cz) - (sx * sy * sz);
+		m[1][2] = -(cy * sx);
+		m[2][0] = (sx * sz) - (cx * cz * sy);
+		m[2][1] = (cx * sy * sz) + (cz * sx);
+		m[2][2] = cx * cy;
+	}
+};
+
+template<>
+struct EulerRotationBuilder<kYZX>
+{
+	template <typename T>
+	static SS_FORCE_INLINE void build(T cx, T sx, T cy, T sy, T cz, T sz, T m[3][3])
+	{
+		m[0][0] = cy * cz;
+		m[0][1] = (sx * sy) - (cx * cy * sz);
+		m[0][2] = (cx * sy) + (cy * sx * sz);
+		m[1][0] = sz;
+		m[1][1] = cx * cz;
+		m[1][2] = -(cz * sx);
+		m[2][0] = -(cz * sy);
+		m[2][1] = (cx * sy * sz) + (cy * sx);
+		m[2][2] = (cx * cy) - (sx * sy * sz);
+	}
+};
+
+template<>
+struct EulerRotationBuilder<kZXY>
+{
+	template <typename T>
+	static SS_FORCE_INLINE void build(T cx, T sx, T cy, T sy, T cz, T sz, T m[3][3])
+	{
+		m[0][0] = (cy * cz) - (sx * sy * sz);
+		m[0][1] = -(cx * sz);
+		m[0][2] = (cy * sx * sz) + (cz * sy);
+		m[1][0] = (cy * sz) + (cz * sx * sy);
+		m[1][1] = cx * cz;
+		m[1][2] = (sy * sz) - (cy * cz * sx);
+		m[2][0] = -(cx * sy);
+		m[2][1] = sx;
+		m[2][2] = cx * cy;
+	}
+};
+
+template<>
+struct EulerRotationBuilder<kXZY>
+{
+	template <typename T>
+	static SS_FORCE_INLINE void build(T cx, T sx, T cy, T sy, T cz, T sz, T m[3][3])
+	{
+		m[0][0] = cy * cz;
+		m[0][1] = -sz;
+		m[0][2] = cz * sy;
+		m[1][0] = (cx * cy * sz) + (sx * sy);
+		m[1][1] = cx * cz;
+		m[1][2] = (cx * sy * sz) - (cy * sx);
+		m[2][0] = (cy * sx * sz) - (cx * sy);
+		m[2][1] = cz * sx;
+		m[2][2] = (cx * cy) + (sx * sy * sz);
+	}
+};
+
+template<>
+struct EulerRotationBuilder<kYXZ>
+{
+	template <typename T>
+	static SS_FORCE_INLINE void build(T cx, T sx, T cy, T sy, T cz, T sz, T m[3][3])
+	{
+		m[0][0] = (cy * cz) + (sx * sy * sz);
+		m[0][1] = (cz * sx * sy) - (cy * sz);
+		m[0][2] = cx * sy;
+		m[1][0] = cx * sz;
+		m[1][1] = cx * cz;
+		m[1][2] = -sx;
+		m[2][0] = (cy * sx * sz) - (cz * sy);
+		m[2][1] = (cy * cz * sx) + (sy * sz);
+		m[2][2] = cx * cy;
+	}
+};
+
+template<>
+struct EulerRotationBuilder<kZYX>
+{
+	template <typename T>
+	static SS_FORCE_INLINE void build(T cx, T sx, T cy, T sy, T cz, T sz, T m[3][3])
+	{
+		m[0][0] = cy * cz;
+		m[0][1] = (cz * sx * sy) - (cx * sz);
+		m[0][2] = (cx * cz * sy) + (sx * sz);
+		m[1][0] = cy * sz;
+		m[1][1] = (cx * cz) + (sx * sy * sz);
+		m[1][2] = (cx * sy * sz) - (cz * sx);
+		m[2][0] = -sy;
+		m[2][1] = cy * sx;
+		m[2][2] = cx * cy;
+	}
+};
+
+
 inline Mat44 scaleBy(const Mat44 &mat, float x, float y, float z)
 {
 	Mat44 result;
@@ -379,6 +589,66 @@ inline Mat44 scaleBy(Mat44 mat, float factor)
 }
 
 
+/// A matrix is treated as singular when the magnitude of its determinant is less
+/// than this fraction of the product of the lengths of its rows (or of its columns,
+/// whichever is smaller). Either product is the largest that the determinant can be
+/// (Hadamard's inequality), so unlike an absolute threshold, the test does not
+/// depend on the scale of the matrix.
+static const float kSingularMatrixTolerance = 1e-6f;
+static const double kSingularMatrixToleranceDouble = 1e-14;
+
+inline float singularMatrixTolerance(float) { return kSingularMatrixTolerance; }
+inline double singularMatrixTolerance(double) { return kSingularMatrixToleranceDouble; }
+
+
+/**
+ * Checks whether a matrix is singular from its determinant.
+ *
+ * @param det				The determinant of the matrix.
+ * @param lengthProduct	The product of the lengths of the rows of the matrix, or
+ * 						of its columns if that is smaller.
+ *
+ * @return					``true`` if the determinant is negligible next to the
+ * 						scale of the matrix, or is not a number.
+ */
+template<class T>
+inline bool isSingularDeterminant(T det, T lengthProduct)
+{
+	// NOTE: (sonictk) Written so that a NaN determinant is also singular.
+	T detAbs = det < 0 ? -det : det;
+	return !(detAbs > lengthProduct * singularMatrixTolerance(det));
+}
+
+
+/**
+ * Calculates the product of the lengths of the rows of a square matrix, or of its
+ * columns if that is smaller, which ``isSingularDeterminant`` compares the
+ * determinant against.
+ *
+ * @param mat	A square matrix.
+ *
+ * @return		The product of the lengths.
+ */
+template<class T, int n>
+inline T lengthProduct(const MatX<T, n, n> &mat)
+{
+	T rowProduct = T(1);
+	T columnProduct = T(1);
+	for (int i=0; i < n; ++i) {
+		T rowSum = T(0);
+		T columnSum = T(0);
+		for (int j=0; j < n; ++j) {
+			rowSum += mat(i, j) * mat(i, j);
+			columnSum += mat(j, i) * mat(j, i);
+		}
+		rowProduct *= T(sqrt((double)rowSum));
+		columnProduct *= T(sqrt((double)columnSum));
+	}
+
+	return rowProduct < columnProduct ? rowProduct : columnProduct;
+}
+
+
 /**
  * Calculate the determinant of a 4x4 matrix. This should be used instead of the
  * other version when the size of the matrix is 4x4, as it is faster.
@@ -390,16 +660,354 @@ inline Mat44 scaleBy(Mat44 mat, float factor)
 float determinant(const Mat44 &mat);
 
 
+/// The largest dimension that ``determinant(float **, int)`` supports. The LU
+/// decomposition is done in a stack buffer of this size (4 KiB) to avoid any heap
+/// allocations; pass a scratch buffer for larger matrices.
+static const int kMaxDeterminantDimension = 32;
+
+
 /**
- * Calculate the determinant of a variable-sized square matrix.
+ * Calculate the determinant of a variable-sized square matrix using an LU
+ * decomposition that is done in the given scratch buffer. This does not allocate
+ * any memory, and works for any dimension.
  *
  * @param mat			Pointer to a pointer of an arbitrary square matrix.
  * @param dimension	The dimension of the square matrix.
+ * @param scratch		A buffer of at least ``dimension * dimension`` floats, which
+ * 					is overwritten.
+ *
+ * @return				The determinant. This is exactly ``0`` if the matrix is
+ * 					singular (see ``isSingularDeterminant``).
+ */
+float determinant(float **mat, int dimension, float *scratch);
+
+
+/**
+ * Calculate the determinant of a variable-sized square matrix using an LU
+ * decomposition. This does not allocate any memory.
+ *
+ * @param mat			Pointer to a pointer of an arbitrary square matrix.
+ * @param dimension	The dimension of the square matrix. This must not be larger
+ * 					than ``kMaxDeterminantDimension``.
  *
- * @return				The determinant.
+ * @return				The determinant, or ``NAN`` if the dimension is larger
+ * 					than what is supported. This is exactly ``0`` if the matrix
+ * 					is singular (see ``isSingularDeterminant``).
  */
 float determinant(float **mat, int dimension);
 
+/// Same as ``determinant(float **, int)``.
+float determinant(float **mat, unsigned int dimension);
+
+
+/**
+ * Decomposes the given square matrix in-place into ``P.A = L.U`` using partial
+ * (row) pivoting. After decomposition, the strictly lower triangle of ``mat``
+ * holds ``L`` (whose diagonal is implicitly ``1``) and the upper triangle holds ``U``.
+ *
+ * @param mat			The matrix to decompose. This is overwritten with the result.
+ * @param permutation	Storage for ``n`` indices. Row ``i`` of the decomposition
+ * 					corresponds to row ``permutation[i]`` of the original matrix.
+ * @param parity		If not ``NULL``, this is set to ``1`` or ``-1`` depending
+ * 					on whether an even or odd number of row swaps was done.
+ *
+ * @return				``0`` on success, a negative value if the matrix is singular
+ * 					(see ``isSingularDeterminant``). The decomposition is still
+ * 					completed in that case.
+ */
+template<class T, int n>
+inline int luDecompose(MatX<T, n, n> &mat, int permutation[n], int *parity)
+{
+	int status = 0;
+	int sign = 1;
+	for (int i=0; i < n; ++i) {
+		permutation[i] = i;
+	}
+
+	// NOTE: (sonictk) The determinant is the product of the pivots, which is checked
+	// against the lengths of the rows and columns (see ``isSingularDeterminant``).
+	// The ratios are built up one row and column at a time, since any of the
+	// products on their own can overflow for large matrices.
+	T detByRows = T(1);
+	T detByColumns = T(1);
+	for (int i=0; i < n; ++i) {
+		T rowSum = T(0);
+		T columnSum = T(0);
+		for (int j=0; j < n; ++j) {
+			rowSum += mat[i][j] * mat[i][j];
+			columnSum += mat[j][i] * mat[j][i];
+		}
+		T rowLength = T(sqrt((double)rowSum));
+		T columnLength = T(sqrt((double)columnSum));
+		detByRows = rowLength > T(0) ? detByRows / rowLength : T(0);
+		detByColumns = columnLength > T(0) ? detByColumns / columnLength : T(0);
+	}
+
+	for (int k=0; k < n; ++k) {
+		// NOTE: (sonictk) Pick the largest remaining element of this column as the
+		// pivot to keep the elimination numerically stable.
+		int pivotRow = k;
+		T pivotAbs = mat[k][k] < 0 ? -mat[k][k] : mat[k][k];
+		for (int r=k + 1; r < n; ++r) {
+			T value = mat[r][k] < 0 ? -mat[r][k] : mat[r][k];
+			if (value > pivotAbs) {
+				pivotAbs = value;
+				pivotRow = r;
+			}
+		}
+
+		if (pivotRow != k) {
+			for (int c=0; c < n; ++c) {
+				T tmp = mat[k][c];
+				mat[k][c] = mat[pivotRow][c];
+				mat[pivotRow][c] = tmp;
+			}
+			int tmp = permutation[k];
+			permutation[k] = permutation[pivotRow];
+			permutation[pivotRow] = tmp;
+			sign = -sign;
+		}
+
+		detByRows *= pivotAbs;
+		detByColumns *= pivotAbs;
+		if (pivotAbs == T(0)) {
+			status = -1;
+			continue;
+		}
+
+		T invPivot = T(1) / mat[k][k];
+		for (int r=k + 1; r < n; ++r) {
+			T factor = mat[r][k] * invPivot;
+			mat[r][k] = factor;
+			for (int c=k + 1; c < n; ++c) {
+				mat[r][c] -= factor * mat[k][c];
+			}
+		}
+	}
+
+	if (isSingularDeterminant(detByRows > detByColumns ? detByRows : detByColumns, T(1))) {
+		status = -1;
+	}
+
+	if (parity) {
+		*parity = sign;
+	}
+
+	return status;
+}
+
+
+/**
+ * Solves ``A.x = b`` given the LU decomposition of ``A`` from ``luDecompose``.
+ *
+ * @param lu			The decomposed matrix.
+ * @param permutation	The permutation returned from ``luDecompose``.
+ * @param b			The right-hand side vector of ``n`` elements.
+ * @param x			Storage for the ``n`` elements of the solution. May alias ``b``.
+ */
+template<class T, int n>
+inline void luSolve(const MatX<T, n, n> &lu, const int permutation[n], const T b[n], T x[n])
+{
+	T y[n];
+	// NOTE: (sonictk) Forward substitution with the unit lower triangle...
+	for (int r=0; r < n; ++r) {
+		T sum = b[permutation[r]];
+		for (int c=0; c < r; ++c) {
+			sum -= lu[r][c] * y[c];
+		}
+		y[r] = sum;
+	}
+
+	// NOTE: (sonictk) ...then back substitution with the upper triangle.
+	for (int r=n - 1; r >= 0; --r) {
+		T sum = y[r];
+		for (int c=r + 1; c < n; ++c) {
+			sum -= lu[r][c] * x[c];
+		}
+		x[r] = sum / lu[r][r];
+	}
+}
+
+
+/// The determinant and inverse of square ``MatX`` matrices. The generic version
+/// uses an LU decomposition, while small sizes are specialized at compile time
+/// with closed-form expressions.
+template<class T, int n>
+struct MatXOps
+{
+	static inline T determinant(const MatX<T, n, n> &mat) {
+		MatX<T, n, n> lu = mat;
+		int permutation[n];
+		int parity;
+		if (luDecompose(lu, permutation, &parity) != 0) {
+			return T(0);
+		}
+
+		T det = T(parity);
+		for (int i=0; i < n; ++i) {
+			det *= lu[i][i];
+		}
+
+		return det;
+	}
+
+	static inline int inverse(const MatX<T, n, n> &mat, MatX<T, n, n> &out) {
+		MatX<T, n, n> lu = mat;
+		int permutation[n];
+		if (luDecompose(lu, permutation, (int *)0) != 0) {
+			return -1;
+		}
+
+		// NOTE: (sonictk) Solve for each column of the identity matrix in turn.
+		for (int c=0; c < n; ++c) {
+			T b[n];
+			T x[n];
+			for (int r=0; r < n; ++r) {
+				b[r] = r == c ? T(1) : T(0);
+			}
+			luSolve(lu, permutation, b, x);
+			for (int r=0; r < n; ++r) {
+				out[r][c] = x[r];
+			}
+		}
+
+		return 0;
+	}
+};
+
+template<class T>
+struct MatXOps<T, 1>
+{
+	static inline T determinant(const MatX<T, 1, 1> &m) {
+		return m(0, 0);
+	}
+
+	static inline int inverse(const MatX<T, 1, 1> &m, MatX<T, 1, 1> &out) {
+		if (isSingularDeterminant(m(0, 0), m(0, 0) < 0 ? -m(0, 0) : m(0, 0))) {
+			return -1;
+		}
+		out(0, 0) = T(1) / m(0, 0);
+
+		return 0;
+	}
+};
+
+template<class T>
+struct MatXOps<T, 2>
+{
+	static inline T determinant(const MatX<T, 2, 2> &m) {
+		return m(0, 0) * m(1, 1) - m(0, 1) * m(1, 0);
+	}
+
+	static inline int inverse(const MatX<T, 2, 2> &m, MatX<T, 2, 2> &out) {
+		T det = determinant(m);
+		if (isSingularDeterminant(det, lengthProduct(m))) {
+			return -1;
+		}
+
+		T invDet = T(1) / det;
+		T m00 = m(0, 0);
+		out(0, 0) = m(1, 1) * invDet;
+		out(0, 1) = -m(0, 1) * invDet;
+		out(1, 0) = -m(1, 0) * invDet;
+		out(1, 1) = m00 * invDet;
+
+		return 0;
+	}
+};
+
+template<class T>
+struct MatXOps<T, 3>
+{
+	static inline T determinant(const MatX<T, 3, 3> &m) {
+		return m(0, 0) * (m(1, 1) * m(2, 2) - m(1, 2) * m(2, 1))
+			- m(0, 1) * (m(1, 0) * m(2, 2) - m(1, 2) * m(2, 0))
+			+ m(0, 2) * (m(1, 0) * m(2, 1) - m(1, 1) * m(2, 0));
+	}
+
+	static inline int inverse(const MatX<T, 3, 3> &m, MatX<T, 3, 3> &out) {
+		T det = determinant(m);
+		if (isSingularDeterminant(det, lengthProduct(m))) {
+			return -1;
+		}
+
+		// NOTE: (sonictk) Write to a temporary in case ``out`` aliases ``m``.
+		T invDet = T(1) / det;
+		MatX<T, 3, 3> adj;
+		adj(0, 0) = m(1, 1) * m(2, 2) - m(1, 2) * m(2, 1);
+		adj(0, 1) = m(0, 2) * m(2, 1) - m(0, 1) * m(2, 2);
+		adj(0, 2) = m(0, 1) * m(1, 2) - m(0, 2) * m(1, 1);
+		adj(1, 0) = m(1, 2) * m(2, 0) - m(1, 0) * m(2, 2);
+		adj(1, 1) = m(0, 0) * m(2, 2) - m(0, 2) * m(2, 0);
+		adj(1, 2) = m(0, 2) * m(1, 0) - m(0, 0) * m(1, 2);
+		adj(2, 0) = m(1, 0) * m(2, 1) - m(1, 1) * m(2, 0);
+		adj(2, 1) = m(0, 1) * m(2, 0) - m(0, 0) * m(2, 1);
+		adj(2, 2) = m(0, 0) * m(1, 1) - m(0, 1) * m(1, 0);
+		for (int r=0; r < 3; ++r) {
+			for (int c=0; c < 3; ++c) {
+				out(r, c) = adj(r, c) * invDet;
+			}
+		}
+
+		return 0;
+	}
+};
+
+
+/**
+ * Calculate the determinant of a square matrix. This does not allocate any memory.
+ *
+ * @param mat	A square matrix.
+ *
+ * @return		The determinant. For matrices larger than 3x3, this is exactly ``0``
+ * 			if the matrix is singular (see ``isSingularDeterminant``).
+ */
+template<class T, int n>
+inline T determinant(const MatX<T, n, n> &mat)
+{
+	return MatXOps<T, n>::determinant(mat);
+}
+
+
+/**
+ * This finds the inverse of the given square matrix. This does not allocate any memory.
+ *
+ * @param inMat 	The matrix to find the inverse of.
+ * @param outMat	The matrix that will have the result written to. May alias ``inMat``.
+ *
+ * @return 		``0`` on success, a negative value if the inverse does not exist
+ * 				(see ``isSingularDeterminant``).
+ */
+template<class T, int n>
+inline int inverse(const MatX<T, n, n> &inMat, MatX<T, n, n> &outMat)
+{
+	return MatXOps<T, n>::inverse(inMat, outMat);
+}
+
+
+/**
+ * Solves the linear system ``A.x = b``. If several systems with the same matrix
+ * need to be solved, use ``luDecompose`` once and ``luSolve`` for each of them instead.
+ *
+ * @param a		The square matrix of the system.
+ * @param b		The right-hand side vector of ``n`` elements.
+ * @param x		Storage for the ``n`` elements of the solution. May alias ``b``.
+ *
+ * @return			``0`` on success, a negative value if the matrix is singular.
+ */
+template<class T, int n>
+inline int solve(const MatX<T, n, n> &a, const T b[n], T x[n])
+{
+	MatX<T, n, n> lu = a;
+	int permutation[n];
+	if (luDecompose(lu, permutation, (int *)0) != 0) {
+		return -1;
+	}
+	luSolve(lu, permutation, b, x);
+
+	return 0;
+}
+
 
 /**
  * This finds the matrix of cofactors for the given 4x4 matrix.
@@ -428,9 +1036,36 @@ Mat44 adjugate(const Mat44 &mat);
  * @param outMat	The 4x4 matrix that will have the result written to.
  *
  * @return 		``0`` on success, a negative value if the inverse does not
- * 				exist or an error occurred.
+ * 				exist (see ``isSingularDeterminant``) or an error occurred.
  */
 int inverse(const Mat44 &inMat, Mat44 &outMat);
 
 
+/**
+ * The scalar reference implementation of ``inverse``, using a full cofactor
+ * expansion. This is kept around to validate the SIMD versions against.
+ *
+ * @param inMat 	The 4x4 matrix to find the inverse of.
+ * @param outMat	The 4x4 matrix that will have the result written to.
+ *
+ * @return 		``0`` on success, a negative value if the inverse does not
+ * 				exist (see ``isSingularDeterminant``) or an error occurred.
+ */
+int inverseScalar(const Mat44 &inMat, Mat44 &outMat);
+
+
+/**
+ * This finds the inverse of the given 4x4 affine transformation matrix (i.e. one
+ * whose bottom row is ``[0, 0, 0, 1]``). This is considerably cheaper than the
+ * general ``inverse`` and should be preferred for transforms such as joints.
+ *
+ * @param inMat 	The 4x4 affine matrix to find the inverse of.
+ * @param outMat	The 4x4 matrix that will have the result written to.
+ *
+ * @return 		``0`` on success, a negative value if the inverse does not
+ * 				exist (see ``isSingularDeterminant``) or an error occurred.
+ */
+int inverseAffine(const Mat44 &inMat, Mat44 &outMat);
+
+
 #endif /* MATRIX_MATH_H */
@@ -0,0 +1,368 @@
+/**
+ * @brief  	Batched construction of transformation matrices from SoA streams, and
+ * 			batched products and inverses of arrays of matrices. The per-element
+ * 			math is done over the packet types of ``simd_float.h``, and the public
+ * 			functions (in ``simd_kernels.h``) use the widest packet type the CPU
+ * 			supports, the same as for ``vector_stream.h``.
+ *
+ * 			The arrays of matrices are AoS, so each packet of matrices is transposed
+ * 			into one packet per element (i.e. SoA form) on the way in, and back on
+ * 			the way out. Every matrix then goes through exactly the same operations,
+ * 			whichever lane it ends up in.
+ */
+#ifndef MATRIX_STREAM_H
+#define MATRIX_STREAM_H
+
+#include "matrix_math.h"
+#include "vector_stream.h"
+#include "simd_math.h"
+
+
+template<RotationOrder order>
+struct EulerRotationMatricesKernel
+{
+	template <typename F>
+	static SS_FORCE_INLINE void run(const Vec3Stream &rotations, Mat44 *out)
+	{
+		const F degreesToRadians = F::broadcast(PI / 180.0f);
+
+		for (unsigned int i=0; i < rotations.count; i += F::width) {
+			Vec3Packet<F> angles = loadVec3Packet<F>(rotations, i);
+
+			F sx, cx, sy, cy, sz, cz;
+			sinCos(angles.x * degreesToRadians, sx, cx);
+			sinCos(angles.y * degreesToRadians, sy, cy);
+			sinCos(angles.z * degreesToRadians, sz, cz);
+
+			F m[3][3];
+			EulerRotationBuilder<order>::build(cx, sx, cy, sy, cz, sz, m);
+
+			// NOTE: (sonictk) The matrices are AoS, so transpose the packets through
+			// a small buffer. The streams are padded, but the output array isn't, so
+			// only the matrices that actually exist are written.
+			float lanes[3][3][F::width];
+			for (int r=0; r < 3; ++r) {
+				for (int c=0; c < 3; ++c) {
+					m[r][c].storeUnaligned(lanes[r][c]);
+				}
+			}
+
+			unsigned int numLanes = rotations.count - i < F::width ? rotations.count - i : F::width;
+			for (unsigned int lane=0; lane < numLanes; ++lane) {
+				Mat44 &mat = out[i + lane];
+				for (int r=0; r < 3; ++r) {
+					mat[r][0] = lanes[r][0][lane];
+					mat[r][1] = lanes[r][1][lane];
+					mat[r][2] = lanes[r][2][lane];
+					mat[r][3] = 0.0f;
+				}
+				mat[3][0] = mat[3][1] = mat[3][2] = 0.0f;
+				mat[3][3] = 1.0f;
+			}
+		}
+	}
+};
+
+
+/**
+ * Transposes up to ``F::width`` matrices into one packet per element. The lanes past
+ * ``count`` are filled with the identity matrix, so that they stay finite.
+ *
+ * @param in		The matrices to load.
+ * @param count	The number of matrices left in ``in``.
+ * @param m		The packets to load the elements into.
+ */
+template <typename F>
+SS_FORCE_INLINE void loadMat44Packet(const Mat44 *in, unsigned int count, F m[4][4])
+{
+	if (count >= F::width) {
+		for (int r=0; r <= 3; ++r) {
+			loadTransposed4(in[0][r], 16, m[r]);
+		}
+		return;
+	}
+
+	float lanes[4][4][F::width];
+	for (unsigned int lane=0; lane < count; ++lane) {
+		for (int r=0; r <= 3; ++r) {
+			for (int c=0; c <= 3; ++c) {
+				lanes[r][c][lane] = in[lane][r][c];
+			}
+		}
+	}
+
+	for (unsigned int lane=count; lane < F::width; ++lane) {
+		for (int r=0; r <= 3; ++r) {
+			for (int c=0; c <= 3; ++c) {
+				lanes[r][c][lane] = r == c ? 1.0f : 0.0f;
+			}
+		}
+	}
+
+	for (int r=0; r <= 3; ++r) {
+		for (int c=0; c <= 3; ++c) {
+			m[r][c] = F::loadUnaligned(lanes[r][c]);
+		}
+	}
+}
+
+
+/**
+ * Transposes packets of elements back into up to ``F::width`` matrices.
+ *
+ * @param m		The packets of elements.
+ * @param count	The number of matrices left in ``out``; only these are written.
+ * @param out		The matrices to store to.
+ */
+template <typename F>
+SS_FORCE_INLINE void storeMat44Packet(const F m[4][4], unsigned int count, Mat44 *out)
+{
+	if (count >= F::width) {
+		for (int r=0; r <= 3; ++r) {
+			storeTransposed4(m[r], out[0][r], 16);
+		}
+		return;
+	}
+
+	float lanes[4][4][F::width];
+	for (int r=0; r <= 3; ++r) {
+		for (int c=0; c <= 3; ++c) {
+			m[r][c].storeUnaligned(lanes[r][c]);
+		}
+	}
+
+	unsigned int numLanes = count < F::width ? count : F::width;
+	for (unsigned int lane=0; lane < numLanes; ++lane) {
+		for (int r=0; r <= 3; ++r) {
+			for (int c=0; c <= 3; ++c) {
+				out[lane][r][c] = lanes[r][c][lane];
+			}
+		}
+	}
+}
+
+
+/// Multiplies two packets of matrices.
+template <typename F>
+SS_FORCE_INLINE void multiplyMat44Packet(const F a[4][4], const F b[4][4], F out[4][4])
+{
+	for (int r=0; r <= 3; ++r) {
+		for (int c=0; c <= 3; ++c) {
+			out[r][c] = (a[r][0] * b[0][c]) + (a[r][1] * b[1][c]) + (a[r][2] * b[2][c]) + (a[r][3] * b[3][c]);
+		}
+	}
+}
+
+
+/**
+ * Checks the determinant of each lane of a packet (see ``isSingularDeterminant``),
+ * and replaces the matrices of the lanes that are singular with identity.
+ *
+ * @param det				The determinants.
+ * @param lengthProducts	The products of the lengths of the rows or columns.
+ * @param count			The number of matrices left in ``out``.
+ * @param out				The inverted matrices, as stored by ``storeMat44Packet``.
+ *
+ * @return					``0`` if none of the matrices were singular, ``-1`` otherwise.
+ */
+template <typename F>
+SS_FORCE_INLINE int replaceSingularMat44Lanes(F det, F lengthProducts, unsigned int count, Mat44 *out)
+{
+	float detLanes[F::width];
+	float lengthLanes[F::width];
+	det.storeUnaligned(detLanes);
+	lengthProducts.storeUnaligned(lengthLanes);
+
+	int result = 0;
+	unsigned int numLanes = count < F::width ? count : F::width;
+	for (unsigned int lane=0; lane < numLanes; ++lane) {
+		if (isSingularDeterminant(detLanes[lane], lengthLanes[lane])) {
+			out[lane] = identityMat44();
+			result = -1;
+		}
+	}
+
+	return result;
+}
+
+
+/// See ``multiplyMat44Array``.
+struct MultiplyMat44ArrayKernel
+{
+	template <typename F>
+	static SS_FORCE_INLINE void run(const Mat44 *a, const Mat44 *b, Mat44 *out, unsigned int count)
+	{
+		// NOTE: (sonictk) A 4-wide packet of products costs as many operations as 4
+		// row-by-row products do, so the transposes would only be overhead there.
+		if (F::width < 8) {
+			for (unsigned int i=0; i < count; ++i) {
+				out[i] = a[i] * b[i];
+			}
+			return;
+		}
+
+		for (unsigned int i=0; i < count; i += F::width) {
+			F ma[4][4];
+			F mb[4][4];
+			loadMat44Packet(a + i, count - i, ma);
+			loadMat44Packet(b + i, count - i, mb);
+
+			F result[4][4];
+			multiplyMat44Packet(ma, mb, result);
+			storeMat44Packet(result, count - i, out + i);
+		}
+	}
+};
+
+
+/// See ``multiplyMat44Array``, for a single left-hand side matrix.
+struct MultiplyMat44ArrayBroadcastKernel
+{
+	template <typename F>
+	static SS_FORCE_INLINE void run(const Mat44 &a, const Mat44 *b, Mat44 *out, unsigned int count)
+	{
+		// NOTE: (sonictk) Broadcast before anything is stored, in case ``a`` lives
+		// inside the output array.
+		if (F::width < 8) {
+			Mat44 lhs = a;
+			for (unsigned int i=0; i < count; ++i) {
+				out[i] = lhs * b[i];
+			}
+			return;
+		}
+
+		F ma[4][4];
+		for (int r=0; r <= 3; ++r) {
+			for (int c=0; c <= 3; ++c) {
+				ma[r][c] = F::broadcast(a[r][c]);
+			}
+		}
+
+		for (unsigned int i=0; i < count; i += F::width) {
+			F mb[4][4];
+			loadMat44Packet(b + i, count - i, mb);
+
+			F result[4][4];
+			multiplyMat44Packet(ma, mb, result);
+			storeMat44Packet(result, count - i, out + i);
+		}
+	}
+};
+
+
+/// See ``inverseMat44Array``.
+struct InverseMat44ArrayKernel
+{
+	template <typename F>
+	static SS_FORCE_INLINE void run(const Mat44 *in, Mat44 *out, unsigned int count, int &result)
+	{
+		result = 0;
+		for (unsigned int i=0; i < count; i += F::width) {
+			F m[4][4];
+			loadMat44Packet(in + i, count - i, m);
+
+			// NOTE: (sonictk) The 2x2 minors of the top two rows (``s``) and of the
+			// bottom two rows (``c``), from which every cofactor is built.
+			F s0 = (m[0][0] * m[1][1]) - (m[1][0] * m[0][1]);
+			F s1 = (m[0][0] * m[1][2]) - (m[1][0] * m[0][2]);
+			F s2 = (m[0][0] * m[1][3]) - (m[1][0] * m[0][3]);
+			F s3 = (m[0][1] * m[1][2]) - (m[1][1] * m[0][2]);
+			F s4 = (m[0][1] * m[1][3]) - (m[1][1] * m[0][3]);
+			F s5 = (m[0][2] * m[1][3]) - (m[1][2] * m[0][3]);
+			F c5 = (m[2][2] * m[3][3]) - (m[3][2] * m[2][3]);
+			F c4 = (m[2][1] * m[3][3]) - (m[3][1] * m[2][3]);
+			F c3 = (m[2][1] * m[3][2]) - (m[3][1] * m[2][2]);
+			F c2 = (m[2][0] * m[3][3]) - (m[3][0] * m[2][3]);
+			F c1 = (m[2][0] * m[3][2]) - (m[3][0] * m[2][2]);
+			F c0 = (m[2][0] * m[3][1]) - (m[3][0] * m[2][1]);
+
+			F det = (s0 * c5) - (s1 * c4) + (s2 * c3) + (s3 * c2) - (s4 * c1) + (s5 * c0);
+			F invDet = F::broadcast(1.0f) / det;
+
+			F inv[4][4];
+			inv[0][0] = ((m[1][1] * c5) - (m[1][2] * c4) + (m[1][3] * c3)) * invDet;
+			inv[0][1] = ((m[0][2] * c4) - (m[0][1] * c5) - (m[0][3] * c3)) * invDet;
+			inv[0][2] = ((m[3][1] * s5) - (m[3][2] * s4) + (m[3][3] * s3)) * invDet;
+			inv[0][3] = ((m[2][2] * s4) - (m[2][1] * s5) - (m[2][3] * s3)) * invDet;
+			inv[1][0] = ((m[1][2] * c2) - (m[1][0] * c5) - (m[1][3] * c1)) * invDet;
+			inv[1][1] = ((m[0][0] * c5) - (m[0][2] * c2) + (m[0][3] * c1)) * invDet;
+			inv[1][2] = ((m[3][2] * s2) - (m[3][0] * s5) - (m[3][3] * s1)) * invDet;
+			inv[1][3] = ((m[2][0] * s5) - (m[2][2] * s2) + (m[2][3] * s1)) * invDet;
+			inv[2][0] = ((m[1][0] * c4) - (m[1][1] * c2) + (m[1][3] * c0)) * invDet;
+			inv[2][1] = ((m[0][1] * c2) - (m[0][0] * c4) - (m[0][3] * c0)) * invDet;
+			inv[2][2] = ((m[3][0] * s4) - (m[3][1] * s2) + (m[3][3] * s0)) * invDet;
+			inv[2][3] = ((m[2][1] * s2) - (m[2][0] * s4) - (m[2][3] * s0)) * invDet;
+			inv[3][0] = ((m[1][1] * c1) - (m[1][0] * c3) - (m[1][2] * c0)) * invDet;
+			inv[3][1] = ((m[0][0] * c3) - (m[0][1] * c1) + (m[0][2] * c0)) * invDet;
+			inv[3][2] = ((m[3][1] * s1) - (m[3][0] * s3) - (m[3][2] * s0)) * invDet;
+			inv[3][3] = ((m[2][0] * s3) - (m[2][1] * s1) + (m[2][2] * s0)) * invDet;
+
+			F rowProduct = F::broadcast(1.0f);
+			F columnProduct = F::broadcast(1.0f);
+			for (int r=0; r <= 3; ++r) {
+				rowProduct = rowProduct * squareRoot((m[r][0] * m[r][0]) + (m[r][1] * m[r][1])
+													 + (m[r][2] * m[r][2]) + (m[r][3] * m[r][3]));
+				columnProduct = columnProduct * squareRoot((m[0][r] * m[0][r]) + (m[1][r] * m[1][r])
+														   + (m[2][r] * m[2][r]) + (m[3][r] * m[3][r]));
+			}
+
+			storeMat44Packet(inv, count - i, out + i);
+			if (replaceSingularMat44Lanes(det, minimum(rowProduct, columnProduct), count - i, out + i) != 0) {
+				result = -1;
+			}
+		}
+	}
+};
+
+
+/// See ``inverseAffineMat44Array``.
+struct InverseAffineMat44ArrayKernel
+{
+	template <typename F>
+	static SS_FORCE_INLINE void run(const Mat44 *in, Mat44 *out, unsigned int count, int &result)
+	{
+		result = 0;
+		for (unsigned int i=0; i < count; i += F::width) {
+			F m[4][4];
+			loadMat44Packet(in + i, count - i, m);
+
+			// NOTE: (sonictk) ``R^-1`` is the adjugate of the upper 3x3 block divided
+			// by its determinant, and the translation is ``-(R^-1 . t)``.
+			F inv[4][4];
+			inv[0][0] = (m[1][1] * m[2][2]) - (m[1][2] * m[2][1]);
+			inv[0][1] = (m[0][2] * m[2][1]) - (m[0][1] * m[2][2]);
+			inv[0][2] = (m[0][1] * m[1][2]) - (m[0][2] * m[1][1]);
+			inv[1][0] = (m[1][2] * m[2][0]) - (m[1][0] * m[2][2]);
+			inv[1][1] = (m[0][0] * m[2][2]) - (m[0][2] * m[2][0]);
+			inv[1][2] = (m[0][2] * m[1][0]) - (m[0][0] * m[1][2]);
+			inv[2][0] = (m[1][0] * m[2][1]) - (m[1][1] * m[2][0]);
+			inv[2][1] = (m[0][1] * m[2][0]) - (m[0][0] * m[2][1]);
+			inv[2][2] = (m[0][0] * m[1][1]) - (m[0][1] * m[1][0]);
+
+			F det = (m[0][0] * inv[0][0]) + (m[0][1] * inv[1][0]) + (m[0][2] * inv[2][0]);
+			F invDet = F::broadcast(1.0f) / det;
+
+			F rowProduct = F::broadcast(1.0f);
+			F columnProduct = F::broadcast(1.0f);
+			for (int r=0; r <= 2; ++r) {
+				for (int c=0; c <= 2; ++c) {
+					inv[r][c] = inv[r][c] * invDet;
+				}
+				inv[r][3] = -((inv[r][0] * m[0][3]) + (inv[r][1] * m[1][3]) + (inv[r][2] * m[2][3]));
+				inv[3][r] = F::broadcast(0.0f);
+
+				rowProduct = rowProduct * squareRoot((m[r][0] * m[r][0]) + (m[r][1] * m[r][1]) + (m[r][2] * m[r][2]));
+				columnProduct = columnProduct * squareRoot((m[0][r] * m[0][r]) + (m[1][r] * m[1][r]) + (m[2][r] * m[2][r]));
+			}
+			inv[3][3] = F::broadcast(1.0f);
+
+			storeMat44Packet(inv, count - i, out + i);
+			if (replaceSingularMat44Lanes(det, minimum(rowProduct, columnProduct), count - i, out + i) != 0) {
+				result = -1;
+			}
+		}
+	}
+};
+
+
+#endif /* MATRIX_STREAM_H */
@@ -0,0 +1,526 @@
+/**
+ * @brief  	3D and 4D gradient (Perlin) and simplex noise, and fractal sums of them
+ * 			(fBm), over the packet types of ``simd_float.h``.
+ *
+ * 			The lattice is hashed with integer operations only, and no FMA
+ * 			contraction is used, so every packet width (including the scalar
+ * 			``F32x1``) gives bit-identical results. The stream versions (in
+ * 			``simd_kernels.h``) use the widest packet type the CPU supports.
+ *
+ * 			The 4D versions are mostly useful for animating 3D noise, by passing the
+ * 			time as the fourth coordinate.
+ */
+#ifndef NOISE_H
+#define NOISE_H
+
+#include "simd_int.h"
+#include "random.h"
+#include "vector_stream.h"
+
+
+// NOTE: (sonictk) The lattice coordinates are multiplied by these large primes and
+// combined before hashing, so that neighbouring cells get unrelated hashes.
+static const uint32_t kNoisePrimeX = 501125321u;
+static const uint32_t kNoisePrimeY = 1136930381u;
+static const uint32_t kNoisePrimeZ = 1720413743u;
+static const uint32_t kNoisePrimeW = 1066037191u;
+
+// NOTE: (sonictk) These scale the raw sums to roughly ``[-1, 1]``. They were found by
+// sampling; the noise can very occasionally go slightly outside of that range.
+static const float kGradientNoise3Scale = 1.15f;
+static const float kGradientNoise4Scale = 1.2f;
+static const float kSimplexNoise3Scale = 62.0f;
+static const float kSimplexNoise4Scale = 60.0f;
+
+
+/// The quintic ``6t^5 - 15t^4 + 10t^3`` curve, which has zero first and second
+/// derivatives at ``0`` and ``1``.
+template <typename F>
+SS_FORCE_INLINE F noiseFade(F t)
+{
+	return t * t * t * (t * (t * F::broadcast(6.0f) - F::broadcast(15.0f)) + F::broadcast(10.0f));
+}
+
+template <typename F>
+SS_FORCE_INLINE F noiseLerp(F a, F b, F t)
+{
+	return a + (t * (b - a));
+}
+
+/**
+ * Returns the dot product of the gradient for a lattice point with the offset from
+ * it. The gradient components are taken from 10 bits of the hash each, and mapped
+ * to ``[-1, 1]``.
+ */
+template <typename F, typename U>
+SS_FORCE_INLINE F gradientDot(U hash, F x, F y, F z)
+{
+	const U mask = U::broadcast(0x3ff);
+	const F scale = F::broadcast(2.0f / 1023.0f);
+	const F one = F::broadcast(1.0f);
+
+	F gx = (convertToFloat(hash & mask) * scale) - one;
+	F gy = (convertToFloat(shiftRight<10>(hash) & mask) * scale) - one;
+	F gz = (convertToFloat(shiftRight<20>(hash) & mask) * scale) - one;
+
+	return (gx * x) + (gy * y) + (gz * z);
+}
+
+/// The 4D version of ``gradientDot``, with 8 bits of the hash per component.
+template <typename F, typename U>
+SS_FORCE_INLINE F gradientDot(U hash, F x, F y, F z, F w)
+{
+	const U mask = U::broadcast(0xff);
+	const F scale = F::broadcast(2.0f / 255.0f);
+	const F one = F::broadcast(1.0f);
+
+	F gx = (convertToFloat(hash & mask) * scale) - one;
+	F gy = (convertToFloat(shiftRight<8>(hash) & mask) * scale) - one;
+	F gz = (convertToFloat(shiftRight<16>(hash) & mask) * scale) - one;
+	F gw = (convertToFloat(shiftRight<24>(hash)) * scale) - one;
+
+	return (gx * x) + (gy * y) + (gz * z) + (gw * w);
+}
+
+/**
+ * Interpolates the values at the corners of a lattice cell. Bit ``d`` of the index
+ * of a corner is its offset along axis ``d``. The values are overwritten.
+ */
+template <int dimensions, typename F>
+SS_FORCE_INLINE F interpolateCorners(F *values, const F *fades)
+{
+	int count = 1 << dimensions;
+	for (int d=0; d < dimensions; ++d) {
+		count >>= 1;
+		for (int i=0; i < count; ++i) {
+			values[i] = noiseLerp(values[2 * i], values[(2 * i) + 1], fades[d]);
+		}
+	}
+
+	return values[0];
+}
+
+
+/**
+ * Evaluates 3D gradient noise at every element.
+ *
+ * @param x		The coordinates. They must be within ``[-2^31, 2^31)``, and are
+ * 				only accurate for magnitudes well below ``2^24``.
+ * @param y		See ``x``.
+ * @param z		See ``x``.
+ * @param seed		Different seeds give unrelated noise.
+ *
+ * @return			The noise, in roughly ``[-1, 1]``.
+ */
+template <typename F>
+SS_FORCE_INLINE F gradientNoise(F x, F y, F z, typename SIMDIntType<F>::Type seed)
+{
+	typedef typename SIMDIntType<F>::Type U;
+
+	const F one = F::broadcast(1.0f);
+	const U primeX = U::broadcast(kNoisePrimeX);
+	const U primeY = U::broadcast(kNoisePrimeY);
+	const U primeZ = U::broadcast(kNoisePrimeZ);
+
+	U ix = floorToInt(x);
+	U iy = floorToInt(y);
+	U iz = floorToInt(z);
+
+	// NOTE: (sonictk) The offsets from, and the hashed coordinates of, the lower and
+	// upper lattice points along each axis.
+	F dx[2], dy[2], dz[2];
+	dx[0] = x - convertToFloat(ix);
+	dy[0] = y - convertToFloat(iy);
+	dz[0] = z - convertToFloat(iz);
+	dx[1] = dx[0] - one;
+	dy[1] = dy[0] - one;
+	dz[1] = dz[0] - one;
+
+	U hx[2], hy[2], hz[2];
+	hx[0] = ix * primeX;
+	hy[0] = iy * primeY;
+	hz[0] = iz * primeZ;
+	hx[1] = hx[0] + primeX;
+	hy[1] = hy[0] + primeY;
+	hz[1] = hz[0] + primeZ;
+
+	F values[8];
+	for (int c=0; c < 8; ++c) {
+		int ox = c & 1, oy = (c >> 1) & 1, oz = (c >> 2) & 1;
+		U hash = hashUInt32(seed ^ hx[ox] ^ hy[oy] ^ hz[oz]);
+		values[c] = gradientDot(hash, dx[ox], dy[oy], dz[oz]);
+	}
+
+	F fades[3] = {noiseFade(dx[0]), noiseFade(dy[0]), noiseFade(dz[0])};
+
+	return interpolateCorners<3>(values, fades) * F::broadcast(kGradientNoise3Scale);
+}
+
+/// The 4D version of ``gradientNoise``.
+template <typename F>
+SS_FORCE_INLINE F gradientNoise(F x, F y, F z, F w, typename SIMDIntType<F>::Type seed)
+{
+	typedef typename SIMDIntType<F>::Type U;
+
+	const F one = F::broadcast(1.0f);
+	const U primeX = U::broadcast(kNoisePrimeX);
+	const U primeY = U::broadcast(kNoisePrimeY);
+	const U primeZ = U::broadcast(kNoisePrimeZ);
+	const U primeW = U::broadcast(kNoisePrimeW);
+
+	U ix = floorToInt(x);
+	U iy = floorToInt(y);
+	U iz = floorToInt(z);
+	U iw = floorToInt(w);
+
+	F dx[2], dy[2], dz[2], dw[2];
+	dx[0] = x - convertToFloat(ix);
+	dy[0] = y - convertToFloat(iy);
+	dz[0] = z - convertToFloat(iz);
+	dw[0] = w - convertToFloat(iw);
+	dx[1] = dx[0] - one;
+	dy[1] = dy[0] - one;
+	dz[1] = dz[0] - one;
+	dw[1] = dw[0] - one;
+
+	U hx[2], hy[2], hz[2], hw[2];
+	hx[0] = ix * primeX;
+	hy[0] = iy * primeY;
+	hz[0] = iz * primeZ;
+	hw[0] = iw * primeW;
+	hx[1] = hx[0] + primeX;
+	hy[1] = hy[0] + primeY;
+	hz[1] = hz[0] + primeZ;
+	hw[1] = hw[0] + primeW;
+
+	F values[16];
+	for (int c=0; c < 16; ++c) {
+		int ox = c & 1, oy = (c >> 1) & 1, oz = (c >> 2) & 1, ow = (c >> 3) & 1;
+		U hash = hashUInt32(seed ^ hx[ox] ^ hy[oy] ^ hz[oz] ^ hw[ow]);
+		values[c] = gradientDot(hash, dx[ox], dy[oy], dz[oz], dw[ow]);
+	}
+
+	F fades[4] = {noiseFade(dx[0]), noiseFade(dy[0]), noiseFade(dz[0]), noiseFade(dw[0])};
+
+	return interpolateCorners<4>(values, fades) * F::broadcast(kGradientNoise4Scale);
+}
+
+
+/// Returns ``1`` in the elements where ``a > b``, and ``0`` elsewhere.
+template <typename F>
+SS_FORCE_INLINE typename SIMDIntType<F>::Type greaterThanBit(F a, F b)
+{
+	return shiftRight<31>(lessThan(b, a));
+}
+
+/// Returns ``1`` in the elements where ``rank >= threshold``, and ``0`` elsewhere.
+/// ``threshold`` must be at least ``1``, and the ranks must be small.
+template <typename U>
+SS_FORCE_INLINE U rankAtLeast(U rank, uint32_t threshold)
+{
+	return shiftRight<31>(U::broadcast(threshold - 1) - rank);
+}
+
+/// The falloff of a simplex corner's contribution, ``max(0.5 - d^2, 0)^4``.
+template <typename F>
+SS_FORCE_INLINE F simplexFalloff(F distanceSquared)
+{
+	F t = maximum(F::broadcast(0.5f) - distanceSquared, F::broadcast(0.0f));
+	t = t * t;
+
+	return t * t;
+}
+
+
+/**
+ * Evaluates 3D simplex noise at every element. This is cheaper than
+ * ``gradientNoise`` (4 corners instead of 8) and has fewer axis-aligned artifacts.
+ * See ``gradientNoise`` for the parameters.
+ *
+ * @return			The noise, in roughly ``[-1, 1]``.
+ */
+template <typename F>
+SS_FORCE_INLINE F simplexNoise(F x, F y, F z, typename SIMDIntType<F>::Type seed)
+{
+	typedef typename SIMDIntType<F>::Type U;
+
+	const F skew = F::broadcast(1.0f / 3.0f);
+	const F unskew = F::broadcast(1.0f / 6.0f);
+	const U one = U::broadcast(1);
+	const U zero = U::broadcast(0);
+
+	// NOTE: (sonictk) Skew the space so that the simplices become cubes, find the
+	// cube, and then the offsets from its origin in the unskewed space.
+	F s = (x + y + z) * skew;
+	U i = floorToInt(x + s);
+	U j = floorToInt(y + s);
+	U k = floorToInt(z + s);
+	F t = convertToFloat(i + j + k) * unskew;
+	F x0 = x - (convertToFloat(i) - t);
+	F y0 = y - (convertToFloat(j) - t);
+	F z0 = z - (convertToFloat(k) - t);
+
+	// NOTE: (sonictk) The simplex is found by ranking the offsets: the corners step
+	// along the axis with the largest offset first. Each pair of axes is compared
+	// once, so that ties still give every axis a distinct rank.
+	U xy = greaterThanBit(x0, y0);
+	U xz = greaterThanBit(x0, z0);
+	U yz = greaterThanBit(y0, z0);
+	U rankX = xy + xz;
+	U rankY = (one - xy) + yz;
+	U rankZ = (one - xz) + (one - yz);
+
+	U hi = i * U::broadcast(kNoisePrimeX);
+	U hj = j * U::broadcast(kNoisePrimeY);
+	U hk = k * U::broadcast(kNoisePrimeZ);
+
+	F result = F::broadcast(0.0f);
+	for (int corner=0; corner < 4; ++corner) {
+		U ox = corner == 0 ? zero : (corner == 3 ? one : rankAtLeast(rankX, 3 - corner));
+		U oy = corner == 0 ? zero : (corner == 3 ? one : rankAtLeast(rankY, 3 - corner));
+		U oz = corner == 0 ? zero : (corner == 3 ? one : rankAtLeast(rankZ, 3 - corner));
+
+		F cornerUnskew = F::broadcast((float)corner * (1.0f / 6.0f));
+		F cx = x0 - convertToFloat(ox) + cornerUnskew;
+		F cy = y0 - convertToFloat(oy) + cornerUnskew;
+		F cz = z0 - convertToFloat(oz) + cornerUnskew;
+
+		// NOTE: (sonictk) The offsets are ``0`` or ``1``, so negating them gives a
+		// mask for adding the prime instead of needing another multiply.
+		U hash = hashUInt32(seed
+							^ (hi + ((zero - ox) & U::broadcast(kNoisePrimeX)))
+							^ (hj + ((zero - oy) & U::broadcast(kNoisePrimeY)))
+							^ (hk + ((zero - oz) & U::broadcast(kNoisePrimeZ))));
+
+		F falloff = simplexFalloff((cx * cx) + (cy * cy) + (cz * cz));
+		result = result + (falloff * gradientDot(hash, cx, cy, cz));
+	}
+
+	return result * F::broadcast(kSimplexNoise3Scale);
+}
+
+/// The 4D version of ``simplexNoise``.
+template <typename F>
+SS_FORCE_INLINE F simplexNoise(F x, F y, F z, F w, typename SIMDIntType<F>::Type seed)
+{
+	typedef typename SIMDIntType<F>::Type U;
+
+	// NOTE: (sonictk) ``(sqrt(5) - 1) / 4`` and ``(5 - sqrt(5)) / 20``.
+	const float unskewFactor = 0.138196601125010504f;
+	const F skew = F::broadcast(0.309016994374947424f);
+	const F unskew = F::broadcast(unskewFactor);
+	const U one = U::broadcast(1);
+	const U zero = U::broadcast(0);
+
+	F s = (x + y + z + w) * skew;
+	U i = floorToInt(x + s);
+	U j = floorToInt(y + s);
+	U k = floorToInt(z + s);
+	U l = floorToInt(w + s);
+	F t = convertToFloat(i + j + k + l) * unskew;
+	F x0 = x - (convertToFloat(i) - t);
+	F y0 = y - (convertToFloat(j) - t);
+	F z0 = z - (convertToFloat(k) - t);
+	F w0 = w - (convertToFloat(l) - t);
+
+	U xy = greaterThanBit(x0, y0);
+	U xz = greaterThanBit(x0, z0);
+	U xw = greaterThanBit(x0, w0);
+	U yz = greaterThanBit(y0, z0);
+	U yw = greaterThanBit(y0, w0);
+	U zw = greaterThanBit(z0, w0);
+	U rankX = xy + xz + xw;
+	U rankY = (one - xy) + yz + yw;
+	U rankZ = (one - xz) + (one - yz) + zw;
+	U rankW = (one - xw) + (one - yw) + (one - zw);
+
+	U hi = i * U::broadcast(kNoisePrimeX);
+	U hj = j * U::broadcast(kNoisePrimeY);
+	U hk = k * U::broadcast(kNoisePrimeZ);
+	U hl = l * U::broadcast(kNoisePrimeW);
+
+	F result = F::broadcast(0.0f);
+	for (int corner=0; corner < 5; ++corner) {
+		U ox = corner == 0 ? zero : (corner == 4 ? one : rankAtLeast(rankX, 4 - corner));
+		U oy = corner == 0 ? zero : (corner == 4 ? one : rankAtLeast(rankY, 4 - corner));
+		U oz = corner == 0 ? zero : (corner == 4 ? one : rankAtLeast(rankZ, 4 - corner));
+		U ow = corner == 0 ? zero : (corner == 4 ? one : rankAtLeast(rankW, 4 - corner));
+
+		F cornerUnskew = F::broadcast((float)corner * unskewFactor);
+		F cx = x0 - convertToFloat(ox) + cornerUnskew;
+		F cy = y0 - convertToFloat(oy) + cornerUnskew;
+		F cz = z0 - convertToFloat(oz) + cornerUnskew;
+		F cw = w0 - convertToFloat(ow) + cornerUnskew;
+
+		U hash = hashUInt32(seed
+							^ (hi + ((zero - ox) & U::broadcast(kNoisePrimeX)))
+							^ (hj + ((zero - oy) & U::broadcast(kNoisePrimeY)))
+							^ (hk + ((zero - oz) & U::broadcast(kNoisePrimeZ)))
+							^ (hl + ((zero - ow) & U::broadcast(kNoisePrimeW))));
+
+		F falloff = simplexFalloff((cx * cx) + (cy * cy) + (cz * cz) + (cw * cw));
+		result = result + (falloff * gradientDot(hash, cx, cy, cz, cw));
+	}
+
+	return result * F::broadcast(kSimplexNoise4Scale);
+}
+
+
+/// Wrappers so that the fractal sums and the stream kernels can take the kind of
+/// noise as a template parameter.
+struct GradientNoiseFunction
+{
+	template <typename F, typename U>
+	static SS_FORCE_INLINE F evaluate(F x, F y, F z, U seed) { return gradientNoise(x, y, z, seed); }
+
+	template <typename F, typename U>
+	static SS_FORCE_INLINE F evaluate(F x, F y, F z, F w, U seed) { return gradientNoise(x, y, z, w, seed); }
+};
+
+struct SimplexNoiseFunction
+{
+	template <typename F, typename U>
+	static SS_FORCE_INLINE F evaluate(F x, F y, F z, U seed) { return simplexNoise(x, y, z, seed); }
+
+	template <typename F, typename U>
+	static SS_FORCE_INLINE F evaluate(F x, F y, F z, F w, U seed) { return simplexNoise(x, y, z, w, seed); }
+};
+
+
+enum NoiseType
+{
+	NoiseType_Gradient,
+	NoiseType_Simplex,
+
+	NoiseType_Count
+};
+
+/// The parameters of a fractal sum of noise. Use ``noiseSettings`` to get the
+/// defaults.
+struct NoiseSettings
+{
+	NoiseType type;
+	uint32_t seed;
+
+	unsigned int octaves;	/// The number of layers of noise that are summed.
+	float frequency;		/// The frequency of the first octave.
+	float lacunarity;		/// How much the frequency is multiplied by for each octave.
+	float gain;			/// How much the amplitude is multiplied by for each octave.
+};
+
+/// Returns the settings for a single octave of noise with a frequency of ``1``.
+/// The usual fractal settings are a lacunarity of ``2`` and a gain of ``0.5``.
+inline NoiseSettings noiseSettings(NoiseType type, uint32_t seed)
+{
+	NoiseSettings settings;
+	settings.type = type;
+	settings.seed = seed;
+	settings.octaves = 1;
+	settings.frequency = 1.0f;
+	settings.lacunarity = 2.0f;
+	settings.gain = 0.5f;
+
+	return settings;
+}
+
+
+/**
+ * Evaluates a fractal sum of noise (fBm) at every element. Each octave uses a
+ * different seed. The sum is divided by the total amplitude of the octaves, so it
+ * stays in the same range as a single octave.
+ */
+template <class Noise, typename F>
+SS_FORCE_INLINE F fractalNoise(F x, F y, F z, const NoiseSettings &settings)
+{
+	typedef typename SIMDIntType<F>::Type U;
+
+	F result = F::broadcast(0.0f);
+	float frequency = settings.frequency;
+	float amplitude = 1.0f;
+	float totalAmplitude = 0.0f;
+	for (unsigned int octave=0; octave < settings.octaves; ++octave) {
+		F f = F::broadcast(frequency);
+		U seed = U::broadcast(settings.seed + octave);
+		result = result + (Noise::evaluate(x * f, y * f, z * f, seed) * F::broadcast(amplitude));
+
+		totalAmplitude += amplitude;
+		frequency *= settings.lacunarity;
+		amplitude *= settings.gain;
+	}
+
+	return result * F::broadcast(1.0f / totalAmplitude);
+}
+
+/// The 4D version of ``fractalNoise``. ``w`` is not scaled by the frequency, so
+/// that it can be used directly as the time.
+template <class Noise, typename F>
+SS_FORCE_INLINE F fractalNoise(F x, F y, F z, F w, const NoiseSettings &settings)
+{
+	typedef typename SIMDIntType<F>::Type U;
+
+	F result = F::broadcast(0.0f);
+	float frequency = settings.frequency;
+	float amplitude = 1.0f;
+	float totalAmplitude = 0.0f;
+	for (unsigned int octave=0; octave < settings.octaves; ++octave) {
+		F f = F::broadcast(frequency);
+		U seed = U::broadcast(settings.seed + octave);
+		result = result + (Noise::evaluate(x * f, y * f, z * f, w, seed) * F::broadcast(amplitude));
+
+		totalAmplitude += amplitude;
+		frequency *= settings.lacunarity;
+		amplitude *= settings.gain;
+	}
+
+	return result * F::broadcast(1.0f / totalAmplitude);
+}
+
+
+template <class Noise>
+struct NoiseStreamKernel
+{
+	template <typename F>
+	static SS_FORCE_INLINE void run(const Vec3Stream &points, const NoiseSettings &settings, FloatStream &out)
+	{
+		for (unsigned int i=0; i < points.count; i += F::width) {
+			Vec3Packet<F> p = loadVec3Packet<F>(points, i);
+			fractalNoise<Noise>(p.x, p.y, p.z, settings).store(out.e + i);
+		}
+	}
+
+	template <typename F>
+	static SS_FORCE_INLINE void run(const Vec3Stream &points, float w, const NoiseSettings &settings, FloatStream &out)
+	{
+		F time = F::broadcast(w);
+		for (unsigned int i=0; i < points.count; i += F::width) {
+			Vec3Packet<F> p = loadVec3Packet<F>(points, i);
+			fractalNoise<Noise>(p.x, p.y, p.z, time, settings).store(out.e + i);
+		}
+	}
+};
+
+
+/// Scalar versions, for evaluating the noise at a single point. These give the same
+/// values as the packet versions.
+inline float gradientNoise(float x, float y, float z, uint32_t seed)
+{
+	return gradientNoise(F32x1::broadcast(x), F32x1::broadcast(y), F32x1::broadcast(z), U32x1::broadcast(seed)).v;
+}
+
+inline float gradientNoise(float x, float y, float z, float w, uint32_t seed)
+{
+	return gradientNoise(F32x1::broadcast(x), F32x1::broadcast(y), F32x1::broadcast(z), F32x1::broadcast(w), U32x1::broadcast(seed)).v;
+}
+
+inline float simplexNoise(float x, float y, float z, uint32_t seed)
+{
+	return simplexNoise(F32x1::broadcast(x), F32x1::broadcast(y), F32x1::broadcast(z), U32x1::broadcast(seed)).v;
+}
+
+inline float simplexNoise(float x, float y, float z, float w, uint32_t seed)
+{
+	return simplexNoise(F32x1::broadcast(x), F32x1::broadcast(y), F32x1::broadcast(z), F32x1::broadcast(w), U32x1::broadcast(seed)).v;
+}
+
+
+#endif /* NOISE_H */
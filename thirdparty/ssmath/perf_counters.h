@@ -0,0 +1,190 @@
+/**
+ * @brief  	Hardware performance counters for the calling thread, read through
+ * 			``perf_event_open`` on Linux. They are not available on other platforms,
+ * 			where opening them always fails.
+ *
+ * 			All the counters are opened as a single group, so that they are always
+ * 			scheduled onto the PMU together and can be compared with each other.
+ * 			Only user-space events are counted, which also lets them be opened
+ * 			with the default ``perf_event_paranoid`` setting of ``2``.
+ *
+ * 			Reading the counters is a system call, which takes around a microsecond,
+ * 			so they should be read around work that takes considerably longer.
+ */
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif // __linux__
+
+
+enum PerfCounter
+{
+	PerfCounter_Cycles = 0,
+	PerfCounter_Instructions,
+	PerfCounter_CacheMisses,
+	PerfCounter_BranchMisses,
+	PerfCounter_Count
+};
+
+
+/// A group of counters for a single thread.
+struct PerfCounterGroup
+{
+	int fds[PerfCounter_Count];
+	bool isValid;
+};
+
+
+/// A reading of every counter in a group.
+struct PerfCounterValues
+{
+	uint64_t values[PerfCounter_Count];
+};
+
+
+#ifdef __linux__
+
+/// The hardware events that each counter counts.
+static const uint64_t kPerfCounterConfigs[PerfCounter_Count] = {
+	PERF_COUNT_HW_CPU_CYCLES,
+	PERF_COUNT_HW_INSTRUCTIONS,
+	PERF_COUNT_HW_CACHE_MISSES,
+	PERF_COUNT_HW_BRANCH_MISSES
+};
+
+/**
+ * Opens and starts the counters for the calling thread. They only count events
+ * that happen on that thread, and must only be read from it.
+ *
+ * @param group	The group to open.
+ *
+ * @return			``0`` on success, ``-1`` if the counters are not available (e.g. in
+ * 				a virtual machine without a virtual PMU, or if they are
+ * 				restricted by ``perf_event_paranoid``).
+ */
+inline int openPerfCounterGroup(PerfCounterGroup &group)
+{
+	group.isValid = false;
+	for (int i=0; i < PerfCounter_Count; ++i) {
+		group.fds[i] = -1;
+	}
+
+	for (int i=0; i < PerfCounter_Count; ++i) {
+		perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.size = sizeof(attr);
+		attr.config = kPerfCounterConfigs[i];
+		attr.read_format = PERF_FORMAT_GROUP;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		// NOTE: (sonictk) The group is started all at once by enabling its leader.
+		attr.disabled = i == 0 ? 1 : 0;
+
+		int groupFD = i == 0 ? -1 : group.fds[0];
+		int fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, groupFD, 0);
+		if (fd < 0) {
+			for (int j=0; j < i; ++j) {
+				close(group.fds[j]);
+				group.fds[j] = -1;
+			}
+			return -1;
+		}
+		group.fds[i] = fd;
+	}
+
+	if (ioctl(group.fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP) != 0) {
+		for (int i=0; i < PerfCounter_Count; ++i) {
+			close(group.fds[i]);
+			group.fds[i] = -1;
+		}
+		return -1;
+	}
+	group.isValid = true;
+
+	return 0;
+}
+
+/**
+ * Reads the current values of the counters. The values only increase, so the
+ * events counted over some work are the difference of readings before and after it.
+ *
+ * @param group	The group to read. Must be read from the thread that opened it.
+ * @param values	Set to the values of the counters.
+ *
+ * @return			``0`` on success, ``-1`` if the group could not be read.
+ */
+inline int readPerfCounterGroup(const PerfCounterGroup &group, PerfCounterValues &values)
+{
+	if (!group.isValid) {
+		return -1;
+	}
+
+	uint64_t buffer[1 + PerfCounter_Count];
+	ssize_t bytesRead = read(group.fds[0], buffer, sizeof(buffer));
+	if (bytesRead != (ssize_t)sizeof(buffer) || buffer[0] != PerfCounter_Count) {
+		return -1;
+	}
+	for (int i=0; i < PerfCounter_Count; ++i) {
+		values.values[i] = buffer[1 + i];
+	}
+
+	return 0;
+}
+
+inline void closePerfCounterGroup(PerfCounterGroup &group)
+{
+	for (int i=0; i < PerfCounter_Count; ++i) {
+		if (group.fds[i] >= 0) {
+			close(group.fds[i]);
+		}
+		group.fds[i] = -1;
+	}
+	group.isValid = false;
+}
+
+#else
+
+inline int openPerfCounterGroup(PerfCounterGroup &group)
+{
+	for (int i=0; i < PerfCounter_Count; ++i) {
+		group.fds[i] = -1;
+	}
+	group.isValid = false;
+
+	return -1;
+}
+
+inline int readPerfCounterGroup(const PerfCounterGroup &group, PerfCounterValues &values)
+{
+	return -1;
+}
+
+inline void closePerfCounterGroup(PerfCounterGroup &group)
+{
+	group.isValid = false;
+}
+
+#endif // __linux__
+
+
+/// Adds the events counted between two readings to a running total.
+inline void accumulatePerfCounters(PerfCounterValues &total,
+								   const PerfCounterValues &start,
+								   const PerfCounterValues &end)
+{
+	for (int i=0; i < PerfCounter_Count; ++i) {
+		total.values[i] += end.values[i] - start.values[i];
+	}
+}
+
+
+#endif /* PERF_COUNTERS_H */
@@ -139,6 +139,7 @@ globalVar const char kUnixPathSeparator = '/';
 #ifndef PLATFORM_LEAN
 
 #include "timer.h"		// NOTE: (yliangsiew) On linux, requires C++11 support
+#include "profiler.h"	// NOTE: (sonictk) Requires C++11 support
 #include "library.h" 	// NOTE: (yliangsiew) Requires linking with ``dl`` on Linux
 #include "filesys.h" 	// NOTE: (yliangsiew) Requires linking with ``Shlwapi.dll`` on Windows
 
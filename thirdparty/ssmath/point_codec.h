@@ -0,0 +1,607 @@
+/**
+ * @brief  	A lossy codec for caches of animated point positions.
+ *
+ * 			The points are split into chunks of ``kPointCacheChunkSize``. On every
+ * 			keyframe, each chunk's positions are quantized to a grid with a spacing
+ * 			of twice the error bound, starting from the minimum of the chunk's
+ * 			bounding box. On the frames in between, only the differences of the
+ * 			quantized positions from the previous frame are stored. Since the
+ * 			differences are exact integers, the error never accumulates: every
+ * 			decoded coordinate is within the error bound of the original, plus a
+ * 			few ULPs of the coordinate from the float arithmetic.
+ *
+ * 			The values of each chunk and axis are packed with just enough bits for
+ * 			the largest of them, in a layout that lets whole packets of values be
+ * 			unpacked at once: value ``i`` of a chunk is in lane ``i % 16``, and each
+ * 			lane's values are packed one after the other into every 16th word.
+ * 			Decoding (``decodePointCacheFrame`` in ``simd_kernels.h``) uses the
+ * 			widest packet type the CPU supports, and gives the same results at every
+ * 			width.
+ */
+#ifndef POINT_CODEC_H
+#define POINT_CODEC_H
+
+#include "simd_int.h"
+#include "vector_stream.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+
+/// The number of lanes that the packed values are interleaved over. This is the
+/// width of the widest packet type, so that every packet type can unpack them.
+static const unsigned int kPointCacheLanes = 16;
+
+/// The number of points in each chunk, which share a bounding box and bit widths.
+static const unsigned int kPointCacheChunkSize = kPointCacheLanes * 16;
+
+
+struct PointCacheSettings
+{
+	float errorBound;				/// The largest error allowed in any coordinate.
+	unsigned int keyframeInterval;	/// The number of frames between keyframes.
+};
+
+/// Returns the default settings for the given error bound. Keyframes are the most
+/// expensive frames to store, but also limit how far back decoding has to start
+/// from when jumping to a frame.
+inline PointCacheSettings pointCacheSettings(float errorBound)
+{
+	PointCacheSettings settings;
+	settings.errorBound = errorBound;
+	settings.keyframeInterval = 32;
+
+	return settings;
+}
+
+/// An encoded cache. Frames are appended with ``appendPointCacheFrame``, and read
+/// back through a ``PointCacheDecoder``.
+struct PointCache
+{
+	unsigned int numPoints;
+	unsigned int numChunks;
+	unsigned int numFrames;
+	unsigned int keyframeInterval;
+	float step;
+
+	uint32_t *words;			/// The encoded frames, one after the other.
+	size_t numWords;
+	size_t wordCapacity;
+
+	size_t *frameOffsets;		/// The offset into ``words`` of each frame.
+	unsigned int frameCapacity;
+
+	// NOTE: (sonictk) The encoder's state: the quantized positions of the last frame
+	// for every axis, and the origin of every chunk's grid since the last keyframe.
+	uint32_t *quantized;
+	float *origins;
+};
+
+/// The state needed to decode the frames of a ``PointCache``. It remembers the last
+/// decoded frame, so that playing forwards only has to apply one frame of deltas.
+struct PointCacheDecoder
+{
+	unsigned int numChunks;
+	int frame;					/// The last frame decoded, or ``-1``.
+
+	uint32_t *quantized;
+	float *origins;
+};
+
+
+/// The number of 16-point slots that are used in the given chunk; only the last
+/// chunk can have fewer than 16.
+inline unsigned int getPointCacheChunkSlots(unsigned int numPoints, unsigned int chunk)
+{
+	unsigned int count = numPoints - (chunk * kPointCacheChunkSize);
+	if (count > kPointCacheChunkSize) {
+		count = kPointCacheChunkSize;
+	}
+
+	return (count + kPointCacheLanes - 1) / kPointCacheLanes;
+}
+
+/// The number of words each lane needs for ``slots`` values of ``bits`` bits.
+inline unsigned int getPointCacheWordsPerLane(unsigned int slots, unsigned int bits)
+{
+	return ((slots * bits) + 31) / 32;
+}
+
+
+/**
+ * Creates an empty cache. The cache must have been zero-initialized or freed with
+ * ``freePointCache``.
+ *
+ * @param cache		The cache to create.
+ * @param numPoints	The number of points in every frame.
+ * @param settings		The error bound and keyframe interval.
+ *
+ * @return				``0`` on success, a negative value if the settings are invalid
+ * 					or the allocation failed.
+ */
+inline int createPointCache(PointCache &cache, unsigned int numPoints, const PointCacheSettings &settings)
+{
+	if (!(settings.errorBound > 0.0f) || settings.keyframeInterval == 0) {
+		return -1;
+	}
+
+	cache.numPoints = numPoints;
+	cache.numChunks = (numPoints + kPointCacheChunkSize - 1) / kPointCacheChunkSize;
+	cache.numFrames = 0;
+	cache.keyframeInterval = settings.keyframeInterval;
+	cache.step = settings.errorBound * 2.0f;
+
+	cache.words = NULL;
+	cache.numWords = cache.wordCapacity = 0;
+	cache.frameOffsets = NULL;
+	cache.frameCapacity = 0;
+
+	size_t numValues = (size_t)cache.numChunks * kPointCacheChunkSize * 3;
+	cache.quantized = (uint32_t *)calloc(numValues > 0 ? numValues : 1, sizeof(uint32_t));
+	cache.origins = (float *)calloc(cache.numChunks > 0 ? cache.numChunks * 3 : 1, sizeof(float));
+	if (!cache.quantized || !cache.origins) {
+		free(cache.quantized);
+		free(cache.origins);
+		cache.quantized = NULL;
+		cache.origins = NULL;
+		return -1;
+	}
+
+	return 0;
+}
+
+inline void freePointCache(PointCache &cache)
+{
+	free(cache.words);
+	free(cache.frameOffsets);
+	free(cache.quantized);
+	free(cache.origins);
+	memset(&cache, 0, sizeof(cache));
+}
+
+
+/// The number of bits needed to store ``value``.
+inline unsigned int getBitWidth(uint32_t value)
+{
+	unsigned int bits = 0;
+	while (value) {
+		++bits;
+		value >>= 1;
+	}
+
+	return bits;
+}
+
+/// Quantizes a coordinate to the grid of the given origin and spacing. Returns
+/// ``false`` if it is too far from the origin to be stored exactly.
+inline bool quantizePointCacheValue(float value, float origin, float step, int32_t &quantized)
+{
+	float scaled = floorf(((value - origin) / step) + 0.5f);
+
+	// NOTE: (sonictk) Past ``2^24``, the grid points can no longer be represented
+	// exactly as floats when decoding. This also rejects NaNs.
+	if (!(fabsf(scaled) < 16777216.0f)) {
+		return false;
+	}
+	quantized = (int32_t)scaled;
+
+	return true;
+}
+
+
+/**
+ * Encodes a frame and appends it to the cache.
+ *
+ * @param cache		The cache to append to.
+ * @param positions	The positions of all of the points in this frame.
+ *
+ * @return				``0`` on success, a negative value if the number of points does
+ * 					not match the cache, a position is not finite or is too far
+ * 					from its chunk's keyframe bounding box for the error bound,
+ * 					or the allocation failed. The cache is unchanged on failure.
+ */
+inline int appendPointCacheFrame(PointCache &cache, const Vec3Stream &positions)
+{
+	if (positions.count != cache.numPoints || !cache.quantized) {
+		return -1;
+	}
+
+	const float *axes[3] = {positions.x, positions.y, positions.z};
+	const bool isKeyframe = cache.numFrames % cache.keyframeInterval == 0;
+	const size_t valuesPerAxis = (size_t)cache.numChunks * kPointCacheChunkSize;
+
+	// NOTE: (sonictk) Check that every position can be encoded before touching the
+	// encoder's state, so that a failure leaves the cache as it was.
+	for (unsigned int chunk=0; chunk < cache.numChunks; ++chunk) {
+		unsigned int start = chunk * kPointCacheChunkSize;
+		unsigned int end = start + kPointCacheChunkSize < cache.numPoints ? start + kPointCacheChunkSize : cache.numPoints;
+		for (int axis=0; axis < 3; ++axis) {
+			float origin = cache.origins[(axis * cache.numChunks) + chunk];
+			if (isKeyframe) {
+				origin = axes[axis][start];
+				for (unsigned int i=start + 1; i < end; ++i) {
+					origin = axes[axis][i] < origin ? axes[axis][i] : origin;
+				}
+			}
+
+			int32_t quantized;
+			for (unsigned int i=start; i < end; ++i) {
+				if (!quantizePointCacheValue(axes[axis][i], origin, cache.step, quantized)) {
+					return -1;
+				}
+			}
+		}
+	}
+
+	// NOTE: (sonictk) The most a frame can take is a full 32 bits per value, plus the
+	// origins and the bit widths of each chunk.
+	size_t maxFrameWords = (size_t)cache.numChunks * (4 + (3 * kPointCacheChunkSize));
+	if (cache.numWords + maxFrameWords > cache.wordCapacity) {
+		size_t capacity = cache.wordCapacity * 2;
+		if (capacity < cache.numWords + maxFrameWords) {
+			capacity = cache.numWords + maxFrameWords;
+		}
+		uint32_t *words = (uint32_t *)realloc(cache.words, capacity * sizeof(uint32_t));
+		if (!words) {
+			return -1;
+		}
+		cache.words = words;
+		cache.wordCapacity = capacity;
+	}
+	if (cache.numFrames == cache.frameCapacity) {
+		unsigned int capacity = cache.frameCapacity > 0 ? cache.frameCapacity * 2 : 64;
+		size_t *offsets = (size_t *)realloc(cache.frameOffsets, capacity * sizeof(size_t));
+		if (!offsets) {
+			return -1;
+		}
+		cache.frameOffsets = offsets;
+		cache.frameCapacity = capacity;
+	}
+
+	cache.frameOffsets[cache.numFrames] = cache.numWords;
+	uint32_t *out = cache.words + cache.numWords;
+
+	uint32_t values[3][kPointCacheChunkSize];
+	for (unsigned int chunk=0; chunk < cache.numChunks; ++chunk) {
+		unsigned int start = chunk * kPointCacheChunkSize;
+		unsigned int count = cache.numPoints - start < kPointCacheChunkSize ? cache.numPoints - start : kPointCacheChunkSize;
+		unsigned int slots = getPointCacheChunkSlots(cache.numPoints, chunk);
+
+		unsigned int bits[3];
+		for (int axis=0; axis < 3; ++axis) {
+			const float *p = axes[axis] + start;
+			float &origin = cache.origins[(axis * cache.numChunks) + chunk];
+			uint32_t *previous = cache.quantized + (axis * valuesPerAxis) + start;
+
+			if (isKeyframe) {
+				origin = p[0];
+				for (unsigned int i=1; i < count; ++i) {
+					origin = p[i] < origin ? p[i] : origin;
+				}
+			}
+
+			uint32_t combined = 0;
+			for (unsigned int i=0; i < slots * kPointCacheLanes; ++i) {
+				uint32_t value = 0;
+				if (i < count) {
+					int32_t quantized = 0;
+					quantizePointCacheValue(p[i], origin, cache.step, quantized);
+
+					if (isKeyframe) {
+						value = (uint32_t)quantized;
+					} else {
+						// NOTE: (sonictk) Zigzag-encode the delta, so that small negative
+						// deltas also only need a few bits.
+						int32_t delta = (int32_t)((uint32_t)quantized - previous[i]);
+						value = ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31);
+					}
+					previous[i] = (uint32_t)quantized;
+				}
+				values[axis][i] = value;
+				combined |= value;
+			}
+			bits[axis] = getBitWidth(combined);
+		}
+
+		if (isKeyframe) {
+			for (int axis=0; axis < 3; ++axis) {
+				memcpy(out++, &cache.origins[(axis * cache.numChunks) + chunk], sizeof(uint32_t));
+			}
+		}
+		*out++ = bits[0] | (bits[1] << 8) | (bits[2] << 16);
+
+		for (int axis=0; axis < 3; ++axis) {
+			unsigned int b = bits[axis];
+			unsigned int numWords = getPointCacheWordsPerLane(slots, b) * kPointCacheLanes;
+			memset(out, 0, numWords * sizeof(uint32_t));
+
+			for (unsigned int i=0; i < slots * kPointCacheLanes; ++i) {
+				unsigned int lane = i % kPointCacheLanes;
+				unsigned int bitOffset = (i / kPointCacheLanes) * b;
+				unsigned int word = bitOffset / 32;
+				unsigned int shift = bitOffset % 32;
+
+				out[(word * kPointCacheLanes) + lane] |= values[axis][i] << shift;
+				if (shift + b > 32) {
+					out[((word + 1) * kPointCacheLanes) + lane] |= values[axis][i] >> (32 - shift);
+				}
+			}
+			out += numWords;
+		}
+	}
+
+	cache.numWords = out - cache.words;
+	++cache.numFrames;
+
+	return 0;
+}
+
+
+/**
+ * Creates a decoder for the given cache. The decoder must have been zero-initialized
+ * or freed with ``freePointCacheDecoder``.
+ *
+ * @return		``0`` on success, a negative value if the allocation failed.
+ */
+inline int createPointCacheDecoder(PointCacheDecoder &decoder, const PointCache &cache)
+{
+	size_t numValues = (size_t)cache.numChunks * kPointCacheChunkSize * 3;
+
+	decoder.numChunks = cache.numChunks;
+	decoder.frame = -1;
+	decoder.quantized = (uint32_t *)allocateAligned((numValues > 0 ? numValues : 1) * sizeof(uint32_t));
+	decoder.origins = (float *)calloc(cache.numChunks > 0 ? cache.numChunks * 3 : 1, sizeof(float));
+	if (!decoder.quantized || !decoder.origins) {
+		freeAligned(decoder.quantized);
+		free(decoder.origins);
+		decoder.quantized = NULL;
+		decoder.origins = NULL;
+		return -1;
+	}
+
+	return 0;
+}
+
+inline void freePointCacheDecoder(PointCacheDecoder &decoder)
+{
+	freeAligned(decoder.quantized);
+	free(decoder.origins);
+	memset(&decoder, 0, sizeof(decoder));
+}
+
+
+struct DecodePointCacheFrameKernel
+{
+	template <typename F>
+	static SS_FORCE_INLINE void run(const PointCache &cache, unsigned int frame, PointCacheDecoder &decoder, Vec3Stream *out)
+	{
+		typedef typename SIMDIntType<F>::Type U;
+
+		const bool isKeyframe = frame % cache.keyframeInterval == 0;
+		const size_t valuesPerAxis = (size_t)cache.numChunks * kPointCacheChunkSize;
+		const F step = F::broadcast(cache.step);
+		const U one = U::broadcast(1);
+		const U zero = U::broadcast(0);
+
+		const uint32_t *words = cache.words + cache.frameOffsets[frame];
+		for (unsigned int chunk=0; chunk < cache.numChunks; ++chunk) {
+			unsigned int slots = getPointCacheChunkSlots(cache.numPoints, chunk);
+
+			if (isKeyframe) {
+				for (int axis=0; axis < 3; ++axis) {
+					memcpy(&decoder.origins[(axis * cache.numChunks) + chunk], words++, sizeof(uint32_t));
+				}
+			}
+			uint32_t widths = *words++;
+
+			for (int axis=0; axis < 3; ++axis) {
+				unsigned int b = (widths >> (8 * axis)) & 0xff;
+				const U mask = U::broadcast(b < 32 ? (1u << b) - 1 : 0xffffffffu);
+				const F origin = F::broadcast(decoder.origins[(axis * cache.numChunks) + chunk]);
+
+				uint32_t *quantized = decoder.quantized + (axis * valuesPerAxis) + (chunk * kPointCacheChunkSize);
+				float *positions = NULL;
+				if (out) {
+					positions = (axis == 0 ? out->x : (axis == 1 ? out->y : out->z)) + (chunk * kPointCacheChunkSize);
+				}
+
+				for (unsigned int slot=0; slot < slots; ++slot) {
+					unsigned int bitOffset = slot * b;
+					const uint32_t *lo = words + ((bitOffset / 32) * kPointCacheLanes);
+					unsigned int shift = bitOffset % 32;
+					bool spills = shift + b > 32;
+
+					for (unsigned int lane=0; lane < kPointCacheLanes; lane += F::width) {
+						U value = zero;
+						if (b > 0) {
+							value = shiftRight(U::loadUnaligned(lo + lane), shift);
+							if (spills) {
+								value = value | shiftLeft(U::loadUnaligned(lo + kPointCacheLanes + lane), 32 - shift);
+							}
+							value = value & mask;
+						}
+
+						uint32_t *q = quantized + (slot * kPointCacheLanes) + lane;
+						if (!isKeyframe) {
+							value = U::loadUnaligned(q) + (shiftRight<1>(value) ^ (zero - (value & one)));
+						}
+						value.storeUnaligned(q);
+
+						// NOTE: (sonictk) The chunks are whole multiples of the stream padding,
+						// so this never writes past the end of the stream.
+						if (positions) {
+							(origin + (convertToFloat(value) * step)).store(positions + (slot * kPointCacheLanes) + lane);
+						}
+					}
+				}
+				words += getPointCacheWordsPerLane(slots, b) * kPointCacheLanes;
+			}
+		}
+	}
+};
+
+
+/// The size of the encoded frames, in bytes.
+inline size_t getPointCacheSize(const PointCache &cache)
+{
+	return cache.numWords * sizeof(uint32_t);
+}
+
+/// The size that the frames would take as raw float triples, divided by their
+/// encoded size.
+inline float getPointCacheCompressionRatio(const PointCache &cache)
+{
+	if (cache.numWords == 0) {
+		return 0.0f;
+	}
+	double rawSize = (double)cache.numFrames * cache.numPoints * 3 * sizeof(float);
+
+	return (float)(rawSize / (double)getPointCacheSize(cache));
+}
+
+
+/// Identifies point cache files (``"SSPC"``) and the version of their layout.
+static const uint32_t kPointCacheFileMagic = 0x43505353;
+static const uint32_t kPointCacheFileVersion = 1;
+
+/// The header of a point cache file. It is followed by the encoded words, the
+/// offset of every frame (as 64-bit integers) and the encoder's state.
+struct PointCacheFileHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t numPoints;
+	uint32_t numChunks;
+	uint32_t numFrames;
+	uint32_t keyframeInterval;
+	float step;
+	uint32_t reserved;
+	uint64_t numWords;
+};
+
+
+/**
+ * Writes a cache to a file. The encoder's state is written too, so that frames
+ * can still be appended to the cache after it is read back. The file is written in
+ * the byte order of this machine.
+ *
+ * @param cache		The cache to write.
+ * @param path			The path of the file to write.
+ *
+ * @return				``0`` on success, a negative value if the file could not be
+ * 					written.
+ */
+inline int writePointCacheFile(const PointCache &cache, const char *path)
+{
+	FILE *file = fopen(path, "wb");
+	if (!file) {
+		return -1;
+	}
+
+	PointCacheFileHeader header;
+	memset(&header, 0, sizeof(header));
+	header.magic = kPointCacheFileMagic;
+	header.version = kPointCacheFileVersion;
+	header.numPoints = cache.numPoints;
+	header.numChunks = cache.numChunks;
+	header.numFrames = cache.numFrames;
+	header.keyframeInterval = cache.keyframeInterval;
+	header.step = cache.step;
+	header.numWords = cache.numWords;
+
+	size_t numValues = (size_t)cache.numChunks * kPointCacheChunkSize * 3;
+	bool isWritten = fwrite(&header, sizeof(header), 1, file) == 1
+		&& fwrite(cache.words, sizeof(uint32_t), cache.numWords, file) == cache.numWords;
+	for (unsigned int i=0; isWritten && i < cache.numFrames; ++i) {
+		uint64_t offset = cache.frameOffsets[i];
+		isWritten = fwrite(&offset, sizeof(offset), 1, file) == 1;
+	}
+	isWritten = isWritten
+		&& fwrite(cache.quantized, sizeof(uint32_t), numValues, file) == numValues
+		&& fwrite(cache.origins, sizeof(float), (size_t)cache.numChunks * 3, file) == (size_t)cache.numChunks * 3;
+
+	if (fclose(file) != 0 || !isWritten) {
+		return -1;
+	}
+
+	return 0;
+}
+
+
+/**
+ * Reads a cache that was written with ``writePointCacheFile``. The cache must have
+ * been zero-initialized or freed with ``freePointCache``.
+ *
+ * @param cache		The cache to read into.
+ * @param path			The path of the file to read.
+ *
+ * @return				``0`` on success, a negative value if the file could not be
+ * 					read or is not a valid point cache. The cache is left empty
+ * 					on failure.
+ */
+inline int readPointCacheFile(PointCache &cache, const char *path)
+{
+	FILE *file = fopen(path, "rb");
+	if (!file) {
+		return -1;
+	}
+
+	PointCacheFileHeader header;
+	if (fread(&header, sizeof(header), 1, file) != 1
+		|| header.magic != kPointCacheFileMagic
+		|| header.version != kPointCacheFileVersion
+		|| header.numChunks != (header.numPoints + kPointCacheChunkSize - 1) / kPointCacheChunkSize
+		|| header.keyframeInterval == 0
+		|| !(header.step > 0.0f)) {
+		fclose(file);
+		return -1;
+	}
+
+	PointCacheSettings settings = pointCacheSettings(header.step * 0.5f);
+	settings.keyframeInterval = header.keyframeInterval;
+	if (createPointCache(cache, header.numPoints, settings) != 0) {
+		fclose(file);
+		return -1;
+	}
+	cache.step = header.step;
+
+	size_t numWords = (size_t)header.numWords;
+	size_t numValues = (size_t)cache.numChunks * kPointCacheChunkSize * 3;
+	cache.words = (uint32_t *)malloc((numWords > 0 ? numWords : 1) * sizeof(uint32_t));
+	cache.frameOffsets = (size_t *)malloc((header.numFrames > 0 ? header.numFrames : 1) * sizeof(size_t));
+	bool isRead = cache.words && cache.frameOffsets
+		&& fread(cache.words, sizeof(uint32_t), numWords, file) == numWords;
+	if (isRead) {
+		cache.numWords = cache.wordCapacity = numWords;
+		cache.frameCapacity = header.numFrames;
+	}
+
+	// NOTE: (sonictk) Only the offsets are checked; the words themselves are
+	// trusted, so caches should only be read from files written by this codec.
+	for (unsigned int i=0; isRead && i < header.numFrames; ++i) {
+		uint64_t offset;
+		isRead = fread(&offset, sizeof(offset), 1, file) == 1
+			&& offset <= numWords
+			&& (i == 0 || offset >= cache.frameOffsets[i - 1]);
+		if (isRead) {
+			cache.frameOffsets[i] = (size_t)offset;
+		}
+	}
+	isRead = isRead
+		&& fread(cache.quantized, sizeof(uint32_t), numValues, file) == numValues
+		&& fread(cache.origins, sizeof(float), (size_t)cache.numChunks * 3, file) == (size_t)cache.numChunks * 3;
+	fclose(file);
+
+	if (!isRead) {
+		freePointCache(cache);
+		return -1;
+	}
+	cache.numFrames = header.numFrames;
+
+	return 0;
+}
+
+
+#endif /* POINT_CODEC_H */
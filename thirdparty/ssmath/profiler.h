@@ -0,0 +1,491 @@
+/**
+ * @brief  	A low-overhead profiler for timing scoped zones of code on any thread.
+ *
+ * 			Zones are timed with the CPU's timestamp counter (TSC) when it runs at a
+ * 			constant rate, calibrated against the monotonic clock once at startup,
+ * 			and with the monotonic clock otherwise. Every thread records into its
+ * 			own ring buffer, so recording a zone never takes a lock; when a buffer
+ * 			is full, the oldest events are overwritten. Recording a zone costs two
+ * 			counter reads and a few stores.
+ *
+ * 			The names of the zones are only stored as pointers, so they must stay
+ * 			valid for as long as the events are: use string literals from a binary
+ * 			that is never unloaded (i.e. not from the hot-reloaded logic library).
+ *
+ * 			The recorded zones can be written out with ``writeProfileTrace`` to be
+ * 			inspected in a trace viewer.
+ *
+ * 			Define ``SS_DISABLE_PROFILER`` to compile the zone macros out entirely.
+ */
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <new>
+#include <atomic>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(__i386__)
+#define SS_PROFILER_HAS_TSC 1
+#endif // Architecture
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <intrin.h>
+
+#elif __linux__ || __APPLE__
+#include <time.h>
+#include <pthread.h>
+#ifdef SS_PROFILER_HAS_TSC
+#include <x86intrin.h>
+#include <cpuid.h>
+#endif // SS_PROFILER_HAS_TSC
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif // __linux__
+
+#endif // Platform layer
+
+
+/// The number of slots in each thread's ring buffer. Must be a power of two.
+static const unsigned int kProfilerBufferSize = 8192;
+
+
+/// A single timed zone. The times are in profiler ticks; see
+/// ``profilerTicksToNanoseconds``.
+struct ProfileEvent
+{
+	const char *name;
+	uint64_t start;
+	uint64_t end;
+};
+
+/// The ring buffer that a single thread records its events into. Only the owning
+/// thread ever writes to it.
+struct ProfilerThreadBuffer
+{
+	ProfileEvent events[kProfilerBufferSize];
+	std::atomic<uint64_t> numWritten;	/// The total number of events ever recorded.
+
+	uint64_t threadID;
+	ProfilerThreadBuffer *next;
+};
+
+struct Profiler
+{
+	std::atomic<bool> isEnabled;
+	std::atomic<ProfilerThreadBuffer *> threads;	/// A lock-free list of every thread's buffer.
+	std::atomic<uint32_t> generation;				/// Incremented whenever the buffers are freed.
+	std::atomic<uint64_t> clearTicks;				/// Events that start before this are ignored.
+
+	bool useTSC;
+	double nanosecondsPerTick;
+	uint64_t startTicks;							/// The ticks when the profiler was initialized.
+};
+
+
+/// The profiler for this binary.
+globalVar Profiler kProfiler;
+
+// NOTE: (sonictk) These are plain pointers without destructors on purpose, so that
+// no thread-exit callbacks are registered that would outlive the plugin. The
+// generation detects buffers that were freed by ``shutdownProfiler``.
+static thread_local ProfilerThreadBuffer *tProfilerThreadBuffer;
+static thread_local uint32_t tProfilerGeneration;
+
+
+/// Reads the monotonic clock, in nanoseconds.
+inline uint64_t getMonotonicNanoseconds()
+{
+#ifdef _WIN32
+	LARGE_INTEGER counter;
+	LARGE_INTEGER frequency;
+	QueryPerformanceCounter(&counter);
+	QueryPerformanceFrequency(&frequency);
+
+	return (uint64_t)((double)counter.QuadPart * (1e9 / (double)frequency.QuadPart));
+#else
+	timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+
+	return ((uint64_t)time.tv_sec * 1000000000ull) + (uint64_t)time.tv_nsec;
+#endif // _WIN32
+}
+
+/// Checks if the TSC runs at a constant rate that is shared between cores, which is
+/// required to compare readings across threads and to convert them to time.
+inline bool hasInvariantTSC()
+{
+#if defined(SS_PROFILER_HAS_TSC) && defined(_WIN32)
+	int info[4];
+	__cpuid(info, 0x80000000);
+	if ((unsigned int)info[0] < 0x80000007) {
+		return false;
+	}
+	__cpuid(info, 0x80000007);
+
+	return (info[3] & (1 << 8)) != 0;
+#elif defined(SS_PROFILER_HAS_TSC)
+	unsigned int eax, ebx, ecx, edx;
+	if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx)) {
+		return false;
+	}
+
+	return (edx & (1 << 8)) != 0;
+#else
+	return false;
+#endif // SS_PROFILER_HAS_TSC
+}
+
+/// Reads the profiler's clock. The units depend on the clock that is being used.
+inline uint64_t readProfilerTicks()
+{
+#ifdef SS_PROFILER_HAS_TSC
+	if (kProfiler.useTSC) {
+		return __rdtsc();
+	}
+#endif // SS_PROFILER_HAS_TSC
+	return getMonotonicNanoseconds();
+}
+
+/// Converts a duration in profiler ticks to nanoseconds.
+inline double profilerTicksToNanoseconds(uint64_t ticks)
+{
+	return (double)ticks * kProfiler.nanosecondsPerTick;
+}
+
+/// Converts a reading of the profiler's clock to nanoseconds since the profiler
+/// was initialized.
+inline double getProfilerTimestamp(uint64_t ticks)
+{
+	return (double)(int64_t)(ticks - kProfiler.startTicks) * kProfiler.nanosecondsPerTick;
+}
+
+/// Returns the OS ID of the calling thread.
+inline uint64_t getProfilerThreadID()
+{
+#ifdef _WIN32
+	return (uint64_t)GetCurrentThreadId();
+#elif __linux__
+	return (uint64_t)syscall(SYS_gettid);
+#elif __APPLE__
+	uint64_t threadID = 0;
+	pthread_threadid_np(NULL, &threadID);
+	return threadID;
+#endif // Platform layer
+}
+
+/// Returns the OS ID of the current process.
+inline uint64_t getProfilerProcessID()
+{
+#ifdef _WIN32
+	return (uint64_t)GetCurrentProcessId();
+#else
+	return (uint64_t)getpid();
+#endif // _WIN32
+}
+
+
+/**
+ * Initializes the profiler and calibrates its clock, which takes about 10 ms. This
+ * must be called before any zones are recorded; the profiler starts out disabled.
+ *
+ * @return		``0`` on success.
+ */
+inline int initializeProfiler()
+{
+	kProfiler.useTSC = false;
+	kProfiler.nanosecondsPerTick = 1.0;
+
+#ifdef SS_PROFILER_HAS_TSC
+	if (hasInvariantTSC()) {
+		uint64_t startNanoseconds = getMonotonicNanoseconds();
+		uint64_t startTicks = __rdtsc();
+
+		uint64_t endNanoseconds;
+		do {
+			endNanoseconds = getMonotonicNanoseconds();
+		} while (endNanoseconds - startNanoseconds < 10000000);
+		uint64_t endTicks = __rdtsc();
+
+		if (endTicks > startTicks) {
+			kProfiler.useTSC = true;
+			kProfiler.nanosecondsPerTick = (double)(endNanoseconds - startNanoseconds) / (double)(endTicks - startTicks);
+		}
+	}
+#endif // SS_PROFILER_HAS_TSC
+
+	kProfiler.startTicks = readProfilerTicks();
+	kProfiler.clearTicks.store(0);
+	kProfiler.generation.fetch_add(1);
+
+	return 0;
+}
+
+/**
+ * Disables the profiler and frees every thread's buffer. This must not be called
+ * while any zones are being recorded.
+ */
+inline void shutdownProfiler()
+{
+	kProfiler.isEnabled.store(false);
+
+	ProfilerThreadBuffer *buffer = kProfiler.threads.exchange(NULL);
+	while (buffer) {
+		ProfilerThreadBuffer *next = buffer->next;
+		buffer->~ProfilerThreadBuffer();
+		free(buffer);
+		buffer = next;
+	}
+	kProfiler.generation.fetch_add(1);
+}
+
+inline void setProfilerEnabled(bool enabled)
+{
+	kProfiler.isEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+inline bool isProfilerEnabled()
+{
+	return kProfiler.isEnabled.load(std::memory_order_relaxed);
+}
+
+/// Discards the events recorded so far, without touching the buffers that other
+/// threads are writing to.
+inline void clearProfileEvents()
+{
+	kProfiler.clearTicks.store(readProfilerTicks(), std::memory_order_relaxed);
+}
+
+
+/**
+ * Gets the calling thread's buffer, creating it the first time.
+ *
+ * @return		The buffer, or ``NULL`` if it could not be allocated.
+ */
+inline ProfilerThreadBuffer *getProfilerThreadBuffer()
+{
+	uint32_t generation = kProfiler.generation.load(std::memory_order_relaxed);
+	if (tProfilerThreadBuffer && tProfilerGeneration == generation) {
+		return tProfilerThreadBuffer;
+	}
+
+	void *memory = malloc(sizeof(ProfilerThreadBuffer));
+	if (!memory) {
+		return NULL;
+	}
+	ProfilerThreadBuffer *buffer = new (memory) ProfilerThreadBuffer;
+	buffer->numWritten.store(0, std::memory_order_relaxed);
+	buffer->threadID = getProfilerThreadID();
+
+	buffer->next = kProfiler.threads.load(std::memory_order_relaxed);
+	while (!kProfiler.threads.compare_exchange_weak(buffer->next,
+													buffer,
+													std::memory_order_release,
+													std::memory_order_relaxed)) {}
+
+	tProfilerThreadBuffer = buffer;
+	tProfilerGeneration = generation;
+
+	return buffer;
+}
+
+/// Records a zone into the calling thread's buffer.
+inline void recordProfileEvent(const char *name, uint64_t start, uint64_t end)
+{
+	ProfilerThreadBuffer *buffer = getProfilerThreadBuffer();
+	if (!buffer) {
+		return;
+	}
+
+	uint64_t index = buffer->numWritten.load(std::memory_order_relaxed);
+	ProfileEvent &event = buffer->events[index & (kProfilerBufferSize - 1)];
+	event.name = name;
+	event.start = start;
+	event.end = end;
+	buffer->numWritten.store(index + 1, std::memory_order_release);
+}
+
+
+typedef void (*ProfileEventVisitor)(uint64_t threadID, const ProfileEvent &event, void *userData);
+
+/**
+ * Calls ``visitor`` for every event that is still in the buffers, thread by thread
+ * and oldest first within each thread. This can be called while other threads are
+ * recording; events that are overwritten while being read are skipped.
+ *
+ * @param visitor	The function to call for each event.
+ * @param userData	Passed through to ``visitor``.
+ *
+ * @return			The number of events visited.
+ */
+inline unsigned int visitProfileEvents(ProfileEventVisitor visitor, void *userData)
+{
+	uint64_t clearTicks = kProfiler.clearTicks.load(std::memory_order_relaxed);
+	unsigned int count = 0;
+
+	for (ProfilerThreadBuffer *buffer = kProfiler.threads.load(std::memory_order_acquire);
+		 buffer;
+		 buffer = buffer->next) {
+		uint64_t numWritten = buffer->numWritten.load(std::memory_order_acquire);
+		// NOTE: (sonictk) The oldest slot is the next one to be written, so it is
+		// never read; each thread keeps its last ``kProfilerBufferSize - 1`` events.
+		uint64_t first = numWritten >= kProfilerBufferSize ? numWritten - kProfilerBufferSize + 1 : 0;
+
+		for (uint64_t i=first; i < numWritten; ++i) {
+			ProfileEvent event = buffer->events[i & (kProfilerBufferSize - 1)];
+
+			// NOTE: (sonictk) The owner starts overwriting slot ``i`` once it has
+			// written ``i + kProfilerBufferSize`` events, so if it got that far while
+			// the event was being copied, the copy may be torn.
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (buffer->numWritten.load(std::memory_order_relaxed) - i >= kProfilerBufferSize) {
+				continue;
+			}
+			if (event.start < clearTicks) {
+				continue;
+			}
+
+			visitor(buffer->threadID, event, userData);
+			++count;
+		}
+	}
+
+	return count;
+}
+
+
+/// Writes a string as a JSON string literal, escaping it as needed.
+inline void writeJSONString(FILE *file, const char *str)
+{
+	fputc('"', file);
+	for (const char *c=str; *c; ++c) {
+		unsigned char ch = (unsigned char)*c;
+		if (ch == '"' || ch == '\\') {
+			fputc('\\', file);
+			fputc(ch, file);
+		} else if (ch < 0x20) {
+			fprintf(file, "\\u%04x", ch);
+		} else {
+			fputc(ch, file);
+		}
+	}
+	fputc('"', file);
+}
+
+struct ProfileTraceWriter
+{
+	FILE *file;
+	uint64_t processID;
+	unsigned int numWritten;
+	uint64_t lastThreadID;
+};
+
+inline void writeProfileTraceEvent(uint64_t threadID, const ProfileEvent &event, void *userData)
+{
+	ProfileTraceWriter *writer = (ProfileTraceWriter *)userData;
+	FILE *file = writer->file;
+
+	// NOTE: (sonictk) The events arrive thread by thread, so each thread is named
+	// once, just before its first event.
+	if (writer->numWritten == 0 || threadID != writer->lastThreadID) {
+		fprintf(file,
+				"%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%llu,\"tid\":%llu,\"args\":{\"name\":\"Thread %llu\"}}",
+				writer->numWritten == 0 ? "" : ",",
+				(unsigned long long)writer->processID,
+				(unsigned long long)threadID,
+				(unsigned long long)threadID);
+		writer->lastThreadID = threadID;
+		++writer->numWritten;
+	}
+
+	fputs(",\n{\"name\":", file);
+	writeJSONString(file, event.name);
+	fprintf(file,
+			",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%llu,\"tid\":%llu}",
+			getProfilerTimestamp(event.start) * 1e-3,
+			profilerTicksToNanoseconds(event.end - event.start) * 1e-3,
+			(unsigned long long)writer->processID,
+			(unsigned long long)threadID);
+	++writer->numWritten;
+}
+
+/**
+ * Writes the events that are still in the buffers to a file in the Chrome trace
+ * event format, which can be opened in ``chrome://tracing`` or Perfetto. Every
+ * zone becomes a complete (``X``) event on the track of the thread that recorded
+ * it, with times in microseconds since the profiler was initialized.
+ *
+ * @param filename	The path of the file to write. It is overwritten if it exists.
+ *
+ * @return			The number of zones written, or ``-1`` if the file could not be
+ * 				written.
+ */
+inline int writeProfileTrace(const char *filename)
+{
+	FILE *file = fopen(filename, "w");
+	if (!file) {
+		perror("Failed to open the trace file for writing!\n");
+		return -1;
+	}
+
+	ProfileTraceWriter writer;
+	writer.file = file;
+	writer.processID = getProfilerProcessID();
+	writer.numWritten = 0;
+	writer.lastThreadID = 0;
+
+	fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", file);
+	unsigned int numEvents = visitProfileEvents(writeProfileTraceEvent, &writer);
+	fputs("\n]}\n", file);
+
+	int status = ferror(file);
+	if (fclose(file) != 0 || status != 0) {
+		perror("Failed to write the trace file!\n");
+		return -1;
+	}
+
+	return (int)numEvents;
+}
+
+
+/// Times the scope it is declared in. Use ``SS_PROFILE_ZONE`` rather than this
+/// directly, so that it can be compiled out.
+struct ProfileZone
+{
+	const char *name;
+	uint64_t start;
+
+	inline explicit ProfileZone(const char *zoneName)
+	{
+		name = zoneName;
+		start = isProfilerEnabled() ? readProfilerTicks() : 0;
+	}
+
+	inline ~ProfileZone()
+	{
+		if (start != 0) {
+			recordProfileEvent(name, start, readProfilerTicks());
+		}
+	}
+};
+
+
+#define SS_PROFILE_CONCAT_(a, b) a##b
+#define SS_PROFILE_CONCAT(a, b) SS_PROFILE_CONCAT_(a, b)
+
+#ifndef SS_DISABLE_PROFILER
+/// Times the rest of the enclosing scope as a zone with the given name, which must
+/// be a string literal.
+#define SS_PROFILE_ZONE(name) ProfileZone SS_PROFILE_CONCAT(ssProfileZone, __LINE__)(name)
+#define SS_PROFILE_FUNCTION() SS_PROFILE_ZONE(__FUNCTION__)
+#else
+#define SS_PROFILE_ZONE(name)
+#define SS_PROFILE_FUNCTION()
+#endif // SS_DISABLE_PROFILER
+
+
+#endif /* PROFILER_H */
@@ -0,0 +1,324 @@
+/**
+ * @brief  	Batched quaternion and dual-quaternion operations over SoA streams.
+ * 			These follow the same conventions as ``vector_stream.h``: streams are
+ * 			aligned and padded, every operation has a kernel that is written once
+ * 			over the packet type, and the public functions (in ``simd_kernels.h``)
+ * 			validate the stream counts before calling the variant for the widest
+ * 			packet type the CPU supports.
+ */
+#ifndef QUATERNION_STREAM_H
+#define QUATERNION_STREAM_H
+
+#include "vector_stream.h"
+
+
+/// A packet of quaternions, stored with one register per component.
+template <typename F>
+struct QuatPacket
+{
+	F x, y, z, w;
+};
+
+template <typename F>
+SS_FORCE_INLINE QuatPacket<F> quatPacket(const Quat &q)
+{
+	QuatPacket<F> result = {F::broadcast(q.x), F::broadcast(q.y), F::broadcast(q.z), F::broadcast(q.w)};
+	return result;
+}
+
+template <typename F>
+SS_FORCE_INLINE QuatPacket<F> operator+(const QuatPacket<F> &q1, const QuatPacket<F> &q2)
+{
+	QuatPacket<F> result = {q1.x + q2.x, q1.y + q2.y, q1.z + q2.z, q1.w + q2.w};
+	return result;
+}
+
+template <typename F>
+SS_FORCE_INLINE QuatPacket<F> operator*(const QuatPacket<F> &q, F factor)
+{
+	QuatPacket<F> result = {q.x * factor, q.y * factor, q.z * factor, q.w * factor};
+	return result;
+}
+
+template <typename F>
+SS_FORCE_INLINE F innerProduct(const QuatPacket<F> &q1, const QuatPacket<F> &q2)
+{
+	return (q1.x * q2.x) + (q1.y * q2.y) + (q1.z * q2.z) + (q1.w * q2.w);
+}
+
+template <typename F>
+SS_FORCE_INLINE QuatPacket<F> normalize(const QuatPacket<F> &q)
+{
+	return q * (F::broadcast(1.0f) / squareRoot(innerProduct(q, q)));
+}
+
+/// Flips the sign of the quaternions wherever ``s`` is negative.
+template <typename F>
+SS_FORCE_INLINE QuatPacket<F> multiplySign(const QuatPacket<F> &q, F s)
+{
+	QuatPacket<F> result = {multiplySign(q.x, s), multiplySign(q.y, s), multiplySign(q.z, s), multiplySign(q.w, s)};
+	return result;
+}
+
+template <typename F>
+SS_FORCE_INLINE Vec3Packet<F> rotateBy(const Vec3Packet<F> &v, const QuatPacket<F> &rotation)
+{
+	// NOTE: (sonictk) This is the same rotation as the ``Vec3`` version, but
+	// factored as ``v + w.t + (q x t)`` with ``t = 2.(q x v)``, which needs fewer
+	// multiplies than the Rodrigues form.
+	Vec3Packet<F> axis = {rotation.x, rotation.y, rotation.z};
+	Vec3Packet<F> t = crossProduct(axis, v) * 2.0f;
+	return v + (t * rotation.w) + crossProduct(axis, t);
+}
+
+
+/// A stream of quaternions, with the same alignment and padding as ``Vec3Stream``.
+struct QuatStream
+{
+	float *x;
+	float *y;
+	float *z;
+	float *w;
+
+	unsigned int count;
+	unsigned int capacity;
+};
+
+/**
+ * Allocates storage for at least ``count`` quaternions and sets the stream's count.
+ * See ``allocateVec3Stream`` for details.
+ *
+ * @param stream	The stream to allocate.
+ * @param count	The number of quaternions the stream should hold.
+ *
+ * @return			``0`` on success, a negative value if the allocation failed.
+ */
+inline int allocateQuatStream(QuatStream &stream, unsigned int count)
+{
+	if (stream.x && stream.capacity >= count) {
+		stream.count = count;
+		return 0;
+	}
+
+	freeAligned(stream.x);
+
+	unsigned int capacity = padSIMDCount(count > 0 ? count : 1);
+	float *storage = (float *)allocateAligned(sizeof(float) * capacity * 4);
+	if (!storage) {
+		stream.x = stream.y = stream.z = stream.w = NULL;
+		stream.count = stream.capacity = 0;
+		return -1;
+	}
+
+	stream.x = storage;
+	stream.y = storage + capacity;
+	stream.z = storage + (capacity * 2);
+	stream.w = storage + (capacity * 3);
+	stream.count = count;
+	stream.capacity = capacity;
+
+	return 0;
+}
+
+inline void freeQuatStream(QuatStream &stream)
+{
+	freeAligned(stream.x);
+	stream.x = stream.y = stream.z = stream.w = NULL;
+	stream.count = stream.capacity = 0;
+}
+
+template <typename F>
+SS_FORCE_INLINE QuatPacket<F> loadQuatPacket(const QuatStream &stream, unsigned int index)
+{
+	QuatPacket<F> result = {F::load(stream.x + index), F::load(stream.y + index),
+							F::load(stream.z + index), F::load(stream.w + index)};
+	return result;
+}
+
+template <typename F>
+SS_FORCE_INLINE void storeQuatPacket(QuatStream &stream, unsigned int index, const QuatPacket<F> &packet)
+{
+	packet.x.store(stream.x + index);
+	packet.y.store(stream.y + index);
+	packet.z.store(stream.z + index);
+	packet.w.store(stream.w + index);
+}
+
+
+/// A unit dual quaternion representing a rigid transformation. ``real`` holds the
+/// rotation and ``dual`` holds half of the translation multiplied by the rotation.
+struct DualQuat
+{
+	Quat real;
+	Quat dual;
+};
+
+/**
+ * Creates a dual quaternion that rotates by ``rotation`` and then translates by
+ * ``translation``.
+ *
+ * @param rotation		A unit quaternion.
+ * @param translation	The translation to apply after the rotation.
+ *
+ * @return				The dual quaternion.
+ */
+inline DualQuat dualQuat(const Quat &rotation, const Vec3 &translation)
+{
+	// NOTE: (sonictk) ``dual = 0.5 * (t, 0) * real``, expanded for a pure quaternion ``t``.
+	DualQuat result;
+	result.real = rotation;
+	Vec3 axis = vec3(rotation.x, rotation.y, rotation.z);
+	Vec3 v = 0.5f * ((rotation.w * translation) + crossProduct(translation, axis));
+	result.dual = vec4(v, -0.5f * innerProduct(translation, axis));
+
+	return result;
+}
+
+
+// NOTE: (sonictk) ``slerp`` needs ``sin(t.theta) / sin(theta)`` where ``cos(theta)`` is
+// the inner product of the quaternions. Rather than calling ``acos`` and ``sin`` per
+// lane, this is evaluated as a polynomial in ``x - 1`` (with ``x = cos(theta)``) using
+// the series from David Eberly's "A Fast and Accurate Algorithm for Computing SLERP":
+// ``b0 = t``, ``b(i) = b(i-1).(t^2 - i^2) / (i.(2i + 1))``. Since the shortest arc is
+// always taken, ``x - 1`` is in ``[-1, 0]`` and each term is at most half of the
+// previous one; 16 terms leave an absolute error of about 1e-6 at ``theta = 90``.
+static const unsigned int kSlerpSeriesTerms = 16;
+static const float kSlerpSeriesU[kSlerpSeriesTerms] = {
+	1.0f / (1 * 3), 1.0f / (2 * 5), 1.0f / (3 * 7), 1.0f / (4 * 9),
+	1.0f / (5 * 11), 1.0f / (6 * 13), 1.0f / (7 * 15), 1.0f / (8 * 17),
+	1.0f / (9 * 19), 1.0f / (10 * 21), 1.0f / (11 * 23), 1.0f / (12 * 25),
+	1.0f / (13 * 27), 1.0f / (14 * 29), 1.0f / (15 * 31), 1.0f / (16 * 33)
+};
+static const float kSlerpSeriesV[kSlerpSeriesTerms] = {
+	1.0f / 3, 2.0f / 5, 3.0f / 7, 4.0f / 9, 5.0f / 11, 6.0f / 13, 7.0f / 15, 8.0f / 17,
+	9.0f / 19, 10.0f / 21, 11.0f / 23, 12.0f / 25, 13.0f / 27, 14.0f / 29, 15.0f / 31, 16.0f / 33
+};
+
+template <typename F>
+SS_FORCE_INLINE F slerpWeight(F t, F xMinusOne)
+{
+	F t2 = t * t;
+	F term = t;
+	F sum = t;
+	for (unsigned int i=0; i < kSlerpSeriesTerms; ++i) {
+		term = term * ((t2 * F::broadcast(kSlerpSeriesU[i])) - F::broadcast(kSlerpSeriesV[i])) * xMinusOne;
+		sum = sum + term;
+	}
+
+	return sum;
+}
+
+
+// NOTE: (sonictk) The kernels below are bound into the kernel table with
+// ``bindSIMDKernel``, so each of them is a struct with a single ``run`` template
+// over the packet type.
+struct RotateStreamKernel
+{
+	template <typename F>
+	static SS_FORCE_INLINE void run(const Quat &rotation, const Vec3Stream &in, Vec3Stream &out)
+	{
+		QuatPacket<F> q = quatPacket<F>(rotation);
+		for (unsigned int i=0; i < in.count; i += F::width) {
+			storeVec3Packet(out, i, rotateBy(loadVec3Packet<F>(in, i), q));
+		}
+	}
+};
+
+struct RotateStreamPerPointKernel
+{
+	template <typename F>
+	static SS_FORCE_INLINE void run(const QuatStream &rotations, const Vec3Stream &in, Vec3Stream &out)
+	{
+		for (unsigned int i=0; i < in.count; i += F::width) {
+			storeVec3Packet(out, i, rotateBy(loadVec3Packet<F>(in, i), loadQuatPacket<F>(rotations, i)));
+		}
+	}
+};
+
+struct NormalizeQuatStreamKernel
+{
+	template <typename F>
+	static SS_FORCE_INLINE void run(const QuatStream &in, QuatStream &out)
+	{
+		for (unsigned int i=0; i < in.count; i += F::width) {
+			storeQuatPacket(out, i, normalize(loadQuatPacket<F>(in, i)));
+		}
+	}
+};
+
+struct NlerpQuatStreamsKernel
+{
+	template <typename F>
+	static SS_FORCE_INLINE void run(const QuatStream &a, float t, const QuatStream &b, QuatStream &out)
+	{
+		F ft = F::broadcast(t);
+		F oneMinusT = F::broadcast(1.0f - t);
+		for (unsigned int i=0; i < a.count; i += F::width) {
+			QuatPacket<F> q1 = loadQuatPacket<F>(a, i);
+			QuatPacket<F> q2 = loadQuatPacket<F>(b, i);
+			// NOTE: (sonictk) Take the shortest arc by flipping ``q2`` into the same
+			// hemisphere as ``q1``.
+			q2 = multiplySign(q2, innerProduct(q1, q2));
+			storeQuatPacket(out, i, normalize((q1 * oneMinusT) + (q2 * ft)));
+		}
+	}
+};
+
+struct SlerpQuatStreamsKernel
+{
+	template <typename F>
+	static SS_FORCE_INLINE void run(const QuatStream &a, float t, const QuatStream &b, QuatStream &out)
+	{
+		F ft = F::broadcast(t);
+		F oneMinusT = F::broadcast(1.0f - t);
+		F one = F::broadcast(1.0f);
+		for (unsigned int i=0; i < a.count; i += F::width) {
+			QuatPacket<F> q1 = loadQuatPacket<F>(a, i);
+			QuatPacket<F> q2 = loadQuatPacket<F>(b, i);
+			F cosTheta = innerProduct(q1, q2);
+			q2 = multiplySign(q2, cosTheta);
+
+			// NOTE: (sonictk) ``|cos(theta)|`` is clamped in case rounding pushed it past 1.
+			F xMinusOne = minimum(multiplySign(cosTheta, cosTheta), one) - one;
+			storeQuatPacket(out, i, (q1 * slerpWeight(oneMinusT, xMinusOne)) + (q2 * slerpWeight(ft, xMinusOne)));
+		}
+	}
+};
+
+struct BlendDualQuatsKernel
+{
+	template <typename F>
+	static SS_FORCE_INLINE void run(const DualQuat *transforms,
+									const FloatStream *weights,
+									unsigned int numInfluences,
+									const Vec3Stream &in,
+									Vec3Stream &out)
+	{
+		for (unsigned int i=0; i < in.count; i += F::width) {
+			QuatPacket<F> real = quatPacket<F>(vec4(0, 0, 0, 0));
+			QuatPacket<F> dual = real;
+			for (unsigned int j=0; j < numInfluences; ++j) {
+				// NOTE: (sonictk) Every influence is blended in the same hemisphere as
+				// the first one, otherwise antipodal rotations would cancel out.
+				float sign = innerProduct(transforms[j].real, transforms[0].real) < 0.0f ? -1.0f : 1.0f;
+				F weight = F::load(weights[j].e + i) * F::broadcast(sign);
+				real = real + (quatPacket<F>(transforms[j].real) * weight);
+				dual = dual + (quatPacket<F>(transforms[j].dual) * weight);
+			}
+
+			F invLength = F::broadcast(1.0f) / squareRoot(innerProduct(real, real));
+			real = real * invLength;
+			dual = dual * invLength;
+
+			// NOTE: (sonictk) The translation is the vector part of ``2 * dual * conj(real)``.
+			Vec3Packet<F> realAxis = {real.x, real.y, real.z};
+			Vec3Packet<F> dualAxis = {dual.x, dual.y, dual.z};
+			Vec3Packet<F> translation = ((dualAxis * real.w) - (realAxis * dual.w) + crossProduct(realAxis, dualAxis)) * 2.0f;
+
+			storeVec3Packet(out, i, rotateBy(loadVec3Packet<F>(in, i), real) + translation);
+		}
+	}
+};
+
+
+#endif /* QUATERNION_STREAM_H */
@@ -0,0 +1,213 @@
+/**
+ * @brief  	Random number generation that is safe to use from several threads and
+ * 			gives the same results no matter how the work is split between them.
+ *
+ * 			There are two kinds of generators here:
+ *
+ * 			- A counter-based generator, where each value is a hash of a seed and an
+ * 			  index (e.g. the index of a point). Since no state is shared between
+ * 			  values, any range of indices can be generated by any thread in any
+ * 			  order and the results are always identical. The stream versions (in
+ * 			  ``simd_kernels.h``) use the widest packet type that the CPU supports,
+ * 			  and give the same values at every width.
+ *
+ * 			- ``RandomState``, a xoroshiro128+ generator for when a thread just needs
+ * 			  a fast sequence of values. Each thread should own its own state, seeded
+ * 			  with ``seedRandomState`` from a shared seed and its own stream ID.
+ */
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include "simd_int.h"
+#include "vector_stream.h"
+#include <stdint.h>
+
+
+/**
+ * Hashes a 32-bit integer. This is the ``lowbias32`` hash by Chris Wellons; it is
+ * a bijection, and flipping any input bit flips each output bit with a probability
+ * very close to one half.
+ */
+template <typename U>
+SS_FORCE_INLINE U hashUInt32(U x)
+{
+	x = x ^ shiftRight<16>(x);
+	x = x * U::broadcast(0x7feb352du);
+	x = x ^ shiftRight<15>(x);
+	x = x * U::broadcast(0x846ca68bu);
+	x = x ^ shiftRight<16>(x);
+
+	return x;
+}
+
+inline uint32_t hashUInt32(uint32_t x)
+{
+	U32x1 h = {x};
+	return hashUInt32(h).v;
+}
+
+/**
+ * Derives the key that ``randomBits`` mixes into the indices from a seed. This only
+ * needs to be done once per seed.
+ */
+inline uint32_t randomKey(uint32_t seed)
+{
+	return hashUInt32(seed + 0x9e3779b9u);
+}
+
+/**
+ * Returns the random bits for the given index. The index is hashed twice, with the
+ * key mixed in between the rounds, so that the sequences for different seeds are
+ * not simply reorderings of each other.
+ *
+ * @param key		The key returned by ``randomKey`` for the seed.
+ * @param seed		The seed.
+ * @param index	The indices.
+ *
+ * @return			32 random bits for each index.
+ */
+template <typename U>
+SS_FORCE_INLINE U randomBits(U key, U seed, U index)
+{
+	return hashUInt32(hashUInt32(index ^ key) + seed);
+}
+
+/**
+ * Converts random bits to floats that are uniformly distributed in ``[0, 1)``.
+ * Only the top 24 bits are used, so every value that can be returned is an exact
+ * multiple of ``2^-24``.
+ */
+template <typename U>
+SS_FORCE_INLINE typename SIMDFloatType<U>::Type bitsToNormalizedFloat(U bits)
+{
+	typedef typename SIMDFloatType<U>::Type F;
+	return convertToFloat(shiftRight<8>(bits)) * F::broadcast(1.0f / 16777216.0f);
+}
+
+/**
+ * Returns a random value in ``[0, 1)`` that only depends on the seed and the index.
+ * This is the same value that the stream versions below give for that index.
+ *
+ * @param seed		The seed.
+ * @param index	The index of the value, e.g. the index of a point.
+ *
+ * @return			The random value.
+ */
+inline float randomFloat(uint32_t seed, uint32_t index)
+{
+	U32x1 bits = randomBits(U32x1::broadcast(randomKey(seed)), U32x1::broadcast(seed), U32x1::broadcast(index));
+	return bitsToNormalizedFloat(bits).v;
+}
+
+
+struct RandomFloatStreamKernel
+{
+	template <typename F>
+	static SS_FORCE_INLINE void run(FloatStream &out, uint32_t seed, uint32_t firstIndex, float min, float max)
+	{
+		typedef typename SIMDIntType<F>::Type U;
+
+		const U key = U::broadcast(randomKey(seed));
+		const U seeds = U::broadcast(seed);
+		const U laneOffsets = packetLaneOffsets<U>();
+		const F offset = F::broadcast(min);
+		const F scale = F::broadcast(max - min);
+
+		for (unsigned int i=0; i < out.count; i += F::width) {
+			U index = U::broadcast(firstIndex + i) + laneOffsets;
+			F value = bitsToNormalizedFloat(randomBits(key, seeds, index));
+			(offset + (value * scale)).store(out.e + i);
+		}
+	}
+};
+
+struct RandomVec3StreamKernel
+{
+	template <typename F>
+	static SS_FORCE_INLINE void run(Vec3Stream &out, uint32_t seed, uint32_t firstIndex, float min, float max)
+	{
+		typedef typename SIMDIntType<F>::Type U;
+
+		const U key = U::broadcast(randomKey(seed));
+		const U seeds = U::broadcast(seed);
+		const U laneOffsets = packetLaneOffsets<U>();
+		const U three = U::broadcast(3);
+		const F offset = F::broadcast(min);
+		const F scale = F::broadcast(max - min);
+
+		for (unsigned int i=0; i < out.count; i += F::width) {
+			// NOTE: (sonictk) Vector ``i`` uses the values at indices ``3i``, ``3i + 1``
+			// and ``3i + 2``, the same as if the components were laid out as AoS.
+			U index = (U::broadcast(firstIndex + i) + laneOffsets) * three;
+			F x = bitsToNormalizedFloat(randomBits(key, seeds, index));
+			F y = bitsToNormalizedFloat(randomBits(key, seeds, index + U::broadcast(1)));
+			F z = bitsToNormalizedFloat(randomBits(key, seeds, index + U::broadcast(2)));
+			(offset + (x * scale)).store(out.x + i);
+			(offset + (y * scale)).store(out.y + i);
+			(offset + (z * scale)).store(out.z + i);
+		}
+	}
+};
+
+
+/// The state of a xoroshiro128+ generator. Use ``seedRandomState`` to initialize it.
+struct RandomState
+{
+	uint64_t s0;
+	uint64_t s1;
+};
+
+/// One step of the SplitMix64 generator, used to expand seeds into full states.
+inline uint64_t splitMix64(uint64_t &x)
+{
+	uint64_t z = (x += 0x9e3779b97f4a7c15ull);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+
+	return z ^ (z >> 31);
+}
+
+/**
+ * Seeds a generator. Generators seeded with the same seed but different stream IDs
+ * (e.g. the index of the thread, or of the chunk of work it is doing) give
+ * unrelated sequences.
+ *
+ * @param state	The generator to seed.
+ * @param seed		The seed.
+ * @param stream	The ID of the sequence.
+ */
+inline void seedRandomState(RandomState &state, uint64_t seed, uint64_t stream)
+{
+	uint64_t x = seed ^ splitMix64(stream);
+	state.s0 = splitMix64(x);
+	state.s1 = splitMix64(x);
+
+	// NOTE: (sonictk) The all-zero state is the one state xoroshiro can never leave.
+	if (state.s0 == 0 && state.s1 == 0) {
+		state.s1 = 1;
+	}
+}
+
+/// Returns the next 64 random bits from the generator and advances it.
+inline uint64_t nextRandomBits(RandomState &state)
+{
+	uint64_t s0 = state.s0;
+	uint64_t s1 = state.s1;
+	uint64_t result = s0 + s1;
+
+	s1 ^= s0;
+	state.s0 = ((s0 << 24) | (s0 >> 40)) ^ s1 ^ (s1 << 16);
+	state.s1 = (s1 << 37) | (s1 >> 27);
+
+	return result;
+}
+
+/// Returns the next random value in ``[0, 1)`` from the generator and advances it.
+inline float nextRandomFloat(RandomState &state)
+{
+	// NOTE: (sonictk) The low bits of xoroshiro128+ are its weakest, so use the top 24.
+	return float(nextRandomBits(state) >> 40) * (1.0f / 16777216.0f);
+}
+
+
+#endif /* RANDOM_H */
@@ -0,0 +1,188 @@
+/**
+ * @brief  	Runtime selection between the packet widths of ``simd_float.h``. Kernels
+ * 			are written as a struct with a static ``run<F>`` template, which is
+ * 			instantiated for every width that is available; ``bindSIMDKernel``
+ * 			then points a function pointer at the variant for a given level. The
+ * 			kernels of ``ssmath`` are bound this way into the table in
+ * 			``simd_kernels.h``.
+ *
+ * 			The translation unit that uses these must also compile ``instrset.cpp``.
+ */
+#ifndef SIMD_DISPATCH_H
+#define SIMD_DISPATCH_H
+
+#include "simd_float.h"
+
+
+/// These match the values returned from ``instrset_detect``.
+enum SIMDLevel
+{
+	SIMDLevel_Scalar = 0,
+	SIMDLevel_SSE2 = 2,
+	SIMDLevel_AVX2 = 8,
+	SIMDLevel_AVX512 = 9
+};
+
+
+// NOTE: (sonictk) These have internal linkage on purpose. Function-local statics of
+// inline functions are emitted as unique symbols on Linux, and a shared library
+// containing one can never be unloaded, which would break hot-reloading the logic
+// library. Every binary therefore keeps its own copy of this state.
+
+/// The highest level that runtime dispatch is allowed to pick. Lowering this is
+/// useful for comparing the different code paths on the same machine; the kernel
+/// table has to be bound again (see ``initializeSIMDKernels``) to pick it up.
+static inline int &maxSIMDLevel()
+{
+	static int level = SIMDLevel_AVX512;
+	return level;
+}
+
+
+/**
+ * Gets the widest instruction set that kernels will be dispatched to on this CPU.
+ * The CPU is only queried once.
+ *
+ * @return		One of the ``SIMDLevel`` values.
+ */
+static inline int getSIMDLevel()
+{
+	static const int detected = instrset_detect();
+
+	int level = detected < maxSIMDLevel() ? detected : maxSIMDLevel();
+	if (level >= SIMDLevel_AVX512) {
+		return SIMDLevel_AVX512;
+	} else if (level >= SIMDLevel_AVX2) {
+		return SIMDLevel_AVX2;
+	} else if (level >= SIMDLevel_SSE2) {
+		return SIMDLevel_SSE2;
+	}
+
+	return SIMDLevel_Scalar;
+}
+
+
+/**
+ * Gets the name of the given level, for logging.
+ *
+ * @param level	One of the ``SIMDLevel`` values.
+ *
+ * @return			The name of the level.
+ */
+inline const char *getSIMDLevelName(int level)
+{
+	switch (level) {
+	case SIMDLevel_AVX512:
+		return "AVX-512";
+	case SIMDLevel_AVX2:
+		return "AVX2";
+	case SIMDLevel_SSE2:
+		return "SSE2";
+	default:
+		return "Scalar";
+	}
+}
+
+
+// NOTE: (sonictk) The wide variants can contract multiplies and adds into FMA
+// instructions where the CPU has them, which changes the rounding of the results.
+// These targets turn that contraction on.
+#if defined(SS_SIMD_TARGET_ATTRIBUTES)
+#define SS_HAS_FMA_TARGETS 1
+#define SS_TARGET_AVX2_FMA __attribute__((target("avx2,fma"), optimize("fp-contract=fast")))
+#define SS_TARGET_AVX512_FMA __attribute__((target("avx512f"), optimize("fp-contract=fast")))
+#endif // SS_SIMD_TARGET_ATTRIBUTES
+
+
+/// These instantiate a kernel for one packet type, with the same signature as the
+/// function pointer that they are bound to. They are kept out-of-line so that the
+/// code compiled for the wider instruction sets is never inlined into (and executed
+/// by) code compiled for the baseline one.
+template <class Kernel, class... Args>
+void runSIMDKernelScalar(Args... args)
+{
+	Kernel::template run<F32x1>(args...);
+}
+
+#if INSTRSET >= 2
+template <class Kernel, class... Args>
+void runSIMDKernelSSE2(Args... args)
+{
+	Kernel::template run<F32x4>(args...);
+}
+#endif // INSTRSET
+
+#ifdef SS_HAS_F32X8
+template <class Kernel, class... Args>
+SS_TARGET_AVX2 void runSIMDKernelAVX2(Args... args)
+{
+	Kernel::template run<F32x8>(args...);
+}
+#endif // SS_HAS_F32X8
+
+#ifdef SS_HAS_F32X16
+template <class Kernel, class... Args>
+SS_TARGET_AVX512 void runSIMDKernelAVX512(Args... args)
+{
+	Kernel::template run<F32x16>(args...);
+}
+#endif // SS_HAS_F32X16
+
+#ifdef SS_HAS_FMA_TARGETS
+template <class Kernel, class... Args>
+SS_TARGET_AVX2_FMA void runSIMDKernelAVX2FMA(Args... args)
+{
+	Kernel::template run<F32x8>(args...);
+}
+
+template <class Kernel, class... Args>
+SS_TARGET_AVX512_FMA void runSIMDKernelAVX512FMA(Args... args)
+{
+	Kernel::template run<F32x16>(args...);
+}
+#endif // SS_HAS_FMA_TARGETS
+
+
+/**
+ * Points a function pointer at the variant of a kernel for the given level.
+ *
+ * @param entry		The function pointer to bind.
+ * @param level		One of the ``SIMDLevel`` values. The CPU must support it.
+ * @param useFMA		Whether to use the variants that contract into FMA instructions.
+ * 					This is ignored below AVX2.
+ */
+template <class Kernel, class... Args>
+inline void bindSIMDKernel(void (*&entry)(Args...), int level, bool useFMA)
+{
+#ifdef SS_HAS_F32X16
+	if (level >= SIMDLevel_AVX512) {
+#ifdef SS_HAS_FMA_TARGETS
+		entry = useFMA ? &runSIMDKernelAVX512FMA<Kernel, Args...> : &runSIMDKernelAVX512<Kernel, Args...>;
+#else
+		entry = &runSIMDKernelAVX512<Kernel, Args...>;
+#endif // SS_HAS_FMA_TARGETS
+		return;
+	}
+#endif // SS_HAS_F32X16
+#ifdef SS_HAS_F32X8
+	if (level >= SIMDLevel_AVX2) {
+#ifdef SS_HAS_FMA_TARGETS
+		entry = useFMA ? &runSIMDKernelAVX2FMA<Kernel, Args...> : &runSIMDKernelAVX2<Kernel, Args...>;
+#else
+		entry = &runSIMDKernelAVX2<Kernel, Args...>;
+#endif // SS_HAS_FMA_TARGETS
+		return;
+	}
+#endif // SS_HAS_F32X8
+#if INSTRSET >= 2
+	if (level >= SIMDLevel_SSE2) {
+		entry = &runSIMDKernelSSE2<Kernel, Args...>;
+		return;
+	}
+#endif // INSTRSET
+	(void)useFMA;
+	entry = &runSIMDKernelScalar<Kernel, Args...>;
+}
+
+
+#endif /* SIMD_DISPATCH_H */
@@ -0,0 +1,523 @@
+/**
+ * @brief  	Thin wrappers around the SIMD float registers of each instruction set,
+ * 			so that batched kernels can be written once as templates over the
+ * 			packet type and instantiated for whichever widths are available.
+ * 			Every packet type exposes the same static members and operators.
+ */
+#ifndef SIMD_FLOAT_H
+#define SIMD_FLOAT_H
+
+#include "instrset.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+// NOTE: (sonictk) The wider packet types are also made available when the code is
+// compiled for a lower instruction set, so that kernels can be instantiated for
+// them and picked at runtime (see ``simd_dispatch.h``). On GCC/Clang, this means
+// compiling those functions with a ``target`` attribute; MSVC allows the intrinsics
+// anywhere. These targets never contract multiplies and adds into FMA (AVX-512F
+// implies it on GCC, so contraction is turned off there); the ``*_FMA`` targets of
+// ``simd_dispatch.h`` turn it back on. The kernel table uses those for the vector,
+// matrix, quaternion and transcendental kernels (e.g. ``transformPoints``, sine,
+// cosine, ``exponential`` and ``power``) when the CPU has FMA, so their results
+// differ between widths by a rounding. Only the noise, random number and point
+// cache kernels are always bound without FMA, and give the same bits at every width.
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__)) && !defined(__INTEL_COMPILER)
+#define SS_SIMD_TARGET_ATTRIBUTES 1
+#include <immintrin.h>
+#elif defined(_MSC_VER) && defined(__x86_64__)
+#define SS_SIMD_ANY_TARGET 1
+#include <immintrin.h>
+#endif // Compiler
+
+#if INSTRSET >= 7 || defined(SS_SIMD_TARGET_ATTRIBUTES) || defined(SS_SIMD_ANY_TARGET)
+#define SS_HAS_F32X8 1
+#endif
+
+#if INSTRSET >= 9 || defined(SS_SIMD_TARGET_ATTRIBUTES) || (defined(SS_SIMD_ANY_TARGET) && _MSC_VER >= 1911)
+#define SS_HAS_F32X16 1
+#endif
+
+// NOTE: (sonictk) GCC refuses to force-inline a function compiled for a wider target
+// into a generic one, even if that generic function is itself force-inlined into a
+// caller with the right target. The generic kernels are only ever instantiated with
+// the wide packets from inside such a caller, so the packet operations are left as
+// regular ``inline`` functions there and get inlined once the kernel has been.
+#if defined(SS_SIMD_TARGET_ATTRIBUTES) && INSTRSET < 8
+#define SS_AVX2_INLINE inline
+#define SS_TARGET_AVX2 __attribute__((target("avx2")))
+#if defined(__clang__)
+#define SS_BEGIN_TARGET_AVX2 _Pragma("clang attribute push (__attribute__((target(\"avx2\"))), apply_to = function)")
+#define SS_END_TARGET_AVX2 _Pragma("clang attribute pop")
+#else
+#define SS_BEGIN_TARGET_AVX2 _Pragma("GCC push_options") _Pragma("GCC target(\"avx2\")")
+#define SS_END_TARGET_AVX2 _Pragma("GCC pop_options")
+#endif // __clang__
+#else
+#define SS_AVX2_INLINE SS_FORCE_INLINE
+#define SS_TARGET_AVX2
+#define SS_BEGIN_TARGET_AVX2
+#define SS_END_TARGET_AVX2
+#endif // SS_SIMD_TARGET_ATTRIBUTES
+
+#if defined(SS_SIMD_TARGET_ATTRIBUTES) && INSTRSET < 9
+#define SS_AVX512_INLINE inline
+#define SS_TARGET_AVX512 __attribute__((target("avx512f"), optimize("fp-contract=off")))
+#if defined(__clang__)
+#define SS_BEGIN_TARGET_AVX512 _Pragma("clang attribute push (__attribute__((target(\"avx512f\"))), apply_to = function)")
+#define SS_END_TARGET_AVX512 _Pragma("clang attribute pop")
+#else
+#define SS_BEGIN_TARGET_AVX512 _Pragma("GCC push_options") _Pragma("GCC target(\"avx512f\")")
+#define SS_END_TARGET_AVX512 _Pragma("GCC pop_options")
+#endif // __clang__
+#else
+#define SS_AVX512_INLINE SS_FORCE_INLINE
+#define SS_TARGET_AVX512
+#define SS_BEGIN_TARGET_AVX512
+#define SS_END_TARGET_AVX512
+#endif // SS_SIMD_TARGET_ATTRIBUTES
+
+
+// NOTE: (sonictk) Kernels are written as templates over the packet types, and we
+// rely on everything collapsing into a single loop body for them to be fast.
+#if defined(_MSC_VER)
+#define SS_FORCE_INLINE __forceinline
+#elif defined(__GNUC__) || defined(__clang__)
+#define SS_FORCE_INLINE inline __attribute__((always_inline))
+#else
+#define SS_FORCE_INLINE inline
+#endif // Compiler
+
+
+/// The alignment (in bytes) of all SIMD streams; this is enough for the widest
+/// packet type (AVX-512) and is also the size of a cache line.
+static const unsigned int kSIMDAlignment = 64;
+
+/// The number of floats that streams are padded to a multiple of, so that kernels
+/// can always process whole packets of the widest type without a scalar tail.
+static const unsigned int kSIMDPadding = kSIMDAlignment / sizeof(float);
+
+
+/// Scalar fallback "packet", used when no SIMD instruction set is available.
+struct F32x1
+{
+	float v;
+
+	/// The result of a comparison, which ``select`` picks elements with.
+	typedef bool Mask;
+
+	static const unsigned int width = 1;
+
+	static SS_FORCE_INLINE F32x1 broadcast(float f) { F32x1 r = {f}; return r; }
+	static SS_FORCE_INLINE F32x1 load(const float *p) { F32x1 r = {*p}; return r; }
+	static SS_FORCE_INLINE F32x1 loadUnaligned(const float *p) { F32x1 r = {*p}; return r; }
+	SS_FORCE_INLINE void store(float *p) const { *p = v; }
+	SS_FORCE_INLINE void storeUnaligned(float *p) const { *p = v; }
+};
+
+SS_FORCE_INLINE F32x1 operator+(F32x1 a, F32x1 b) { F32x1 r = {a.v + b.v}; return r; }
+SS_FORCE_INLINE F32x1 operator-(F32x1 a, F32x1 b) { F32x1 r = {a.v - b.v}; return r; }
+SS_FORCE_INLINE F32x1 operator*(F32x1 a, F32x1 b) { F32x1 r = {a.v * b.v}; return r; }
+SS_FORCE_INLINE F32x1 operator/(F32x1 a, F32x1 b) { F32x1 r = {a.v / b.v}; return r; }
+SS_FORCE_INLINE F32x1 operator-(F32x1 a) { F32x1 r = {-a.v}; return r; }
+SS_FORCE_INLINE F32x1 squareRoot(F32x1 a) { F32x1 r = {sqrtf(a.v)}; return r; }
+/// Approximates ``1 / sqrt(a)``. The accuracy depends on the instruction set: there
+/// is no estimate instruction without SSE, so the scalar version is exact.
+SS_FORCE_INLINE F32x1 reciprocalSquareRootEstimate(F32x1 a) { F32x1 r = {1.0f / sqrtf(a.v)}; return r; }
+SS_FORCE_INLINE F32x1 minimum(F32x1 a, F32x1 b) { F32x1 r = {a.v < b.v ? a.v : b.v}; return r; }
+SS_FORCE_INLINE F32x1 maximum(F32x1 a, F32x1 b) { F32x1 r = {a.v > b.v ? a.v : b.v}; return r; }
+/// Returns ``a`` with its sign flipped wherever ``s`` is negative (including ``-0``).
+SS_FORCE_INLINE F32x1 multiplySign(F32x1 a, F32x1 s) { F32x1 r = {signbit(s.v) ? -a.v : a.v}; return r; }
+/// Compares every element; comparisons with ``NaN`` are false.
+SS_FORCE_INLINE bool compareLess(F32x1 a, F32x1 b) { return a.v < b.v; }
+SS_FORCE_INLINE bool compareEqual(F32x1 a, F32x1 b) { return a.v == b.v; }
+/// Returns ``a`` wherever ``mask`` is set and ``b`` elsewhere.
+SS_FORCE_INLINE F32x1 select(bool mask, F32x1 a, F32x1 b) { return mask ? a : b; }
+/// Returns ``a * 2^n``. ``n`` must be an integer in ``[-126, 127]``.
+SS_FORCE_INLINE F32x1 scaleByPowerOfTwo(F32x1 a, F32x1 n) {
+	unsigned int bits = (unsigned int)((int)n.v + 127) << 23;
+	float scale;
+	memcpy(&scale, &bits, sizeof(float));
+	F32x1 r = {a.v * scale}; return r;
+}
+/// Splits a positive, normal ``a`` into ``m * 2^e``, with ``m`` in ``[sqrt(1/2), sqrt(2))``.
+/// The mantissa ``m`` is returned and ``e`` is written to ``exponent``.
+SS_FORCE_INLINE F32x1 splitExponent(F32x1 a, F32x1 &exponent) {
+	unsigned int bits;
+	memcpy(&bits, &a.v, sizeof(float));
+	bits += 0x004afb0d;
+	exponent.v = (float)((int)(bits >> 23) - 127);
+	bits = (bits & 0x007fffff) + 0x3f3504f3;
+	F32x1 r;
+	memcpy(&r.v, &bits, sizeof(float));
+	return r;
+}
+/// Loads 4 consecutive floats from ``p + lane * stride`` for each lane, so that
+/// ``out[k]`` holds element ``k`` of every lane. This is a transposing load of
+/// ``width`` small AoS records into SoA packets.
+SS_FORCE_INLINE void loadTransposed4(const float *p, unsigned int stride, F32x1 out[4]) {
+	(void)stride;
+	out[0].v = p[0]; out[1].v = p[1]; out[2].v = p[2]; out[3].v = p[3];
+}
+/// The inverse of ``loadTransposed4``.
+SS_FORCE_INLINE void storeTransposed4(const F32x1 in[4], float *p, unsigned int stride) {
+	(void)stride;
+	p[0] = in[0].v; p[1] = in[1].v; p[2] = in[2].v; p[3] = in[3].v;
+}
+
+
+#if INSTRSET >= 2 // NOTE: (sonictk) Require SSE2 support for these intrinsics
+/// The result of comparing two ``F32x4``, with every bit of the true lanes set.
+struct M32x4
+{
+	__m128 v;
+};
+
+/// 4-wide SSE packet.
+struct F32x4
+{
+	__m128 v;
+
+	typedef M32x4 Mask;
+
+	static const unsigned int width = 4;
+
+	static SS_FORCE_INLINE F32x4 broadcast(float f) { F32x4 r = {_mm_set1_ps(f)}; return r; }
+	static SS_FORCE_INLINE F32x4 load(const float *p) { F32x4 r = {_mm_load_ps(p)}; return r; }
+	static SS_FORCE_INLINE F32x4 loadUnaligned(const float *p) { F32x4 r = {_mm_loadu_ps(p)}; return r; }
+	SS_FORCE_INLINE void store(float *p) const { _mm_store_ps(p, v); }
+	SS_FORCE_INLINE void storeUnaligned(float *p) const { _mm_storeu_ps(p, v); }
+};
+
+SS_FORCE_INLINE F32x4 operator+(F32x4 a, F32x4 b) { F32x4 r = {_mm_add_ps(a.v, b.v)}; return r; }
+SS_FORCE_INLINE F32x4 operator-(F32x4 a, F32x4 b) { F32x4 r = {_mm_sub_ps(a.v, b.v)}; return r; }
+SS_FORCE_INLINE F32x4 operator*(F32x4 a, F32x4 b) { F32x4 r = {_mm_mul_ps(a.v, b.v)}; return r; }
+SS_FORCE_INLINE F32x4 operator/(F32x4 a, F32x4 b) { F32x4 r = {_mm_div_ps(a.v, b.v)}; return r; }
+SS_FORCE_INLINE F32x4 operator-(F32x4 a) { F32x4 r = {_mm_xor_ps(a.v, _mm_set1_ps(-0.0f))}; return r; }
+SS_FORCE_INLINE F32x4 squareRoot(F32x4 a) { F32x4 r = {_mm_sqrt_ps(a.v)}; return r; }
+/// Relative error of at most ``1.5 * 2^-12``.
+SS_FORCE_INLINE F32x4 reciprocalSquareRootEstimate(F32x4 a) { F32x4 r = {_mm_rsqrt_ps(a.v)}; return r; }
+SS_FORCE_INLINE F32x4 minimum(F32x4 a, F32x4 b) { F32x4 r = {_mm_min_ps(a.v, b.v)}; return r; }
+SS_FORCE_INLINE F32x4 maximum(F32x4 a, F32x4 b) { F32x4 r = {_mm_max_ps(a.v, b.v)}; return r; }
+SS_FORCE_INLINE F32x4 multiplySign(F32x4 a, F32x4 s) {
+	F32x4 r = {_mm_xor_ps(a.v, _mm_and_ps(s.v, _mm_set1_ps(-0.0f)))}; return r;
+}
+SS_FORCE_INLINE M32x4 compareLess(F32x4 a, F32x4 b) { M32x4 r = {_mm_cmplt_ps(a.v, b.v)}; return r; }
+SS_FORCE_INLINE M32x4 compareEqual(F32x4 a, F32x4 b) { M32x4 r = {_mm_cmpeq_ps(a.v, b.v)}; return r; }
+// NOTE: (sonictk) ``blendv`` needs SSE4.1, so the lanes are masked instead.
+SS_FORCE_INLINE F32x4 select(M32x4 mask, F32x4 a, F32x4 b) {
+	F32x4 r = {_mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v))}; return r;
+}
+SS_FORCE_INLINE F32x4 scaleByPowerOfTwo(F32x4 a, F32x4 n) {
+	__m128i bits = _mm_slli_epi32(_mm_add_epi32(_mm_cvttps_epi32(n.v), _mm_set1_epi32(127)), 23);
+	F32x4 r = {_mm_mul_ps(a.v, _mm_castsi128_ps(bits))}; return r;
+}
+SS_FORCE_INLINE F32x4 splitExponent(F32x4 a, F32x4 &exponent) {
+	__m128i bits = _mm_add_epi32(_mm_castps_si128(a.v), _mm_set1_epi32(0x004afb0d));
+	exponent.v = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127)));
+	bits = _mm_add_epi32(_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)), _mm_set1_epi32(0x3f3504f3));
+	F32x4 r = {_mm_castsi128_ps(bits)}; return r;
+}
+// NOTE: (sonictk) The 4 rows that are loaded form a 4x4 block that is transposed
+// in registers; the wider types do the same within each 128-bit lane.
+SS_FORCE_INLINE void transpose4(__m128 &a, __m128 &b, __m128 &c, __m128 &d) {
+	__m128 t0 = _mm_unpacklo_ps(a, b);
+	__m128 t1 = _mm_unpacklo_ps(c, d);
+	__m128 t2 = _mm_unpackhi_ps(a, b);
+	__m128 t3 = _mm_unpackhi_ps(c, d);
+	a = _mm_movelh_ps(t0, t1);
+	b = _mm_movehl_ps(t1, t0);
+	c = _mm_movelh_ps(t2, t3);
+	d = _mm_movehl_ps(t3, t2);
+}
+SS_FORCE_INLINE void loadTransposed4(const float *p, unsigned int stride, F32x4 out[4]) {
+	__m128 a = _mm_loadu_ps(p);
+	__m128 b = _mm_loadu_ps(p + stride);
+	__m128 c = _mm_loadu_ps(p + 2 * stride);
+	__m128 d = _mm_loadu_ps(p + 3 * stride);
+	transpose4(a, b, c, d);
+	out[0].v = a; out[1].v = b; out[2].v = c; out[3].v = d;
+}
+SS_FORCE_INLINE void storeTransposed4(const F32x4 in[4], float *p, unsigned int stride) {
+	__m128 a = in[0].v, b = in[1].v, c = in[2].v, d = in[3].v;
+	transpose4(a, b, c, d);
+	_mm_storeu_ps(p, a);
+	_mm_storeu_ps(p + stride, b);
+	_mm_storeu_ps(p + 2 * stride, c);
+	_mm_storeu_ps(p + 3 * stride, d);
+}
+
+#endif // INSTRSET
+
+
+#ifdef SS_HAS_F32X8
+SS_BEGIN_TARGET_AVX2
+/// The result of comparing two ``F32x8``, with every bit of the true lanes set.
+struct M32x8
+{
+	__m256 v;
+};
+
+/// 8-wide AVX packet.
+struct F32x8
+{
+	__m256 v;
+
+	typedef M32x8 Mask;
+
+	static const unsigned int width = 8;
+
+	static SS_AVX2_INLINE F32x8 broadcast(float f) { F32x8 r = {_mm256_set1_ps(f)}; return r; }
+	static SS_AVX2_INLINE F32x8 load(const float *p) { F32x8 r = {_mm256_load_ps(p)}; return r; }
+	static SS_AVX2_INLINE F32x8 loadUnaligned(const float *p) { F32x8 r = {_mm256_loadu_ps(p)}; return r; }
+	SS_AVX2_INLINE void store(float *p) const { _mm256_store_ps(p, v); }
+	SS_AVX2_INLINE void storeUnaligned(float *p) const { _mm256_storeu_ps(p, v); }
+};
+
+SS_AVX2_INLINE F32x8 operator+(F32x8 a, F32x8 b) { F32x8 r = {_mm256_add_ps(a.v, b.v)}; return r; }
+SS_AVX2_INLINE F32x8 operator-(F32x8 a, F32x8 b) { F32x8 r = {_mm256_sub_ps(a.v, b.v)}; return r; }
+SS_AVX2_INLINE F32x8 operator*(F32x8 a, F32x8 b) { F32x8 r = {_mm256_mul_ps(a.v, b.v)}; return r; }
+SS_AVX2_INLINE F32x8 operator/(F32x8 a, F32x8 b) { F32x8 r = {_mm256_div_ps(a.v, b.v)}; return r; }
+SS_AVX2_INLINE F32x8 operator-(F32x8 a) { F32x8 r = {_mm256_xor_ps(a.v, _mm256_set1_ps(-0.0f))}; return r; }
+SS_AVX2_INLINE F32x8 squareRoot(F32x8 a) { F32x8 r = {_mm256_sqrt_ps(a.v)}; return r; }
+/// Relative error of at most ``1.5 * 2^-12``.
+SS_AVX2_INLINE F32x8 reciprocalSquareRootEstimate(F32x8 a) { F32x8 r = {_mm256_rsqrt_ps(a.v)}; return r; }
+SS_AVX2_INLINE F32x8 minimum(F32x8 a, F32x8 b) { F32x8 r = {_mm256_min_ps(a.v, b.v)}; return r; }
+SS_AVX2_INLINE F32x8 maximum(F32x8 a, F32x8 b) { F32x8 r = {_mm256_max_ps(a.v, b.v)}; return r; }
+SS_AVX2_INLINE F32x8 multiplySign(F32x8 a, F32x8 s) {
+	F32x8 r = {_mm256_xor_ps(a.v, _mm256_and_ps(s.v, _mm256_set1_ps(-0.0f)))}; return r;
+}
+SS_AVX2_INLINE M32x8 compareLess(F32x8 a, F32x8 b) { M32x8 r = {_mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ)}; return r; }
+SS_AVX2_INLINE M32x8 compareEqual(F32x8 a, F32x8 b) { M32x8 r = {_mm256_cmp_ps(a.v, b.v, _CMP_EQ_OQ)}; return r; }
+SS_AVX2_INLINE F32x8 select(M32x8 mask, F32x8 a, F32x8 b) { F32x8 r = {_mm256_blendv_ps(b.v, a.v, mask.v)}; return r; }
+// NOTE: (sonictk) ``F32x8`` is also used natively when only AVX is available, which
+// has no 256-bit integer operations, so the exponent bits are worked on in halves.
+SS_AVX2_INLINE F32x8 scaleByPowerOfTwo(F32x8 a, F32x8 n) {
+	__m256i e = _mm256_cvttps_epi32(n.v);
+	__m128i lo = _mm_slli_epi32(_mm_add_epi32(_mm256_castsi256_si128(e), _mm_set1_epi32(127)), 23);
+	__m128i hi = _mm_slli_epi32(_mm_add_epi32(_mm256_extractf128_si256(e, 1), _mm_set1_epi32(127)), 23);
+	__m256i bits = _mm256_insertf128_si256(_mm256_castsi128_si256(lo), hi, 1);
+	F32x8 r = {_mm256_mul_ps(a.v, _mm256_castsi256_ps(bits))}; return r;
+}
+SS_AVX2_INLINE F32x8 splitExponent(F32x8 a, F32x8 &exponent) {
+	__m256i bits = _mm256_castps_si256(a.v);
+	__m128i lo = _mm_add_epi32(_mm256_castsi256_si128(bits), _mm_set1_epi32(0x004afb0d));
+	__m128i hi = _mm_add_epi32(_mm256_extractf128_si256(bits, 1), _mm_set1_epi32(0x004afb0d));
+	__m128i loExponent = _mm_sub_epi32(_mm_srli_epi32(lo, 23), _mm_set1_epi32(127));
+	__m128i hiExponent = _mm_sub_epi32(_mm_srli_epi32(hi, 23), _mm_set1_epi32(127));
+	exponent.v = _mm256_cvtepi32_ps(_mm256_insertf128_si256(_mm256_castsi128_si256(loExponent), hiExponent, 1));
+	lo = _mm_add_epi32(_mm_and_si128(lo, _mm_set1_epi32(0x007fffff)), _mm_set1_epi32(0x3f3504f3));
+	hi = _mm_add_epi32(_mm_and_si128(hi, _mm_set1_epi32(0x007fffff)), _mm_set1_epi32(0x3f3504f3));
+	F32x8 r = {_mm256_castsi256_ps(_mm256_insertf128_si256(_mm256_castsi128_si256(lo), hi, 1))}; return r;
+}
+SS_AVX2_INLINE void transpose4(__m256 &a, __m256 &b, __m256 &c, __m256 &d) {
+	__m256 t0 = _mm256_unpacklo_ps(a, b);
+	__m256 t1 = _mm256_unpacklo_ps(c, d);
+	__m256 t2 = _mm256_unpackhi_ps(a, b);
+	__m256 t3 = _mm256_unpackhi_ps(c, d);
+	a = _mm256_shuffle_ps(t0, t1, 0x44);
+	b = _mm256_shuffle_ps(t0, t1, 0xEE);
+	c = _mm256_shuffle_ps(t2, t3, 0x44);
+	d = _mm256_shuffle_ps(t2, t3, 0xEE);
+}
+SS_AVX2_INLINE __m256 loadRowPair(const float *p, unsigned int stride) {
+	return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(p)), _mm_loadu_ps(p + 4 * stride), 1);
+}
+SS_AVX2_INLINE void storeRowPair(__m256 v, float *p, unsigned int stride) {
+	_mm_storeu_ps(p, _mm256_castps256_ps128(v));
+	_mm_storeu_ps(p + 4 * stride, _mm256_extractf128_ps(v, 1));
+}
+SS_AVX2_INLINE void loadTransposed4(const float *p, unsigned int stride, F32x8 out[4]) {
+	__m256 a = loadRowPair(p, stride);
+	__m256 b = loadRowPair(p + stride, stride);
+	__m256 c = loadRowPair(p + 2 * stride, stride);
+	__m256 d = loadRowPair(p + 3 * stride, stride);
+	transpose4(a, b, c, d);
+	out[0].v = a; out[1].v = b; out[2].v = c; out[3].v = d;
+}
+SS_AVX2_INLINE void storeTransposed4(const F32x8 in[4], float *p, unsigned int stride) {
+	__m256 a = in[0].v, b = in[1].v, c = in[2].v, d = in[3].v;
+	transpose4(a, b, c, d);
+	storeRowPair(a, p, stride);
+	storeRowPair(b, p + stride, stride);
+	storeRowPair(c, p + 2 * stride, stride);
+	storeRowPair(d, p + 3 * stride, stride);
+}
+
+SS_END_TARGET_AVX2
+#endif // SS_HAS_F32X8
+
+
+#ifdef SS_HAS_F32X16
+// NOTE: (sonictk) GCC implements the unmasked forms of many AVX-512 intrinsics by
+// merging into ``_mm512_undefined_ps()``, which trips ``-Wmaybe-uninitialized``
+// wherever they are inlined. The zero-masked forms with every lane selected
+// compile to exactly the same instructions, so those are used instead.
+#define SS_AVX512_ALL_LANES ((__mmask16)0xFFFF)
+
+SS_BEGIN_TARGET_AVX512
+/// The result of comparing two ``F32x16``, with one bit per lane.
+struct M32x16
+{
+	__mmask16 v;
+};
+
+/// 16-wide AVX-512 packet.
+struct F32x16
+{
+	__m512 v;
+
+	typedef M32x16 Mask;
+
+	static const unsigned int width = 16;
+
+	static SS_AVX512_INLINE F32x16 broadcast(float f) { F32x16 r = {_mm512_set1_ps(f)}; return r; }
+	static SS_AVX512_INLINE F32x16 load(const float *p) { F32x16 r = {_mm512_load_ps(p)}; return r; }
+	static SS_AVX512_INLINE F32x16 loadUnaligned(const float *p) { F32x16 r = {_mm512_loadu_ps(p)}; return r; }
+	SS_AVX512_INLINE void store(float *p) const { _mm512_store_ps(p, v); }
+	SS_AVX512_INLINE void storeUnaligned(float *p) const { _mm512_storeu_ps(p, v); }
+};
+
+SS_AVX512_INLINE F32x16 operator+(F32x16 a, F32x16 b) { F32x16 r = {_mm512_add_ps(a.v, b.v)}; return r; }
+SS_AVX512_INLINE F32x16 operator-(F32x16 a, F32x16 b) { F32x16 r = {_mm512_sub_ps(a.v, b.v)}; return r; }
+SS_AVX512_INLINE F32x16 operator*(F32x16 a, F32x16 b) { F32x16 r = {_mm512_mul_ps(a.v, b.v)}; return r; }
+SS_AVX512_INLINE F32x16 operator/(F32x16 a, F32x16 b) { F32x16 r = {_mm512_div_ps(a.v, b.v)}; return r; }
+SS_AVX512_INLINE F32x16 operator-(F32x16 a) { F32x16 r = {_mm512_sub_ps(_mm512_setzero_ps(), a.v)}; return r; }
+SS_AVX512_INLINE F32x16 squareRoot(F32x16 a) { F32x16 r = {_mm512_maskz_sqrt_ps(SS_AVX512_ALL_LANES, a.v)}; return r; }
+/// Relative error of at most ``2^-14``.
+SS_AVX512_INLINE F32x16 reciprocalSquareRootEstimate(F32x16 a) { F32x16 r = {_mm512_maskz_rsqrt14_ps(SS_AVX512_ALL_LANES, a.v)}; return r; }
+SS_AVX512_INLINE F32x16 minimum(F32x16 a, F32x16 b) { F32x16 r = {_mm512_maskz_min_ps(SS_AVX512_ALL_LANES, a.v, b.v)}; return r; }
+SS_AVX512_INLINE F32x16 maximum(F32x16 a, F32x16 b) { F32x16 r = {_mm512_maskz_max_ps(SS_AVX512_ALL_LANES, a.v, b.v)}; return r; }
+SS_AVX512_INLINE F32x16 multiplySign(F32x16 a, F32x16 s) {
+	// NOTE: (sonictk) The floating-point logical operations need AVX-512DQ, so go
+	// through the integer versions instead.
+	__m512i signBits = _mm512_and_si512(_mm512_castps_si512(s.v), _mm512_set1_epi32((int)0x80000000));
+	F32x16 r = {_mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(a.v), signBits))}; return r;
+}
+SS_AVX512_INLINE M32x16 compareLess(F32x16 a, F32x16 b) { M32x16 r = {_mm512_cmp_ps_mask(a.v, b.v, _CMP_LT_OQ)}; return r; }
+SS_AVX512_INLINE M32x16 compareEqual(F32x16 a, F32x16 b) { M32x16 r = {_mm512_cmp_ps_mask(a.v, b.v, _CMP_EQ_OQ)}; return r; }
+SS_AVX512_INLINE F32x16 select(M32x16 mask, F32x16 a, F32x16 b) { F32x16 r = {_mm512_mask_blend_ps(mask.v, b.v, a.v)}; return r; }
+SS_AVX512_INLINE F32x16 scaleByPowerOfTwo(F32x16 a, F32x16 n) {
+	__m512i bits = _mm512_maskz_slli_epi32(SS_AVX512_ALL_LANES,
+											_mm512_add_epi32(_mm512_maskz_cvttps_epi32(SS_AVX512_ALL_LANES, n.v), _mm512_set1_epi32(127)),
+											23);
+	F32x16 r = {_mm512_mul_ps(a.v, _mm512_castsi512_ps(bits))}; return r;
+}
+SS_AVX512_INLINE F32x16 splitExponent(F32x16 a, F32x16 &exponent) {
+	__m512i bits = _mm512_add_epi32(_mm512_castps_si512(a.v), _mm512_set1_epi32(0x004afb0d));
+	exponent.v = _mm512_maskz_cvtepi32_ps(SS_AVX512_ALL_LANES, _mm512_sub_epi32(_mm512_maskz_srli_epi32(SS_AVX512_ALL_LANES, bits, 23), _mm512_set1_epi32(127)));
+	bits = _mm512_add_epi32(_mm512_and_si512(bits, _mm512_set1_epi32(0x007fffff)), _mm512_set1_epi32(0x3f3504f3));
+	F32x16 r = {_mm512_castsi512_ps(bits)}; return r;
+}
+SS_AVX512_INLINE void transpose4(__m512 &a, __m512 &b, __m512 &c, __m512 &d) {
+	__m512 t0 = _mm512_maskz_unpacklo_ps(SS_AVX512_ALL_LANES, a, b);
+	__m512 t1 = _mm512_maskz_unpacklo_ps(SS_AVX512_ALL_LANES, c, d);
+	__m512 t2 = _mm512_maskz_unpackhi_ps(SS_AVX512_ALL_LANES, a, b);
+	__m512 t3 = _mm512_maskz_unpackhi_ps(SS_AVX512_ALL_LANES, c, d);
+	a = _mm512_shuffle_ps(t0, t1, 0x44);
+	b = _mm512_shuffle_ps(t0, t1, 0xEE);
+	c = _mm512_shuffle_ps(t2, t3, 0x44);
+	d = _mm512_shuffle_ps(t2, t3, 0xEE);
+}
+SS_AVX512_INLINE __m512 loadRowQuad(const float *p, unsigned int stride) {
+	__m512 v = _mm512_castps128_ps512(_mm_loadu_ps(p));
+	v = _mm512_insertf32x4(v, _mm_loadu_ps(p + 4 * stride), 1);
+	v = _mm512_insertf32x4(v, _mm_loadu_ps(p + 8 * stride), 2);
+	return _mm512_insertf32x4(v, _mm_loadu_ps(p + 12 * stride), 3);
+}
+SS_AVX512_INLINE void storeRowQuad(__m512 v, float *p, unsigned int stride) {
+	_mm_storeu_ps(p, _mm512_maskz_extractf32x4_ps((__mmask8)0xF, v, 0));
+	_mm_storeu_ps(p + 4 * stride, _mm512_maskz_extractf32x4_ps((__mmask8)0xF, v, 1));
+	_mm_storeu_ps(p + 8 * stride, _mm512_maskz_extractf32x4_ps((__mmask8)0xF, v, 2));
+	_mm_storeu_ps(p + 12 * stride, _mm512_maskz_extractf32x4_ps((__mmask8)0xF, v, 3));
+}
+SS_AVX512_INLINE void loadTransposed4(const float *p, unsigned int stride, F32x16 out[4]) {
+	__m512 a = loadRowQuad(p, stride);
+	__m512 b = loadRowQuad(p + stride, stride);
+	__m512 c = loadRowQuad(p + 2 * stride, stride);
+	__m512 d = loadRowQuad(p + 3 * stride, stride);
+	transpose4(a, b, c, d);
+	out[0].v = a; out[1].v = b; out[2].v = c; out[3].v = d;
+}
+SS_AVX512_INLINE void storeTransposed4(const F32x16 in[4], float *p, unsigned int stride) {
+	__m512 a = in[0].v, b = in[1].v, c = in[2].v, d = in[3].v;
+	transpose4(a, b, c, d);
+	storeRowQuad(a, p, stride);
+	storeRowQuad(b, p + stride, stride);
+	storeRowQuad(c, p + 2 * stride, stride);
+	storeRowQuad(d, p + 3 * stride, stride);
+}
+
+SS_END_TARGET_AVX512
+#endif // SS_HAS_F32X16
+
+
+/// This is the widest packet type supported by the instruction set that the
+/// code is being compiled for. Wider types may still be available for runtime
+/// dispatch.
+#if INSTRSET >= 9
+typedef F32x16 SIMDFloat;
+#elif INSTRSET >= 7
+typedef F32x8 SIMDFloat;
+#elif INSTRSET >= 2
+typedef F32x4 SIMDFloat;
+#else
+typedef F32x1 SIMDFloat;
+#endif // INSTRSET
+
+
+/**
+ * Allocates memory that is aligned to ``kSIMDAlignment``. Must be freed with
+ * ``freeAligned``.
+ *
+ * @param size		The number of bytes to allocate.
+ *
+ * @return			The allocated memory, or ``NULL`` if the allocation failed.
+ */
+inline void *allocateAligned(size_t size)
+{
+#if INSTRSET >= 2
+	// NOTE: (sonictk) ``_mm_malloc`` is made available by ``xmmintrin.h`` on all compilers
+	return _mm_malloc(size, kSIMDAlignment);
+#else
+	// NOTE: (sonictk) Over-allocate and stash the original pointer right before
+	// the aligned block so that it can be recovered when freeing.
+	void *raw = malloc(size + kSIMDAlignment + sizeof(void *));
+	if (!raw) {
+		return NULL;
+	}
+	uintptr_t aligned = ((uintptr_t)raw + sizeof(void *) + kSIMDAlignment - 1) & ~(uintptr_t)(kSIMDAlignment - 1);
+	((void **)aligned)[-1] = raw;
+
+	return (void *)aligned;
+#endif // INSTRSET
+}
+
+inline void freeAligned(void *ptr)
+{
+#if INSTRSET >= 2
+	_mm_free(ptr);
+#else
+	if (ptr) {
+		free(((void **)ptr)[-1]);
+	}
+#endif // INSTRSET
+}
+
+
+/**
+ * Rounds the given number of elements up to a multiple of ``kSIMDPadding``.
+ *
+ * @param count	The number of elements.
+ *
+ * @return			The padded number of elements.
+ */
+inline unsigned int padSIMDCount(unsigned int count)
+{
+	return (count + kSIMDPadding - 1) & ~(kSIMDPadding - 1);
+}
+
+
+#endif /* SIMD_FLOAT_H */
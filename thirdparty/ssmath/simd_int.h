@@ -0,0 +1,221 @@
+/**
+ * @brief  	32-bit unsigned integer packets to go with the float packets of
+ * 			``simd_float.h``, mainly for hashing. Every ``F32xN`` has a matching
+ * 			``U32xN`` of the same width, found through ``SIMDIntType``.
+ */
+#ifndef SIMD_INT_H
+#define SIMD_INT_H
+
+#include "simd_float.h"
+#include <stdint.h>
+
+
+/// Scalar fallback "packet".
+struct U32x1
+{
+	uint32_t v;
+
+	static const unsigned int width = 1;
+
+	static SS_FORCE_INLINE U32x1 broadcast(uint32_t i) { U32x1 r = {i}; return r; }
+	static SS_FORCE_INLINE U32x1 loadUnaligned(const uint32_t *p) { U32x1 r = {*p}; return r; }
+	SS_FORCE_INLINE void storeUnaligned(uint32_t *p) const { *p = v; }
+};
+
+SS_FORCE_INLINE U32x1 operator+(U32x1 a, U32x1 b) { U32x1 r = {a.v + b.v}; return r; }
+SS_FORCE_INLINE U32x1 operator-(U32x1 a, U32x1 b) { U32x1 r = {a.v - b.v}; return r; }
+SS_FORCE_INLINE U32x1 operator&(U32x1 a, U32x1 b) { U32x1 r = {a.v & b.v}; return r; }
+SS_FORCE_INLINE U32x1 operator|(U32x1 a, U32x1 b) { U32x1 r = {a.v | b.v}; return r; }
+SS_FORCE_INLINE U32x1 operator^(U32x1 a, U32x1 b) { U32x1 r = {a.v ^ b.v}; return r; }
+/// Keeps the low 32 bits of the product.
+SS_FORCE_INLINE U32x1 operator*(U32x1 a, U32x1 b) { U32x1 r = {a.v * b.v}; return r; }
+template <int n>
+SS_FORCE_INLINE U32x1 shiftLeft(U32x1 a) { U32x1 r = {a.v << n}; return r; }
+template <int n>
+SS_FORCE_INLINE U32x1 shiftRight(U32x1 a) { U32x1 r = {a.v >> n}; return r; }
+/// Shifts every element by the same number of bits, which is only known at runtime.
+/// Shifting by ``32`` or more gives zero, the same as the SIMD instructions.
+SS_FORCE_INLINE U32x1 shiftLeft(U32x1 a, unsigned int n) { U32x1 r = {n < 32 ? a.v << n : 0}; return r; }
+SS_FORCE_INLINE U32x1 shiftRight(U32x1 a, unsigned int n) { U32x1 r = {n < 32 ? a.v >> n : 0}; return r; }
+/// Converts every element to a float, treating the elements as signed integers.
+SS_FORCE_INLINE F32x1 convertToFloat(U32x1 a) { F32x1 r = {(float)(int32_t)a.v}; return r; }
+/// Converts every element to a signed integer, rounding towards zero. The elements
+/// must be within ``[-2^31, 2^31)``.
+SS_FORCE_INLINE U32x1 truncateToInt(F32x1 a) { U32x1 r = {(uint32_t)(int32_t)a.v}; return r; }
+/// Returns all bits set in the elements where ``a < b``, and zero elsewhere.
+SS_FORCE_INLINE U32x1 lessThan(F32x1 a, F32x1 b) { U32x1 r = {a.v < b.v ? 0xffffffffu : 0u}; return r; }
+
+
+#if INSTRSET >= 2 // NOTE: (sonictk) Require SSE2 support for these intrinsics
+struct U32x4
+{
+	__m128i v;
+
+	static const unsigned int width = 4;
+
+	static SS_FORCE_INLINE U32x4 broadcast(uint32_t i) { U32x4 r = {_mm_set1_epi32((int)i)}; return r; }
+	static SS_FORCE_INLINE U32x4 loadUnaligned(const uint32_t *p) { U32x4 r = {_mm_loadu_si128((const __m128i *)p)}; return r; }
+	SS_FORCE_INLINE void storeUnaligned(uint32_t *p) const { _mm_storeu_si128((__m128i *)p, v); }
+};
+
+SS_FORCE_INLINE U32x4 operator+(U32x4 a, U32x4 b) { U32x4 r = {_mm_add_epi32(a.v, b.v)}; return r; }
+SS_FORCE_INLINE U32x4 operator-(U32x4 a, U32x4 b) { U32x4 r = {_mm_sub_epi32(a.v, b.v)}; return r; }
+SS_FORCE_INLINE U32x4 operator&(U32x4 a, U32x4 b) { U32x4 r = {_mm_and_si128(a.v, b.v)}; return r; }
+SS_FORCE_INLINE U32x4 operator|(U32x4 a, U32x4 b) { U32x4 r = {_mm_or_si128(a.v, b.v)}; return r; }
+SS_FORCE_INLINE U32x4 operator^(U32x4 a, U32x4 b) { U32x4 r = {_mm_xor_si128(a.v, b.v)}; return r; }
+SS_FORCE_INLINE U32x4 operator*(U32x4 a, U32x4 b)
+{
+#if INSTRSET >= 5
+	U32x4 r = {_mm_mullo_epi32(a.v, b.v)}; return r;
+#else
+	// NOTE: (sonictk) SSE2 only multiplies the even elements into 64-bit results, so
+	// multiply the even and odd elements separately and interleave the low halves.
+	__m128i even = _mm_mul_epu32(a.v, b.v);
+	__m128i odd = _mm_mul_epu32(_mm_srli_si128(a.v, 4), _mm_srli_si128(b.v, 4));
+	U32x4 r = {_mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+								  _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)))};
+	return r;
+#endif // INSTRSET
+}
+template <int n>
+SS_FORCE_INLINE U32x4 shiftLeft(U32x4 a) { U32x4 r = {_mm_slli_epi32(a.v, n)}; return r; }
+template <int n>
+SS_FORCE_INLINE U32x4 shiftRight(U32x4 a) { U32x4 r = {_mm_srli_epi32(a.v, n)}; return r; }
+SS_FORCE_INLINE U32x4 shiftLeft(U32x4 a, unsigned int n) { U32x4 r = {_mm_sll_epi32(a.v, _mm_cvtsi32_si128((int)n))}; return r; }
+SS_FORCE_INLINE U32x4 shiftRight(U32x4 a, unsigned int n) { U32x4 r = {_mm_srl_epi32(a.v, _mm_cvtsi32_si128((int)n))}; return r; }
+SS_FORCE_INLINE F32x4 convertToFloat(U32x4 a) { F32x4 r = {_mm_cvtepi32_ps(a.v)}; return r; }
+SS_FORCE_INLINE U32x4 truncateToInt(F32x4 a) { U32x4 r = {_mm_cvttps_epi32(a.v)}; return r; }
+SS_FORCE_INLINE U32x4 lessThan(F32x4 a, F32x4 b) { U32x4 r = {_mm_castps_si128(_mm_cmplt_ps(a.v, b.v))}; return r; }
+#endif // INSTRSET
+
+
+// NOTE: (sonictk) Unlike ``F32x8``, these need AVX2 for the 256-bit integer operations.
+#ifdef SS_HAS_F32X8
+SS_BEGIN_TARGET_AVX2
+struct U32x8
+{
+	__m256i v;
+
+	static const unsigned int width = 8;
+
+	static SS_AVX2_INLINE U32x8 broadcast(uint32_t i) { U32x8 r = {_mm256_set1_epi32((int)i)}; return r; }
+	static SS_AVX2_INLINE U32x8 loadUnaligned(const uint32_t *p) { U32x8 r = {_mm256_loadu_si256((const __m256i *)p)}; return r; }
+	SS_AVX2_INLINE void storeUnaligned(uint32_t *p) const { _mm256_storeu_si256((__m256i *)p, v); }
+};
+
+SS_AVX2_INLINE U32x8 operator+(U32x8 a, U32x8 b) { U32x8 r = {_mm256_add_epi32(a.v, b.v)}; return r; }
+SS_AVX2_INLINE U32x8 operator-(U32x8 a, U32x8 b) { U32x8 r = {_mm256_sub_epi32(a.v, b.v)}; return r; }
+SS_AVX2_INLINE U32x8 operator&(U32x8 a, U32x8 b) { U32x8 r = {_mm256_and_si256(a.v, b.v)}; return r; }
+SS_AVX2_INLINE U32x8 operator|(U32x8 a, U32x8 b) { U32x8 r = {_mm256_or_si256(a.v, b.v)}; return r; }
+SS_AVX2_INLINE U32x8 operator^(U32x8 a, U32x8 b) { U32x8 r = {_mm256_xor_si256(a.v, b.v)}; return r; }
+SS_AVX2_INLINE U32x8 operator*(U32x8 a, U32x8 b) { U32x8 r = {_mm256_mullo_epi32(a.v, b.v)}; return r; }
+template <int n>
+SS_AVX2_INLINE U32x8 shiftLeft(U32x8 a) { U32x8 r = {_mm256_slli_epi32(a.v, n)}; return r; }
+template <int n>
+SS_AVX2_INLINE U32x8 shiftRight(U32x8 a) { U32x8 r = {_mm256_srli_epi32(a.v, n)}; return r; }
+SS_AVX2_INLINE U32x8 shiftLeft(U32x8 a, unsigned int n) { U32x8 r = {_mm256_sll_epi32(a.v, _mm_cvtsi32_si128((int)n))}; return r; }
+SS_AVX2_INLINE U32x8 shiftRight(U32x8 a, unsigned int n) { U32x8 r = {_mm256_srl_epi32(a.v, _mm_cvtsi32_si128((int)n))}; return r; }
+SS_AVX2_INLINE F32x8 convertToFloat(U32x8 a) { F32x8 r = {_mm256_cvtepi32_ps(a.v)}; return r; }
+SS_AVX2_INLINE U32x8 truncateToInt(F32x8 a) { U32x8 r = {_mm256_cvttps_epi32(a.v)}; return r; }
+SS_AVX2_INLINE U32x8 lessThan(F32x8 a, F32x8 b) { U32x8 r = {_mm256_castps_si256(_mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ))}; return r; }
+SS_END_TARGET_AVX2
+#endif // SS_HAS_F32X8
+
+
+#ifdef SS_HAS_F32X16
+SS_BEGIN_TARGET_AVX512
+struct U32x16
+{
+	__m512i v;
+
+	static const unsigned int width = 16;
+
+	static SS_AVX512_INLINE U32x16 broadcast(uint32_t i) { U32x16 r = {_mm512_set1_epi32((int)i)}; return r; }
+	static SS_AVX512_INLINE U32x16 loadUnaligned(const uint32_t *p) { U32x16 r = {_mm512_loadu_si512(p)}; return r; }
+	SS_AVX512_INLINE void storeUnaligned(uint32_t *p) const { _mm512_storeu_si512(p, v); }
+};
+
+SS_AVX512_INLINE U32x16 operator+(U32x16 a, U32x16 b) { U32x16 r = {_mm512_add_epi32(a.v, b.v)}; return r; }
+SS_AVX512_INLINE U32x16 operator-(U32x16 a, U32x16 b) { U32x16 r = {_mm512_sub_epi32(a.v, b.v)}; return r; }
+SS_AVX512_INLINE U32x16 operator&(U32x16 a, U32x16 b) { U32x16 r = {_mm512_and_si512(a.v, b.v)}; return r; }
+SS_AVX512_INLINE U32x16 operator|(U32x16 a, U32x16 b) { U32x16 r = {_mm512_or_si512(a.v, b.v)}; return r; }
+SS_AVX512_INLINE U32x16 operator^(U32x16 a, U32x16 b) { U32x16 r = {_mm512_xor_si512(a.v, b.v)}; return r; }
+SS_AVX512_INLINE U32x16 operator*(U32x16 a, U32x16 b) { U32x16 r = {_mm512_mullo_epi32(a.v, b.v)}; return r; }
+template <int n>
+SS_AVX512_INLINE U32x16 shiftLeft(U32x16 a) { U32x16 r = {_mm512_maskz_slli_epi32(SS_AVX512_ALL_LANES, a.v, n)}; return r; }
+template <int n>
+SS_AVX512_INLINE U32x16 shiftRight(U32x16 a) { U32x16 r = {_mm512_maskz_srli_epi32(SS_AVX512_ALL_LANES, a.v, n)}; return r; }
+SS_AVX512_INLINE U32x16 shiftLeft(U32x16 a, unsigned int n) { U32x16 r = {_mm512_maskz_sll_epi32(SS_AVX512_ALL_LANES, a.v, _mm_cvtsi32_si128((int)n))}; return r; }
+SS_AVX512_INLINE U32x16 shiftRight(U32x16 a, unsigned int n) { U32x16 r = {_mm512_maskz_srl_epi32(SS_AVX512_ALL_LANES, a.v, _mm_cvtsi32_si128((int)n))}; return r; }
+SS_AVX512_INLINE F32x16 convertToFloat(U32x16 a) { F32x16 r = {_mm512_maskz_cvtepi32_ps(SS_AVX512_ALL_LANES, a.v)}; return r; }
+SS_AVX512_INLINE U32x16 truncateToInt(F32x16 a) { U32x16 r = {_mm512_maskz_cvttps_epi32(SS_AVX512_ALL_LANES, a.v)}; return r; }
+SS_AVX512_INLINE U32x16 lessThan(F32x16 a, F32x16 b) {
+	U32x16 r = {_mm512_maskz_mov_epi32(_mm512_cmp_ps_mask(a.v, b.v, _CMP_LT_OQ), _mm512_set1_epi32(-1))}; return r;
+}
+SS_END_TARGET_AVX512
+#endif // SS_HAS_F32X16
+
+
+/// Map each float packet type to the integer packet type of the same width, and back.
+template <typename F>
+struct SIMDIntType;
+
+template <typename U>
+struct SIMDFloatType;
+
+template <>
+struct SIMDIntType<F32x1> { typedef U32x1 Type; };
+template <>
+struct SIMDFloatType<U32x1> { typedef F32x1 Type; };
+
+#if INSTRSET >= 2
+template <>
+struct SIMDIntType<F32x4> { typedef U32x4 Type; };
+template <>
+struct SIMDFloatType<U32x4> { typedef F32x4 Type; };
+#endif // INSTRSET
+
+#ifdef SS_HAS_F32X8
+template <>
+struct SIMDIntType<F32x8> { typedef U32x8 Type; };
+template <>
+struct SIMDFloatType<U32x8> { typedef F32x8 Type; };
+#endif // SS_HAS_F32X8
+
+#ifdef SS_HAS_F32X16
+template <>
+struct SIMDIntType<F32x16> { typedef U32x16 Type; };
+template <>
+struct SIMDFloatType<U32x16> { typedef F32x16 Type; };
+#endif // SS_HAS_F32X16
+
+
+/**
+ * Rounds every element down to the nearest integer, as a signed integer. The
+ * elements must be within ``[-2^31, 2^31)``.
+ */
+template <typename F>
+SS_FORCE_INLINE typename SIMDIntType<F>::Type floorToInt(F a)
+{
+	typename SIMDIntType<F>::Type i = truncateToInt(a);
+
+	// NOTE: (sonictk) Truncation rounds negative values up, so subtract one wherever
+	// that happened. The mask is ``-1`` in those elements.
+	return i + lessThan(a, convertToFloat(i));
+}
+
+
+// NOTE: (sonictk) Kept at file scope rather than as a function-local static so that
+// it has internal linkage; see ``getSIMDLevel()`` for why that matters.
+static const uint32_t kPacketLaneOffsets[16] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15};
+
+/// The element offsets ``0, 1, 2, ...`` for a packet, e.g. for turning a starting
+/// index into the indices of every element.
+template <typename U>
+SS_FORCE_INLINE U packetLaneOffsets()
+{
+	return U::loadUnaligned(kPacketLaneOffsets);
+}
+
+
+#endif /* SIMD_INT_H */
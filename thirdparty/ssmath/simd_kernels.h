@@ -0,0 +1,1098 @@
+/**
+ * @brief  	A table of function pointers to the hot ``ssmath`` kernels, bound once at
+ * 			startup to the variants compiled for the best instruction set the CPU
+ * 			supports. This lets a single binary built for the baseline instruction
+ * 			set run the AVX2 (with FMA where available) and AVX-512 code paths on
+ * 			the machines that have them, without checking the CPU on every call.
+ *
+ * 			Every batched operation over streams goes through the table, so the
+ * 			public functions that validate the streams and call into it are
+ * 			declared here rather than next to their kernels.
+ *
+ * 			Each binary (i.e. the plugin and every build of the logic library) has
+ * 			its own table, which must be bound with ``initializeSIMDKernels``
+ * 			before use. The translation unit must also compile ``instrset.cpp``.
+ */
+#ifndef SIMD_KERNELS_H
+#define SIMD_KERNELS_H
+
+#include "matrix_math.h"
+#include "vector_stream.h"
+#include "quaternion_stream.h"
+#include "matrix_stream.h"
+#include "simd_math.h"
+#include "noise.h"
+#include "random.h"
+#include "half_stream.h"
+#include "point_codec.h"
+#include "simd_dispatch.h"
+
+
+/// The number of rotation orders, for the table of Euler rotation builders.
+static const unsigned int kNumRotationOrders = kZYX + 1;
+
+
+/**
+ * The kernels that are dispatched through the table. These are the raw kernels:
+ * they do no validation and don't update the count of the output streams, so the
+ * caller must make sure that the streams are valid for the operation (see the
+ * public functions of the same name for the requirements).
+ */
+struct SIMDKernelTable
+{
+	/// One of the ``SIMDLevel`` values that the kernels were bound for.
+	int level;
+	/// Whether the kernels contract multiplies and adds into FMA instructions.
+	/// Their results can then differ slightly from the other levels.
+	bool usesFMA;
+	/// Whether the half-precision conversions use the F16C instructions.
+	bool usesF16C;
+
+	void (*addStreams)(const Vec3Stream &a, const Vec3Stream &b, Vec3Stream &out);
+	void (*subtractStreams)(const Vec3Stream &a, const Vec3Stream &b, Vec3Stream &out);
+	void (*scaleStream)(const Vec3Stream &a, float factor, Vec3Stream &out);
+	void (*lerpStreams)(const Vec3Stream &a, float t, const Vec3Stream &b, Vec3Stream &out);
+	void (*innerProductStreams)(const Vec3Stream &a, const Vec3Stream &b, FloatStream &out);
+	void (*crossProductStreams)(const Vec3Stream &a, const Vec3Stream &b, Vec3Stream &out);
+	/// Indexed by ``PrecisionMode``.
+	void (*lengthStream[PrecisionMode_Count])(const Vec3Stream &a, FloatStream &out);
+	void (*normalizeStream[PrecisionMode_Count])(const Vec3Stream &a, Vec3Stream &out);
+
+	void (*transformPoints)(const Mat44 &mat, Vec3 *points, unsigned int numPoints);
+	void (*transformStream)(const Mat44 &mat, const Vec3Stream &in, Vec3Stream &out);
+	/// Indexed by ``RotationOrder``.
+	void (*buildEulerRotationMatrices[kNumRotationOrders])(const Vec3Stream &rotations, Mat44 *out);
+	void (*multiplyMat44Array)(const Mat44 *a, const Mat44 *b, Mat44 *out, unsigned int count);
+	void (*multiplyMat44ArrayBroadcast)(const Mat44 &a, const Mat44 *b, Mat44 *out, unsigned int count);
+	/// These set ``result`` to ``-1`` if any of the matrices did not have an inverse.
+	void (*inverseMat44Array)(const Mat44 *in, Mat44 *out, unsigned int count, int &result);
+	void (*inverseAffineMat44Array)(const Mat44 *in, Mat44 *out, unsigned int count, int &result);
+
+	void (*rotateStream)(const Quat &rotation, const Vec3Stream &in, Vec3Stream &out);
+	void (*rotateStreamPerPoint)(const QuatStream &rotations, const Vec3Stream &in, Vec3Stream &out);
+	void (*normalizeQuatStream)(const QuatStream &in, QuatStream &out);
+	void (*nlerpQuatStreams)(const QuatStream &a, float t, const QuatStream &b, QuatStream &out);
+	void (*slerpQuatStreams)(const QuatStream &a, float t, const QuatStream &b, QuatStream &out);
+	void (*blendDualQuaternions)(const DualQuat *transforms,
+								 const FloatStream *weights,
+								 unsigned int numInfluences,
+								 const Vec3Stream &in,
+								 Vec3Stream &out);
+
+	void (*sineStream)(const FloatStream &in, FloatStream &out);
+	void (*cosineStream)(const FloatStream &in, FloatStream &out);
+	void (*sinCosStream)(const FloatStream &in, FloatStream &outSin, FloatStream &outCos);
+	void (*exponentialStream)(const FloatStream &in, FloatStream &out);
+	void (*logarithmStream)(const FloatStream &in, FloatStream &out);
+	void (*powerStreams)(const FloatStream &x, const FloatStream &y, FloatStream &out);
+	void (*powerStream)(const FloatStream &x, float y, FloatStream &out);
+
+	/// Indexed by ``NoiseType``.
+	void (*noiseStream[NoiseType_Count])(const Vec3Stream &points, const NoiseSettings &settings, FloatStream &out);
+	void (*noiseStream4D[NoiseType_Count])(const Vec3Stream &points,
+										   float w,
+										   const NoiseSettings &settings,
+										   FloatStream &out);
+
+	void (*fillRandomFloatStream)(FloatStream &out, uint32_t seed, uint32_t firstIndex, float min, float max);
+	void (*fillRandomVec3Stream)(Vec3Stream &out, uint32_t seed, uint32_t firstIndex, float min, float max);
+
+	/// These convert whole padded blocks of ``kSIMDPadding`` elements.
+	void (*encodeHalves)(const float *in, uint16_t *out, unsigned int count);
+	void (*decodeHalves)(const uint16_t *in, float *out, unsigned int count);
+
+	/// Decodes a single frame, which must follow the last frame that the decoder
+	/// decoded (or be a keyframe). ``out`` may be ``NULL`` to only apply the deltas.
+	void (*decodePointCacheFrame)(const PointCache &cache,
+								  unsigned int frame,
+								  PointCacheDecoder &decoder,
+								  Vec3Stream *out);
+};
+
+
+/// Transforms a single packet of points. This is shared between the packet loop
+/// and the remainder, so that every point gets exactly the same operations.
+template <typename F>
+SS_FORCE_INLINE void transformPointsPacket(const F m[3][4], F &x, F &y, F &z)
+{
+	F rx = ((x * m[0][0]) + (y * m[0][1])) + ((z * m[0][2]) + m[0][3]);
+	F ry = ((x * m[1][0]) + (y * m[1][1])) + ((z * m[1][2]) + m[1][3]);
+	F rz = ((x * m[2][0]) + (y * m[2][1])) + ((z * m[2][2]) + m[2][3]);
+	x = rx;
+	y = ry;
+	z = rz;
+}
+
+/// See ``transformPoints``.
+struct TransformPointsKernel
+{
+	template <typename F>
+	static SS_FORCE_INLINE void run(const Mat44 &mat, Vec3 *points, unsigned int numPoints)
+	{
+		F m[3][4];
+		F32x1 m1[3][4];
+		for (int r=0; r < 3; ++r) {
+			for (int c=0; c < 4; ++c) {
+				m[r][c] = F::broadcast(mat[r][c]);
+				m1[r][c] = F32x1::broadcast(mat[r][c]);
+			}
+		}
+
+		unsigned int i = 0;
+		for (; i + F::width <= numPoints; i += F::width) {
+			Vec3Packet<F> v;
+			loadVec3PacketAoS(points + i, v);
+			transformPointsPacket(m, v.x, v.y, v.z);
+			storeVec3PacketAoS(points + i, v);
+		}
+
+		for (; i < numPoints; ++i) {
+			F32x1 px = {points[i].x};
+			F32x1 py = {points[i].y};
+			F32x1 pz = {points[i].z};
+			transformPointsPacket(m1, px, py, pz);
+			points[i] = vec3(px.v, py.v, pz.v);
+		}
+	}
+};
+
+struct TransformStreamKernel
+{
+	template <typename F>
+	static SS_FORCE_INLINE void run(const Mat44 &mat, const Vec3Stream &in, Vec3Stream &out)
+	{
+		F m[3][4];
+		for (int r=0; r < 3; ++r) {
+			for (int c=0; c < 4; ++c) {
+				m[r][c] = F::broadcast(mat[r][c]);
+			}
+		}
+
+		for (unsigned int i=0; i < in.count; i += F::width) {
+			Vec3Packet<F> v = loadVec3Packet<F>(in, i);
+			transformPointsPacket(m, v.x, v.y, v.z);
+			storeVec3Packet(out, i, v);
+		}
+	}
+};
+
+// NOTE: (sonictk) These wrap the kernels of ``vector_stream.h``, which are plain
+// function templates, into the form that ``bindSIMDKernel`` expects.
+struct AddStreamsKernel
+{
+	template <typename F>
+	static SS_FORCE_INLINE void run(const Vec3Stream &a, const Vec3Stream &b, Vec3Stream &out)
+	{
+		addStreamsKernel<F>(a, b, out);
+	}
+};
+
+struct SubtractStreamsKernel
+{
+	template <typename F>
+	static SS_FORCE_INLINE void run(const Vec3Stream &a, const Vec3Stream &b, Vec3Stream &out)
+	{
+		subtractStreamsKernel<F>(a, b, out);
+	}
+};
+
+struct ScaleStreamKernel
+{
+	template <typename F>
+	static SS_FORCE_INLINE void run(const Vec3Stream &a, float factor, Vec3Stream &out)
+	{
+		scaleStreamKernel<F>(a, factor, out);
+	}
+};
+
+struct LerpStreamsKernel
+{
+	template <typename F>
+	static SS_FORCE_INLINE void run(const Vec3Stream &a, float t, const Vec3Stream &b, Vec3Stream &out)
+	{
+		lerpStreamsKernel<F>(a, t, b, out);
+	}
+};
+
+struct InnerProductStreamsKernel
+{
+	template <typename F>
+	static SS_FORCE_INLINE void run(const Vec3Stream &a, const Vec3Stream &b, FloatStream &out)
+	{
+		innerProductStreamsKernel<F>(a, b, out);
+	}
+};
+
+struct CrossProductStreamsKernel
+{
+	template <typename F>
+	static SS_FORCE_INLINE void run(const Vec3Stream &a, const Vec3Stream &b, Vec3Stream &out)
+	{
+		crossProductStreamsKernel<F>(a, b, out);
+	}
+};
+
+template <PrecisionMode mode>
+struct LengthStreamKernel
+{
+	template <typename F>
+	static SS_FORCE_INLINE void run(const Vec3Stream &a, FloatStream &out)
+	{
+		lengthStreamKernel<mode, F>(a, out);
+	}
+};
+
+template <PrecisionMode mode>
+struct NormalizeStreamKernel
+{
+	template <typename F>
+	static SS_FORCE_INLINE void run(const Vec3Stream &a, Vec3Stream &out)
+	{
+		normalizeStreamKernel<mode, F>(a, out);
+	}
+};
+
+
+/**
+ * Binds every entry of the table to the variants for the given level.
+ *
+ * @param table		The table to bind.
+ * @param level		One of the ``SIMDLevel`` values. The CPU must support it.
+ * @param useFMA		Whether to use FMA instructions. The CPU must support them.
+ *
+ * @return				``0`` on success, a negative value if the level is unknown.
+ */
+inline int bindSIMDKernelTable(SIMDKernelTable &table, int level, bool useFMA)
+{
+	if (level != SIMDLevel_Scalar && level != SIMDLevel_SSE2
+		&& level != SIMDLevel_AVX2 && level != SIMDLevel_AVX512) {
+		return -1;
+	}
+
+	// NOTE: (sonictk) FMA is only available for the wide levels. Other compilers
+	// can't be told to contract per function, so those only have one variant.
+#ifdef SS_HAS_FMA_TARGETS
+	useFMA = useFMA && level >= SIMDLevel_AVX2;
+#else
+	useFMA = false;
+#endif // SS_HAS_FMA_TARGETS
+
+	table.level = level;
+	table.usesFMA = useFMA;
+
+	bindSIMDKernel<AddStreamsKernel>(table.addStreams, level, useFMA);
+	bindSIMDKernel<SubtractStreamsKernel>(table.subtractStreams, level, useFMA);
+	bindSIMDKernel<ScaleStreamKernel>(table.scaleStream, level, useFMA);
+	bindSIMDKernel<LerpStreamsKernel>(table.lerpStreams, level, useFMA);
+	bindSIMDKernel<InnerProductStreamsKernel>(table.innerProductStreams, level, useFMA);
+	bindSIMDKernel<CrossProductStreamsKernel>(table.crossProductStreams, level, useFMA);
+	bindSIMDKernel<LengthStreamKernel<PrecisionMode_Exact> >(table.lengthStream[PrecisionMode_Exact], level, useFMA);
+	bindSIMDKernel<LengthStreamKernel<PrecisionMode_Refined> >(table.lengthStream[PrecisionMode_Refined], level, useFMA);
+	bindSIMDKernel<LengthStreamKernel<PrecisionMode_Fast> >(table.lengthStream[PrecisionMode_Fast], level, useFMA);
+	bindSIMDKernel<NormalizeStreamKernel<PrecisionMode_Exact> >(table.normalizeStream[PrecisionMode_Exact], level, useFMA);
+	bindSIMDKernel<NormalizeStreamKernel<PrecisionMode_Refined> >(table.normalizeStream[PrecisionMode_Refined], level, useFMA);
+	bindSIMDKernel<NormalizeStreamKernel<PrecisionMode_Fast> >(table.normalizeStream[PrecisionMode_Fast], level, useFMA);
+
+	// NOTE: (sonictk) The AoS points have to be transposed four at a time, and with
+	// AVX-512 the extra inserts and extracts cost more than the wider math saves.
+	bindSIMDKernel<TransformPointsKernel>(table.transformPoints,
+										  level < SIMDLevel_AVX2 ? level : SIMDLevel_AVX2,
+										  useFMA);
+	bindSIMDKernel<TransformStreamKernel>(table.transformStream, level, useFMA);
+	bindSIMDKernel<EulerRotationMatricesKernel<kXYZ> >(table.buildEulerRotationMatrices[kXYZ], level, useFMA);
+	bindSIMDKernel<EulerRotationMatricesKernel<kYZX> >(table.buildEulerRotationMatrices[kYZX], level, useFMA);
+	bindSIMDKernel<EulerRotationMatricesKernel<kZXY> >(table.buildEulerRotationMatrices[kZXY], level, useFMA);
+	bindSIMDKernel<EulerRotationMatricesKernel<kXZY> >(table.buildEulerRotationMatrices[kXZY], level, useFMA);
+	bindSIMDKernel<EulerRotationMatricesKernel<kYXZ> >(table.buildEulerRotationMatrices[kYXZ], level, useFMA);
+	bindSIMDKernel<EulerRotationMatricesKernel<kZYX> >(table.buildEulerRotationMatrices[kZYX], level, useFMA);
+	bindSIMDKernel<MultiplyMat44ArrayKernel>(table.multiplyMat44Array, level, useFMA);
+	bindSIMDKernel<MultiplyMat44ArrayBroadcastKernel>(table.multiplyMat44ArrayBroadcast, level, useFMA);
+	bindSIMDKernel<InverseMat44ArrayKernel>(table.inverseMat44Array, level, useFMA);
+	bindSIMDKernel<InverseAffineMat44ArrayKernel>(table.inverseAffineMat44Array, level, useFMA);
+
+	bindSIMDKernel<RotateStreamKernel>(table.rotateStream, level, useFMA);
+	bindSIMDKernel<RotateStreamPerPointKernel>(table.rotateStreamPerPoint, level, useFMA);
+	bindSIMDKernel<NormalizeQuatStreamKernel>(table.normalizeQuatStream, level, useFMA);
+	bindSIMDKernel<NlerpQuatStreamsKernel>(table.nlerpQuatStreams, level, useFMA);
+	bindSIMDKernel<SlerpQuatStreamsKernel>(table.slerpQuatStreams, level, useFMA);
+	bindSIMDKernel<BlendDualQuatsKernel>(table.blendDualQuaternions, level, useFMA);
+
+	bindSIMDKernel<ApplyFunctionStreamKernel<SineFunction> >(table.sineStream, level, useFMA);
+	bindSIMDKernel<ApplyFunctionStreamKernel<CosineFunction> >(table.cosineStream, level, useFMA);
+	bindSIMDKernel<SinCosStreamKernel>(table.sinCosStream, level, useFMA);
+	bindSIMDKernel<ApplyFunctionStreamKernel<ExponentialFunction> >(table.exponentialStream, level, useFMA);
+	bindSIMDKernel<ApplyFunctionStreamKernel<LogarithmFunction> >(table.logarithmStream, level, useFMA);
+	bindSIMDKernel<PowerStreamsKernel>(table.powerStreams, level, useFMA);
+	bindSIMDKernel<PowerStreamKernel>(table.powerStream, level, useFMA);
+
+	// NOTE: (sonictk) The noise, the random streams and the point cache decoder
+	// promise the same results at every width, so they never use FMA.
+	bindSIMDKernel<NoiseStreamKernel<GradientNoiseFunction> >(table.noiseStream[NoiseType_Gradient], level, false);
+	bindSIMDKernel<NoiseStreamKernel<SimplexNoiseFunction> >(table.noiseStream[NoiseType_Simplex], level, false);
+	bindSIMDKernel<NoiseStreamKernel<GradientNoiseFunction> >(table.noiseStream4D[NoiseType_Gradient], level, false);
+	bindSIMDKernel<NoiseStreamKernel<SimplexNoiseFunction> >(table.noiseStream4D[NoiseType_Simplex], level, false);
+	bindSIMDKernel<RandomFloatStreamKernel>(table.fillRandomFloatStream, level, false);
+	bindSIMDKernel<RandomVec3StreamKernel>(table.fillRandomVec3Stream, level, false);
+	bindSIMDKernel<DecodePointCacheFrameKernel>(table.decodePointCacheFrame, level, false);
+
+	// NOTE: (sonictk) The F16C instructions come with AVX, so they are only used at
+	// the AVX2 level and above; lowering the level also switches to the (identical)
+	// software conversion.
+	table.usesF16C = false;
+	table.encodeHalves = &encodeHalvesScalar;
+	table.decodeHalves = &decodeHalvesScalar;
+#ifdef SS_HAS_F16C_TARGET
+	if (level >= SIMDLevel_AVX2 && hasF16C()) {
+		table.usesF16C = true;
+		table.encodeHalves = &encodeHalvesF16C;
+		table.decodeHalves = &decodeHalvesF16C;
+	}
+#endif // SS_HAS_F16C_TARGET
+
+	return 0;
+}
+
+
+/// The table for this binary. See ``initializeSIMDKernels``. This is ``static``
+/// for the same reason as ``maxSIMDLevel``.
+static SIMDKernelTable kSIMDKernels;
+
+
+/**
+ * Binds ``kSIMDKernels`` to the best variants for this CPU (limited by
+ * ``maxSIMDLevel``). FMA is used when ``hasFMA3`` reports that it is available.
+ * This can be called again after changing ``maxSIMDLevel`` to rebind the table.
+ *
+ * @return		The ``SIMDLevel`` that the table was bound for.
+ */
+inline int initializeSIMDKernels()
+{
+	int level = getSIMDLevel();
+	bindSIMDKernelTable(kSIMDKernels, level, hasFMA3());
+
+	return level;
+}
+
+
+/**
+ * Gets a name for the variants that the table is bound to, for logging.
+ *
+ * @param table		The table.
+ *
+ * @return				The name of the variants.
+ */
+inline const char *getSIMDKernelTableName(const SIMDKernelTable &table)
+{
+	if (table.usesFMA) {
+		return table.level >= SIMDLevel_AVX512 ? "AVX-512 (FMA)" : "AVX2 (FMA)";
+	}
+
+	return getSIMDLevelName(table.level);
+}
+
+
+// ---------------------------------------------------------------------------------
+// Vector streams
+// ---------------------------------------------------------------------------------
+
+/**
+ * These are the batched equivalents of the ``Vec3`` operators of the same name.
+ * Each of them operates on every vector of the input streams, which must all have
+ * the same count. The output stream must have been allocated with at least as
+ * much capacity as the inputs, and is allowed to alias any of the inputs. Its
+ * count will be set to the count of the inputs.
+ *
+ * @return		``0`` on success, a negative value if the streams are mismatched.
+ */
+inline int addStreams(const Vec3Stream &a, const Vec3Stream &b, Vec3Stream &out)
+{
+	if (a.count != b.count || out.capacity < a.count) {
+		return -1;
+	}
+	out.count = a.count;
+	kSIMDKernels.addStreams(a, b, out);
+
+	return 0;
+}
+
+inline int subtractStreams(const Vec3Stream &a, const Vec3Stream &b, Vec3Stream &out)
+{
+	if (a.count != b.count || out.capacity < a.count) {
+		return -1;
+	}
+	out.count = a.count;
+	kSIMDKernels.subtractStreams(a, b, out);
+
+	return 0;
+}
+
+inline int scaleStream(const Vec3Stream &a, float factor, Vec3Stream &out)
+{
+	if (out.capacity < a.count) {
+		return -1;
+	}
+	out.count = a.count;
+	kSIMDKernels.scaleStream(a, factor, out);
+
+	return 0;
+}
+
+inline int lerpStreams(const Vec3Stream &a, float t, const Vec3Stream &b, Vec3Stream &out)
+{
+	if (a.count != b.count || out.capacity < a.count) {
+		return -1;
+	}
+	out.count = a.count;
+	kSIMDKernels.lerpStreams(a, t, b, out);
+
+	return 0;
+}
+
+inline int innerProductStreams(const Vec3Stream &a, const Vec3Stream &b, FloatStream &out)
+{
+	if (a.count != b.count || out.capacity < a.count) {
+		return -1;
+	}
+	out.count = a.count;
+	kSIMDKernels.innerProductStreams(a, b, out);
+
+	return 0;
+}
+
+inline int crossProductStreams(const Vec3Stream &a, const Vec3Stream &b, Vec3Stream &out)
+{
+	if (a.count != b.count || out.capacity < a.count) {
+		return -1;
+	}
+	out.count = a.count;
+	kSIMDKernels.crossProductStreams(a, b, out);
+
+	return 0;
+}
+
+/**
+ * Gets the length of every vector, or normalizes every vector. The approximate
+ * precision modes trade accuracy for speed; see ``PrecisionMode`` for the error of
+ * each of them.
+ *
+ * @param a		The vectors.
+ * @param out		The stream to write the results to. May alias ``a``.
+ * @param mode		The precision to compute the results with.
+ *
+ * @return			``0`` on success, a negative value if the output stream is too small.
+ */
+inline int lengthStream(const Vec3Stream &a, FloatStream &out, PrecisionMode mode)
+{
+	if (out.capacity < a.count) {
+		return -1;
+	}
+	out.count = a.count;
+	kSIMDKernels.lengthStream[(unsigned int)mode < PrecisionMode_Count ? mode : PrecisionMode_Exact](a, out);
+
+	return 0;
+}
+
+inline int lengthStream(const Vec3Stream &a, FloatStream &out)
+{
+	return lengthStream(a, out, PrecisionMode_Exact);
+}
+
+inline int normalizeStream(const Vec3Stream &a, Vec3Stream &out, PrecisionMode mode)
+{
+	if (out.capacity < a.count) {
+		return -1;
+	}
+	out.count = a.count;
+	kSIMDKernels.normalizeStream[(unsigned int)mode < PrecisionMode_Count ? mode : PrecisionMode_Exact](a, out);
+
+	return 0;
+}
+
+inline int normalizeStream(const Vec3Stream &a, Vec3Stream &out)
+{
+	return normalizeStream(a, out, PrecisionMode_Exact);
+}
+
+
+// ---------------------------------------------------------------------------------
+// Matrices
+// ---------------------------------------------------------------------------------
+
+/**
+ * Transforms the given points in-place by the matrix, treating each of them as a
+ * position (i.e. ``w = 1``). This is the batched equivalent of calling
+ * ``operator*(const Mat44 &, Vec3)`` on every point. The bottom row of the matrix
+ * is assumed to be ``[0, 0, 0, 1]``, as is the case for affine transforms.
+ *
+ * @param mat			The transformation matrix.
+ * @param points		The points to transform.
+ * @param numPoints	The number of points to transform.
+ */
+inline void transformPoints(const Mat44 &mat, Vec3 *points, unsigned int numPoints)
+{
+	kSIMDKernels.transformPoints(mat, points, numPoints);
+}
+
+/**
+ * The same as ``transformPoints``, for points stored in a stream.
+ *
+ * @param mat			The affine transformation matrix.
+ * @param in			The points to transform.
+ * @param out			The stream to write the transformed points to. May alias ``in``.
+ *
+ * @return				``0`` on success, a negative value if the output stream is too small.
+ */
+inline int transformStream(const Mat44 &mat, const Vec3Stream &in, Vec3Stream &out)
+{
+	if (out.capacity < in.count) {
+		return -1;
+	}
+	out.count = in.count;
+	kSIMDKernels.transformStream(mat, in, out);
+
+	return 0;
+}
+
+/**
+ * Builds a rotation matrix for every Euler rotation in the stream. This gives the
+ * same matrices as ``rotateBy(mat44(), rotation, order)``, but the sines and cosines
+ * are computed with ``sinCos`` for a whole packet of rotations at a time.
+ *
+ * @param rotations	The Euler rotations, in **degrees**.
+ * @param order		The rotation order shared by all of the rotations.
+ * @param out			Storage for ``rotations.count`` matrices.
+ *
+ * @return				``0`` on success, a negative value if ``out`` is ``NULL``.
+ */
+inline int buildEulerRotationMatrices(const Vec3Stream &rotations, RotationOrder order, Mat44 *out)
+{
+	if (!out && rotations.count > 0) {
+		return -1;
+	}
+
+	// NOTE: (sonictk) There is a builder for each order, so that the kernels never
+	// branch on the rotation order.
+	kSIMDKernels.buildEulerRotationMatrices[(unsigned int)order < kNumRotationOrders ? order : kXYZ](rotations, out);
+
+	return 0;
+}
+
+/**
+ * Multiplies each matrix of ``a`` with the matrix at the same index of ``b``.
+ * This is the batched version of ``operator*(const Mat44 &, const Mat44 &)``.
+ *
+ * @param a		The left-hand side matrices.
+ * @param b		The right-hand side matrices.
+ * @param out		The array to write the products to. May alias ``a`` or ``b``.
+ * @param count	The number of matrices in each array.
+ */
+inline void multiplyMat44Array(const Mat44 *a, const Mat44 *b, Mat44 *out, unsigned int count)
+{
+	kSIMDKernels.multiplyMat44Array(a, b, out, count);
+}
+
+/**
+ * Multiplies a single matrix with every matrix of ``b`` (e.g. to move a whole
+ * palette of joint matrices into the space of a parent).
+ *
+ * @param a		The left-hand side matrix.
+ * @param b		The right-hand side matrices.
+ * @param out		The array to write the products to. May alias ``b``.
+ * @param count	The number of matrices in ``b``.
+ */
+inline void multiplyMat44Array(const Mat44 &a, const Mat44 *b, Mat44 *out, unsigned int count)
+{
+	kSIMDKernels.multiplyMat44ArrayBroadcast(a, b, out, count);
+}
+
+/**
+ * Inverts every matrix of the given array. This is the batched version of
+ * ``inverse``. Matrices that have no inverse are written out as identity.
+ *
+ * @param in		The matrices to invert.
+ * @param out		The array to write the inverses to. May alias ``in``.
+ * @param count	The number of matrices.
+ *
+ * @return			``0`` on success, a negative value if any of the matrices
+ * 				did not have an inverse.
+ */
+inline int inverseMat44Array(const Mat44 *in, Mat44 *out, unsigned int count)
+{
+	int result = 0;
+	kSIMDKernels.inverseMat44Array(in, out, count, result);
+
+	return result;
+}
+
+/**
+ * Inverts every affine matrix of the given array. This is the batched version of
+ * ``inverseAffine``. Matrices that have no inverse are written out as identity.
+ *
+ * @param in		The affine matrices to invert.
+ * @param out		The array to write the inverses to. May alias ``in``.
+ * @param count	The number of matrices.
+ *
+ * @return			``0`` on success, a negative value if any of the matrices
+ * 				did not have an inverse.
+ */
+inline int inverseAffineMat44Array(const Mat44 *in, Mat44 *out, unsigned int count)
+{
+	int result = 0;
+	kSIMDKernels.inverseAffineMat44Array(in, out, count, result);
+
+	return result;
+}
+
+
+// ---------------------------------------------------------------------------------
+// Quaternions
+// ---------------------------------------------------------------------------------
+
+/**
+ * Rotates every vector of the input stream by the same quaternion.
+ *
+ * @param rotation		A unit quaternion.
+ * @param in			The vectors to rotate.
+ * @param out			The stream to write the rotated vectors to. May alias ``in``.
+ *
+ * @return				``0`` on success, a negative value if the output stream is too small.
+ */
+inline int rotateStream(const Quat &rotation, const Vec3Stream &in, Vec3Stream &out)
+{
+	if (out.capacity < in.count) {
+		return -1;
+	}
+	out.count = in.count;
+	kSIMDKernels.rotateStream(rotation, in, out);
+
+	return 0;
+}
+
+/**
+ * Rotates every vector of the input stream by the quaternion at the same index.
+ *
+ * @param rotations	Unit quaternions, one per vector.
+ * @param in			The vectors to rotate.
+ * @param out			The stream to write the rotated vectors to. May alias ``in``.
+ *
+ * @return				``0`` on success, a negative value if the streams are mismatched.
+ */
+inline int rotateStream(const QuatStream &rotations, const Vec3Stream &in, Vec3Stream &out)
+{
+	if (rotations.count != in.count || out.capacity < in.count) {
+		return -1;
+	}
+	out.count = in.count;
+	kSIMDKernels.rotateStreamPerPoint(rotations, in, out);
+
+	return 0;
+}
+
+/**
+ * Normalizes every quaternion of the input stream.
+ *
+ * @return		``0`` on success, a negative value if the output stream is too small.
+ */
+inline int normalizeQuatStream(const QuatStream &in, QuatStream &out)
+{
+	if (out.capacity < in.count) {
+		return -1;
+	}
+	out.count = in.count;
+	kSIMDKernels.normalizeQuatStream(in, out);
+
+	return 0;
+}
+
+/**
+ * Interpolates between the quaternions of two streams along the shortest arc.
+ * ``nlerpQuatStreams`` linearly interpolates and re-normalizes, which is cheaper
+ * but does not have a constant angular velocity; ``slerpQuatStreams`` does.
+ *
+ * @param a		The quaternions at ``t = 0``.
+ * @param t		The interpolation parameter.
+ * @param b		The quaternions at ``t = 1``.
+ * @param out		The stream to write the results to. May alias ``a`` or ``b``.
+ *
+ * @return			``0`` on success, a negative value if the streams are mismatched.
+ */
+inline int nlerpQuatStreams(const QuatStream &a, float t, const QuatStream &b, QuatStream &out)
+{
+	if (a.count != b.count || out.capacity < a.count) {
+		return -1;
+	}
+	out.count = a.count;
+	kSIMDKernels.nlerpQuatStreams(a, t, b, out);
+
+	return 0;
+}
+
+inline int slerpQuatStreams(const QuatStream &a, float t, const QuatStream &b, QuatStream &out)
+{
+	if (a.count != b.count || out.capacity < a.count) {
+		return -1;
+	}
+	out.count = a.count;
+	kSIMDKernels.slerpQuatStreams(a, t, b, out);
+
+	return 0;
+}
+
+/**
+ * Deforms every point of the input stream by a weighted blend of rigid transforms
+ * using dual quaternion linear blending.
+ *
+ * @param transforms		The unit dual quaternions of each influence.
+ * @param weights			One stream per influence, holding its weight for each point.
+ * @param numInfluences	The number of influences.
+ * @param in				The points to deform.
+ * @param out				The stream to write the deformed points to. May alias ``in``.
+ *
+ * @return					``0`` on success, a negative value if there are no
+ * 						influences or the streams are mismatched.
+ */
+inline int blendDualQuaternions(const DualQuat *transforms,
+								const FloatStream *weights,
+								unsigned int numInfluences,
+								const Vec3Stream &in,
+								Vec3Stream &out)
+{
+	if (numInfluences == 0 || !transforms || !weights || out.capacity < in.count) {
+		return -1;
+	}
+	for (unsigned int j=0; j < numInfluences; ++j) {
+		if (weights[j].count != in.count) {
+			return -1;
+		}
+	}
+	out.count = in.count;
+	kSIMDKernels.blendDualQuaternions(transforms, weights, numInfluences, in, out);
+
+	return 0;
+}
+
+
+// ---------------------------------------------------------------------------------
+// Transcendental functions
+// ---------------------------------------------------------------------------------
+
+/**
+ * Applies ``sine``, ``cosine``, ``exponential`` or ``logarithm`` to every element
+ * of the input stream. See the packet versions for their ranges and errors.
+ *
+ * @param in		The input values.
+ * @param out		The stream to write the results to. May alias ``in``.
+ *
+ * @return			``0`` on success, a negative value if the output stream is too small.
+ */
+inline int sineStream(const FloatStream &in, FloatStream &out)
+{
+	if (out.capacity < in.count) {
+		return -1;
+	}
+	out.count = in.count;
+	kSIMDKernels.sineStream(in, out);
+
+	return 0;
+}
+
+inline int cosineStream(const FloatStream &in, FloatStream &out)
+{
+	if (out.capacity < in.count) {
+		return -1;
+	}
+	out.count = in.count;
+	kSIMDKernels.cosineStream(in, out);
+
+	return 0;
+}
+
+inline int exponentialStream(const FloatStream &in, FloatStream &out)
+{
+	if (out.capacity < in.count) {
+		return -1;
+	}
+	out.count = in.count;
+	kSIMDKernels.exponentialStream(in, out);
+
+	return 0;
+}
+
+inline int logarithmStream(const FloatStream &in, FloatStream &out)
+{
+	if (out.capacity < in.count) {
+		return -1;
+	}
+	out.count = in.count;
+	kSIMDKernels.logarithmStream(in, out);
+
+	return 0;
+}
+
+/**
+ * Computes both the sine and cosine of every element of the input stream.
+ *
+ * @param in		The angles, in radians.
+ * @param outSin	The stream to write the sines to. May alias ``in``.
+ * @param outCos	The stream to write the cosines to. Must not alias ``outSin``.
+ *
+ * @return			``0`` on success, a negative value if an output stream is too small.
+ */
+inline int sinCosStream(const FloatStream &in, FloatStream &outSin, FloatStream &outCos)
+{
+	if (outSin.capacity < in.count || outCos.capacity < in.count) {
+		return -1;
+	}
+	outSin.count = outCos.count = in.count;
+	kSIMDKernels.sinCosStream(in, outSin, outCos);
+
+	return 0;
+}
+
+/**
+ * Raises every element of ``x`` to the power of the element of ``y`` at the same index.
+ *
+ * @param x		The bases. See ``power`` for the restrictions.
+ * @param y		The exponents.
+ * @param out		The stream to write the results to. May alias either input.
+ *
+ * @return			``0`` on success, a negative value if the streams are mismatched.
+ */
+inline int powerStreams(const FloatStream &x, const FloatStream &y, FloatStream &out)
+{
+	if (x.count != y.count || out.capacity < x.count) {
+		return -1;
+	}
+	out.count = x.count;
+	kSIMDKernels.powerStreams(x, y, out);
+
+	return 0;
+}
+
+/**
+ * Raises every element of ``x`` to the same power.
+ *
+ * @param x		The bases. See ``power`` for the restrictions.
+ * @param y		The exponent.
+ * @param out		The stream to write the results to. May alias ``x``.
+ *
+ * @return			``0`` on success, a negative value if the output stream is too small.
+ */
+inline int powerStream(const FloatStream &x, float y, FloatStream &out)
+{
+	if (out.capacity < x.count) {
+		return -1;
+	}
+	out.count = x.count;
+	kSIMDKernels.powerStream(x, y, out);
+
+	return 0;
+}
+
+
+// ---------------------------------------------------------------------------------
+// Noise and random numbers
+// ---------------------------------------------------------------------------------
+
+/**
+ * Evaluates fractal noise at every point of the stream.
+ *
+ * @param points		The positions to sample the noise at.
+ * @param settings		The kind of noise and its fractal parameters.
+ * @param out			The stream to write the noise to.
+ *
+ * @return				``0`` on success, a negative value if the output stream is too
+ * 					small or ``settings.octaves`` is ``0``.
+ */
+inline int noiseStream(const Vec3Stream &points, const NoiseSettings &settings, FloatStream &out)
+{
+	if (out.capacity < points.count || settings.octaves == 0) {
+		return -1;
+	}
+	out.count = points.count;
+	kSIMDKernels.noiseStream[(unsigned int)settings.type < NoiseType_Count ? settings.type : NoiseType_Gradient](points, settings, out);
+
+	return 0;
+}
+
+/**
+ * Evaluates 4D fractal noise at every point of the stream, with the same fourth
+ * coordinate (e.g. the time) for every point. See the 3D version for details.
+ */
+inline int noiseStream(const Vec3Stream &points, float w, const NoiseSettings &settings, FloatStream &out)
+{
+	if (out.capacity < points.count || settings.octaves == 0) {
+		return -1;
+	}
+	out.count = points.count;
+	kSIMDKernels.noiseStream4D[(unsigned int)settings.type < NoiseType_Count ? settings.type : NoiseType_Gradient](points, w, settings, out);
+
+	return 0;
+}
+
+/**
+ * Fills a stream with random values that are uniformly distributed in ``[min, max)``.
+ * Element ``i`` of the stream gets the value for index ``firstIndex + i``, so a large
+ * range can be split into chunks across threads and the values will be identical
+ * to generating the whole range at once.
+ *
+ * @param out			The stream to fill. All ``out.count`` elements are written.
+ * @param seed			The seed.
+ * @param firstIndex	The index of the first element of the stream.
+ * @param min			The lower bound of the values.
+ * @param max			The upper bound of the values.
+ *
+ * @return				``0`` on success, a negative value if ``max`` is less than ``min``.
+ */
+inline int fillRandomStream(FloatStream &out, uint32_t seed, uint32_t firstIndex, float min, float max)
+{
+	if (max < min) {
+		return -1;
+	}
+	kSIMDKernels.fillRandomFloatStream(out, seed, firstIndex, min, max);
+
+	return 0;
+}
+
+inline int fillRandomStream(FloatStream &out, uint32_t seed, uint32_t firstIndex)
+{
+	return fillRandomStream(out, seed, firstIndex, 0.0f, 1.0f);
+}
+
+/**
+ * Fills a stream with random vectors, each component of which is uniformly
+ * distributed in ``[min, max)``. See the ``FloatStream`` version for details.
+ *
+ * @param out			The stream to fill. All ``out.count`` vectors are written.
+ * @param seed			The seed.
+ * @param firstIndex	The index of the first vector of the stream.
+ * @param min			The lower bound of the components.
+ * @param max			The upper bound of the components.
+ *
+ * @return				``0`` on success, a negative value if ``max`` is less than ``min``.
+ */
+inline int fillRandomStream(Vec3Stream &out, uint32_t seed, uint32_t firstIndex, float min, float max)
+{
+	if (max < min) {
+		return -1;
+	}
+	kSIMDKernels.fillRandomVec3Stream(out, seed, firstIndex, min, max);
+
+	return 0;
+}
+
+
+// ---------------------------------------------------------------------------------
+// Caches
+// ---------------------------------------------------------------------------------
+
+/**
+ * Converts a stream to half precision, e.g. to store it in a cache. The output
+ * stream must have been allocated with at least as much capacity as the input,
+ * and its count will be set to the count of the input.
+ *
+ * @param in		The stream to convert.
+ * @param out		The stream to write the halves to.
+ *
+ * @return			``0`` on success, a negative value if the output stream is too small.
+ */
+inline int encodeHalfStream(const FloatStream &in, HalfStream &out)
+{
+	if (out.capacity < in.count) {
+		return -1;
+	}
+	out.count = in.count;
+	kSIMDKernels.encodeHalves(in.e, out.e, padSIMDCount(in.count));
+
+	return 0;
+}
+
+inline int encodeHalfStream(const Vec3Stream &in, HalfVec3Stream &out)
+{
+	if (out.capacity < in.count) {
+		return -1;
+	}
+	out.count = in.count;
+	unsigned int padded = padSIMDCount(in.count);
+	kSIMDKernels.encodeHalves(in.x, out.x, padded);
+	kSIMDKernels.encodeHalves(in.y, out.y, padded);
+	kSIMDKernels.encodeHalves(in.z, out.z, padded);
+
+	return 0;
+}
+
+/**
+ * Converts a half-precision stream back to single precision. The output stream
+ * must have been allocated with at least as much capacity as the input, and its
+ * count will be set to the count of the input.
+ *
+ * @param in		The stream to convert.
+ * @param out		The stream to write the floats to.
+ *
+ * @return			``0`` on success, a negative value if the output stream is too small.
+ */
+inline int decodeHalfStream(const HalfStream &in, FloatStream &out)
+{
+	if (out.capacity < in.count) {
+		return -1;
+	}
+	out.count = in.count;
+	kSIMDKernels.decodeHalves(in.e, out.e, padSIMDCount(in.count));
+
+	return 0;
+}
+
+inline int decodeHalfStream(const HalfVec3Stream &in, Vec3Stream &out)
+{
+	if (out.capacity < in.count) {
+		return -1;
+	}
+	out.count = in.count;
+	unsigned int padded = padSIMDCount(in.count);
+	kSIMDKernels.decodeHalves(in.x, out.x, padded);
+	kSIMDKernels.decodeHalves(in.y, out.y, padded);
+	kSIMDKernels.decodeHalves(in.z, out.z, padded);
+
+	return 0;
+}
+
+/**
+ * Decodes a frame of the cache. Decoding the frame after the last one decoded only
+ * applies that frame's deltas; any other frame is decoded starting from the
+ * keyframe before it.
+ *
+ * @param cache		The cache to decode from.
+ * @param frame		The frame to decode.
+ * @param decoder		A decoder created for this cache.
+ * @param out			The stream to write the positions to. It must have been
+ * 					allocated with at least ``cache.numPoints`` capacity.
+ *
+ * @return				``0`` on success, a negative value if the frame does not exist,
+ * 					the decoder was not created for the cache, or the output
+ * 					stream is too small.
+ */
+inline int decodePointCacheFrame(const PointCache &cache, unsigned int frame, PointCacheDecoder &decoder, Vec3Stream &out)
+{
+	if (frame >= cache.numFrames
+		|| decoder.numChunks != cache.numChunks
+		|| !decoder.quantized
+		|| out.capacity < cache.numPoints) {
+		return -1;
+	}
+	out.count = cache.numPoints;
+
+	unsigned int first = frame - (frame % cache.keyframeInterval);
+	if (decoder.frame >= (int)first && decoder.frame < (int)frame) {
+		first = decoder.frame + 1;
+	}
+	for (unsigned int f=first; f < frame; ++f) {
+		kSIMDKernels.decodePointCacheFrame(cache, f, decoder, (Vec3Stream *)NULL);
+	}
+	kSIMDKernels.decodePointCacheFrame(cache, frame, decoder, &out);
+	decoder.frame = (int)frame;
+
+	return 0;
+}
+
+
+#endif /* SIMD_KERNELS_H */
@@ -0,0 +1,285 @@
+/**
+ * @brief  	Transcendental functions over the packet types of ``simd_float.h``. These
+ * 			are written once as templates, so they work for every packet width
+ * 			(including the scalar ``F32x1``). The stream versions are bound into
+ * 			the kernel table for the widest packet type that the CPU supports (see
+ * 			``simd_kernels.h``), with FMA contraction when the CPU has it, so the
+ * 			sine, cosine, exponential, logarithm and power streams are not
+ * 			bit-identical across widths; they stay within the errors quoted below.
+ * 			Only the noise, random number and point cache kernels are kept
+ * 			bit-exact at every width.
+ *
+ * 			The errors quoted are the largest seen when comparing against the
+ * 			correctly rounded (double-precision) results over the documented ranges.
+ */
+#ifndef SIMD_MATH_H
+#define SIMD_MATH_H
+
+#include "simd_float.h"
+#include "vector_stream.h"
+
+
+/**
+ * Rounds every element to the nearest integer (ties to even). This uses the
+ * ``1.5 * 2^23`` trick, so it only needs the basic arithmetic operators and is
+ * only valid for ``|x| < 2^22``.
+ */
+template <typename F>
+SS_FORCE_INLINE F roundNearest(F x)
+{
+	const F magic = F::broadcast(12582912.0f);
+	return (x + magic) - magic;
+}
+
+
+/**
+ * Computes the sine and cosine of every element at the same time.
+ *
+ * The argument is reduced to ``[-pi/4, pi/4]`` with a three-part Cody-Waite
+ * reduction by ``pi/2``, and the sine and cosine of the remainder are evaluated
+ * with the minimax polynomials from Cephes' ``sinf``/``cosf``. The quadrant then
+ * selects and negates the results. For ``|x| <= 8192`` the error is within 2 ULP
+ * of the correctly rounded result (absolute error below ``1e-7`` near the zeros);
+ * beyond that the reduction loses accuracy.
+ *
+ * @param x		The angles, in radians.
+ * @param s		Storage for the sines.
+ * @param c		Storage for the cosines.
+ */
+template <typename F>
+SS_FORCE_INLINE void sinCos(F x, F &s, F &c)
+{
+	const F one = F::broadcast(1.0f);
+	const F two = F::broadcast(2.0f);
+	const F half = F::broadcast(0.5f);
+	const F quarter = F::broadcast(0.25f);
+
+	F q = roundNearest(x * F::broadcast(0.636619772367581343f));
+	F y = ((x - (q * F::broadcast(1.5703125f)))
+		   - (q * F::broadcast(4.837512969970703125e-4f)))
+		- (q * F::broadcast(7.54978995489188216e-8f));
+
+	F z = y * y;
+	F sinY = y + ((y * z) * ((((F::broadcast(-1.9515295891e-4f) * z) + F::broadcast(8.3321608736e-3f)) * z)
+							 - F::broadcast(1.6666654611e-1f)));
+	F cosY = (one - (half * z))
+		+ ((z * z) * ((((F::broadcast(2.443315711809948e-5f) * z) - F::broadcast(1.388731625493765e-3f)) * z)
+					  + F::broadcast(4.166664568298827e-2f)));
+
+	// NOTE: (sonictk) Work out the quadrant ``r = q mod 4`` using float arithmetic
+	// only (``q`` is integral, so all of this is exact). Odd quadrants swap the sine
+	// and cosine, quadrants 2 and 3 negate the sine, and quadrants 1 and 2 negate the
+	// cosine. Blending with weights of exactly 0 and 1 is also exact.
+	F r = q - (F::broadcast(4.0f) * roundNearest((q * quarter) - F::broadcast(0.375f)));
+	F negateSin = roundNearest((r * half) - quarter);
+	F swap = r - (two * negateSin);
+	F keep = one - swap;
+	F negateCos = (swap + negateSin) - (two * swap * negateSin);
+
+	s = ((swap * cosY) + (keep * sinY)) * (one - (two * negateSin));
+	c = ((swap * sinY) + (keep * cosY)) * (one - (two * negateCos));
+}
+
+
+/// Sine of every element. See ``sinCos`` for the range and error.
+template <typename F>
+SS_FORCE_INLINE F sine(F x)
+{
+	F s, c;
+	sinCos(x, s, c);
+	return s;
+}
+
+/// Cosine of every element. See ``sinCos`` for the range and error.
+template <typename F>
+SS_FORCE_INLINE F cosine(F x)
+{
+	F s, c;
+	sinCos(x, s, c);
+	return c;
+}
+
+
+/**
+ * Computes ``e^x`` for every element.
+ *
+ * The argument is reduced to ``x = n * ln(2) + r`` with ``|r| <= ln(2) / 2`` and
+ * ``e^r`` is evaluated with the Cephes ``expf`` polynomial. The error is within
+ * 1 ULP for normal results. Results that would overflow give ``inf``, and results
+ * below the normal range gradually underflow to ``0``. ``NaN`` is not propagated.
+ *
+ * @param x		The exponents.
+ *
+ * @return			The exponentials.
+ */
+template <typename F>
+SS_FORCE_INLINE F exponential(F x)
+{
+	x = maximum(minimum(x, F::broadcast(89.0f)), F::broadcast(-104.0f));
+
+	F n = roundNearest(x * F::broadcast(1.44269504088896341f));
+	F r = (x - (n * F::broadcast(0.693359375f))) + (n * F::broadcast(2.12194440e-4f));
+
+	F p = F::broadcast(1.9875691500e-4f);
+	p = (p * r) + F::broadcast(1.3981999507e-3f);
+	p = (p * r) + F::broadcast(8.3334519073e-3f);
+	p = (p * r) + F::broadcast(4.1665795894e-2f);
+	p = (p * r) + F::broadcast(1.6666665459e-1f);
+	p = (p * r) + F::broadcast(5.0000001201e-1f);
+	p = p * (r * r);
+	p = (p + r) + F::broadcast(1.0f);
+
+	// NOTE: (sonictk) ``n`` can be outside the range of a normal exponent at both
+	// ends, so apply it in two halves; the final multiply then overflows or
+	// underflows the way that it should.
+	F halfN = roundNearest(n * F::broadcast(0.5f));
+	return scaleByPowerOfTwo(scaleByPowerOfTwo(p, halfN), n - halfN);
+}
+
+
+/**
+ * Computes the natural logarithm of every element.
+ *
+ * The argument is split into ``m * 2^e`` with ``m`` in ``[sqrt(1/2), sqrt(2))`` and
+ * ``ln(m)`` is evaluated with the Cephes ``logf`` polynomial. The error is within
+ * 1 ULP for positive, normal inputs. Like ``logf``, zero gives ``-inf`` and
+ * negative inputs give ``NaN``; denormal, infinite and ``NaN`` inputs give
+ * meaningless results.
+ *
+ * @param x		The values to take the logarithm of.
+ *
+ * @return			The logarithms.
+ */
+template <typename F>
+SS_FORCE_INLINE F logarithm(F x)
+{
+	F e;
+	F f = splitExponent(x, e) - F::broadcast(1.0f);
+
+	F z = f * f;
+	F p = F::broadcast(7.0376836292e-2f);
+	p = (p * f) - F::broadcast(1.1514610310e-1f);
+	p = (p * f) + F::broadcast(1.1676998740e-1f);
+	p = (p * f) - F::broadcast(1.2420140846e-1f);
+	p = (p * f) + F::broadcast(1.4249322787e-1f);
+	p = (p * f) - F::broadcast(1.6668057665e-1f);
+	p = (p * f) + F::broadcast(2.0000714765e-1f);
+	p = (p * f) - F::broadcast(2.4999993993e-1f);
+	p = (p * f) + F::broadcast(3.3333331174e-1f);
+	p = (p * f) * z;
+
+	// NOTE: (sonictk) ``ln(2)`` is split into a part that is exact when multiplied by
+	// any exponent, and a small correction.
+	p = (p - (e * F::broadcast(2.12194440e-4f))) - (F::broadcast(0.5f) * z);
+	F result = (f + p) + (e * F::broadcast(0.693359375f));
+
+	// NOTE: (sonictk) The exponent split is meaningless outside of the domain, so
+	// those elements are replaced once the polynomial has been evaluated.
+	const F zero = F::broadcast(0.0f);
+	result = select(compareEqual(x, zero), F::broadcast(-INFINITY), result);
+	return select(compareLess(x, zero), F::broadcast(NAN), result);
+}
+
+
+/**
+ * Computes ``x^y`` for every element as ``e^(y * ln(x))``.
+ *
+ * The rounding error of ``y * ln(x)`` is magnified by the exponential, so the error
+ * grows with the magnitude of the result's exponent: within 2 ULP while
+ * ``|y * ln(x)| <= 1``, within 17 ULP while it is at most 10, and up to 150 ULP near
+ * the limits of the float range (a relative error below ``1e-5``). Zero bases give
+ * ``0`` for positive exponents and ``inf`` for negative ones, negative bases give
+ * ``NaN`` (even for integer exponents), and a zero exponent always gives ``1``.
+ * Otherwise, ``x`` must satisfy the same restrictions as for ``logarithm``.
+ *
+ * @param x		The bases.
+ * @param y		The exponents.
+ *
+ * @return			The powers.
+ */
+template <typename F>
+SS_FORCE_INLINE F power(F x, F y)
+{
+	// NOTE: (sonictk) ``exponential`` does not propagate ``NaN``, so the domain
+	// of ``logarithm`` is checked again here.
+	F result = exponential(y * logarithm(x));
+	result = select(compareLess(x, F::broadcast(0.0f)), F::broadcast(NAN), result);
+	return select(compareEqual(y, F::broadcast(0.0f)), F::broadcast(1.0f), result);
+}
+
+
+struct SineFunction
+{
+	template <typename F>
+	static SS_FORCE_INLINE F apply(F x) { return sine(x); }
+};
+
+struct CosineFunction
+{
+	template <typename F>
+	static SS_FORCE_INLINE F apply(F x) { return cosine(x); }
+};
+
+struct ExponentialFunction
+{
+	template <typename F>
+	static SS_FORCE_INLINE F apply(F x) { return exponential(x); }
+};
+
+struct LogarithmFunction
+{
+	template <typename F>
+	static SS_FORCE_INLINE F apply(F x) { return logarithm(x); }
+};
+
+template <class Function>
+struct ApplyFunctionStreamKernel
+{
+	template <typename F>
+	static SS_FORCE_INLINE void run(const FloatStream &in, FloatStream &out)
+	{
+		for (unsigned int i=0; i < in.count; i += F::width) {
+			Function::template apply<F>(F::load(in.e + i)).store(out.e + i);
+		}
+	}
+};
+
+struct SinCosStreamKernel
+{
+	template <typename F>
+	static SS_FORCE_INLINE void run(const FloatStream &in, FloatStream &outSin, FloatStream &outCos)
+	{
+		for (unsigned int i=0; i < in.count; i += F::width) {
+			F s, c;
+			sinCos(F::load(in.e + i), s, c);
+			s.store(outSin.e + i);
+			c.store(outCos.e + i);
+		}
+	}
+};
+
+struct PowerStreamsKernel
+{
+	template <typename F>
+	static SS_FORCE_INLINE void run(const FloatStream &x, const FloatStream &y, FloatStream &out)
+	{
+		for (unsigned int i=0; i < x.count; i += F::width) {
+			power(F::load(x.e + i), F::load(y.e + i)).store(out.e + i);
+		}
+	}
+};
+
+struct PowerStreamKernel
+{
+	template <typename F>
+	static SS_FORCE_INLINE void run(const FloatStream &x, float y, FloatStream &out)
+	{
+		F exponent = F::broadcast(y);
+		for (unsigned int i=0; i < x.count; i += F::width) {
+			power(F::load(x.e + i), exponent).store(out.e + i);
+		}
+	}
+};
+
+
+#endif /* SIMD_MATH_H */
@@ -9,7 +9,7 @@ typedef LARGE_INTEGER HighResTimerVal;
 
 #elif __linux__ || __APPLE__
 
-typedef double HighResTimerVal;
+typedef double HighResTimerVal;	// NOTE: (sonictk) In nanoseconds
 
 #endif // Platform layer
 
@@ -17,13 +17,14 @@ typedef double HighResTimerVal;
 /// Performance timer API
 struct PerfTimer
 {
-	HighResTimerVal freq; // NOTE: (sonictk) On Linux/OSX, this is undefined
+	HighResTimerVal freq; // NOTE: (sonictk) On Linux/OSX, this is always 1e9 (i.e. nanoseconds)
 	HighResTimerVal start;
 	HighResTimerVal end;
 };
 
 
-/// This acts as a global timer that can used for the host application.
+/// This acts as a global timer that can used for the host application. It cannot
+/// time concurrent work; use the zones in ``profiler.h`` for that.
 globalVar PerfTimer kGlobalPerfTimer;
 
 // TODO: (yliangsiew) Document forward declarations
@@ -120,16 +121,16 @@ double getPerfTimerValue()
 // TODO: (sonictk) Eventually stop relying on stdlib
 #include <chrono>
 
-using std::chrono::high_resolution_clock;
+using std::chrono::steady_clock;
 using std::chrono::duration_cast;
-using std::chrono::microseconds;
-using std::chrono::time_point_cast;
+using std::chrono::nanoseconds;
 
 
-// TODO: (sonictk) Test timer functions on linux
+// NOTE: (sonictk) ``high_resolution_clock`` may be the system clock, which can jump,
+// so the monotonic clock is used instead.
 int resetPerfTimerValue(PerfTimer &timer)
 {
-	timer.freq = 0.0;
+	timer.freq = 1e9;
 	timer.start = 0.0;
 	timer.end = 0.0;
 
@@ -146,7 +147,7 @@ PerfTimer perfTimer()
 
 int startPerfTimer(PerfTimer &timer)
 {
-	timer.start = time_point_cast<microseconds>(high_resolution_clock::now()).time_since_epoch().count();
+	timer.start = (double)duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
 	return 0;
 }
 
@@ -158,7 +159,7 @@ int startPerfTimer()
 
 int endPerfTimer(PerfTimer &timer)
 {
-	timer.end = time_point_cast<microseconds>(high_resolution_clock::now()).time_since_epoch().count();
+	timer.end = (double)duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
 	return 0;
 }
 
@@ -169,7 +170,8 @@ int endPerfTimer()
 
 double getPerfTimerValue(PerfTimer &timer)
 {
-	return timer.end - timer.start;
+	// NOTE: (sonictk) In seconds, to match Windows.
+	return (timer.end - timer.start) / timer.freq;
 }
 
 double getPerfTimerValue()
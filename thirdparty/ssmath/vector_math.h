@@ -329,24 +329,74 @@ inline __m128 loadVec3(const Vec3 &vec)
 	// return _mm_shuffle_ps(xy, z, _MM_SHUFFLE(2, 0, 2, 0));
 }
 
+/// The inverse of ``loadVec3``; writes the X, Y and Z lanes of the register to
+/// ``vec`` without touching the memory past it.
+inline void storeVec3(Vec3 &vec, __m128 v)
+{
+	_mm_storel_pi((__m64 *)&vec, v);
+	_mm_store_ss(&vec.z, _mm_movehl_ps(v, v));
+}
+
+/**
+ * Loads four consecutive ``Vec3``s and transposes them into separate registers
+ * for each component (i.e. from ``XYZXYZXYZXYZ`` to ``XXXX``, ``YYYY``, ``ZZZZ``).
+ * The vectors do not need to be aligned.
+ *
+ * @param v	Pointer to the first of the four vectors.
+ * @param x	Will be set to the X components.
+ * @param y	Will be set to the Y components.
+ * @param z	Will be set to the Z components.
+ */
+inline void loadVec3x4(const Vec3 *v, __m128 &x, __m128 &y, __m128 &z)
+{
+	const float *f = (const float *)v;
+	__m128 a = _mm_loadu_ps(f);		// NOTE: (sonictk) x0 y0 z0 x1
+	__m128 b = _mm_loadu_ps(f + 4);	// NOTE: (sonictk) y1 z1 x2 y2
+	__m128 c = _mm_loadu_ps(f + 8);	// NOTE: (sonictk) z2 x3 y3 z3
+
+	__m128 x2y2x3y3 = _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 1, 3, 2));
+	__m128 y0z0y1z1 = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 0, 2, 1));
+
+	x = _mm_shuffle_ps(a, x2y2x3y3, _MM_SHUFFLE(2, 0, 3, 0));
+	y = _mm_shuffle_ps(y0z0y1z1, x2y2x3y3, _MM_SHUFFLE(3, 1, 2, 0));
+	z = _mm_shuffle_ps(y0z0y1z1, c, _MM_SHUFFLE(3, 0, 3, 1));
+}
+
+/**
+ * The inverse of ``loadVec3x4``; transposes the components back and stores them
+ * as four consecutive ``Vec3``s. The vectors do not need to be aligned.
+ *
+ * @param v	Pointer to the first of the four vectors to write to.
+ * @param x	The X components.
+ * @param y	The Y components.
+ * @param z	The Z components.
+ */
+inline void storeVec3x4(Vec3 *v, __m128 x, __m128 y, __m128 z)
+{
+	__m128 x0x2y0y2 = _mm_shuffle_ps(x, y, _MM_SHUFFLE(2, 0, 2, 0));
+	__m128 y1y3z1z3 = _mm_shuffle_ps(y, z, _MM_SHUFFLE(3, 1, 3, 1));
+	__m128 z0z2x1x3 = _mm_shuffle_ps(z, x, _MM_SHUFFLE(3, 1, 2, 0));
+
+	float *f = (float *)v;
+	_mm_storeu_ps(f, _mm_shuffle_ps(x0x2y0y2, z0z2x1x3, _MM_SHUFFLE(2, 0, 2, 0)));
+	_mm_storeu_ps(f + 4, _mm_shuffle_ps(y1y3z1z3, x0x2y0y2, _MM_SHUFFLE(3, 1, 2, 0)));
+	_mm_storeu_ps(f + 8, _mm_shuffle_ps(z0z2x1x3, y1y3z1z3, _MM_SHUFFLE(3, 1, 3, 1)));
+}
+
 inline Vec3 crossProduct(const Vec3 &v1, const Vec3 &v2)
 {
 	// NOTE: (sonictk) Referenced from http://fastcpp.blogspot.com/2011/04/vector-cross-product-using-sse-code.html
-	__m128 sseV1 = _mm_set_ps(v1.x, v1.y, v1.z, 0);
-	__m128 sseV2 = _mm_set_ps(v2.x, v2.y, v2.z, 0);
+	// Computes ``(v1 * v2.yzx - v2 * v1.yzx).yzx``; the W lane stays zero throughout.
+	__m128 sseV1 = loadVec3(v1);
+	__m128 sseV2 = loadVec3(v2);
 	__m128 sseV = _mm_sub_ps(
-		_mm_mul_ps(sseV2, _mm_shuffle_ps(sseV1, sseV1, _MM_SHUFFLE(3, 0, 2, 1))),
-		_mm_mul_ps(sseV1, _mm_shuffle_ps(sseV2, sseV2, _MM_SHUFFLE(3, 0, 2, 1)))
+		_mm_mul_ps(sseV1, _mm_shuffle_ps(sseV2, sseV2, _MM_SHUFFLE(3, 0, 2, 1))),
+		_mm_mul_ps(sseV2, _mm_shuffle_ps(sseV1, sseV1, _MM_SHUFFLE(3, 0, 2, 1)))
 		);
-	__m128 sseResult = _mm_shuffle_ps(sseV, sseV, _MM_SHUFFLE(3, 0, 2, 1 ));
-
-	float fResult[4];
-	_mm_store_ps(fResult, sseResult);
+	__m128 sseResult = _mm_shuffle_ps(sseV, sseV, _MM_SHUFFLE(3, 0, 2, 1));
 
 	Vec3 result;
-	result.x = fResult[0];
-	result.y = fResult[1];
-	result.z = fResult[2];
+	storeVec3(result, sseResult);
 
 	return result;
 }
@@ -363,7 +413,7 @@ inline Vec3 crossProduct(const Vec3 &v1, const Vec3 &v2)
 
 #endif // INSTRSET
 
-#if INSTRSET >=3 // NOTE: (sonictk) Require SSE 4.1 support for these intrinsics
+#if INSTRSET >= 5 // NOTE: (sonictk) Require SSE 4.1 support for these intrinsics
 #include "smmintrin.h"
 
 inline float innerProduct(const Vec3 &v1, const Vec3 &v2)
@@ -595,6 +645,242 @@ inline Vec4 lerp(Vec4 &v1, float t, Vec4 &v2)
 }
 
 
+#if INSTRSET >= 2 // NOTE: (sonictk) Require SSE2 support for these intrinsics
+/// A 3D vector that lives in a 16-byte aligned SSE register. Unlike ``Vec3``,
+/// chains of operations on these stay in registers instead of being loaded from
+/// and stored back to memory for every operation. The W lane is always zero.
+/// Convert to and from ``Vec3`` explicitly with ``vec3a`` and ``toVec3``.
+struct Vec3A
+{
+	__m128 v;
+};
+
+/// A 4D vector that lives in a 16-byte aligned SSE register. Convert to and from
+/// ``Vec4`` explicitly with ``vec4a`` and ``toVec4``.
+struct Vec4A
+{
+	__m128 v;
+};
+
+inline Vec3A vec3a(__m128 v)
+{
+	Vec3A result = {v};
+	return result;
+}
+
+/// Clears the W lane of ``v``, for the results of operations that can leave ``NaN``
+/// there (i.e. ``0 / 0``) even though the W lanes of their inputs are zero.
+inline Vec3A vec3aClearW(__m128 v)
+{
+	const __m128 xyzMask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+	return vec3a(_mm_and_ps(v, xyzMask));
+}
+
+inline Vec3A vec3a(float x, float y, float z)
+{
+	return vec3a(_mm_set_ps(0, z, y, x));
+}
+
+inline Vec3A vec3a(const Vec3 &v)
+{
+	return vec3a(loadVec3(v));
+}
+
+inline Vec3A vec3a()
+{
+	return vec3a(_mm_setzero_ps());
+}
+
+inline Vec3 toVec3(const Vec3A &v)
+{
+	Vec3 result;
+	storeVec3(result, v.v);
+	return result;
+}
+
+inline Vec4A vec4a(__m128 v)
+{
+	Vec4A result = {v};
+	return result;
+}
+
+inline Vec4A vec4a(float x, float y, float z, float w)
+{
+	return vec4a(_mm_set_ps(w, z, y, x));
+}
+
+inline Vec4A vec4a(const Vec4 &v)
+{
+	return vec4a(_mm_loadu_ps(v.e));
+}
+
+inline Vec4A vec4a()
+{
+	return vec4a(_mm_setzero_ps());
+}
+
+/// Extends the vector with the given W component.
+inline Vec4A vec4a(const Vec3A &v, float w)
+{
+	// NOTE: (sonictk) The W lane of a ``Vec3A`` is zero, so we can just add it in
+	return vec4a(_mm_add_ps(v.v, _mm_set_ps(w, 0, 0, 0)));
+}
+
+inline Vec4 toVec4(const Vec4A &v)
+{
+	Vec4 result;
+	_mm_storeu_ps(result.e, v.v);
+	return result;
+}
+
+/// Drops the W component of the vector.
+inline Vec3A toVec3A(const Vec4A &v)
+{
+	return vec3aClearW(v.v);
+}
+
+
+// NOTE: (sonictk) ``divCtor`` wraps the results of divisions, which are the only
+// operations that turn a zero W lane into ``NaN`` for finite inputs; that would
+// otherwise carry over into everything computed from them.
+#define SS_ALIGNED_VECTOR_OPERATORS(Type, ctor, divCtor, dpMask, cmpMask) \
+	inline Type operator*(const float factor, const Type &v)		\
+	{																\
+		return ctor(_mm_mul_ps(_mm_set1_ps(factor), v.v));			\
+	}																\
+	inline Type operator*(const Type &v, const float factor)		\
+	{																\
+		return factor * v;											\
+	}																\
+	inline Type &operator*=(Type &v, const float factor)			\
+	{																\
+		v = v * factor;												\
+		return v;													\
+	}																\
+	inline Type operator/(const Type &v, const float factor)		\
+	{																\
+		return divCtor(_mm_div_ps(v.v, _mm_set1_ps(factor)));		\
+	}																\
+	inline Type operator/(const float factor, const Type &v)		\
+	{																\
+		return v / factor;											\
+	}																\
+	inline Type &operator/=(Type &v, const float factor)			\
+	{																\
+		v = v / factor;												\
+		return v;													\
+	}																\
+	inline Type operator-(const Type &v)							\
+	{																\
+		return ctor(_mm_xor_ps(v.v, _mm_set1_ps(-0.0f)));			\
+	}																\
+	inline Type operator+(const Type &v1, const Type &v2)			\
+	{																\
+		return ctor(_mm_add_ps(v1.v, v2.v));						\
+	}																\
+	inline Type &operator+=(Type &v1, const Type &v2)				\
+	{																\
+		v1 = v1 + v2;												\
+		return v1;													\
+	}																\
+	inline Type operator-(const Type &v1, const Type &v2)			\
+	{																\
+		return ctor(_mm_sub_ps(v1.v, v2.v));						\
+	}																\
+	inline Type &operator-=(Type &v1, const Type &v2)				\
+	{																\
+		v1 = v1 - v2;												\
+		return v1;													\
+	}																\
+	inline bool operator==(const Type &v1, const Type &v2)			\
+	{																\
+		__m128 absDiff = _mm_andnot_ps(_mm_set1_ps(-0.0f), _mm_sub_ps(v1.v, v2.v)); \
+		int mask = _mm_movemask_ps(_mm_cmplt_ps(absDiff, _mm_set1_ps(FLT_EPSILON))); \
+		return (mask & cmpMask) == cmpMask;							\
+	}																\
+	inline bool operator!=(const Type &v1, const Type &v2)			\
+	{																\
+		return !(v1 == v2);											\
+	}																\
+	inline __m128 innerProductSplat(const Type &v1, const Type &v2)	\
+	{																\
+		return dotProductSplat<dpMask>(v1.v, v2.v);					\
+	}																\
+	inline float innerProduct(const Type &v1, const Type &v2)		\
+	{																\
+		return _mm_cvtss_f32(innerProductSplat(v1, v2));			\
+	}																\
+	inline float length(const Type &v)								\
+	{																\
+		return _mm_cvtss_f32(_mm_sqrt_ss(innerProductSplat(v, v)));	\
+	}																\
+	inline Type normalize(const Type &v)							\
+	{																\
+		return divCtor(_mm_div_ps(v.v, _mm_sqrt_ps(innerProductSplat(v, v)))); \
+	}																\
+	inline Type lerp(const Type &v1, float t, const Type &v2)		\
+	{																\
+		Type result = ((1.0f - t) * v1) + (t * v2);					\
+		return result;												\
+	}
+
+
+/**
+ * Computes the dot product of the lanes selected by ``mask`` (a bitmask of lanes
+ * ``XYZW``, from the least significant bit) and broadcasts it to every lane, so
+ * that it can be used in further vector math without leaving the register.
+ */
+template <int mask>
+inline __m128 dotProductSplat(__m128 v1, __m128 v2)
+{
+#if INSTRSET >= 5 // NOTE: (sonictk) Require SSE 4.1 support for ``_mm_dp_ps``
+	return _mm_dp_ps(v1, v2, (mask << 4) | 0xF);
+#else
+	const __m128 laneMask = _mm_castsi128_ps(_mm_set_epi32((mask & 8) ? -1 : 0,
+														   (mask & 4) ? -1 : 0,
+														   (mask & 2) ? -1 : 0,
+														   (mask & 1) ? -1 : 0));
+	__m128 m = _mm_and_ps(_mm_mul_ps(v1, v2), laneMask);
+	// NOTE: (sonictk) Horizontal add: (x+y, y+x, z+w, w+z) then swap the halves
+	__m128 sum = _mm_add_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_add_ps(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 0, 3, 2)));
+#endif // INSTRSET
+}
+
+SS_ALIGNED_VECTOR_OPERATORS(Vec3A, vec3a, vec3aClearW, 0x7, 0x7)
+SS_ALIGNED_VECTOR_OPERATORS(Vec4A, vec4a, vec4a, 0xF, 0xF)
+
+#undef SS_ALIGNED_VECTOR_OPERATORS
+
+
+inline Vec3A crossProduct(const Vec3A &v1, const Vec3A &v2)
+{
+	__m128 v = _mm_sub_ps(
+		_mm_mul_ps(v1.v, _mm_shuffle_ps(v2.v, v2.v, _MM_SHUFFLE(3, 0, 2, 1))),
+		_mm_mul_ps(v2.v, _mm_shuffle_ps(v1.v, v1.v, _MM_SHUFFLE(3, 0, 2, 1)))
+		);
+	return vec3a(_mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 0, 2, 1)));
+}
+
+
+#else // NOTE: (sonictk) Fallback implementation; the aligned types are just aliases
+typedef Vec3 Vec3A;
+typedef Vec4 Vec4A;
+
+inline Vec3A vec3a(float x, float y, float z) { return vec3(x, y, z); }
+inline Vec3A vec3a(const Vec3 &v) { return v; }
+inline Vec3A vec3a() { return vec3(); }
+inline Vec3 toVec3(const Vec3A &v) { return v; }
+inline Vec4A vec4a(float x, float y, float z, float w) { return vec4(x, y, z, w); }
+inline Vec4A vec4a(const Vec4 &v) { return v; }
+inline Vec4A vec4a() { return vec4(); }
+inline Vec4A vec4a(const Vec3A &v, float w) { return vec4(v, w); }
+inline Vec4 toVec4(const Vec4A &v) { return v; }
+inline Vec3A toVec3A(const Vec4A &v) { return v.xyz; }
+
+#endif // INSTRSET
+
+
 // NOTE: (sonictk) This expects the values to be specified in **degrees**.
 typedef Vec3 EulerRotation;
 
@@ -602,6 +888,31 @@ typedef Vec4 Quaternion;
 typedef Quaternion Quat;
 
 
+#if INSTRSET >= 2 // NOTE: (sonictk) Require SSE2 support for these intrinsics
+inline Vec3A rotateBy(const Vec3A &v, const Vec4A &rotation)
+{
+	Vec3A axis = toVec3A(rotation);
+	__m128 scalar = _mm_shuffle_ps(rotation.v, rotation.v, _MM_SHUFFLE(3, 3, 3, 3));
+
+	// NOTE: (sonictk) Same formula as the ``Vec3`` version, but every intermediate
+	// value is kept splatted across the register so nothing is spilled to memory.
+	__m128 axisDotV = innerProductSplat(axis, v);
+	__m128 axisDotAxis = innerProductSplat(axis, axis);
+	__m128 result = _mm_add_ps(
+		_mm_add_ps(_mm_mul_ps(_mm_add_ps(axisDotV, axisDotV), axis.v),
+				   _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(scalar, scalar), axisDotAxis), v.v)),
+		_mm_mul_ps(_mm_add_ps(scalar, scalar), crossProduct(axis, v).v));
+
+	return vec3a(result);
+}
+
+inline Vec3 rotateBy(Vec3 v, Quat rotation)
+{
+	// NOTE: (sonictk) Derived from Rodrigues' rotation formula; see below.
+	return toVec3(rotateBy(vec3a(v), vec4a(rotation)));
+}
+
+#else
 inline Vec3 rotateBy(Vec3 v, Quat rotation)
 {
 	Vec3 axis = vec3(rotation.x, rotation.y, rotation.z);
@@ -618,5 +929,7 @@ inline Vec3 rotateBy(Vec3 v, Quat rotation)
 	return result;
 }
 
+#endif // INSTRSET
+
 
 #endif /* VECTOR_MATH_H */
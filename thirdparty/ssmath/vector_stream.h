@@ -0,0 +1,623 @@
+/**
+ * @brief  	Structure-of-arrays (SoA) vector types for batched math. A ``Vec3Stream``
+ * 			stores the X, Y and Z components of many vectors in separate aligned
+ * 			arrays, and a ``Vec3Packet`` holds one SIMD register's worth of them.
+ * 			These are the building blocks for batched kernels; single vectors
+ * 			should keep using the types in ``vector_math.h``.
+ */
+#ifndef VECTOR_STREAM_H
+#define VECTOR_STREAM_H
+
+#include "vector_math.h"
+#include "simd_float.h"
+
+
+/// A packet of 3D vectors, stored with one register per component.
+template <typename F>
+struct Vec3Packet
+{
+	F x, y, z;
+};
+
+typedef Vec3Packet<F32x1> Vec3x1;
+
+#if INSTRSET >= 2
+typedef Vec3Packet<F32x4> Vec3x4;
+#endif // INSTRSET
+
+#ifdef SS_HAS_F32X8
+typedef Vec3Packet<F32x8> Vec3x8;
+#endif // SS_HAS_F32X8
+
+#ifdef SS_HAS_F32X16
+typedef Vec3Packet<F32x16> Vec3x16;
+#endif // SS_HAS_F32X16
+
+
+template <typename F>
+SS_FORCE_INLINE Vec3Packet<F> vec3Packet(F x, F y, F z)
+{
+	Vec3Packet<F> result = {x, y, z};
+	return result;
+}
+
+/// Broadcasts a single vector to every lane of a packet.
+template <typename F>
+SS_FORCE_INLINE Vec3Packet<F> vec3Packet(const Vec3 &v)
+{
+	Vec3Packet<F> result = {F::broadcast(v.x), F::broadcast(v.y), F::broadcast(v.z)};
+	return result;
+}
+
+template <typename F>
+SS_FORCE_INLINE Vec3Packet<F> operator+(const Vec3Packet<F> &v1, const Vec3Packet<F> &v2)
+{
+	Vec3Packet<F> result = {v1.x + v2.x, v1.y + v2.y, v1.z + v2.z};
+	return result;
+}
+
+template <typename F>
+SS_FORCE_INLINE Vec3Packet<F> operator-(const Vec3Packet<F> &v1, const Vec3Packet<F> &v2)
+{
+	Vec3Packet<F> result = {v1.x - v2.x, v1.y - v2.y, v1.z - v2.z};
+	return result;
+}
+
+template <typename F>
+SS_FORCE_INLINE Vec3Packet<F> operator-(const Vec3Packet<F> &v)
+{
+	Vec3Packet<F> result = {-v.x, -v.y, -v.z};
+	return result;
+}
+
+template <typename F>
+SS_FORCE_INLINE Vec3Packet<F> operator*(const Vec3Packet<F> &v, F factor)
+{
+	Vec3Packet<F> result = {v.x * factor, v.y * factor, v.z * factor};
+	return result;
+}
+
+template <typename F>
+SS_FORCE_INLINE Vec3Packet<F> operator*(F factor, const Vec3Packet<F> &v)
+{
+	return v * factor;
+}
+
+template <typename F>
+SS_FORCE_INLINE Vec3Packet<F> operator*(const Vec3Packet<F> &v, float factor)
+{
+	return v * F::broadcast(factor);
+}
+
+template <typename F>
+SS_FORCE_INLINE Vec3Packet<F> operator*(float factor, const Vec3Packet<F> &v)
+{
+	return v * F::broadcast(factor);
+}
+
+template <typename F>
+SS_FORCE_INLINE F innerProduct(const Vec3Packet<F> &v1, const Vec3Packet<F> &v2)
+{
+	F result = (v1.x * v2.x) + (v1.y * v2.y) + (v1.z * v2.z);
+	return result;
+}
+
+template <typename F>
+SS_FORCE_INLINE Vec3Packet<F> crossProduct(const Vec3Packet<F> &v1, const Vec3Packet<F> &v2)
+{
+	Vec3Packet<F> result = {
+		(v1.y * v2.z) - (v1.z * v2.y),
+		(v1.z * v2.x) - (v1.x * v2.z),
+		(v1.x * v2.y) - (v1.y * v2.x)
+	};
+	return result;
+}
+
+template <typename F>
+SS_FORCE_INLINE F length(const Vec3Packet<F> &v)
+{
+	return squareRoot(innerProduct(v, v));
+}
+
+template <typename F>
+SS_FORCE_INLINE Vec3Packet<F> normalize(const Vec3Packet<F> &v)
+{
+	F invLength = F::broadcast(1.0f) / length(v);
+	return v * invLength;
+}
+
+
+/// How accurately ``length`` and ``normalize`` should be computed.
+enum PrecisionMode
+{
+	/// Uses a division and a full-precision square root.
+	PrecisionMode_Exact,
+	/// Uses the reciprocal square root estimate refined with one Newton-Raphson
+	/// step. The relative error is below ``5e-7`` (about 4 ULP).
+	PrecisionMode_Refined,
+	/// Uses the reciprocal square root estimate only. The relative error is below
+	/// ``4e-4`` with SSE/AVX, and ``7e-5`` with AVX-512.
+	PrecisionMode_Fast,
+
+	PrecisionMode_Count
+};
+
+/**
+ * Computes ``1 / sqrt(x)`` with the given precision. Unlike the exact version, the
+ * approximate ones give a large finite value instead of ``inf`` for ``0``.
+ */
+template <PrecisionMode mode>
+struct ReciprocalSquareRoot
+{
+	template <typename F>
+	static SS_FORCE_INLINE F apply(F x)
+	{
+		return F::broadcast(1.0f) / squareRoot(x);
+	}
+};
+
+template <>
+struct ReciprocalSquareRoot<PrecisionMode_Refined>
+{
+	template <typename F>
+	static SS_FORCE_INLINE F apply(F x)
+	{
+		// NOTE: (sonictk) Clamp to the smallest normal so that zero-length vectors
+		// don't turn into ``0 * inf``.
+		x = maximum(x, F::broadcast(FLT_MIN));
+		F y = reciprocalSquareRootEstimate(x);
+		return y * (F::broadcast(1.5f) - ((F::broadcast(0.5f) * x) * (y * y)));
+	}
+};
+
+template <>
+struct ReciprocalSquareRoot<PrecisionMode_Fast>
+{
+	template <typename F>
+	static SS_FORCE_INLINE F apply(F x)
+	{
+		return reciprocalSquareRootEstimate(maximum(x, F::broadcast(FLT_MIN)));
+	}
+};
+
+/// Gets the length of every vector with the given precision. The approximate
+/// modes compute ``x * (1 / sqrt(x))``, which avoids the square root entirely.
+template <PrecisionMode mode, typename F>
+SS_FORCE_INLINE F length(const Vec3Packet<F> &v)
+{
+	// NOTE: (sonictk) ``mode`` is a constant, so only one of these is compiled in.
+	if (mode == PrecisionMode_Exact) {
+		return length(v);
+	}
+
+	F lengthSquared = innerProduct(v, v);
+	return lengthSquared * ReciprocalSquareRoot<mode>::apply(lengthSquared);
+}
+
+/// Normalizes every vector with the given precision. Zero-length vectors stay zero
+/// in the approximate modes, instead of becoming ``NaN``.
+template <PrecisionMode mode, typename F>
+SS_FORCE_INLINE Vec3Packet<F> normalize(const Vec3Packet<F> &v)
+{
+	if (mode == PrecisionMode_Exact) {
+		return normalize(v);
+	}
+
+	return v * ReciprocalSquareRoot<mode>::apply(innerProduct(v, v));
+}
+
+template <typename F>
+SS_FORCE_INLINE Vec3Packet<F> lerp(const Vec3Packet<F> &v1, F t, const Vec3Packet<F> &v2)
+{
+	// NOTE: (sonictk) Same formulation as the scalar ``lerp`` so that results match
+	F oneMinusT = F::broadcast(1.0f) - t;
+	Vec3Packet<F> result = (oneMinusT * v1) + (t * v2);
+	return result;
+}
+
+template <typename F>
+SS_FORCE_INLINE Vec3Packet<F> lerp(const Vec3Packet<F> &v1, float t, const Vec3Packet<F> &v2)
+{
+	return lerp(v1, F::broadcast(t), v2);
+}
+
+
+#if INSTRSET >= 2
+/**
+ * Loads four consecutive array-of-structures ``Vec3``s into a packet. The
+ * vectors do not need to be aligned.
+ *
+ * @param v	Pointer to the first of the four vectors.
+ *
+ * @return		The packet.
+ */
+inline Vec3x4 loadVec3x4(const Vec3 *v)
+{
+	Vec3x4 result;
+	loadVec3x4(v, result.x.v, result.y.v, result.z.v);
+	return result;
+}
+
+/**
+ * Stores a packet as four consecutive array-of-structures ``Vec3``s. The
+ * vectors do not need to be aligned.
+ *
+ * @param v		Pointer to the first of the four vectors to write to.
+ * @param packet	The packet to store.
+ */
+inline void storeVec3x4(Vec3 *v, const Vec3x4 &packet)
+{
+	storeVec3x4(v, packet.x.v, packet.y.v, packet.z.v);
+}
+
+#endif // INSTRSET
+
+
+/// A stream of 3D vectors stored as structure-of-arrays. Each component array is
+/// aligned to ``kSIMDAlignment`` and padded to a multiple of ``kSIMDPadding``
+/// floats; the contents of the padding are unspecified.
+struct Vec3Stream
+{
+	float *x;
+	float *y;
+	float *z;
+
+	unsigned int count;
+	unsigned int capacity;
+};
+
+/// A stream of scalars, with the same alignment and padding as ``Vec3Stream``.
+struct FloatStream
+{
+	float *e;
+
+	unsigned int count;
+	unsigned int capacity;
+};
+
+
+/**
+ * Allocates storage for at least ``count`` vectors and sets the stream's count.
+ * If the stream already has enough capacity, no allocation is made. The stream
+ * must have been zero-initialized or previously allocated with this function.
+ * Existing contents are not preserved when the stream grows.
+ *
+ * @param stream	The stream to allocate.
+ * @param count	The number of vectors the stream should hold.
+ *
+ * @return			``0`` on success, a negative value if the allocation failed.
+ */
+inline int allocateVec3Stream(Vec3Stream &stream, unsigned int count)
+{
+	if (stream.x && stream.capacity >= count) {
+		stream.count = count;
+		return 0;
+	}
+
+	freeAligned(stream.x);
+
+	// NOTE: (sonictk) All three components share a single allocation; since each
+	// array is padded to the alignment, they all start on an aligned boundary.
+	unsigned int capacity = padSIMDCount(count > 0 ? count : 1);
+	float *storage = (float *)allocateAligned(sizeof(float) * capacity * 3);
+	if (!storage) {
+		stream.x = stream.y = stream.z = NULL;
+		stream.count = stream.capacity = 0;
+		return -1;
+	}
+
+	stream.x = storage;
+	stream.y = storage + capacity;
+	stream.z = storage + (capacity * 2);
+	stream.count = count;
+	stream.capacity = capacity;
+
+	return 0;
+}
+
+inline void freeVec3Stream(Vec3Stream &stream)
+{
+	freeAligned(stream.x);
+	stream.x = stream.y = stream.z = NULL;
+	stream.count = stream.capacity = 0;
+}
+
+/**
+ * Allocates storage for at least ``count`` scalars and sets the stream's count.
+ * See ``allocateVec3Stream`` for details.
+ *
+ * @param stream	The stream to allocate.
+ * @param count	The number of scalars the stream should hold.
+ *
+ * @return			``0`` on success, a negative value if the allocation failed.
+ */
+inline int allocateFloatStream(FloatStream &stream, unsigned int count)
+{
+	if (stream.e && stream.capacity >= count) {
+		stream.count = count;
+		return 0;
+	}
+
+	freeAligned(stream.e);
+
+	unsigned int capacity = padSIMDCount(count > 0 ? count : 1);
+	stream.e = (float *)allocateAligned(sizeof(float) * capacity);
+	if (!stream.e) {
+		stream.count = stream.capacity = 0;
+		return -1;
+	}
+	stream.count = count;
+	stream.capacity = capacity;
+
+	return 0;
+}
+
+inline void freeFloatStream(FloatStream &stream)
+{
+	freeAligned(stream.e);
+	stream.e = NULL;
+	stream.count = stream.capacity = 0;
+}
+
+
+/// Loads the packet starting at vector ``index`` of the stream. ``index`` must be
+/// a multiple of the packet width.
+template <typename F>
+SS_FORCE_INLINE Vec3Packet<F> loadVec3Packet(const Vec3Stream &stream, unsigned int index)
+{
+	Vec3Packet<F> result = {F::load(stream.x + index), F::load(stream.y + index), F::load(stream.z + index)};
+	return result;
+}
+
+/// Stores the packet to vector ``index`` of the stream. ``index`` must be a
+/// multiple of the packet width.
+template <typename F>
+SS_FORCE_INLINE void storeVec3Packet(Vec3Stream &stream, unsigned int index, const Vec3Packet<F> &packet)
+{
+	packet.x.store(stream.x + index);
+	packet.y.store(stream.y + index);
+	packet.z.store(stream.z + index);
+}
+
+/// Loads ``F::width`` consecutive ``Vec3``s and transposes them into a packet. This
+/// is the AoS equivalent of ``loadVec3Packet``; the vectors do not need to be aligned.
+SS_FORCE_INLINE void loadVec3PacketAoS(const Vec3 *v, Vec3Packet<F32x1> &packet)
+{
+	packet.x.v = v->x;
+	packet.y.v = v->y;
+	packet.z.v = v->z;
+}
+
+/// The inverse of ``loadVec3PacketAoS``.
+SS_FORCE_INLINE void storeVec3PacketAoS(Vec3 *v, const Vec3Packet<F32x1> &packet)
+{
+	*v = vec3(packet.x.v, packet.y.v, packet.z.v);
+}
+
+#if INSTRSET >= 2 // NOTE: (sonictk) Require SSE2 support for these intrinsics
+SS_FORCE_INLINE void loadVec3PacketAoS(const Vec3 *v, Vec3Packet<F32x4> &packet)
+{
+	loadVec3x4(v, packet.x.v, packet.y.v, packet.z.v);
+}
+
+SS_FORCE_INLINE void storeVec3PacketAoS(Vec3 *v, const Vec3Packet<F32x4> &packet)
+{
+	storeVec3x4(v, packet.x.v, packet.y.v, packet.z.v);
+}
+
+// NOTE: (sonictk) The wider packets are transposed four vectors at a time, since
+// shuffles don't cross 128-bit lanes anyway.
+#ifdef SS_HAS_F32X8
+SS_BEGIN_TARGET_AVX2
+SS_AVX2_INLINE void loadVec3PacketAoS(const Vec3 *v, Vec3Packet<F32x8> &packet)
+{
+	__m128 x0, y0, z0, x1, y1, z1;
+	loadVec3x4(v, x0, y0, z0);
+	loadVec3x4(v + 4, x1, y1, z1);
+	packet.x.v = _mm256_insertf128_ps(_mm256_castps128_ps256(x0), x1, 1);
+	packet.y.v = _mm256_insertf128_ps(_mm256_castps128_ps256(y0), y1, 1);
+	packet.z.v = _mm256_insertf128_ps(_mm256_castps128_ps256(z0), z1, 1);
+}
+
+SS_AVX2_INLINE void storeVec3PacketAoS(Vec3 *v, const Vec3Packet<F32x8> &packet)
+{
+	storeVec3x4(v,
+				_mm256_castps256_ps128(packet.x.v),
+				_mm256_castps256_ps128(packet.y.v),
+				_mm256_castps256_ps128(packet.z.v));
+	storeVec3x4(v + 4,
+				_mm256_extractf128_ps(packet.x.v, 1),
+				_mm256_extractf128_ps(packet.y.v, 1),
+				_mm256_extractf128_ps(packet.z.v, 1));
+}
+SS_END_TARGET_AVX2
+#endif // SS_HAS_F32X8
+
+#ifdef SS_HAS_F32X16
+SS_BEGIN_TARGET_AVX512
+SS_AVX512_INLINE void loadVec3PacketAoS(const Vec3 *v, Vec3Packet<F32x16> &packet)
+{
+	__m128 x0, y0, z0, x1, y1, z1, x2, y2, z2, x3, y3, z3;
+	loadVec3x4(v, x0, y0, z0);
+	loadVec3x4(v + 4, x1, y1, z1);
+	loadVec3x4(v + 8, x2, y2, z2);
+	loadVec3x4(v + 12, x3, y3, z3);
+
+	// NOTE: (sonictk) The lane index of the inserts must be an immediate.
+	__m512 x = _mm512_insertf32x4(_mm512_castps128_ps512(x0), x1, 1);
+	__m512 y = _mm512_insertf32x4(_mm512_castps128_ps512(y0), y1, 1);
+	__m512 z = _mm512_insertf32x4(_mm512_castps128_ps512(z0), z1, 1);
+	x = _mm512_insertf32x4(_mm512_insertf32x4(x, x2, 2), x3, 3);
+	y = _mm512_insertf32x4(_mm512_insertf32x4(y, y2, 2), y3, 3);
+	z = _mm512_insertf32x4(_mm512_insertf32x4(z, z2, 2), z3, 3);
+	packet.x.v = x;
+	packet.y.v = y;
+	packet.z.v = z;
+}
+
+SS_AVX512_INLINE void storeVec3PacketAoS(Vec3 *v, const Vec3Packet<F32x16> &packet)
+{
+	storeVec3x4(v,
+				_mm512_maskz_extractf32x4_ps((__mmask8)0xF, packet.x.v, 0),
+				_mm512_maskz_extractf32x4_ps((__mmask8)0xF, packet.y.v, 0),
+				_mm512_maskz_extractf32x4_ps((__mmask8)0xF, packet.z.v, 0));
+	storeVec3x4(v + 4,
+				_mm512_maskz_extractf32x4_ps((__mmask8)0xF, packet.x.v, 1),
+				_mm512_maskz_extractf32x4_ps((__mmask8)0xF, packet.y.v, 1),
+				_mm512_maskz_extractf32x4_ps((__mmask8)0xF, packet.z.v, 1));
+	storeVec3x4(v + 8,
+				_mm512_maskz_extractf32x4_ps((__mmask8)0xF, packet.x.v, 2),
+				_mm512_maskz_extractf32x4_ps((__mmask8)0xF, packet.y.v, 2),
+				_mm512_maskz_extractf32x4_ps((__mmask8)0xF, packet.z.v, 2));
+	storeVec3x4(v + 12,
+				_mm512_maskz_extractf32x4_ps((__mmask8)0xF, packet.x.v, 3),
+				_mm512_maskz_extractf32x4_ps((__mmask8)0xF, packet.y.v, 3),
+				_mm512_maskz_extractf32x4_ps((__mmask8)0xF, packet.z.v, 3));
+}
+SS_END_TARGET_AVX512
+#endif // SS_HAS_F32X16
+#endif // INSTRSET
+
+
+/**
+ * Copies array-of-structures vectors into the stream, allocating it as needed.
+ *
+ * @param stream		The stream to write to.
+ * @param v			The vectors to copy.
+ * @param count		The number of vectors to copy.
+ *
+ * @return				``0`` on success, a negative value if the allocation failed.
+ */
+inline int loadVec3Stream(Vec3Stream &stream, const Vec3 *v, unsigned int count)
+{
+	if (allocateVec3Stream(stream, count) != 0) {
+		return -1;
+	}
+
+	unsigned int i = 0;
+#if INSTRSET >= 2
+	for (; i + 4 <= count; i += 4) {
+		__m128 x, y, z;
+		loadVec3x4(v + i, x, y, z);
+		_mm_store_ps(stream.x + i, x);
+		_mm_store_ps(stream.y + i, y);
+		_mm_store_ps(stream.z + i, z);
+	}
+#endif // INSTRSET
+	for (; i < count; ++i) {
+		stream.x[i] = v[i].x;
+		stream.y[i] = v[i].y;
+		stream.z[i] = v[i].z;
+	}
+
+	return 0;
+}
+
+/**
+ * Copies the stream's vectors out to an array-of-structures buffer.
+ *
+ * @param stream		The stream to read from.
+ * @param v			The buffer to write to. Must have room for ``stream.count``
+ * 					vectors.
+ */
+inline void storeVec3Stream(const Vec3Stream &stream, Vec3 *v)
+{
+	unsigned int i = 0;
+#if INSTRSET >= 2
+	for (; i + 4 <= stream.count; i += 4) {
+		storeVec3x4(v + i, _mm_load_ps(stream.x + i), _mm_load_ps(stream.y + i), _mm_load_ps(stream.z + i));
+	}
+#endif // INSTRSET
+	for (; i < stream.count; ++i) {
+		v[i] = vec3(stream.x[i], stream.y[i], stream.z[i]);
+	}
+}
+
+
+// NOTE: (sonictk) The kernels below are written once over the packet type. Since
+// streams are padded, they always process whole packets and never need a tail.
+// The public functions that run them are in ``simd_kernels.h``.
+template <typename F>
+SS_FORCE_INLINE void addStreamsKernel(const Vec3Stream &a, const Vec3Stream &b, Vec3Stream &out)
+{
+	for (unsigned int i=0; i < a.count; i += F::width) {
+		storeVec3Packet(out, i, loadVec3Packet<F>(a, i) + loadVec3Packet<F>(b, i));
+	}
+}
+
+template <typename F>
+SS_FORCE_INLINE void subtractStreamsKernel(const Vec3Stream &a, const Vec3Stream &b, Vec3Stream &out)
+{
+	for (unsigned int i=0; i < a.count; i += F::width) {
+		storeVec3Packet(out, i, loadVec3Packet<F>(a, i) - loadVec3Packet<F>(b, i));
+	}
+}
+
+template <typename F>
+SS_FORCE_INLINE void scaleStreamKernel(const Vec3Stream &a, float factor, Vec3Stream &out)
+{
+	F f = F::broadcast(factor);
+	for (unsigned int i=0; i < a.count; i += F::width) {
+		storeVec3Packet(out, i, loadVec3Packet<F>(a, i) * f);
+	}
+}
+
+template <typename F>
+SS_FORCE_INLINE void lerpStreamsKernel(const Vec3Stream &a, float t, const Vec3Stream &b, Vec3Stream &out)
+{
+	F ft = F::broadcast(t);
+	for (unsigned int i=0; i < a.count; i += F::width) {
+		storeVec3Packet(out, i, lerp(loadVec3Packet<F>(a, i), ft, loadVec3Packet<F>(b, i)));
+	}
+}
+
+template <typename F>
+SS_FORCE_INLINE void innerProductStreamsKernel(const Vec3Stream &a, const Vec3Stream &b, FloatStream &out)
+{
+	for (unsigned int i=0; i < a.count; i += F::width) {
+		innerProduct(loadVec3Packet<F>(a, i), loadVec3Packet<F>(b, i)).store(out.e + i);
+	}
+}
+
+template <typename F>
+SS_FORCE_INLINE void crossProductStreamsKernel(const Vec3Stream &a, const Vec3Stream &b, Vec3Stream &out)
+{
+	for (unsigned int i=0; i < a.count; i += F::width) {
+		storeVec3Packet(out, i, crossProduct(loadVec3Packet<F>(a, i), loadVec3Packet<F>(b, i)));
+	}
+}
+
+template <typename F>
+SS_FORCE_INLINE void lengthStreamKernel(const Vec3Stream &a, FloatStream &out)
+{
+	for (unsigned int i=0; i < a.count; i += F::width) {
+		length(loadVec3Packet<F>(a, i)).store(out.e + i);
+	}
+}
+
+template <typename F>
+SS_FORCE_INLINE void normalizeStreamKernel(const Vec3Stream &a, Vec3Stream &out)
+{
+	for (unsigned int i=0; i < a.count; i += F::width) {
+		storeVec3Packet(out, i, normalize(loadVec3Packet<F>(a, i)));
+	}
+}
+
+template <PrecisionMode mode, typename F>
+SS_FORCE_INLINE void lengthStreamKernel(const Vec3Stream &a, FloatStream &out)
+{
+	for (unsigned int i=0; i < a.count; i += F::width) {
+		length<mode>(loadVec3Packet<F>(a, i)).store(out.e + i);
+	}
+}
+
+template <PrecisionMode mode, typename F>
+SS_FORCE_INLINE void normalizeStreamKernel(const Vec3Stream &a, Vec3Stream &out)
+{
+	for (unsigned int i=0; i < a.count; i += F::width) {
+		storeVec3Packet(out, i, normalize<mode>(loadVec3Packet<F>(a, i)));
+	}
+}
+
+
+#endif /* VECTOR_STREAM_H */